@@ -16,7 +16,7 @@
 //   <o>Number of UDP Sockets <1-20>
 //   <i>Number of available UDP sockets
 //   <i>Default: 5
-#define UDP_NUM_SOCKS 1
+#define UDP_NUM_SOCKS 2
 
 // </h>
 
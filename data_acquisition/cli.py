@@ -6,45 +6,104 @@ import argparse
 import logging
 import sys
 import time
+from ipaddress import IPv4Address
 
 from data_acquisition.client import DataAcquisitionClient
+from data_acquisition.protocol import (
+    CAPTURE_MAX_SAMPLES,
+    DEFAULT_MCAST_PORT,
+    TELEMETRY_GAUGES,
+    AcqMode,
+    ConfigParam,
+    TelemetryId,
+)
 
 logger = logging.getLogger()
 
 
-def cmd_start(client: DataAcquisitionClient, _args: argparse.Namespace) -> None:
-    """Handle 'start' command - configure, start acquisition, receive data.
+def _collect_config(_args: argparse.Namespace) -> dict[ConfigParam, int]:
+    """Collect configuration parameters given on the command line.
 
     Args:
-        client (DataAcquisitionClient): Client instance
         args (argparse.Namespace): Parsed command line arguments
 
-    Returns: None
+    Returns:
+        dict[ConfigParam, int]: Parameters to send, in application order
     """
+    params: dict[ConfigParam, int] = {}
+
     if _args.reset_sequence:
-        client.reset_sequence()
-        time.sleep(0.1)
+        params[ConfigParam.RESET_SEQUENCE] = 0
 
     if _args.log_level is not None:
-        client.set_log_level(_args.log_level)
-        time.sleep(0.1)
+        params[ConfigParam.LOG_LEVEL] = _args.log_level
 
     if _args.batch_size is not None:
-        client.configure_batch_size(_args.batch_size)
-        time.sleep(0.1)
+        params[ConfigParam.BATCH_SIZE] = _args.batch_size
 
     if _args.threshold_mv is not None:
-        client.configure_threshold_mv(_args.threshold_mv)
-        time.sleep(0.1)
+        params[ConfigParam.THRESHOLD_MV] = _args.threshold_mv
     elif _args.threshold_percent is not None:
-        client.configure_threshold_percent(_args.threshold_percent)
-        time.sleep(0.1)
+        params[ConfigParam.THRESHOLD_PERCENT] = _args.threshold_percent
 
     if _args.channel is not None:
-        client.configure_channel(_args.channel)
-        time.sleep(0.1)
+        params[ConfigParam.CHANNEL] = _args.channel
+
+    if _args.summary_window is not None:
+        params[ConfigParam.SUMMARY_WINDOW] = _args.summary_window
+
+    if _args.fft_average is not None:
+        params[ConfigParam.SPECTRUM_AVERAGE] = _args.fft_average
+
+    if _args.decimation is not None:
+        params[ConfigParam.DECIMATION] = _args.decimation
+
+    if _args.dead_time is not None:
+        params[ConfigParam.EVENT_DEAD_TIME] = _args.dead_time
+
+    if _args.sample_rate is not None:
+        params[ConfigParam.SAMPLE_RATE_HZ] = _args.sample_rate
+
+    if _args.pace_bytes is not None:
+        params[ConfigParam.PACE_BYTES_PER_S] = _args.pace_bytes
+
+    if _args.pace_packets is not None:
+        params[ConfigParam.PACE_PACKETS_PER_S] = _args.pace_packets
+
+    if _args.mode is not None:
+        params[ConfigParam.ACQ_MODE] = AcqMode[_args.mode.upper()]
+
+    if _args.data_crc is not None:
+        params[ConfigParam.DATA_CRC] = _args.data_crc
+
+    if _args.multicast_port is not None:
+        params[ConfigParam.MCAST_PORT] = _args.multicast_port
+
+    if _args.multicast is not None:
+        params[ConfigParam.MCAST_GROUP] = int(_args.multicast)
+
+    return params
+
+
+def cmd_start(client: DataAcquisitionClient, _args: argparse.Namespace) -> None:
+    """Handle 'start' command - configure, start acquisition, receive data.
+
+    Args:
+        client (DataAcquisitionClient): Client instance
+        args (argparse.Namespace): Parsed command line arguments
 
-    client.start_acquisition()
+    Returns: None
+    """
+    params = _collect_config(_args)
+    if params:
+        client.configure(params)
+
+    if _args.multicast is not None and _args.multicast.is_multicast:
+        client.join_group(
+            str(_args.multicast), _args.multicast_port or DEFAULT_MCAST_PORT
+        )
+
+    client.start_acquisition(_args.subscribe)
     time.sleep(0.1)
 
     try:
@@ -53,6 +112,19 @@ def cmd_start(client: DataAcquisitionClient, _args: argparse.Namespace) -> None:
         client.stop_acquisition()
 
 
+def cmd_listen(client: DataAcquisitionClient, _args: argparse.Namespace) -> None:
+    """Handle 'listen' command - receive multicast data without starting.
+
+    Args:
+        client (DataAcquisitionClient): Client instance
+        args (argparse.Namespace): Parsed command line arguments
+
+    Returns: None
+    """
+    client.join_group(_args.group, _args.group_port)
+    client.receive_loop(duration_s=_args.duration, max_samples=_args.samples)
+
+
 def cmd_stop(client: DataAcquisitionClient, _args: argparse.Namespace) -> None:
     """Handle 'stop' command.
 
@@ -83,11 +155,71 @@ def cmd_status(client: DataAcquisitionClient, _args: argparse.Namespace) -> None
         logger.info(f"Threshold:    {status.threshold_mv} mV")
         logger.info(f"Uptime:       {status.uptime} s")
         logger.info(f"Samples sent: {status.samples_sent}")
+        if status.sample_rate_hz is not None:
+            logger.info(f"Sample rate:  {status.sample_rate_hz:.3f} Hz")
     else:
         logger.error("Failed to get status")
         sys.exit(1)
 
 
+def _print_telemetry(
+    values: dict[int, int], previous: dict[int, int] | None, elapsed_s: float
+) -> None:
+    """Print telemetry values, with rates of counters when a previous sample exists.
+
+    Args:
+        values (dict[int, int]): Current telemetry values
+        previous (dict[int, int] | None): Values of the previous sample
+        elapsed_s (float): Device time between the two samples in seconds
+
+    Returns: None
+    """
+    for key, value in values.items():
+        name = key.name if isinstance(key, TelemetryId) else f"0x{key:02X}"
+        line = f"{name:<20} {value:>12}"
+
+        if previous is not None and key not in TELEMETRY_GAUGES and key in previous:
+            # Device counters are 32-bit and wrap around
+            delta = (value - previous[key]) & 0xFFFFFFFF
+            line += f" {delta / elapsed_s:>12.1f}/s"
+
+        logger.info(line)
+
+
+def cmd_stats(client: DataAcquisitionClient, args: argparse.Namespace) -> None:
+    """Handle 'stats' command - print device telemetry, optionally with rates.
+
+    Args:
+        client (DataAcquisitionClient): Client instance
+        args (argparse.Namespace): Parsed command line arguments
+
+    Returns: None
+    """
+    previous: dict[int, int] | None = None
+
+    while True:
+        values = client.get_telemetry()
+        if values is None:
+            logger.error("Failed to get telemetry")
+            sys.exit(1)
+
+        elapsed_s = 0.0
+        if previous is not None:
+            uptime_delta = (
+                values[TelemetryId.UPTIME_MS] - previous[TelemetryId.UPTIME_MS]
+            )
+            elapsed_s = (uptime_delta & 0xFFFFFFFF) / 1000
+
+        _print_telemetry(values, previous if elapsed_s > 0 else None, elapsed_s)
+
+        if not args.watch:
+            return
+
+        previous = values
+        time.sleep(args.interval)
+        logger.info("")
+
+
 def cmd_ping(client: DataAcquisitionClient, _args: argparse.Namespace) -> None:
     """Handle 'ping' command.
 
@@ -111,8 +243,8 @@ def cmd_ping(client: DataAcquisitionClient, _args: argparse.Namespace) -> None:
             time.sleep(1)
 
 
-def cmd_configure(client: DataAcquisitionClient, _args: argparse.Namespace) -> None:
-    """Handle 'configure' command.
+def cmd_sync(client: DataAcquisitionClient, args: argparse.Namespace) -> None:
+    """Handle 'sync' command - estimate device clock offset and drift.
 
     Args:
         client (DataAcquisitionClient): Client instance
@@ -120,38 +252,66 @@ def cmd_configure(client: DataAcquisitionClient, _args: argparse.Namespace) -> N
 
     Returns: None
     """
-    configured = False
+    if not client.sync_clock(count=args.count):
+        logger.error("Clock synchronization failed")
+        sys.exit(1)
 
-    if _args.reset_sequence:
-        client.reset_sequence()
-        configured = True
+    best_delay = client.clock.best_delay or 0.0
+    logger.info(f"Offset:     {client.clock.offset:.6f} s")
+    logger.info(f"Drift:      {client.clock.drift_ppm:.2f} ppm")
+    logger.info(f"Best RTT:   {best_delay * 1000:.3f} ms")
 
-    if _args.log_level is not None:
-        configured = False
-        client.set_log_level(_args.log_level)
-        configured = True
 
-    if _args.threshold_percent is not None:
-        configured = False
-        client.configure_threshold_percent(_args.threshold_percent)
-        configured = True
+def cmd_capture(client: DataAcquisitionClient, args: argparse.Namespace) -> None:
+    """Handle 'capture' command - burst capture at the maximum sample rate.
 
-    if _args.threshold_mv is not None:
-        configured = False
-        client.configure_threshold_mv(_args.threshold_mv)
-        configured = True
+    Args:
+        client (DataAcquisitionClient): Client instance
+        args (argparse.Namespace): Parsed command line arguments
 
-    if _args.batch_size is not None:
-        configured = False
-        client.configure_batch_size(_args.batch_size)
-        configured = True
+    Returns: None
+    """
+    capture = client.capture(args.samples, timeout_s=args.timeout)
+    if capture is None:
+        logger.error("Capture failed")
+        sys.exit(1)
 
-    if _args.channel is not None:
-        configured = False
-        client.configure_channel(_args.channel)
-        configured = True
+    count = len(capture.samples)
+    logger.info(
+        f"Captured {count} samples on channel {capture.channel} "
+        f"at {capture.sample_rate_hz:.1f} Hz, {capture.overruns} lost"
+    )
+    if count:
+        logger.info(
+            f"Min {min(capture.samples)}, max {max(capture.samples)}, "
+            f"mean {sum(capture.samples) / count:.1f}"
+        )
+
+    if args.output:
+        period_us = 1e6 / capture.sample_rate_hz
+        with open(args.output, "w", encoding="ascii") as out:
+            out.write("index,time_us,value\n")
+            for i, value in enumerate(capture.samples):
+                t = capture.timestamp_us + i * period_us
+                out.write(f"{i},{t:.2f},{value}\n")
+        logger.info(f"Samples written to {args.output}")
+
+
+def cmd_configure(client: DataAcquisitionClient, _args: argparse.Namespace) -> None:
+    """Handle 'configure' command.
+
+    All given options are sent in a single TLV configuration packet.
+
+    Args:
+        client (DataAcquisitionClient): Client instance
+        args (argparse.Namespace): Parsed command line arguments
 
-    if configured:
+    Returns: None
+    """
+    params = _collect_config(_args)
+
+    if params:
+        client.configure(params)
         logger.info("Configuration sent")
     else:
         logger.error("No configuration options specified")
@@ -173,6 +333,12 @@ Examples:
     %(prog)s start --duration 10 --log-level 0               # Device debug logging
     %(prog)s status                                          # Get device status
     %(prog)s ping -c 5                                       # Ping 5 times
+    %(prog)s sync -c 32                                      # Estimate device clock
+    %(prog)s stats --watch                                   # Telemetry with rates
+    %(prog)s capture 2048 -o burst.csv                       # 100 kHz burst to CSV
+    %(prog)s start --duration 60 --multicast 239.1.2.3       # Publish by multicast
+    %(prog)s listen 239.1.2.3 --duration 60                  # Extra multicast receiver
+    %(prog)s start --duration 60 --pace-bytes 500000         # Limit stream to 500 kB/s
     %(prog)s configure --log-level 2                         # Set device log to WARNING
     %(prog)s configure --reset-sequence                      # Reset packet counter
 
@@ -225,8 +391,42 @@ Defaults:
         help="How many samples to acquire (stop after reaching at least this value)",
     )
 
+    start_parser.add_argument(
+        "--subscribe",
+        type=int,
+        nargs="+",
+        choices=range(8),
+        metavar="CH",
+        help="Only receive data of these ADC channels (default: all)",
+    )
+
     _add_config_args(start_parser, required=False)
 
+    listen_parser = subparsers.add_parser(
+        "listen", help="Receive multicast data published for another client"
+    )
+    listen_parser.add_argument("group", help="Multicast group address")
+    listen_parser.add_argument(
+        "--group-port",
+        type=int,
+        default=DEFAULT_MCAST_PORT,
+        metavar="PORT",
+        help=f"Multicast UDP port (default: {DEFAULT_MCAST_PORT})",
+    )
+    listen_stop_group = listen_parser.add_mutually_exclusive_group()
+    listen_stop_group.add_argument(
+        "--duration",
+        type=float,
+        metavar="SEC",
+        help="How long to listen, in seconds",
+    )
+    listen_stop_group.add_argument(
+        "--samples",
+        type=int,
+        metavar="N",
+        help="How many samples to receive",
+    )
+
     subparsers.add_parser("stop", help="Stop acquisition")
     subparsers.add_parser("status", help="Get device status")
 
@@ -239,6 +439,58 @@ Defaults:
         help="Number of pings",
     )
 
+    stats_parser = subparsers.add_parser("stats", help="Get device telemetry")
+    stats_parser.add_argument(
+        "-w",
+        "--watch",
+        action="store_true",
+        help="Poll repeatedly and show counter rates",
+    )
+    stats_parser.add_argument(
+        "-i",
+        "--interval",
+        type=float,
+        default=1.0,
+        metavar="SEC",
+        help="Polling interval for --watch",
+    )
+
+    sync_parser = subparsers.add_parser(
+        "sync", help="Estimate device clock offset and drift"
+    )
+    sync_parser.add_argument(
+        "-c",
+        "--count",
+        type=int,
+        default=16,
+        help="Number of time exchanges",
+    )
+
+    capture_parser = subparsers.add_parser(
+        "capture", help="Capture a burst at the maximum sample rate"
+    )
+    capture_parser.add_argument(
+        "samples",
+        type=int,
+        choices=range(1, CAPTURE_MAX_SAMPLES + 1),
+        metavar="N",
+        help=f"Samples to capture (1-{CAPTURE_MAX_SAMPLES})",
+    )
+    capture_parser.add_argument(
+        "-o",
+        "--output",
+        metavar="FILE",
+        help="Write the samples to a CSV file",
+    )
+    capture_parser.add_argument(
+        "-t",
+        "--timeout",
+        type=float,
+        default=2.0,
+        metavar="SEC",
+        help="Longest wait for the capture to complete",
+    )
+
     config_parser = subparsers.add_parser("configure", help="Configure device")
     _add_config_args(config_parser, required=False)
 
@@ -279,6 +531,53 @@ def _add_config_args(parser: argparse.ArgumentParser, required: bool = False) ->
         metavar="N",
         help="Samples per packet (1-100)",
     )
+    parser.add_argument(
+        "--mode",
+        choices=[mode.name.lower() for mode in AcqMode],
+        help="Send raw samples, min/max/mean/RMS summaries, FFT spectra or pulses",
+    )
+    parser.add_argument(
+        "--summary-window",
+        type=int,
+        metavar="N",
+        help="Samples per summary in summary mode (1-65535)",
+    )
+    parser.add_argument(
+        "--fft-average",
+        type=int,
+        metavar="K",
+        help="FFT frames averaged per spectrum in spectrum mode (1-256)",
+    )
+    parser.add_argument(
+        "--decimation",
+        type=int,
+        metavar="R",
+        help="Low-pass filter and keep every R-th sample (1-64, 1 = off)",
+    )
+    parser.add_argument(
+        "--dead-time",
+        type=int,
+        metavar="N",
+        help="Samples ignored after each pulse in event mode (0-65535)",
+    )
+    parser.add_argument(
+        "--sample-rate",
+        type=int,
+        metavar="HZ",
+        help="ADC sample rate in Hz (1-20000, default 1000)",
+    )
+    parser.add_argument(
+        "--pace-bytes",
+        type=int,
+        metavar="BPS",
+        help="Limit data packets to this many bytes/s, 0 = off (default)",
+    )
+    parser.add_argument(
+        "--pace-packets",
+        type=int,
+        metavar="PPS",
+        help="Limit data packets to this many packets/s, 0 = off (default)",
+    )
     parser.add_argument(
         "--log-level",
         type=int,
@@ -286,6 +585,25 @@ def _add_config_args(parser: argparse.ArgumentParser, required: bool = False) ->
         metavar="LVL",
         help="Device log level: 0=DEBUG, 1=INFO, 2=WARNING, 3=ERROR, 4=CRITICAL, 5=NONE",
     )
+    parser.add_argument(
+        "--data-crc",
+        type=int,
+        choices=[0, 1],
+        metavar="0|1",
+        help="Append CRC32C trailer to data packets (verified by the client)",
+    )
+    parser.add_argument(
+        "--multicast",
+        type=IPv4Address,
+        metavar="GROUP",
+        help="Publish data to this multicast group (0.0.0.0 = unicast)",
+    )
+    parser.add_argument(
+        "--multicast-port",
+        type=int,
+        metavar="PORT",
+        help=f"Multicast UDP port (default: {DEFAULT_MCAST_PORT})",
+    )
     parser.add_argument(
         "--reset-sequence",
         action="store_true",
@@ -311,9 +629,13 @@ def main() -> int:
     try:
         handlers = {
             "start": cmd_start,
+            "listen": cmd_listen,
             "stop": cmd_stop,
             "status": cmd_status,
             "ping": cmd_ping,
+            "sync": cmd_sync,
+            "stats": cmd_stats,
+            "capture": cmd_capture,
             "configure": cmd_configure,
         }
 
@@ -3,25 +3,41 @@
 from __future__ import annotations
 
 import logging
+import select
 import socket
 import time
+from collections.abc import Iterable, Mapping
 from dataclasses import dataclass, field
 from ipaddress import IPv4Address
 
 from data_acquisition.protocol import (
+    CAPTURE_MAX_SAMPLES,
     HEADER_SIZE,
+    MAX_CONFIG_ENTRIES,
+    CapturePayload,
+    CaptureState,
     Command,
     ConfigParam,
     DataPayload,
+    EventPayload,
+    GapPayload,
     Header,
     LogLevel,
     MsgType,
     ProtocolBuilder,
+    SpectrumPayload,
     StatusPayload,
+    SummaryPayload,
+    SyncResponsePayload,
+    decode_telemetry,
 )
+from data_acquisition.timesync import ClockSync, SyncSample
 
 logger = logging.getLogger(__name__)
 
+SEQUENCE_REORDER_WINDOW = 64
+"""Largest step back in sequence numbers taken as a late packet, not a reset."""
+
 
 @dataclass
 class Statistics:
@@ -30,17 +46,78 @@ class Statistics:
     Attributes:
         packets_received (int): Number of data packets received
         samples_received (int): Number of samples received
+        events_received (int): Number of pulses received in event mode
         bytes_received (int): Number of bytes received
+        crc_errors (int): Number of data packets dropped on CRC mismatch
+        packets_lost (int): Packets missing from the device sequence numbers
+        outages (int): Link outages reported by the device
+        outage_dropped (int): Data packets the device dropped during outages
         start_time (float): Timestamp when acquisition started
+        latency_count (int): Packets with a measured latency
+        latency_sum_s (float): Sum of measured latencies in seconds
+        latency_min_s (float): Lowest measured latency in seconds
+        latency_max_s (float): Highest measured latency in seconds
+        last_sequence (int | None): Sequence number of the last packet
 
     Methods:
+        track_sequence: Count packets skipped before a sequence number
+        add_latency: Record the latency of one packet
         print_summary: Print statistics summary
     """
 
     packets_received: int = 0
     samples_received: int = 0
+    events_received: int = 0
     bytes_received: int = 0
+    crc_errors: int = 0
+    packets_lost: int = 0
+    outages: int = 0
+    outage_dropped: int = 0
     start_time: float = field(default_factory=time.time)
+    latency_count: int = 0
+    latency_sum_s: float = 0.0
+    latency_min_s: float = float("inf")
+    latency_max_s: float = 0.0
+    last_sequence: int | None = None
+
+    def track_sequence(self, sequence: int) -> None:
+        """Count packets skipped before a sequence number.
+
+        The device numbers all packets it sends from one counter, so the count
+        is only exact while this client is the only one talking to it.
+        Duplicates and counter resets are not counted as loss. A packet that
+        arrives late, for example a paced data packet overtaken by a reply from
+        the network task, was counted when it was skipped and is taken back.
+
+        Args:
+            sequence (int): Sequence number of a received packet
+
+        Returns: None
+        """
+        if self.last_sequence is not None:
+            gap = (sequence - self.last_sequence - 1) & 0xFFFF
+            if gap < 0x8000:
+                self.packets_lost += gap
+            else:
+                behind = (self.last_sequence - sequence) & 0xFFFF
+                if behind <= SEQUENCE_REORDER_WINDOW:
+                    if behind > 0 and self.packets_lost > 0:
+                        self.packets_lost -= 1
+                    return
+        self.last_sequence = sequence
+
+    def add_latency(self, latency_s: float) -> None:
+        """Record the latency of one packet.
+
+        Args:
+            latency_s (float): Time from the first sample to reception in seconds
+
+        Returns: None
+        """
+        self.latency_count += 1
+        self.latency_sum_s += latency_s
+        self.latency_min_s = min(self.latency_min_s, latency_s)
+        self.latency_max_s = max(self.latency_max_s, latency_s)
 
     def print_summary(self) -> None:
         """Print statistics summary.
@@ -58,8 +135,23 @@ class Statistics:
         logger.info(f"Duration:         {elapsed:.2f} s")
         logger.info(f"Packets received: {self.packets_received}")
         logger.info(f"Samples received: {self.samples_received}")
+        if self.events_received:
+            logger.info(f"Events received:  {self.events_received}")
         logger.info(f"Bytes received:   {self.bytes_received}")
+        logger.info(f"CRC errors:       {self.crc_errors}")
+        logger.info(f"Packets lost:     {self.packets_lost}")
+        if self.outages:
+            logger.info(
+                f"Link outages:     {self.outages} "
+                f"({self.outage_dropped} packets dropped)"
+            )
         logger.info(f"Sample rate:      {rate:.1f} samples/s")
+        if self.latency_count:
+            mean_ms = self.latency_sum_s / self.latency_count * 1e3
+            logger.info(
+                f"Latency:          {self.latency_min_s * 1e3:.2f} / {mean_ms:.2f} / "
+                f"{self.latency_max_s * 1e3:.2f} ms (min / mean / max)"
+            )
         logger.info("=" * 60)
 
 
@@ -71,6 +163,8 @@ class DataAcquisitionClient:
         port (int): Target UDP port
         verbose (bool): Enable verbose logging of received data decoding
         stats (Statistics): Session statistics
+        clock (ClockSync): Device clock estimator
+        sync_interval_s (float): Clock sync period during the receive loop
     """
 
     def __init__(
@@ -103,8 +197,11 @@ class DataAcquisitionClient:
         self._sock.bind((self.local_ip, 0))
         self._sock.settimeout(1.0)
 
+        self._mcast_sock: socket.socket | None = None
         self._builder = ProtocolBuilder()
         self.stats = Statistics()
+        self.clock = ClockSync()
+        self.sync_interval_s = 1.0
         self.running = False
 
         logger.info(
@@ -141,16 +238,58 @@ class DataAcquisitionClient:
             "Sent command: %s (param_type=%d, param=%d)", cmd.name, param_type, param
         )
 
-    def start_acquisition(self) -> None:
-        """Start data acquisition on the device.
+    def join_group(self, group: str, port: int) -> None:
+        """Receive data published by the device to a multicast group.
+
+        Any number of clients can join the same group; the device sends each
+        packet once no matter how many of them listen.
+
+        Args:
+            group (str): IPv4 multicast group address
+            port (int): UDP port the device publishes to
+
+        Returns: None
+        """
+        if not IPv4Address(group).is_multicast:
+            raise ValueError(f"{group} is not a multicast address")
+
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        if hasattr(socket, "SO_REUSEPORT"):
+            sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEPORT, 1)
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4 * 1024 * 1024)
+        sock.bind(("", port))
+
+        mreq = socket.inet_aton(group) + socket.inet_aton(self.local_ip)
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, mreq)
+
+        self._mcast_sock = sock
+        logger.info("Joined multicast group %s:%d", group, port)
+
+    def start_acquisition(self, channels: Iterable[int] | None = None) -> None:
+        """Subscribe to the data stream, starting acquisition if it is not running.
+
+        Several clients may subscribe at once; the device stops acquiring when the
+        last one sends STOP_ACQ or stops sending packets for the lease period.
+
+        Args:
+            channels (Iterable[int] | None): ADC channels to receive, None for all
 
         Return: None
         """
-        self.send_command(Command.START_ACQ)
+        mask = 0
+        for channel in channels or ():
+            if not 0 <= channel <= 7:
+                raise ValueError("Channel must be between 0 and 7")
+            mask |= 1 << channel
+
+        self.send_command(Command.START_ACQ, param=mask)
         logger.info("Sent START_ACQ command")
 
     def stop_acquisition(self) -> None:
-        """Stop data acquisition on the device.
+        """Unsubscribe from the data stream.
+
+        The device stops acquiring once no subscriber is left.
 
         Return: None
         """
@@ -181,6 +320,64 @@ class DataAcquisitionClient:
 
         return None
 
+    def get_telemetry(self) -> dict[int, int] | None:
+        """Request every device counter, stack watermark and the CPU load.
+
+        Returns:
+            dict[int, int] | None: Values by TelemetryId, None on timeout
+        """
+        self.send_command(Command.GET_TELEMETRY)
+        logger.debug("Sent GET_TELEMETRY command")
+
+        try:
+            data, _ = self._sock.recvfrom(2048)
+            header = Header.unpack(data)
+
+            if not header.is_valid():
+                logger.warning("Invalid magic in response")
+                return None
+
+            if header.msg_type == MsgType.TELEMETRY:
+                end = HEADER_SIZE + header.payload_len
+                return decode_telemetry(data[HEADER_SIZE:end])
+
+        except TimeoutError:
+            logger.warning("Telemetry request timed out")
+
+        return None
+
+    def configure(self, params: Mapping[ConfigParam, int]) -> None:
+        """Apply several configuration parameters.
+
+        Parameters are sent in packets of at most MAX_CONFIG_ENTRIES, in the
+        given order. The device validates each packet before applying any of
+        it, so a packet takes effect as a whole or not at all. Every packet is
+        built, and so range-checked, before the first one is sent.
+
+        Args:
+            params (Mapping[ConfigParam, int]): Parameters to set
+
+        Returns: None
+
+        Raises:
+            ValueError: If there are no parameters or a value is out of range
+        """
+        items = list(params.items())
+        if not items:
+            raise ValueError("At least one configuration parameter is required")
+
+        packets = [
+            self._builder.build_configure(dict(items[i : i + MAX_CONFIG_ENTRIES]))
+            for i in range(0, len(items), MAX_CONFIG_ENTRIES)
+        ]
+        for packet in packets:
+            self.send(packet)
+        time.sleep(0.1)  # Allow device to process command
+        logger.info(
+            "Configured: %s",
+            ", ".join(f"{param.name}={value}" for param, value in params.items()),
+        )
+
     def configure_threshold_percent(self, percent: int) -> None:
         """Set threshold as percentage.
 
@@ -283,6 +480,156 @@ class DataAcquisitionClient:
 
         return None
 
+    def _capture_request(self, cmd: Command, offset: int) -> CapturePayload | None:
+        """Send a capture command and wait for the capture packet answering it.
+
+        Other packets, e.g. streamed data, and capture packets for a different
+        offset (late replies to an earlier request) are skipped.
+
+        Args:
+            cmd (Command): CAPTURE or CAPTURE_READ
+            offset (int): Command parameter, the sample count for CAPTURE
+
+        Returns:
+            CapturePayload | None: Reply, None if none arrived within the socket
+            timeout
+        """
+        expected_offset = 0 if cmd == Command.CAPTURE else offset
+        self.send_command(cmd, 0, offset)
+        deadline = time.monotonic() + (self._sock.gettimeout() or 1.0)
+
+        while time.monotonic() < deadline:
+            try:
+                data, _ = self._sock.recvfrom(2048)
+            except TimeoutError:
+                break
+
+            header = Header.unpack(data)
+            if not header.is_valid() or header.msg_type != MsgType.CAPTURE:
+                continue
+            if not DataPayload.verify_crc(data):
+                self.stats.crc_errors += 1
+                continue
+
+            end = HEADER_SIZE + header.payload_len
+            reply = CapturePayload.unpack(data[HEADER_SIZE:end])
+            if reply.offset == expected_offset:
+                return reply
+
+        return None
+
+    def capture(
+        self, sample_count: int, timeout_s: float = 2.0, retries: int = 5
+    ) -> CapturePayload | None:
+        """Take a burst capture and read it back chunk by chunk.
+
+        The device samples at its maximum rate into RAM, so the capture is not
+        limited by the network. Chunks are requested one at a time and a lost
+        request or reply is retried, so no sample is lost on the way.
+
+        Args:
+            sample_count (int): Samples to capture (1 to CAPTURE_MAX_SAMPLES)
+            timeout_s (float): Longest wait for the capture to complete
+            retries (int): Attempts per chunk
+
+        Returns:
+            CapturePayload | None: Whole capture from offset 0, None on failure
+        """
+        if not 1 <= sample_count <= CAPTURE_MAX_SAMPLES:
+            raise ValueError(f"sample_count must be 1 to {CAPTURE_MAX_SAMPLES}")
+
+        for _ in range(retries):
+            reply = self._capture_request(Command.CAPTURE, sample_count)
+            if reply is not None:
+                break
+        else:
+            logger.error("Capture request timed out")
+            return None
+        if reply.state != CaptureState.RUNNING:
+            logger.error("Device refused the capture (state %s)", reply.state.name)
+            return None
+
+        deadline = time.monotonic() + timeout_s
+        first = None
+        while time.monotonic() < deadline:
+            first = self._capture_request(Command.CAPTURE_READ, 0)
+            if first is not None and first.state == CaptureState.DONE:
+                break
+            time.sleep(0.01)
+
+        if first is None or first.state != CaptureState.DONE:
+            logger.error("Capture did not complete within %.1f s", timeout_s)
+            return None
+        if first.total != sample_count:
+            logger.error("Device captured %d of %d samples", first.total, sample_count)
+            return None
+
+        samples = list(first.samples)
+        while len(samples) < first.total:
+            for _ in range(retries):
+                chunk = self._capture_request(Command.CAPTURE_READ, len(samples))
+                if chunk is not None and chunk.samples:
+                    break
+            else:
+                logger.error("Capture readout failed at sample %d", len(samples))
+                return None
+            samples.extend(chunk.samples)
+
+        if first.overruns:
+            logger.warning("Device lost %d conversions during capture", first.overruns)
+
+        first.samples = samples
+        return first
+
+    def _send_sync_request(self) -> None:
+        """Send a clock synchronization request stamped with the host time.
+
+        Returns: None
+        """
+        self.send(self._builder.build_sync_request(time.time_ns()))
+
+    def _handle_sync_response(self, data: bytes) -> None:
+        """Feed a clock synchronization response into the estimator.
+
+        Args:
+            data (bytes): Raw packet data
+
+        Returns: None
+        """
+        host_t4 = time.time()
+        payload = SyncResponsePayload.unpack(data[HEADER_SIZE:])
+        self.clock.add(
+            SyncSample(
+                host_t1=payload.host_t1 / 1e9,
+                device_t2=payload.device_rx_us,
+                device_t3=payload.device_tx_us,
+                host_t4=host_t4,
+            )
+        )
+
+    def sync_clock(self, count: int = 8, interval_s: float = 0.05) -> bool:
+        """Run several time exchanges to estimate the device clock.
+
+        Args:
+            count (int): Number of exchanges
+            interval_s (float): Pause between exchanges in seconds
+
+        Returns:
+            bool: True if at least one exchange completed
+        """
+        for _ in range(count):
+            self._send_sync_request()
+            try:
+                data, _ = self._sock.recvfrom(2048)
+                header = Header.unpack(data)
+                if header.is_valid() and header.msg_type == MsgType.SYNC_RESP:
+                    self._handle_sync_response(data)
+            except TimeoutError:
+                logger.warning("Sync request timed out")
+            time.sleep(interval_s)
+
+        return self.clock.ready
+
     def _handle_data_packet(self, data: bytes) -> None:
         """Process received data packet and log it to stdout.
 
@@ -291,6 +638,11 @@ class DataAcquisitionClient:
 
         Returns: None
         """
+        if not DataPayload.verify_crc(data):
+            self.stats.crc_errors += 1
+            logger.warning("Dropping data packet with bad CRC32C")
+            return
+
         header = Header.unpack(data)
         payload = DataPayload.unpack(data[HEADER_SIZE:])
 
@@ -298,10 +650,15 @@ class DataAcquisitionClient:
         self.stats.samples_received += len(payload.samples)
         self.stats.bytes_received += len(data)
 
-        ts = time.time()
+        if payload.timestamp_us is not None and self.clock.ready:
+            ts = self.clock.to_host(payload.timestamp_us)
+            self.stats.add_latency(time.time() - ts)
+        else:
+            ts = time.time()
+
         if payload.samples:
             line = f"{ts:.6f},{header.sequence},{payload.channel}," + ",".join(
-                str(s) for s in payload.samples
+                f"{v:g}" for v in payload.values()
             )
         else:
             line = f"{ts:.6f},{header.sequence},{payload.channel}"
@@ -315,6 +672,129 @@ class DataAcquisitionClient:
             len(payload.samples),
         )
 
+    def _handle_summary_packet(self, data: bytes) -> None:
+        """Process received summary packet and log it to stdout.
+
+        Args:
+            data (bytes): Raw packet data
+
+        Returns: None
+        """
+        if not DataPayload.verify_crc(data):
+            self.stats.crc_errors += 1
+            logger.warning("Dropping summary packet with bad CRC32C")
+            return
+
+        header = Header.unpack(data)
+        summary = SummaryPayload.unpack(data[HEADER_SIZE:])
+
+        self.stats.packets_received += 1
+        self.stats.samples_received += summary.sample_count
+        self.stats.bytes_received += len(data)
+
+        if self.clock.ready:
+            ts = self.clock.to_host(summary.timestamp_us)
+            self.stats.add_latency(time.time() - ts)
+        else:
+            ts = time.time()
+
+        logger.debug(
+            f"{ts:.6f},{header.sequence},{summary.channel},{summary.sample_count},"
+            f"{summary.min},{summary.max},{summary.mean:.4f},{summary.rms:.4f}"
+        )
+
+        logger.info(
+            "[%5d] CH%d: %d samples, min %d, max %d, mean %.2f, rms %.2f",
+            header.sequence,
+            summary.channel,
+            summary.sample_count,
+            summary.min,
+            summary.max,
+            summary.mean,
+            summary.rms,
+        )
+
+    def _handle_spectrum_packet(self, data: bytes) -> None:
+        """Process received spectrum packet and log it to stdout.
+
+        Args:
+            data (bytes): Raw packet data
+
+        Returns: None
+        """
+        if not DataPayload.verify_crc(data):
+            self.stats.crc_errors += 1
+            logger.warning("Dropping spectrum packet with bad CRC32C")
+            return
+
+        header = Header.unpack(data)
+        spectrum = SpectrumPayload.unpack(data[HEADER_SIZE:])
+
+        self.stats.packets_received += 1
+        self.stats.samples_received += spectrum.frame_count * spectrum.fft_size
+        self.stats.bytes_received += len(data)
+
+        if self.clock.ready:
+            ts = self.clock.to_host(spectrum.timestamp_us)
+            self.stats.add_latency(time.time() - ts)
+        else:
+            ts = time.time()
+
+        logger.debug(
+            f"{ts:.6f},{header.sequence},{spectrum.channel},{spectrum.frame_count},"
+            + ",".join(str(b) for b in spectrum.bins)
+        )
+
+        if len(spectrum.bins) > 1:
+            peak = max(range(1, len(spectrum.bins)), key=spectrum.bins.__getitem__)
+            logger.info(
+                "[%5d] CH%d: %d frames, peak bin %d/%d, amplitude %.1f",
+                header.sequence,
+                spectrum.channel,
+                spectrum.frame_count,
+                peak,
+                spectrum.fft_size,
+                spectrum.amplitudes()[peak],
+            )
+
+    def _handle_event_packet(self, data: bytes) -> None:
+        """Process received event packet and log one line per pulse.
+
+        Args:
+            data (bytes): Raw packet data
+
+        Returns: None
+        """
+        if not DataPayload.verify_crc(data):
+            self.stats.crc_errors += 1
+            logger.warning("Dropping event packet with bad CRC32C")
+            return
+
+        header = Header.unpack(data)
+        payload = EventPayload.unpack(data[HEADER_SIZE:])
+
+        self.stats.packets_received += 1
+        self.stats.events_received += len(payload.events)
+        self.stats.bytes_received += len(data)
+
+        for event in payload.events:
+            if self.clock.ready:
+                ts = self.clock.to_host(event.timestamp_us)
+            else:
+                ts = time.time()
+            logger.debug(
+                f"{ts:.6f},{header.sequence},{payload.channel},"
+                f"{event.peak},{event.width},{event.area}"
+            )
+
+        logger.info(
+            "[%5d] CH%d: %d events, highest peak %d",
+            header.sequence,
+            payload.channel,
+            len(payload.events),
+            max((e.peak for e in payload.events), default=0),
+        )
+
     def receive_loop(
         self,
         *,
@@ -336,6 +816,10 @@ class DataAcquisitionClient:
         """
         self.running = True
         start_t = time.monotonic()
+        next_sync = start_t
+        socks = [self._sock]
+        if self._mcast_sock is not None:
+            socks.append(self._mcast_sock)
         deadline = (start_t + duration_s) if duration_s is not None else None
 
         if duration_s is not None:
@@ -358,33 +842,14 @@ class DataAcquisitionClient:
                     logger.info("Reached sample limit, stopping receive loop")
                     break
 
-                data, addr = self._sock.recvfrom(2048)
-
-                if len(data) < HEADER_SIZE:
-                    continue
+                if time.monotonic() >= next_sync:
+                    self._send_sync_request()
+                    next_sync += self.sync_interval_s
 
-                header = Header.unpack(data)
-
-                if not header.is_valid():
-                    logger.warning("Invalid magic from %s", addr)
-                    continue
-
-                if header.msg_type == MsgType.DATA:
-                    self._handle_data_packet(data)
-
-                elif header.msg_type == MsgType.PONG:
-                    logger.debug("Received PONG")
-
-                elif header.msg_type == MsgType.STATUS:
-                    status = StatusPayload.unpack(data[HEADER_SIZE:])
-                    logger.info(
-                        "Status: acquiring=%s, ch=%d, thresh=%dmV, uptime=%ds, samples=%d",
-                        status.acquiring,
-                        status.channel,
-                        status.threshold_mv,
-                        status.uptime,
-                        status.samples_sent,
-                    )
+                readable, _, _ = select.select(socks, [], [], 1.0)
+                for sock in readable:
+                    data, addr = sock.recvfrom(2048)
+                    self._handle_packet(data, addr)
 
             except TimeoutError:
                 continue
@@ -393,6 +858,68 @@ class DataAcquisitionClient:
 
         self.running = False
 
+    def _handle_packet(self, data: bytes, addr: tuple[str, int]) -> None:
+        """Dispatch a packet received in the receive loop.
+
+        Args:
+            data (bytes): Raw packet data
+            addr (tuple[str, int]): Sender address
+
+        Returns: None
+        """
+        if len(data) < HEADER_SIZE:
+            return
+
+        header = Header.unpack(data)
+
+        if not header.is_valid():
+            logger.warning("Invalid magic from %s", addr)
+            return
+
+        self.stats.track_sequence(header.sequence)
+
+        if header.msg_type == MsgType.DATA:
+            self._handle_data_packet(data)
+
+        elif header.msg_type == MsgType.SUMMARY:
+            self._handle_summary_packet(data)
+
+        elif header.msg_type == MsgType.SPECTRUM:
+            self._handle_spectrum_packet(data)
+
+        elif header.msg_type == MsgType.EVENT:
+            self._handle_event_packet(data)
+
+        elif header.msg_type == MsgType.GAP:
+            gap = GapPayload.unpack(data[HEADER_SIZE:])
+            self.stats.outages += 1
+            self.stats.outage_dropped += gap.dropped
+            logger.warning(
+                "Device link was down for %d ms: %d packets held, %d dropped",
+                gap.outage_ms,
+                gap.held,
+                gap.dropped,
+            )
+
+        elif header.msg_type == MsgType.SYNC_RESP:
+            self._handle_sync_response(data)
+
+        elif header.msg_type == MsgType.PONG:
+            logger.debug("Received PONG")
+
+        elif header.msg_type == MsgType.STATUS:
+            status = StatusPayload.unpack(data[HEADER_SIZE:])
+            logger.info(
+                "Status: acquiring=%s, ch=%d, thresh=%dmV, uptime=%ds, samples=%d, "
+                "rate=%sHz",
+                status.acquiring,
+                status.channel,
+                status.threshold_mv,
+                status.uptime,
+                status.samples_sent,
+                status.sample_rate_hz,
+            )
+
     def stop(self) -> None:
         """Signal the receive loop to stop.
 
@@ -405,5 +932,7 @@ class DataAcquisitionClient:
 
         Returns: None
         """
+        if self._mcast_sock is not None:
+            self._mcast_sock.close()
         self._sock.close()
         self.stats.print_summary()
@@ -8,11 +8,73 @@ structures that must match the C implementation in protocol.h.
 from __future__ import annotations
 
 import struct
+from collections.abc import Mapping
 from dataclasses import dataclass, field
 from enum import IntEnum
 
 PROTOCOL_MAGIC = 0xDA7A
 HEADER_SIZE = 7
+MAX_CONFIG_ENTRIES = 8
+DATA_FLAG_CRC32C = 0x01
+DATA_FLAG_TIMESTAMP = 0x02
+DATA_FLAG_FRAC4 = 0x04
+DATA_FRAC_BITS = 4
+"""Fractional bits of the samples of a data packet with DATA_FLAG_FRAC4."""
+CRC32C_SIZE = 4
+TIMESTAMP_SIZE = 8
+DEFAULT_MCAST_PORT = 5001
+SUMMARY_FRAC_BITS = 4
+SPECTRUM_BIN_PER_COUNT = 4
+"""Spectrum bin value of a sine with an amplitude of one ADC count (k > 0)."""
+CAPTURE_MAX_SAMPLES = 2048
+CAPTURE_CHUNK_SAMPLES = 512
+
+try:
+    # Optional native implementation (SSE4.2 / ARMv8 CRC instructions)
+    from crc32c import crc32c as _crc32c_native  # type: ignore[import-not-found]
+except ImportError:
+    _crc32c_native = None
+
+
+def _make_crc32c_table() -> list[int]:
+    """Build the byte-wise lookup table for the reflected CRC32C polynomial.
+
+    Returns:
+        list[int]: 256-entry lookup table
+    """
+    table = []
+    for i in range(256):
+        crc = i
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x82F63B78 if crc & 1 else crc >> 1
+        table.append(crc)
+    return table
+
+
+_CRC32C_TABLE = _make_crc32c_table()
+
+
+def crc32c(data: bytes, crc: int = 0) -> int:
+    """Compute CRC32C (Castagnoli) checksum, matching crc32c.c on the device.
+
+    Uses the native ``crc32c`` package when installed, otherwise falls back to
+    a pure Python table-driven implementation.
+
+    Args:
+        data (bytes): Data to checksum
+        crc (int): Previous checksum, 0 for the first block
+
+    Returns:
+        int: Updated checksum
+    """
+    if _crc32c_native is not None:
+        return int(_crc32c_native(data, crc))
+
+    crc ^= 0xFFFFFFFF
+    table = _CRC32C_TABLE
+    for byte in data:
+        crc = table[(crc ^ byte) & 0xFF] ^ (crc >> 8)
+    return crc ^ 0xFFFFFFFF
 
 
 class MsgType(IntEnum):
@@ -20,9 +82,18 @@ class MsgType(IntEnum):
 
     PING = 0x01
     PONG = 0x02
+    SYNC_REQ = 0x03
+    SYNC_RESP = 0x04
     DATA = 0x10
+    SUMMARY = 0x11
+    SPECTRUM = 0x12
+    EVENT = 0x13
+    CAPTURE = 0x14
+    GAP = 0x15
     CMD = 0x20
+    CONFIG = 0x21
     STATUS = 0x30
+    TELEMETRY = 0x31
 
 
 class Command(IntEnum):
@@ -32,6 +103,9 @@ class Command(IntEnum):
     STOP_ACQ = 0x02
     GET_STATUS = 0x03
     CONFIGURE = 0x04
+    GET_TELEMETRY = 0x05
+    CAPTURE = 0x06
+    CAPTURE_READ = 0x07
 
 
 class ConfigParam(IntEnum):
@@ -43,6 +117,162 @@ class ConfigParam(IntEnum):
     CHANNEL = 3
     RESET_SEQUENCE = 4
     LOG_LEVEL = 5
+    DATA_CRC = 6
+    MCAST_GROUP = 7
+    MCAST_PORT = 8
+    ACQ_MODE = 9
+    SUMMARY_WINDOW = 10
+    SPECTRUM_AVERAGE = 11
+    DECIMATION = 12
+    EVENT_DEAD_TIME = 13
+    SAMPLE_RATE_HZ = 14
+    PACE_BYTES_PER_S = 15
+    PACE_PACKETS_PER_S = 16
+
+
+class AcqMode(IntEnum):
+    """Acquisition modes (acquisition_mode_t)."""
+
+    RAW = 0
+    SUMMARY = 1
+    SPECTRUM = 2
+    EVENT = 3
+
+
+CONFIG_RANGES: dict[ConfigParam, tuple[int, int]] = {
+    ConfigParam.THRESHOLD_PERCENT: (0, 100),
+    ConfigParam.THRESHOLD_MV: (0, 3300),
+    ConfigParam.BATCH_SIZE: (1, 100),
+    ConfigParam.CHANNEL: (0, 7),
+    ConfigParam.RESET_SEQUENCE: (0, 0xFFFFFFFF),
+    ConfigParam.LOG_LEVEL: (0, 5),
+    ConfigParam.DATA_CRC: (0, 1),
+    ConfigParam.MCAST_GROUP: (0, 0xEFFFFFFF),
+    ConfigParam.MCAST_PORT: (1, 0xFFFF),
+    ConfigParam.ACQ_MODE: (0, 3),
+    ConfigParam.SUMMARY_WINDOW: (1, 0xFFFF),
+    ConfigParam.SPECTRUM_AVERAGE: (1, 256),
+    ConfigParam.DECIMATION: (1, 64),
+    ConfigParam.EVENT_DEAD_TIME: (0, 0xFFFF),
+    ConfigParam.SAMPLE_RATE_HZ: (1, 20000),
+    ConfigParam.PACE_BYTES_PER_S: (0, 12500000),
+    ConfigParam.PACE_PACKETS_PER_S: (0, 100000),
+}
+"""Accepted value range per configuration parameter (must match protocol.c)."""
+
+
+class TelemetryId(IntEnum):
+    """Telemetry entry identifiers (protocol_telemetry_id_t)."""
+
+    UPTIME_MS = 0x01
+    CPU_LOAD = 0x02
+    ACQ_SAMPLES = 0x10
+    ACQ_SAMPLES_SENT = 0x11
+    ACQ_PACKETS_SENT = 0x12
+    ACQ_ERRORS = 0x13
+    ACQ_ADC_OVERRUNS = 0x14
+    NET_PACKETS_SENT = 0x20
+    NET_PACKETS_RECV = 0x21
+    NET_BYTES_SENT = 0x22
+    NET_BYTES_RECV = 0x23
+    NET_ERRORS = 0x24
+    NET_SUBSCRIBERS = 0x25
+    NET_PACED = 0x26
+    NET_PACED_MS = 0x27
+    NET_OUTAGES = 0x28
+    NET_HELD = 0x29
+    NET_HELD_DROPPED = 0x2A
+    NET_ARP_RESOLVE_US = 0x2B
+    NET_ARP_FAILED = 0x2C
+    SOCK_RX_DROPPED = 0x30
+    SOCK_RX_QUEUED = 0x31
+    SOCK_RX_QUEUE_SIZE = 0x32
+    SOCK_TX_POOL_SIZE = 0x33
+    SOCK_TX_POOL_USED = 0x34
+    SOCK_TX_POOL_PEAK = 0x35
+    SOCK_TX_REFUSED = 0x36
+    SOCK_RX_REJECTED = 0x37
+    LOG_MESSAGES = 0x40
+    LOG_DROPPED = 0x41
+    LOG_TRUNCATED = 0x42
+    LOG_BYTES = 0x43
+    STACK_NETWORK = 0x50
+    STACK_ACQUISITION = 0x51
+    STACK_IDLE = 0x52
+    STACK_TIMER = 0x53
+    BOOT_LOGGER = 0x60
+    BOOT_NET_STACK = 0x61
+    BOOT_KERNEL = 0x62
+    BOOT_LINK_UP = 0x63
+    BOOT_NET_READY = 0x64
+    BOOT_FIRST_SAMPLE = 0x65
+    BOOT_FIRST_SEND = 0x66
+
+
+TELEMETRY_GAUGES = frozenset(
+    {
+        TelemetryId.UPTIME_MS,
+        TelemetryId.CPU_LOAD,
+        TelemetryId.NET_SUBSCRIBERS,
+        TelemetryId.NET_ARP_RESOLVE_US,
+        TelemetryId.SOCK_RX_QUEUED,
+        TelemetryId.SOCK_RX_QUEUE_SIZE,
+        TelemetryId.SOCK_TX_POOL_SIZE,
+        TelemetryId.SOCK_TX_POOL_USED,
+        TelemetryId.SOCK_TX_POOL_PEAK,
+        TelemetryId.STACK_NETWORK,
+        TelemetryId.STACK_ACQUISITION,
+        TelemetryId.STACK_IDLE,
+        TelemetryId.STACK_TIMER,
+        TelemetryId.BOOT_LOGGER,
+        TelemetryId.BOOT_NET_STACK,
+        TelemetryId.BOOT_KERNEL,
+        TelemetryId.BOOT_LINK_UP,
+        TelemetryId.BOOT_NET_READY,
+        TelemetryId.BOOT_FIRST_SAMPLE,
+        TelemetryId.BOOT_FIRST_SEND,
+    }
+)
+"""Telemetry entries that are levels rather than monotonic counters."""
+
+
+def decode_telemetry(payload: bytes) -> dict[int, int]:
+    """Decode a telemetry payload of ID byte + LEB128 value entries.
+
+    Args:
+        payload (bytes): Telemetry packet payload
+
+    Returns:
+        dict[int, int]: Values by entry ID, known IDs as TelemetryId
+
+    Raises:
+        ValueError: If the payload ends inside an entry
+    """
+    values: dict[int, int] = {}
+    offset = 0
+
+    while offset < len(payload):
+        entry_id = payload[offset]
+        offset += 1
+
+        value = 0
+        shift = 0
+        while True:
+            if offset >= len(payload):
+                raise ValueError("Truncated telemetry entry")
+            byte = payload[offset]
+            offset += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+
+        try:
+            values[TelemetryId(entry_id)] = value
+        except ValueError:
+            values[entry_id] = value
+
+    return values
 
 
 class LogLevel(IntEnum):
@@ -120,16 +350,27 @@ class DataPayload:
 
     Format (little-endian):
         +-------------+-------------+-----------------+-----------------+
-        |CHANNEL (1B) |RESERVED (1B)|SAMPLE_CNT (2B)  | samples[]...    |
+        |CHANNEL (1B) | FLAGS (1B)  |SAMPLE_CNT (2B)  | samples[]...    |
         +-------------+-------------+-----------------+-----------------+
 
+    Optional trailers follow the samples in this order:
+    - DATA_FLAG_TIMESTAMP: 8-byte device time of the first sample in microseconds
+    - DATA_FLAG_CRC32C: 4-byte CRC32C of the header and payload (see verify_crc())
+
+    With DATA_FLAG_FRAC4 the samples are decimator outputs with DATA_FRAC_BITS
+    fractional bits (see values()).
+
     Attributes:
         channel: ADC channel number (0-7)
         samples: List of acquired samples (16-bit unsigned integers)
+        flags: Data flags (DATA_FLAG_*)
+        timestamp_us: Device time of the first sample, None if not sent
     """
 
     channel: int
     samples: list[int] = field(default_factory=list)
+    flags: int = 0
+    timestamp_us: int | None = None
 
     @classmethod
     def unpack(cls, data: bytes) -> DataPayload:
@@ -141,24 +382,372 @@ class DataPayload:
         Returns:
             DataPayload: Unpacked data payload object
         """
-        channel, _, sample_count = struct.unpack("<BBH", data[:4])
-        samples = list(
-            struct.unpack(f"<{sample_count}H", data[4 : 4 + sample_count * 2])
+        channel, flags, sample_count = struct.unpack("<BBH", data[:4])
+        end = 4 + sample_count * 2
+        samples = list(struct.unpack(f"<{sample_count}H", data[4:end]))
+
+        timestamp_us = None
+        if flags & DATA_FLAG_TIMESTAMP:
+            (timestamp_us,) = struct.unpack("<Q", data[end : end + TIMESTAMP_SIZE])
+
+        return cls(channel, samples, flags, timestamp_us)
+
+    def values(self) -> list[float]:
+        """Convert the samples to ADC counts.
+
+        Returns:
+            list[float]: Samples in ADC counts, fractional if DATA_FLAG_FRAC4 is set
+        """
+        if not self.flags & DATA_FLAG_FRAC4:
+            return [float(s) for s in self.samples]
+        scale = 1 << DATA_FRAC_BITS
+        return [s / scale for s in self.samples]
+
+    @staticmethod
+    def verify_crc(packet: bytes) -> bool:
+        """Verify the CRC32C trailer of a complete data packet.
+
+        Packets without DATA_FLAG_CRC32C are accepted as-is.
+
+        Args:
+            packet (bytes): Complete packet including header
+
+        Returns:
+            bool: False if the trailer is present and does not match
+        """
+        if len(packet) < HEADER_SIZE + 4:
+            return False
+        if not packet[HEADER_SIZE + 1] & DATA_FLAG_CRC32C:
+            return True
+
+        header = Header.unpack(packet)
+        end = HEADER_SIZE + header.payload_len
+        if end > len(packet) or header.payload_len < 4 + CRC32C_SIZE:
+            return False
+
+        (expected,) = struct.unpack("<I", packet[end - CRC32C_SIZE : end])
+        return crc32c(packet[: end - CRC32C_SIZE]) == expected
+
+
+@dataclass
+class SummaryPayload:
+    """
+    Statistics of one window of samples (20 bytes + optional CRC32C trailer).
+
+    Format (little-endian):
+        +-------------+-------------+-----------------+-----------------+
+        |CHANNEL (1B) | FLAGS (1B)  |SAMPLE_CNT (2B)  |    MIN (2B)     |
+        +-------------+-------------+-----------------+-----------------+
+        |   MAX (2B)  |  MEAN (2B)  |    RMS (2B)     |TIMESTAMP_US (8B)|
+        +-------------+-------------+-----------------+-----------------+
+
+    MEAN and RMS are ADC counts with SUMMARY_FRAC_BITS fractional bits. The
+    CRC32C trailer is checked with DataPayload.verify_crc().
+
+    Attributes:
+        channel: ADC channel number (0-7)
+        flags: Data flags (DATA_FLAG_*)
+        sample_count: Number of samples in the window
+        min: Smallest sample
+        max: Largest sample
+        mean: Mean in ADC counts
+        rms: Root mean square in ADC counts
+        timestamp_us: Device time of the first sample in the window
+    """
+
+    channel: int
+    flags: int
+    sample_count: int
+    min: int
+    max: int
+    mean: float
+    rms: float
+    timestamp_us: int
+
+    FORMAT = "<BBHHHHHQ"
+    SIZE = struct.calcsize(FORMAT)
+
+    @classmethod
+    def unpack(cls, data: bytes) -> SummaryPayload:
+        """Unpack summary payload from bytes.
+
+        Args:
+            data (bytes): Raw bytes containing the summary payload
+
+        Returns:
+            SummaryPayload: Unpacked summary payload object
+        """
+        ch, flags, count, lo, hi, mean, rms, ts = struct.unpack(
+            cls.FORMAT, data[: cls.SIZE]
+        )
+        scale = 1 << SUMMARY_FRAC_BITS
+        return cls(ch, flags, count, lo, hi, mean / scale, rms / scale, ts)
+
+
+@dataclass
+class SpectrumPayload:
+    """
+    Averaged FFT magnitudes (16-byte header + 2 bytes per bin + optional CRC32C).
+
+    Format (little-endian):
+        +-------------+-------------+-----------------+-----------------+
+        |CHANNEL (1B) | FLAGS (1B)  |  FFT_SIZE (2B)  |   FRAMES (2B)   |
+        +-------------+-------------+-----------------+-----------------+
+        |BIN_COUNT(2B)|        TIMESTAMP_US (8B)      |   bins[]...     |
+        +-------------+-------------+-----------------+-----------------+
+
+    Each frame is Hann-windowed before the transform. Bin k covers
+    k * sample_rate / fft_size; a sine of amplitude A ADC counts centered on a
+    bin reads A * SPECTRUM_BIN_PER_COUNT, and bin 0 reads 8 times the distance
+    of the mean from mid-scale (2048).
+
+    Attributes:
+        channel: ADC channel number (0-7)
+        flags: Data flags (DATA_FLAG_*)
+        fft_size: Samples per FFT frame
+        frame_count: Frames averaged into the bins
+        timestamp_us: Device time of the first sample of the first frame
+        bins: Magnitude per bin
+    """
+
+    channel: int
+    flags: int
+    fft_size: int
+    frame_count: int
+    timestamp_us: int
+    bins: list[int] = field(default_factory=list)
+
+    FORMAT = "<BBHHHQ"
+    SIZE = struct.calcsize(FORMAT)
+
+    @classmethod
+    def unpack(cls, data: bytes) -> SpectrumPayload:
+        """Unpack spectrum payload from bytes.
+
+        Args:
+            data (bytes): Raw bytes containing the spectrum payload
+
+        Returns:
+            SpectrumPayload: Unpacked spectrum payload object
+        """
+        ch, flags, fft_size, frames, bin_count, ts = struct.unpack(
+            cls.FORMAT, data[: cls.SIZE]
+        )
+        end = cls.SIZE + bin_count * 2
+        bins = list(struct.unpack(f"<{bin_count}H", data[cls.SIZE : end]))
+        return cls(ch, flags, fft_size, frames, ts, bins)
+
+    def amplitudes(self) -> list[float]:
+        """Convert the bins to sine amplitudes in ADC counts.
+
+        Returns:
+            list[float]: Amplitude per bin, bin 0 as the offset from mid-scale
+        """
+        return [self.bins[0] / (2 * SPECTRUM_BIN_PER_COUNT)] + [
+            b / SPECTRUM_BIN_PER_COUNT for b in self.bins[1:]
+        ]
+
+
+@dataclass
+class Event:
+    """One pulse detected above the threshold.
+
+    Attributes:
+        timestamp_us: Device time of the first sample above threshold
+        peak: Largest sample of the pulse in ADC counts
+        width: Samples above threshold
+        area: Sum of (sample - threshold) over the pulse
+    """
+
+    timestamp_us: int
+    peak: int
+    width: int
+    area: int
+
+
+@dataclass
+class EventPayload:
+    """
+    Detected pulses (12-byte header + 12 bytes per event + optional CRC32C).
+
+    Format (little-endian):
+        +-------------+-------------+-----------------+-----------------+
+        |CHANNEL (1B) | FLAGS (1B)  |EVENT_CNT (2B)   |TIMESTAMP_US (8B)|
+        +-------------+-------------+-----------------+-----------------+
+        |OFFSET_US(4B)|  PEAK (2B)  |   WIDTH (2B)    |    AREA (4B)    | ...
+        +-------------+-------------+-----------------+-----------------+
+
+    OFFSET_US of each event is relative to TIMESTAMP_US; unpack() resolves it
+    to the absolute device time.
+
+    Attributes:
+        channel: ADC channel number (0-7)
+        flags: Data flags (DATA_FLAG_*)
+        timestamp_us: Device time of the first pulse start
+        events: Detected pulses, oldest first
+    """
+
+    channel: int
+    flags: int
+    timestamp_us: int
+    events: list[Event] = field(default_factory=list)
+
+    FORMAT = "<BBHQ"
+    SIZE = struct.calcsize(FORMAT)
+    EVENT_FORMAT = "<IHHI"
+    EVENT_SIZE = struct.calcsize(EVENT_FORMAT)
+
+    @classmethod
+    def unpack(cls, data: bytes) -> EventPayload:
+        """Unpack event payload from bytes.
+
+        Args:
+            data (bytes): Raw bytes containing the event payload
+
+        Returns:
+            EventPayload: Unpacked event payload object
+        """
+        ch, flags, count, ts = struct.unpack(cls.FORMAT, data[: cls.SIZE])
+        events = []
+        for i in range(count):
+            start = cls.SIZE + i * cls.EVENT_SIZE
+            offset, peak, width, area = struct.unpack(
+                cls.EVENT_FORMAT, data[start : start + cls.EVENT_SIZE]
+            )
+            events.append(Event(ts + offset, peak, width, area))
+        return cls(ch, flags, ts, events)
+
+
+class CaptureState(IntEnum):
+    """Burst capture states (acquisition_capture_state_t)."""
+
+    IDLE = 0
+    RUNNING = 1
+    DONE = 2
+
+
+@dataclass
+class CapturePayload:
+    """
+    Burst capture state and one chunk of its samples (22-byte header).
+
+    Format (little-endian):
+        +-------------+-------------+-------------+-------------+-------------+
+        |CHANNEL (1B) | FLAGS (1B)  | STATE (1B)  |OVERRUNS (1B)| TOTAL (2B)  |
+        +-------------+-------------+-------------+-------------+-------------+
+        | OFFSET (2B) |SAMPLE_CNT(2B| SAMPLE_RATE (4B, mHz)     |TIMESTAMP(8B)|
+        +-------------+-------------+---------------------------+-------------+
+
+    Samples offset to offset + sample_count - 1 follow, then the optional
+    CRC32C trailer.
+
+    Attributes:
+        channel: ADC channel number (0-7)
+        flags: Data flags (DATA_FLAG_*)
+        state: Capture state
+        overruns: Conversions lost during the capture
+        total: Samples in the whole capture
+        offset: Index of the first sample of this chunk
+        sample_rate_hz: Capture sample rate in Hz
+        timestamp_us: Device time of the first captured sample
+        samples: Samples of this chunk
+    """
+
+    channel: int
+    flags: int
+    state: CaptureState
+    overruns: int
+    total: int
+    offset: int
+    sample_rate_hz: float
+    timestamp_us: int
+    samples: list[int] = field(default_factory=list)
+
+    FORMAT = "<BBBBHHHIQ"
+    SIZE = struct.calcsize(FORMAT)
+
+    @classmethod
+    def unpack(cls, data: bytes) -> CapturePayload:
+        """Unpack capture payload from bytes.
+
+        Args:
+            data (bytes): Raw bytes containing the capture payload
+
+        Returns:
+            CapturePayload: Unpacked capture payload object
+        """
+        ch, flags, state, overruns, total, offset, count, rate, ts = struct.unpack(
+            cls.FORMAT, data[: cls.SIZE]
+        )
+        end = cls.SIZE + count * 2
+        samples = list(struct.unpack(f"<{count}H", data[cls.SIZE : end]))
+        return cls(
+            ch,
+            flags,
+            CaptureState(state),
+            overruns,
+            total,
+            offset,
+            rate / 1000.0,
+            ts,
+            samples,
         )
-        return cls(channel, samples)
+
+
+@dataclass
+class GapPayload:
+    """
+    Stream gap marker sent after a link outage (20 bytes).
+
+    Format (little-endian):
+        +---------------+-------------+---------------+-----------------+
+        | OUTAGE_MS (4B)|  HELD (4B)  | DROPPED (4B)  | TIMESTAMP (8B)  |
+        +---------------+-------------+---------------+-----------------+
+
+    The held packets arrive just before the marker with their original sequence
+    numbers. The dropped ones never arrive and show up as missing numbers.
+
+    Attributes:
+        outage_ms: Time from the first held packet to the resume in milliseconds
+        held: Data packets held on the device and sent after the outage
+        dropped: Data packets dropped because the device backlog was full
+        timestamp_us: Device time when the first packet was held
+    """
+
+    outage_ms: int
+    held: int
+    dropped: int
+    timestamp_us: int
+
+    FORMAT = "<IIIQ"
+    SIZE = struct.calcsize(FORMAT)
+
+    @classmethod
+    def unpack(cls, data: bytes) -> GapPayload:
+        """Unpack gap payload from bytes.
+
+        Args:
+            data (bytes): Raw bytes containing the gap payload
+
+        Returns:
+            GapPayload: Unpacked gap payload object
+        """
+        return cls(*struct.unpack(cls.FORMAT, data[: cls.SIZE]))
 
 
 @dataclass
 class StatusPayload:
     """
-    Status response payload (12 bytes).
+    Status response payload (16 bytes).
 
     Format (little-endian):
         +------------+------------+-----------------+-----------------+
         |  ACQ (1B)  |   CH (1B)  | THRESH_MV (2B)  |   UPTIME (4B)   |
         +------------+------------+-----------------+-----------------+
-        |      SAMPLES_SENT (4B)            |
-        +--------+--------+--------+--------+
+        |      SAMPLES_SENT (4B)            |  SAMPLE_RATE (4B, mHz)  |
+        +--------+--------+--------+--------+-------------------------+
+
+    Firmware older than CONFIG_SAMPLE_RATE_HZ sends only the first 12 bytes.
 
     Attributes:
         acquiring: Whether acquisition is currently active
@@ -166,6 +755,7 @@ class StatusPayload:
         threshold_mv: Configured threshold in millivolts
         uptime: Device uptime in seconds
         samples_sent: Total number of samples sent to host
+        sample_rate_hz: Achieved ADC sample rate, None if not reported
     """
 
     acquiring: bool
@@ -173,8 +763,10 @@ class StatusPayload:
     threshold_mv: int
     uptime: int
     samples_sent: int
+    sample_rate_hz: float | None = None
 
     FORMAT = "<BBHII"
+    RATE_FORMAT = "<I"
 
     @classmethod
     def unpack(cls, data: bytes) -> StatusPayload:
@@ -187,7 +779,47 @@ class StatusPayload:
             StatusPayload: Unpacked status payload object
         """
         acq, ch, thresh, uptime, samples = struct.unpack(cls.FORMAT, data[:12])
-        return cls(bool(acq), ch, thresh, uptime, samples)
+        rate = None
+        if len(data) >= 16:
+            (rate_mhz,) = struct.unpack(cls.RATE_FORMAT, data[12:16])
+            rate = rate_mhz / 1000
+        return cls(bool(acq), ch, thresh, uptime, samples, rate)
+
+
+@dataclass
+class SyncResponsePayload:
+    """
+    Clock synchronization response payload (24 bytes).
+
+    Format (little-endian):
+        +-----------------+-------------------+-------------------+
+        |  HOST_T1 (8B)   | DEVICE_RX_US (8B) | DEVICE_TX_US (8B) |
+        +-----------------+-------------------+-------------------+
+
+    Attributes:
+        host_t1: Host send time echoed from the request (ns)
+        device_rx_us: Device time when the request arrived (us)
+        device_tx_us: Device time when the response left (us)
+    """
+
+    host_t1: int
+    device_rx_us: int
+    device_tx_us: int
+
+    FORMAT = "<QQQ"
+
+    @classmethod
+    def unpack(cls, data: bytes) -> SyncResponsePayload:
+        """Unpack sync response payload from bytes.
+
+        Args:
+            data (bytes): Raw bytes containing the sync response payload
+
+        Returns:
+            SyncResponsePayload: Unpacked sync response object
+        """
+        host_t1, rx_us, tx_us = struct.unpack(cls.FORMAT, data[:24])
+        return cls(host_t1, rx_us, tx_us)
 
 
 class ProtocolBuilder:
@@ -227,6 +859,67 @@ class ProtocolBuilder:
         )
         return header.pack() + payload
 
+    def build_configure(self, params: Mapping[ConfigParam, int]) -> bytes:
+        """
+        Build a multi-parameter TLV configuration packet.
+
+        Each entry is encoded as PARAM_TYPE (1B), LEN (1B) and a little-endian
+        value of LEN bytes. The device validates the whole packet before
+        applying any parameter.
+
+        Args:
+            params (Mapping[ConfigParam, int]): Parameters to set
+
+        Returns:
+            bytes: Complete packet bytes
+
+        Raises:
+            ValueError: If the packet is empty, too long or a value is out of range
+        """
+        if not params:
+            raise ValueError("At least one configuration parameter is required")
+        if len(params) > MAX_CONFIG_ENTRIES:
+            raise ValueError(
+                f"At most {MAX_CONFIG_ENTRIES} parameters fit in one packet"
+            )
+
+        payload = bytearray()
+        for param, value in params.items():
+            low, high = CONFIG_RANGES[param]
+            if not (low <= value <= high):
+                raise ValueError(f"{param.name} must be between {low} and {high}")
+            if param == ConfigParam.MCAST_GROUP and value != 0 and value >> 28 != 0xE:
+                raise ValueError("MCAST_GROUP must be 0 or in 224.0.0.0/4")
+            size = 2 if value <= 0xFFFF else 4
+            payload += struct.pack("<BB", param, size)
+            payload += value.to_bytes(size, "little")
+
+        header = Header(
+            magic=PROTOCOL_MAGIC,
+            msg_type=MsgType.CONFIG,
+            sequence=self._next_seq(),
+            payload_len=len(payload),
+        )
+        return header.pack() + bytes(payload)
+
+    def build_sync_request(self, host_t1: int) -> bytes:
+        """Build a clock synchronization request packet.
+
+        Args:
+            host_t1 (int): Host send time in nanoseconds, echoed by the device
+
+        Returns:
+            bytes: Complete packet bytes
+        """
+        payload = struct.pack("<Q", host_t1)
+        header = Header(
+            magic=PROTOCOL_MAGIC,
+            msg_type=MsgType.SYNC_REQ,
+            sequence=self._next_seq(),
+            payload_len=len(payload),
+        )
+        return header.pack() + payload
+
     def build_ping(self) -> bytes:
         """Build a ping packet.
 
@@ -0,0 +1,138 @@
+"""Device-to-host clock synchronization.
+
+The device answers SYNC requests with the time the request arrived (T2) and the
+time the response left (T3), both in microseconds of its own clock. Together with
+the host send (T1) and receive (T4) times this gives a classic two-way time
+exchange, from which ClockSync estimates the offset and drift of the device clock.
+"""
+
+from __future__ import annotations
+
+from collections import deque
+from dataclasses import dataclass
+
+
+@dataclass(frozen=True)
+class SyncSample:
+    """Result of a single two-way time exchange.
+
+    Attributes:
+        host_t1 (float): Host time when the request was sent, in seconds
+        device_t2 (int): Device time when the request arrived, in microseconds
+        device_t3 (int): Device time when the response left, in microseconds
+        host_t4 (float): Host time when the response arrived, in seconds
+    """
+
+    host_t1: float
+    device_t2: int
+    device_t3: int
+    host_t4: float
+
+    @property
+    def delay(self) -> float:
+        """Round-trip network delay excluding device processing, in seconds."""
+        return (self.host_t4 - self.host_t1) - (self.device_t3 - self.device_t2) / 1e6
+
+    @property
+    def host_mid(self) -> float:
+        """Host time at the midpoint of the exchange, in seconds."""
+        return (self.host_t1 + self.host_t4) / 2
+
+    @property
+    def device_mid(self) -> float:
+        """Device time at the midpoint of the exchange, in seconds."""
+        return (self.device_t2 + self.device_t3) / 2e6
+
+
+class ClockSync:
+    """Estimates the mapping from device time to host time.
+
+    Exchanges with the smallest round-trip delay carry the least queueing noise,
+    so only the best ``keep`` samples of the last ``window`` exchanges are used.
+    A least-squares line through their (host, device) midpoints gives the drift
+    (slope) and offset (intercept) of the device clock.
+
+    Attributes:
+        window (int): Number of recent exchanges considered
+        keep (int): Number of lowest-delay exchanges used for the fit
+    """
+
+    def __init__(self, window: int = 64, keep: int = 16) -> None:
+        """Initialize the estimator.
+
+        Args:
+            window (int): Number of recent exchanges considered
+            keep (int): Number of lowest-delay exchanges used for the fit
+        """
+        self.window = window
+        self.keep = keep
+        self._samples: deque[SyncSample] = deque(maxlen=window)
+        self._host_ref = 0.0
+        self._device_ref = 0.0
+        self._slope = 1.0
+        self._ready = False
+
+    @property
+    def ready(self) -> bool:
+        """Whether at least one exchange has been processed."""
+        return self._ready
+
+    @property
+    def drift_ppm(self) -> float:
+        """Estimated device clock drift relative to the host, in ppm."""
+        return (self._slope - 1.0) * 1e6
+
+    @property
+    def offset(self) -> float:
+        """Estimated device minus host time at the reference point, in seconds."""
+        return self._device_ref - self._host_ref
+
+    @property
+    def best_delay(self) -> float | None:
+        """Smallest round-trip delay in the window, in seconds."""
+        if not self._samples:
+            return None
+        return min(sample.delay for sample in self._samples)
+
+    def add(self, sample: SyncSample) -> None:
+        """Add an exchange and update the estimate.
+
+        Args:
+            sample (SyncSample): Completed time exchange
+
+        Returns: None
+        """
+        self._samples.append(sample)
+        best = sorted(self._samples, key=lambda s: s.delay)[: self.keep]
+
+        # Fit around the mean to keep float precision with epoch-based host times
+        host_ref = sum(s.host_mid for s in best) / len(best)
+        device_ref = sum(s.device_mid for s in best) / len(best)
+        var = sum((s.host_mid - host_ref) ** 2 for s in best)
+        cov = sum(
+            (s.host_mid - host_ref) * (s.device_mid - device_ref) for s in best
+        )
+
+        # A single point, or points too close in time, only determine the offset
+        if len(best) >= 2 and var > 1e-6:
+            self._slope = cov / var
+
+        self._host_ref = host_ref
+        self._device_ref = device_ref
+        self._ready = True
+
+    def to_host(self, device_us: int) -> float:
+        """Convert a device timestamp to host time.
+
+        Args:
+            device_us (int): Device time in microseconds
+
+        Returns:
+            float: Host time in seconds
+
+        Raises:
+            RuntimeError: If no exchange has been processed yet
+        """
+        if not self._ready:
+            raise RuntimeError("Clock is not synchronized yet")
+        return self._host_ref + (device_us / 1e6 - self._device_ref) / self._slope
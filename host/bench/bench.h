@@ -0,0 +1,69 @@
+/**
+ * @file bench.h
+ * @brief Timing helpers shared by the host benchmark programs
+ * @details A benchmark prints its figures and exits with test_report(), so a
+ * nonzero status means the run itself broke, e.g. a request went unanswered,
+ * never that it was slow. Figures are host figures: they compare two ways of
+ * doing the same work in one build, they do not predict the target.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+static inline uint64_t bench_time_ns(void)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Sort timings and print their median, 99th percentile and maximum
+ * @param name Benchmark program name
+ * @param label What was timed
+ * @param samples Timings, sorted in place
+ * @param count Number of timings
+ * @param unit Unit of the timings, e.g. "us"
+ * @return Median, UINT32_MAX if there are no timings
+ */
+static inline uint32_t bench_report(
+    const char *name, const char *label, uint32_t *samples, size_t count,
+    const char *unit
+)
+{
+    if (count == 0U)
+    {
+        printf("%s: %s: no timings\n", name, label);
+        return UINT32_MAX;
+    }
+
+    qsort(samples, count, sizeof(samples[0]), bench_compare);
+    printf(
+        "%s: %-28s median %6u %s, p99 %6u %s, max %6u %s\n", name, label,
+        samples[count / 2U], unit, samples[count * 99U / 100U], unit,
+        samples[count - 1U], unit
+    );
+
+    return samples[count / 2U];
+}
+
+#endif /* BENCH_H */
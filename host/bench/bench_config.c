@@ -0,0 +1,150 @@
+/**
+ * @file bench_config.c
+ * @brief Latency of a four-parameter configuration, one command each or one TLV
+ * @details The firmware runs without the acquisition task. Each round sets the
+ * channel, threshold, batch size and log level, as four CMD_CONFIGURE packets or
+ * as one MSG_TYPE_CONFIG packet with four entries, and times it until all four
+ * values read back from the acquisition task and the logger. Rounds are
+ * ROUND_GAP_MS apart, so each finds the network task waiting on its control
+ * socket as it would between two requests of a host.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "bench.h"
+#include "firmware.h"
+#include "test.h"
+
+/** Rounds timed for each way of sending the set */
+#define ROUNDS 1000U
+/** Parameters in the set */
+#define PARAMS 4U
+/** Time between two rounds */
+#define ROUND_GAP_MS 3U
+/** Time the set is waited for before the round counts as lost */
+#define APPLY_TIMEOUT_US 250000U
+/** Interval the values are read back at */
+#define POLL_US 10U
+
+/**
+ * @brief How a round sends the set
+ */
+typedef enum
+{
+    SEND_COMMANDS, /**< One CMD_CONFIGURE per parameter */
+    SEND_TLV,      /**< One MSG_TYPE_CONFIG with every parameter */
+} send_mode_t;
+
+static uint32_t round_us[ROUNDS];
+
+/**
+ * @brief Values of round i, the threshold changes every round
+ */
+static void round_params(uint32_t i, uint8_t types[PARAMS], uint16_t values[PARAMS])
+{
+    types[0]  = CONFIG_CHANNEL;
+    values[0] = (uint16_t)(i % 2U);
+    types[1]  = CONFIG_THRESHOLD_MV;
+    values[1] = (uint16_t)(1000U + i % 1000U);
+    types[2]  = CONFIG_BATCH_SIZE;
+    values[2] = (uint16_t)(50U + i % 50U);
+    types[3]  = CONFIG_LOG_LEVEL;
+    values[3] = LOG_LEVEL_WARNING;
+}
+
+/**
+ * @brief Send the set of round i as one MSG_TYPE_CONFIG packet
+ */
+static void send_tlv(int fd, const uint8_t types[PARAMS], const uint16_t values[PARAMS])
+{
+    uint8_t payload[PARAMS * (PROTOCOL_CONFIG_TLV_HEADER_SIZE + 2U)];
+    size_t  len = 0;
+
+    for (uint32_t p = 0; p < PARAMS; p++)
+    {
+        payload[len++] = types[p];
+        payload[len++] = 2U;
+        payload[len++] = (uint8_t)values[p];
+        payload[len++] = (uint8_t)(values[p] >> 8);
+    }
+
+    client_send(fd, TASK_NETWORK_LOCAL_PORT, MSG_TYPE_CONFIG, payload, len);
+}
+
+/**
+ * @brief Check whether every value of the set reads back
+ */
+static bool applied(const uint16_t values[PARAMS])
+{
+    return acquisition_get_channel() == values[0] &&
+           acquisition_get_threshold_mv() == values[1] &&
+           acquisition_get_batch_size() == values[2] && logger_get_level() == values[3];
+}
+
+/**
+ * @brief Time ROUNDS rounds sending the set one way
+ * @return Median round time in microseconds
+ */
+static uint32_t time_rounds(int fd, send_mode_t mode, const char *label)
+{
+    uint8_t  types[PARAMS];
+    uint16_t values[PARAMS];
+    size_t   answered = 0;
+
+    for (uint32_t i = 0; i < ROUNDS; i++)
+    {
+        round_params(i, types, values);
+
+        uint64_t start_us = system_time_us();
+        if (mode == SEND_COMMANDS)
+        {
+            for (uint32_t p = 0; p < PARAMS; p++)
+            {
+                client_command(fd, CMD_CONFIGURE, types[p], values[p]);
+            }
+        }
+        else
+        {
+            send_tlv(fd, types, values);
+        }
+
+        uint64_t elapsed_us = 0;
+        while (!applied(values) && elapsed_us < APPLY_TIMEOUT_US)
+        {
+            usleep(POLL_US);
+            elapsed_us = system_time_us() - start_us;
+        }
+        if (elapsed_us < APPLY_TIMEOUT_US)
+        {
+            round_us[answered++] = (uint32_t)(system_time_us() - start_us);
+        }
+        osDelay(ROUND_GAP_MS);
+    }
+
+    TEST_CHECK(answered == ROUNDS);
+    return bench_report("bench_config", label, round_us, answered, "us");
+}
+
+static void bench_body(void *argument)
+{
+    (void)argument;
+
+    TEST_CHECK(firmware_wait_ready());
+    int client = client_open("127.0.0.2");
+
+    uint32_t commands_us = time_rounds(client, SEND_COMMANDS, "4 x CMD_CONFIGURE");
+    uint32_t tlv_us      = time_rounds(client, SEND_TLV, "1 x MSG_TYPE_CONFIG");
+
+    printf(
+        "bench_config: one TLV applies the set %.1f times as fast as four commands\n",
+        (double)commands_us / (double)tlv_us
+    );
+
+    exit(test_report("bench_config"));
+}
+
+int main(void)
+{
+    firmware_boot(false);
+    firmware_run(bench_body);
+}
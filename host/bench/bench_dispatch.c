@@ -0,0 +1,263 @@
+/**
+ * @file bench_dispatch.c
+ * @brief Per-packet dispatch cost of the request tables against the old switches
+ * @details The program includes task_network.c itself, so it can call the static
+ * process_received_packet() directly, without a socket in the way. It times
+ * that against switch_packet(), which dispatches to the same handlers the way
+ * task_network.c did before its tables: nested switches on the message type
+ * and the command, the sender's address formatted for every packet and an INFO
+ * line for every command. Configuration parameters go through the same table in
+ * both, as does the subscriber lease.
+ *
+ * The logger runs at WARNING, so neither variant prints, and each packet type
+ * is timed on its own: a PONG, a CMD_CONFIGURE and a MSG_TYPE_CONFIG with four
+ * entries, none of which sends a reply.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "../../src/tasks/task_network.c"
+
+#include "bench.h"
+#include "firmware.h"
+#include "test.h"
+
+/** Packets timed together for one sample */
+#define BATCH 100U
+/** Samples for each variant and packet type */
+#define SAMPLES 500U
+
+/**
+ * @brief Dispatch a command the way handle_command() did
+ */
+static void
+switch_command(const protocol_cmd_payload_t *cmd, const udp_endpoint_t *remote)
+{
+    LOG_INFO(
+        "Command received: 0x%02X, param_type: %u, param: %u", cmd->cmd,
+        cmd->param_type, cmd->param
+    );
+
+    switch (cmd->cmd)
+    {
+        case CMD_START_ACQ:
+            cmd_start_acq(cmd, remote);
+            break;
+
+        case CMD_STOP_ACQ:
+            cmd_stop_acq(cmd, remote);
+            break;
+
+        case CMD_GET_STATUS:
+            cmd_get_status(cmd, remote);
+            break;
+
+        case CMD_CONFIGURE:
+            cmd_configure(cmd, remote);
+            break;
+
+        case CMD_GET_TELEMETRY:
+            cmd_get_telemetry(cmd, remote);
+            break;
+
+        case CMD_CAPTURE:
+            cmd_capture(cmd, remote);
+            break;
+
+        case CMD_CAPTURE_READ:
+            cmd_capture_read(cmd, remote);
+            break;
+
+        default:
+            LOG_WARNING("Unknown command: 0x%02X", cmd->cmd);
+            break;
+    }
+}
+
+/**
+ * @brief Dispatch a packet the way process_received_packet() did
+ */
+static void
+switch_packet(const uint8_t *data, size_t len, const udp_endpoint_t *remote)
+{
+    protocol_header_t header;
+    const uint8_t    *payload;
+    size_t            payload_len;
+
+    char remote_ip[16];
+    udp_ipv4_to_string(&remote->ip, remote_ip, sizeof(remote_ip));
+
+    LOG_DEBUG("Received %u bytes from %s:%u", len, remote_ip, remote->port);
+
+    protocol_status_t status =
+        protocol_parse_packet(data, len, &header, &payload, &payload_len);
+
+    if (status != PROTO_STATUS_OK)
+    {
+        LOG_WARNING(
+            "Invalid packet from %s:%u (error %d)", remote_ip, remote->port, status
+        );
+        return;
+    }
+
+    (void)session_touch(remote);
+
+    switch (header.msg_type)
+    {
+        case MSG_TYPE_PING:
+            LOG_DEBUG("Ping received, sending pong");
+            msg_ping(payload, payload_len, remote);
+            break;
+
+        case MSG_TYPE_SYNC_REQ:
+            msg_sync_request(payload, payload_len, remote);
+            break;
+
+        case MSG_TYPE_CMD:
+            LOG_DEBUG("Command received");
+            {
+                protocol_cmd_payload_t cmd;
+                if (protocol_parse_command(payload, payload_len, &cmd) ==
+                    PROTO_STATUS_OK)
+                {
+                    switch_command(&cmd, remote);
+                }
+            }
+            break;
+
+        case MSG_TYPE_CONFIG:
+            LOG_DEBUG("Config received");
+            msg_config(payload, payload_len, remote);
+            break;
+
+        case MSG_TYPE_PONG:
+            LOG_DEBUG("Pong received from %s:%u", remote_ip, remote->port);
+            break;
+
+        default:
+            LOG_WARNING("Unknown message type: 0x%02X", header.msg_type);
+            break;
+    }
+}
+
+/**
+ * @brief One request as it arrives from the socket
+ */
+typedef struct
+{
+    const char *name;                            /**< Label of the figures */
+    uint8_t     data[PROTOCOL_MAX_REQUEST_SIZE]; /**< Whole datagram */
+    size_t      len;                             /**< Datagram length */
+} request_t;
+
+/**
+ * @brief Build a request from a message type and its payload
+ */
+static void build_request(
+    request_t *request, const char *name, uint8_t msg_type, const void *payload,
+    size_t payload_len
+)
+{
+    protocol_header_t header = {
+        .magic       = PROTOCOL_MAGIC,
+        .msg_type    = msg_type,
+        .sequence    = 1U,
+        .payload_len = (uint16_t)payload_len,
+    };
+
+    request->name = name;
+    memcpy(request->data, &header, sizeof(header));
+    if (payload_len > 0)
+    {
+        memcpy(&request->data[sizeof(header)], payload, payload_len);
+    }
+    request->len = sizeof(header) + payload_len;
+}
+
+/**
+ * @brief Time BATCH dispatches of one request
+ * @return Nanoseconds per packet
+ */
+static uint32_t time_batch(
+    void (*dispatch)(const uint8_t *, size_t, const udp_endpoint_t *),
+    const request_t *request, const udp_endpoint_t *remote
+)
+{
+    uint64_t start_ns = bench_time_ns();
+
+    for (uint32_t i = 0; i < BATCH; i++)
+    {
+        dispatch(request->data, request->len, remote);
+    }
+
+    return (uint32_t)((bench_time_ns() - start_ns) / BATCH);
+}
+
+static void bench_body(void *argument)
+{
+    static uint32_t      before_ns[SAMPLES];
+    static uint32_t      after_ns[SAMPLES];
+    static const uint8_t config[] = {
+        CONFIG_CHANNEL,    1, 0,    CONFIG_THRESHOLD_MV, 2, 0xE8, 0x03,
+        CONFIG_BATCH_SIZE, 1, 50,   CONFIG_LOG_LEVEL,    1, LOG_LEVEL_WARNING,
+    };
+    protocol_cmd_payload_t configure = {
+        .cmd        = CMD_CONFIGURE,
+        .param_type = CONFIG_THRESHOLD_MV,
+        .param      = 1000U,
+    };
+    request_t      requests[3];
+    udp_endpoint_t remote = {.ip = {{127, 0, 0, 2}}, .port = 40000U};
+    char           label[64];
+
+    (void)argument;
+
+    TEST_CHECK(firmware_wait_ready());
+    (void)logger_init();
+    logger_set_level(LOG_LEVEL_WARNING);
+
+    build_request(&requests[0], "PONG", MSG_TYPE_PONG, NULL, 0);
+    build_request(
+        &requests[1], "CMD_CONFIGURE", MSG_TYPE_CMD, &configure, sizeof(configure)
+    );
+    build_request(
+        &requests[2], "MSG_TYPE_CONFIG", MSG_TYPE_CONFIG, config, sizeof(config)
+    );
+
+    network_stats_t stats;
+    network_get_stats(&stats);
+    uint32_t errors = stats.errors;
+
+    for (size_t r = 0; r < sizeof(requests) / sizeof(requests[0]); r++)
+    {
+        /* Interleaved, so a change in the machine's load hits both alike */
+        for (uint32_t s = 0; s < SAMPLES; s++)
+        {
+            before_ns[s] = time_batch(switch_packet, &requests[r], &remote);
+            after_ns[s]  = time_batch(process_received_packet, &requests[r], &remote);
+        }
+
+        (void)snprintf(label, sizeof(label), "%s, switches", requests[r].name);
+        uint32_t before =
+            bench_report("bench_dispatch", label, before_ns, SAMPLES, "ns");
+        (void)snprintf(label, sizeof(label), "%s, tables", requests[r].name);
+        uint32_t after = bench_report("bench_dispatch", label, after_ns, SAMPLES, "ns");
+        printf(
+            "bench_dispatch: %s costs %d ns less per packet\n", requests[r].name,
+            (int)before - (int)after
+        );
+    }
+
+    /* Every request was valid, so neither variant may have counted an error */
+    network_get_stats(&stats);
+    TEST_CHECK(stats.errors == errors);
+    TEST_CHECK(acquisition_get_threshold_mv() == 1000U);
+
+    exit(test_report("bench_dispatch"));
+}
+
+int main(void)
+{
+    firmware_boot(false);
+    firmware_run(bench_body);
+}
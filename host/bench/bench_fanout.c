@@ -0,0 +1,153 @@
+/**
+ * @file bench_fanout.c
+ * @brief Cost of each further subscriber of a data packet
+ * @details The firmware runs without the acquisition task, so the benchmark
+ * plays the data path and times network_send_raw() of one data packet with 1
+ * to SESSION_MAX_SUBSCRIBERS loopback listeners subscribed. The packet is built
+ * once whatever the fan-out, so the growth from one listener to the next is the
+ * cost of one more subscriber: its snapshot entry, its datagram and the send
+ * itself. Between batches every listener is drained and must have received
+ * each packet.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "bench.h"
+#include "firmware.h"
+#include "session.h"
+#include "test.h"
+
+/** Packets timed together for one sample */
+#define BATCH 50U
+/** Samples for each fan-out */
+#define SAMPLES 200U
+/** Samples per packet, a default-sized batch */
+#define PACKET_SAMPLES 100U
+/** Longest wait for a subscription */
+#define SUBSCRIBE_TIMEOUT_MS 1000U
+
+static int listeners[SESSION_MAX_SUBSCRIBERS];
+
+/**
+ * @brief Subscribe one more listener from its own loopback address
+ */
+static bool subscribe(size_t index)
+{
+    char            host[16];
+    udp_ipv4_addr_t ip;
+
+    (void)snprintf(host, sizeof(host), "127.0.0.%u", (unsigned)(2U + index));
+    (void)inet_pton(AF_INET, host, ip.addr);
+    listeners[index] = client_open(host);
+    client_command(listeners[index], CMD_START_ACQ, 0, 0);
+
+    for (uint32_t waited = 0; waited < SUBSCRIBE_TIMEOUT_MS; waited++)
+    {
+        if (session_has_host(&ip))
+        {
+            return true;
+        }
+        osDelay(1);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Receive what is waiting on a listener without blocking
+ * @return Data packets received
+ */
+static uint32_t drain(int fd)
+{
+    uint8_t  buffer[1500];
+    uint32_t count = 0;
+
+    for (;;)
+    {
+        protocol_header_t header;
+        const uint8_t    *payload;
+        int len = client_recv(fd, buffer, sizeof(buffer), 0U, &header, &payload);
+
+        if (len < 0)
+        {
+            return count;
+        }
+        count += (header.msg_type == MSG_TYPE_DATA);
+    }
+}
+
+/**
+ * @brief Time SAMPLES batches of sends to the listeners subscribed so far
+ * @return Median nanoseconds per packet
+ */
+static uint32_t time_fanout(size_t fanout, const uint8_t *packet, size_t len)
+{
+    static uint32_t packet_ns[SAMPLES];
+    char            label[32];
+    uint32_t        failed = 0;
+
+    for (uint32_t s = 0; s < SAMPLES; s++)
+    {
+        uint64_t start_ns = bench_time_ns();
+        for (uint32_t i = 0; i < BATCH; i++)
+        {
+            failed += (network_send_raw(0, packet, len) != 0);
+        }
+        packet_ns[s] = (uint32_t)((bench_time_ns() - start_ns) / BATCH);
+
+        /* Loopback has queued each datagram by the time its send returns */
+        for (size_t l = 0; l < fanout; l++)
+        {
+            TEST_CHECK(drain(listeners[l]) == BATCH);
+        }
+    }
+
+    TEST_CHECK(failed == 0U);
+    (void)snprintf(label, sizeof(label), "%u subscriber(s)", (unsigned)fanout);
+    return bench_report("bench_fanout", label, packet_ns, SAMPLES, "ns");
+}
+
+static void bench_body(void *argument)
+{
+    static const uint16_t samples[PACKET_SAMPLES] = {0};
+    uint8_t               packet[PROTOCOL_MAX_DATA_SIZE];
+    size_t                len;
+    uint32_t              packet_ns[SESSION_MAX_SUBSCRIBERS];
+
+    (void)argument;
+
+    TEST_CHECK(firmware_wait_ready());
+    protocol_status_t status = protocol_build_data_packet(
+        packet, sizeof(packet), 0, samples, PACKET_SAMPLES, 0, system_time_us(), &len
+    );
+    TEST_CHECK(status == PROTO_STATUS_OK);
+
+    for (size_t fanout = 1; fanout <= SESSION_MAX_SUBSCRIBERS; fanout++)
+    {
+        TEST_CHECK(subscribe(fanout - 1U));
+        packet_ns[fanout - 1U] = time_fanout(fanout, packet, len);
+    }
+
+    int32_t growth = ((int32_t)packet_ns[SESSION_MAX_SUBSCRIBERS - 1U] -
+                      (int32_t)packet_ns[0]) /
+                     (int32_t)(SESSION_MAX_SUBSCRIBERS - 1U);
+    printf(
+        "bench_fanout: %u-byte packet, %d ns per further subscriber, "
+        "%u ns per datagram at %u\n",
+        (unsigned)len, (int)growth,
+        packet_ns[SESSION_MAX_SUBSCRIBERS - 1U] / SESSION_MAX_SUBSCRIBERS,
+        SESSION_MAX_SUBSCRIBERS
+    );
+
+    for (size_t l = 0; l < SESSION_MAX_SUBSCRIBERS; l++)
+    {
+        client_command(listeners[l], CMD_STOP_ACQ, 0, 0);
+    }
+    exit(test_report("bench_fanout"));
+}
+
+int main(void)
+{
+    firmware_boot(false);
+    firmware_run(bench_body);
+}
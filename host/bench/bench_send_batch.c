@@ -0,0 +1,217 @@
+/**
+ * @file bench_send_batch.c
+ * @brief Per-datagram cost of udp_socket_send() against udp_socket_send_batch()
+ * @details The target udp_socket.c runs on the mock RL-NET headers, with a stack
+ * whose netUDP_GetBuffer() hands out one static frame and whose netUDP_Send()
+ * returns at once, so what is timed is the socket layer itself: the checks, the
+ * link query, the send buffer ledger, the endpoint conversion and the copy.
+ * Each sample sends 1, 4 or MAX_COUNT datagrams of a data packet's size to as
+ * many endpoints, once with one udp_socket_send() each and once as one batch,
+ * after the ledger has drained so that none is refused.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "udp_socket.h"
+
+#include "Driver_ETH_PHY.h"
+#include "bench.h"
+#include "cmsis_os2.h"
+#include "rl_net.h"
+#include "test.h"
+
+#include <string.h>
+
+/** Samples for each variant and batch size */
+#define SAMPLES 1000U
+/** Largest batch timed */
+#define MAX_COUNT 16U
+/** Datagram length, a data packet of a default-sized batch */
+#define DATAGRAM_LEN 219U
+
+static uint8_t  frame[UDP_MAX_PAYLOAD_SIZE];
+static uint32_t frames = 0;
+
+static ARM_ETH_LINK_INFO phy_link_info(void)
+{
+    ARM_ETH_LINK_INFO info = {.speed = ARM_ETH_SPEED_100M, .duplex = 1};
+    return info;
+}
+
+ARM_DRIVER_ETH_PHY Driver_ETH_PHY0 = {.GetLinkInfo = phy_link_info};
+
+int32_t netUDP_GetSocket(netUDP_cb_t cb_func)
+{
+    static int32_t next_socket = 0;
+
+    (void)cb_func;
+    return ++next_socket;
+}
+
+netStatus netUDP_ReleaseSocket(int32_t socket)
+{
+    (void)socket;
+    return netOK;
+}
+
+netStatus netUDP_Open(int32_t socket, uint16_t port)
+{
+    (void)socket;
+    (void)port;
+    return netOK;
+}
+
+netStatus netUDP_Close(int32_t socket)
+{
+    (void)socket;
+    return netOK;
+}
+
+uint8_t *netUDP_GetBuffer(uint32_t size)
+{
+    return (size <= sizeof(frame)) ? frame : NULL;
+}
+
+netStatus netUDP_Send(int32_t socket, const NET_ADDR *addr, uint8_t *buf, uint32_t len)
+{
+    (void)socket;
+    (void)addr;
+    (void)buf;
+    (void)len;
+
+    frames++;
+    return netOK;
+}
+
+netStatus
+netIF_GetOption(uint32_t if_id, netIF_Option option, uint8_t *buf, uint32_t buf_len)
+{
+    (void)if_id;
+    (void)option;
+    memset(buf, 0, buf_len);
+    return netOK;
+}
+
+netStatus
+netARP_CacheIP(uint32_t if_id, const uint8_t *ip4_addr, netARP_CacheType type)
+{
+    (void)if_id;
+    (void)ip4_addr;
+    (void)type;
+    return netOK;
+}
+
+netStatus netARP_GetMAC(uint32_t if_id, const uint8_t *ip4_addr, uint8_t *mac_addr)
+{
+    (void)if_id;
+    (void)ip4_addr;
+    memset(mac_addr, 0, NET_ADDR_ETH_LEN);
+    return netOK;
+}
+
+/**
+ * @brief Wait until the ledger takes count datagrams at once
+ */
+static void wait_ledger(size_t count)
+{
+    while (udp_socket_tx_wait_us(DATAGRAM_LEN, count) != 0U)
+    {
+        osDelay(1);
+    }
+}
+
+/**
+ * @brief Time SAMPLES sends of count datagrams each way
+ */
+static void time_count(udp_socket_handle_t handle, size_t count)
+{
+    static const uint8_t  payload[DATAGRAM_LEN];
+    static uint32_t       single_ns[SAMPLES];
+    static uint32_t       batch_ns[SAMPLES];
+    static udp_endpoint_t remotes[MAX_COUNT];
+    udp_datagram_t        datagrams[MAX_COUNT];
+    udp_status_t          results[MAX_COUNT];
+    uint32_t              failed = 0;
+    char                  label[32];
+
+    for (size_t i = 0; i < count; i++)
+    {
+        remotes[i] = (udp_endpoint_t){
+            .ip = {{192, 168, 0, (uint8_t)(2U + i)}}, .port = 5001U
+        };
+        datagrams[i] = (udp_datagram_t){
+            .remote = &remotes[i], .data = payload, .len = sizeof(payload)
+        };
+    }
+
+    for (uint32_t s = 0; s < SAMPLES; s++)
+    {
+        wait_ledger(count);
+        uint64_t start_ns = bench_time_ns();
+        for (size_t i = 0; i < count; i++)
+        {
+            udp_status_t status =
+                udp_socket_send(handle, &remotes[i], payload, sizeof(payload));
+            failed += (status != UDP_STATUS_OK);
+        }
+        single_ns[s] = (uint32_t)((bench_time_ns() - start_ns) / count);
+
+        wait_ledger(count);
+        start_ns = bench_time_ns();
+        (void)udp_socket_send_batch(handle, datagrams, count, results);
+        batch_ns[s] = (uint32_t)((bench_time_ns() - start_ns) / count);
+        for (size_t i = 0; i < count; i++)
+        {
+            failed += (results[i] != UDP_STATUS_OK);
+        }
+    }
+
+    TEST_CHECK(failed == 0U);
+    (void)snprintf(label, sizeof(label), "%2u x udp_socket_send", (unsigned)count);
+    uint32_t single =
+        bench_report("bench_send_batch", label, single_ns, SAMPLES, "ns");
+    (void)snprintf(label, sizeof(label), "batch of %2u", (unsigned)count);
+    uint32_t batch = bench_report("bench_send_batch", label, batch_ns, SAMPLES, "ns");
+    printf(
+        "bench_send_batch: batch of %u saves %d ns per datagram\n", (unsigned)count,
+        (int)single - (int)batch
+    );
+}
+
+static void bench_body(void *argument)
+{
+    static const size_t counts[] = {1U, 4U, MAX_COUNT};
+    udp_socket_handle_t handle;
+
+    (void)argument;
+
+    TEST_CHECK(udp_socket_create(&handle, 5002U) == UDP_STATUS_OK);
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        time_count(handle, counts[c]);
+    }
+
+    /* Every datagram of every sample reached the stack */
+    uint32_t expected = 0;
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+    {
+        expected += 2U * SAMPLES * (uint32_t)counts[c];
+    }
+    TEST_CHECK(frames == expected);
+
+    exit(test_report("bench_send_batch"));
+}
+
+int main(void)
+{
+    osKernelInitialize();
+    if (udp_socket_init() != UDP_STATUS_OK)
+    {
+        return 1;
+    }
+    netETH_Notify(0, netETH_LinkUp, 0);
+
+    osThreadNew(bench_body, NULL, NULL);
+    osKernelStart();
+    return 1;
+}
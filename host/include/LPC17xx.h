@@ -0,0 +1,168 @@
+/**
+ * @file LPC17xx.h
+ * @brief Simulated LPC17xx device header for the host build
+ * @details Declares only the registers the shared sources touch. The ADC and
+ * TIMER1 registers are plain memory watched by a simulator thread, which runs
+ * ADC_IRQHandler() when a conversion completes. The pin, GPIO and EMAC
+ * registers only absorb the writes of task_init.c.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#ifndef LPC17XX_H
+#define LPC17XX_H
+
+#include <stdint.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /** Interrupt numbers of the simulated peripherals */
+    typedef enum
+    {
+        ADC_IRQn = 22 /**< A/D Converter Interrupt */
+    } IRQn_Type;
+
+    /** A/D converter registers */
+    typedef struct
+    {
+        volatile uint32_t ADCR;
+        volatile uint32_t ADGDR;
+        volatile uint32_t ADINTEN;
+        volatile uint32_t ADDR[8];
+        volatile uint32_t ADSTAT;
+        volatile uint32_t ADTRM;
+    } LPC_ADC_TypeDef;
+
+    /** Timer registers */
+    typedef struct
+    {
+        volatile uint32_t IR;
+        volatile uint32_t TCR;
+        volatile uint32_t TC;
+        volatile uint32_t PR;
+        volatile uint32_t PC;
+        volatile uint32_t MCR;
+        volatile uint32_t MR0;
+        volatile uint32_t MR1;
+        volatile uint32_t MR2;
+        volatile uint32_t MR3;
+        volatile uint32_t CCR;
+        volatile uint32_t CR0;
+        volatile uint32_t CR1;
+        volatile uint32_t EMR;
+        volatile uint32_t CTCR;
+    } LPC_TIM_TypeDef;
+
+    /** System control registers */
+    typedef struct
+    {
+        volatile uint32_t PCONP;
+        volatile uint32_t PCLKSEL0;
+        volatile uint32_t PCLKSEL1;
+    } LPC_SC_TypeDef;
+
+    /** Pin connect block registers */
+    typedef struct
+    {
+        volatile uint32_t PINSEL0;
+        volatile uint32_t PINSEL1;
+        volatile uint32_t PINSEL2;
+        volatile uint32_t PINSEL3;
+        volatile uint32_t PINSEL4;
+        volatile uint32_t PINSEL5;
+        volatile uint32_t PINSEL6;
+        volatile uint32_t PINSEL7;
+        volatile uint32_t PINSEL8;
+        volatile uint32_t PINSEL9;
+        volatile uint32_t PINSEL10;
+        volatile uint32_t PINMODE0;
+        volatile uint32_t PINMODE1;
+        volatile uint32_t PINMODE2;
+        volatile uint32_t PINMODE3;
+        volatile uint32_t PINMODE4;
+        volatile uint32_t PINMODE5;
+        volatile uint32_t PINMODE6;
+        volatile uint32_t PINMODE7;
+        volatile uint32_t PINMODE8;
+        volatile uint32_t PINMODE9;
+        volatile uint32_t PINMODE_OD0;
+        volatile uint32_t PINMODE_OD1;
+        volatile uint32_t PINMODE_OD2;
+        volatile uint32_t PINMODE_OD3;
+        volatile uint32_t PINMODE_OD4;
+    } LPC_PINCON_TypeDef;
+
+    /** Fast GPIO registers */
+    typedef struct
+    {
+        volatile uint32_t FIODIR;
+        volatile uint32_t FIOMASK;
+        volatile uint32_t FIOPIN;
+        volatile uint32_t FIOSET;
+        volatile uint32_t FIOCLR;
+    } LPC_GPIO_TypeDef;
+
+    /** Ethernet MAC registers, plus the ones the target udp_socket.c logs */
+    typedef struct
+    {
+        volatile uint32_t RxFilterCtrl;
+        volatile uint32_t RxProduceIndex;
+        volatile uint32_t RxConsumeIndex;
+        volatile uint32_t TxStatus;
+        volatile uint32_t TxDescriptorNumber;
+        volatile uint32_t TxProduceIndex;
+        volatile uint32_t TxConsumeIndex;
+        volatile uint32_t IntStatus;
+        volatile uint32_t IntEnable;
+    } LPC_EMAC_TypeDef;
+
+    extern LPC_ADC_TypeDef    sim_adc;
+    extern LPC_TIM_TypeDef    sim_tim1;
+    extern LPC_SC_TypeDef     sim_sc;
+    extern LPC_PINCON_TypeDef sim_pincon;
+    extern LPC_GPIO_TypeDef   sim_gpio1;
+    extern LPC_EMAC_TypeDef   sim_emac;
+
+#define LPC_ADC    (&sim_adc)
+#define LPC_TIM1   (&sim_tim1)
+#define LPC_SC     (&sim_sc)
+#define LPC_PINCON (&sim_pincon)
+#define LPC_GPIO1  (&sim_gpio1)
+#define LPC_EMAC   (&sim_emac)
+
+    /** Core clock of the simulated part */
+    extern uint32_t SystemCoreClock;
+
+    /**
+     * @brief Read the clock configuration of the simulated part
+     * @details Loads the simulator settings from the environment, the closest
+     * host equivalent of reading the PLL setup on reset.
+     */
+    void SystemCoreClockUpdate(void);
+
+    /**
+     * @brief Enable a simulated interrupt, starting its peripheral model
+     * @param IRQn Interrupt number
+     */
+    void NVIC_EnableIRQ(IRQn_Type IRQn);
+
+    /**
+     * @brief Disable a simulated interrupt
+     * @param IRQn Interrupt number
+     */
+    void NVIC_DisableIRQ(IRQn_Type IRQn);
+
+#define __DMB() __sync_synchronize()
+
+/** Waiting for an interrupt is waiting for a signal on the host */
+#define __WFI() pause()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPC17XX_H */
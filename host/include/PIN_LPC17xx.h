@@ -0,0 +1,54 @@
+/**
+ * @file PIN_LPC17xx.h
+ * @brief Pin configuration stub for the host build
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#ifndef PIN_LPC17XX_H
+#define PIN_LPC17XX_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Pin functions */
+#define PIN_FUNC_0 0U
+#define PIN_FUNC_1 1U
+#define PIN_FUNC_2 2U
+#define PIN_FUNC_3 3U
+
+/* Pin modes */
+#define PIN_PINMODE_PULLUP   0U
+#define PIN_PINMODE_REPEATER 1U
+#define PIN_PINMODE_TRISTATE 2U
+#define PIN_PINMODE_PULLDOWN 3U
+
+/* Open drain modes */
+#define PIN_PINMODE_NORMAL    0U
+#define PIN_PINMODE_OPENDRAIN 1U
+
+    /**
+     * @brief Pin multiplexing has no meaning on the host
+     * @return Always 0
+     */
+    static inline int32_t PIN_Configure(
+        uint8_t port, uint8_t pin, uint8_t function, uint8_t mode, uint8_t open_drain
+    )
+    {
+        (void)port;
+        (void)pin;
+        (void)function;
+        (void)mode;
+        (void)open_drain;
+        return 0;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PIN_LPC17XX_H */
@@ -0,0 +1,452 @@
+/**
+ * @file cmsis_os2.h
+ * @brief Subset of the CMSIS-RTOS2 API implemented on POSIX threads
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+/**
+ * @defgroup HostRTOS Host RTOS
+ * @{
+ */
+
+#ifndef CMSIS_OS2_H
+#define CMSIS_OS2_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Wait until the object becomes available */
+#define osWaitForever 0xFFFFFFFFU
+
+/** Mutex attribute: the owner may acquire the mutex again */
+#define osMutexRecursive 0x00000001U
+/** Mutex attribute: the owner inherits the priority of waiting threads */
+#define osMutexPrioInherit 0x00000002U
+/** Mutex attribute: released automatically when the owner terminates */
+#define osMutexRobust 0x00000008U
+
+/** Flags option: wait for any of the flags */
+#define osFlagsWaitAny 0x00000000U
+/** Flags option: wait for all of the flags */
+#define osFlagsWaitAll 0x00000001U
+/** Flags option: leave the flags set after the wait */
+#define osFlagsNoClear 0x00000002U
+
+/** Flags result: bit set on every error code */
+#define osFlagsError 0x80000000U
+/** Flags result: timeout expired */
+#define osFlagsErrorTimeout 0xFFFFFFFEU
+/** Flags result: flags not set and no timeout given */
+#define osFlagsErrorResource 0xFFFFFFFDU
+/** Flags result: invalid parameter */
+#define osFlagsErrorParameter 0xFFFFFFFCU
+
+    /**
+     * @brief Kernel state
+     */
+    typedef enum
+    {
+        osKernelInactive  = 0,  /**< Not initialized */
+        osKernelReady     = 1,  /**< Initialized, threads wait for osKernelStart() */
+        osKernelRunning   = 2,  /**< Threads are running */
+        osKernelLocked    = 3,  /**< Not used on the host */
+        osKernelSuspended = 4,  /**< Not used on the host */
+        osKernelError     = -1, /**< Error */
+        osKernelReserved  = 0x7FFFFFFF
+    } osKernelState_t;
+
+    /**
+     * @brief Status code returned by most functions
+     */
+    typedef enum
+    {
+        osOK             = 0,  /**< Operation completed successfully */
+        osError          = -1, /**< Unspecified error */
+        osErrorTimeout   = -2, /**< Timeout expired */
+        osErrorResource  = -3, /**< Resource not available */
+        osErrorParameter = -4, /**< Invalid parameter */
+        osErrorNoMemory  = -5, /**< Out of memory */
+        osErrorISR       = -6, /**< Not allowed in interrupt context */
+        osStatusReserved = 0x7FFFFFFF
+    } osStatus_t;
+
+    /**
+     * @brief Thread priority, recorded but not enforced on the host
+     */
+    typedef enum
+    {
+        osPriorityNone        = 0,
+        osPriorityIdle        = 1,
+        osPriorityLow         = 8,
+        osPriorityBelowNormal = 16,
+        osPriorityNormal      = 24,
+        osPriorityAboveNormal = 32,
+        osPriorityHigh        = 40,
+        osPriorityRealtime    = 48,
+        osPriorityISR         = 56,
+        osPriorityError       = -1,
+        osPriorityReserved    = 0x7FFFFFFF
+    } osPriority_t;
+
+    /** Thread entry point */
+    typedef void (*osThreadFunc_t)(void *argument);
+
+    typedef void *osThreadId_t;       /**< Thread handle */
+    typedef void *osMutexId_t;        /**< Mutex handle */
+    typedef void *osSemaphoreId_t;    /**< Semaphore handle */
+    typedef void *osEventFlagsId_t;   /**< Event flags handle */
+    typedef void *osMessageQueueId_t; /**< Message queue handle */
+    typedef void *osMemoryPoolId_t;   /**< Memory pool handle */
+
+    /**
+     * @brief Thread attributes
+     */
+    typedef struct
+    {
+        const char  *name;       /**< Thread name */
+        uint32_t     attr_bits;  /**< Not used on the host */
+        void        *cb_mem;     /**< Not used on the host */
+        uint32_t     cb_size;    /**< Not used on the host */
+        void        *stack_mem;  /**< Not used on the host */
+        uint32_t     stack_size; /**< Stack size of the thread on the target */
+        osPriority_t priority;   /**< Thread priority */
+        uint32_t     tz_module;  /**< Not used on the host */
+        uint32_t     reserved;   /**< Reserved */
+    } osThreadAttr_t;
+
+    /**
+     * @brief Mutex attributes
+     */
+    typedef struct
+    {
+        const char *name;      /**< Mutex name */
+        uint32_t    attr_bits; /**< osMutexRecursive, osMutexPrioInherit, ... */
+        void       *cb_mem;    /**< Not used on the host */
+        uint32_t    cb_size;   /**< Not used on the host */
+    } osMutexAttr_t;
+
+    /**
+     * @brief Event flags attributes
+     */
+    typedef struct
+    {
+        const char *name;      /**< Event flags name */
+        uint32_t    attr_bits; /**< Not used on the host */
+        void       *cb_mem;    /**< Not used on the host */
+        uint32_t    cb_size;   /**< Not used on the host */
+    } osEventFlagsAttr_t;
+
+    /**
+     * @brief Semaphore attributes
+     */
+    typedef struct
+    {
+        const char *name;      /**< Semaphore name */
+        uint32_t    attr_bits; /**< Not used on the host */
+        void       *cb_mem;    /**< Not used on the host */
+        uint32_t    cb_size;   /**< Not used on the host */
+    } osSemaphoreAttr_t;
+
+    /**
+     * @brief Message queue attributes
+     */
+    typedef struct
+    {
+        const char *name;      /**< Queue name */
+        uint32_t    attr_bits; /**< Not used on the host */
+        void       *cb_mem;    /**< Not used on the host */
+        uint32_t    cb_size;   /**< Not used on the host */
+        void       *mq_mem;    /**< Not used on the host */
+        uint32_t    mq_size;   /**< Not used on the host */
+    } osMessageQueueAttr_t;
+
+    /**
+     * @brief Memory pool attributes
+     */
+    typedef struct
+    {
+        const char *name;      /**< Pool name */
+        uint32_t    attr_bits; /**< Not used on the host */
+        void       *cb_mem;    /**< Not used on the host */
+        uint32_t    cb_size;   /**< Not used on the host */
+        void       *mp_mem;    /**< Not used on the host */
+        uint32_t    mp_size;   /**< Not used on the host */
+    } osMemoryPoolAttr_t;
+
+    /**
+     * @brief Initialize the kernel and start its tick counter
+     * @return osOK on success
+     */
+    osStatus_t osKernelInitialize(void);
+
+    /**
+     * @brief Let the threads created so far run
+     * @note Like on the target, does not return on success.
+     * @return Error code if the kernel was not initialized
+     */
+    osStatus_t osKernelStart(void);
+
+    /**
+     * @brief Get kernel state
+     * @return Kernel state
+     */
+    osKernelState_t osKernelGetState(void);
+
+    /**
+     * @brief Get milliseconds since osKernelInitialize()
+     * @return Tick count, wraps like on the target
+     */
+    uint32_t osKernelGetTickCount(void);
+
+    /**
+     * @brief Get tick frequency
+     * @return 1000 Hz
+     */
+    uint32_t osKernelGetTickFreq(void);
+
+    /**
+     * @brief Sleep for a number of ticks
+     * @param ticks Ticks to sleep
+     * @return osOK
+     */
+    osStatus_t osDelay(uint32_t ticks);
+
+    /**
+     * @brief Create a thread
+     * @details Threads created before osKernelStart() wait until it is called.
+     * @param func Thread entry point
+     * @param argument Argument passed to func
+     * @param attr Thread attributes, can be NULL
+     * @return Thread handle, NULL on error
+     */
+    osThreadId_t
+    osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr);
+
+    /**
+     * @brief Get handle of the calling thread
+     * @return Thread handle, NULL if not called from a thread created by osThreadNew()
+     */
+    osThreadId_t osThreadGetId(void);
+
+    /**
+     * @brief Get unused stack of a thread
+     * @note Stack usage is not tracked on the host.
+     * @param thread_id Thread handle
+     * @return 0
+     */
+    uint32_t osThreadGetStackSpace(osThreadId_t thread_id);
+
+    /**
+     * @brief Terminate the calling thread
+     */
+    void osThreadExit(void) __attribute__((noreturn));
+
+    /**
+     * @brief Create a mutex
+     * @param attr Mutex attributes, can be NULL
+     * @return Mutex handle, NULL on error
+     */
+    osMutexId_t osMutexNew(const osMutexAttr_t *attr);
+
+    /**
+     * @brief Acquire a mutex
+     * @param mutex_id Mutex handle
+     * @param timeout Timeout in ticks, 0 to try, osWaitForever to block
+     * @return osOK, osErrorTimeout, osErrorResource or osErrorParameter
+     */
+    osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout);
+
+    /**
+     * @brief Release a mutex
+     * @param mutex_id Mutex handle
+     * @return osOK or osErrorParameter
+     */
+    osStatus_t osMutexRelease(osMutexId_t mutex_id);
+
+    /**
+     * @brief Delete a mutex
+     * @param mutex_id Mutex handle
+     * @return osOK or osErrorParameter
+     */
+    osStatus_t osMutexDelete(osMutexId_t mutex_id);
+
+    /**
+     * @brief Create a counting semaphore
+     * @param max_count Largest token count
+     * @param initial_count Initial token count
+     * @param attr Semaphore attributes, can be NULL
+     * @return Semaphore handle, NULL on error
+     */
+    osSemaphoreId_t osSemaphoreNew(
+        uint32_t max_count, uint32_t initial_count, const osSemaphoreAttr_t *attr
+    );
+
+    /**
+     * @brief Take a token
+     * @param semaphore_id Semaphore handle
+     * @param timeout Timeout in ticks, 0 to try, osWaitForever to block
+     * @return osOK, osErrorTimeout, osErrorResource or osErrorParameter
+     */
+    osStatus_t osSemaphoreAcquire(osSemaphoreId_t semaphore_id, uint32_t timeout);
+
+    /**
+     * @brief Return a token
+     * @param semaphore_id Semaphore handle
+     * @return osOK, osErrorResource if the count is at its maximum
+     */
+    osStatus_t osSemaphoreRelease(osSemaphoreId_t semaphore_id);
+
+    /**
+     * @brief Delete a semaphore
+     * @param semaphore_id Semaphore handle
+     * @return osOK or osErrorParameter
+     */
+    osStatus_t osSemaphoreDelete(osSemaphoreId_t semaphore_id);
+
+    /**
+     * @brief Create an event flags object with all flags cleared
+     * @param attr Event flags attributes, can be NULL
+     * @return Event flags handle, NULL on error
+     */
+    osEventFlagsId_t osEventFlagsNew(const osEventFlagsAttr_t *attr);
+
+    /**
+     * @brief Set flags and wake the threads waiting for them
+     * @param ef_id Event flags handle
+     * @param flags Flags to set
+     * @return Flags after setting, or an osFlagsError code
+     */
+    uint32_t osEventFlagsSet(osEventFlagsId_t ef_id, uint32_t flags);
+
+    /**
+     * @brief Clear flags
+     * @param ef_id Event flags handle
+     * @param flags Flags to clear
+     * @return Flags before clearing, or an osFlagsError code
+     */
+    uint32_t osEventFlagsClear(osEventFlagsId_t ef_id, uint32_t flags);
+
+    /**
+     * @brief Wait for flags to be set
+     * @param ef_id Event flags handle
+     * @param flags Flags to wait for
+     * @param options osFlagsWaitAny or osFlagsWaitAll, optionally osFlagsNoClear
+     * @param timeout Timeout in ticks, 0 to try, osWaitForever to block
+     * @return Flags before clearing, or an osFlagsError code
+     */
+    uint32_t osEventFlagsWait(
+        osEventFlagsId_t ef_id, uint32_t flags, uint32_t options, uint32_t timeout
+    );
+
+    /**
+     * @brief Delete an event flags object
+     * @param ef_id Event flags handle
+     * @return osOK or osErrorParameter
+     */
+    osStatus_t osEventFlagsDelete(osEventFlagsId_t ef_id);
+
+    /**
+     * @brief Create a message queue
+     * @param msg_count Queue capacity in messages
+     * @param msg_size Size of one message in bytes
+     * @param attr Queue attributes, can be NULL
+     * @return Queue handle, NULL on error
+     */
+    osMessageQueueId_t osMessageQueueNew(
+        uint32_t msg_count, uint32_t msg_size, const osMessageQueueAttr_t *attr
+    );
+
+    /**
+     * @brief Append a message
+     * @param mq_id Queue handle
+     * @param msg_ptr Message to copy into the queue
+     * @param msg_prio Not used on the host, messages are kept in FIFO order
+     * @param timeout Timeout in ticks, 0 to try, osWaitForever to block
+     * @return osOK, osErrorTimeout, osErrorResource or osErrorParameter
+     */
+    osStatus_t osMessageQueuePut(
+        osMessageQueueId_t mq_id, const void *msg_ptr, uint8_t msg_prio,
+        uint32_t timeout
+    );
+
+    /**
+     * @brief Take the oldest message
+     * @param mq_id Queue handle
+     * @param msg_ptr Destination of the message
+     * @param msg_prio Set to 0 if not NULL
+     * @param timeout Timeout in ticks, 0 to try, osWaitForever to block
+     * @return osOK, osErrorTimeout, osErrorResource or osErrorParameter
+     */
+    osStatus_t osMessageQueueGet(
+        osMessageQueueId_t mq_id, void *msg_ptr, uint8_t *msg_prio, uint32_t timeout
+    );
+
+    /**
+     * @brief Get number of queued messages
+     * @param mq_id Queue handle
+     * @return Queued messages
+     */
+    uint32_t osMessageQueueGetCount(osMessageQueueId_t mq_id);
+
+    /**
+     * @brief Drop every queued message
+     * @param mq_id Queue handle
+     * @return osOK or osErrorParameter
+     */
+    osStatus_t osMessageQueueReset(osMessageQueueId_t mq_id);
+
+    /**
+     * @brief Delete a message queue
+     * @param mq_id Queue handle
+     * @return osOK or osErrorParameter
+     */
+    osStatus_t osMessageQueueDelete(osMessageQueueId_t mq_id);
+
+    /**
+     * @brief Create a pool of fixed-size blocks
+     * @param block_count Number of blocks
+     * @param block_size Size of one block in bytes
+     * @param attr Pool attributes, can be NULL
+     * @return Pool handle, NULL on error
+     */
+    osMemoryPoolId_t osMemoryPoolNew(
+        uint32_t block_count, uint32_t block_size, const osMemoryPoolAttr_t *attr
+    );
+
+    /**
+     * @brief Take a block
+     * @param mp_id Pool handle
+     * @param timeout Timeout in ticks, 0 to try, osWaitForever to block
+     * @return Block, NULL on timeout or error
+     */
+    void *osMemoryPoolAlloc(osMemoryPoolId_t mp_id, uint32_t timeout);
+
+    /**
+     * @brief Return a block
+     * @param mp_id Pool handle
+     * @param block Block taken from this pool
+     * @return osOK, osErrorParameter if block is not from this pool
+     */
+    osStatus_t osMemoryPoolFree(osMemoryPoolId_t mp_id, void *block);
+
+    /**
+     * @brief Delete a memory pool
+     * @param mp_id Pool handle
+     * @return osOK or osErrorParameter
+     */
+    osStatus_t osMemoryPoolDelete(osMemoryPoolId_t mp_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CMSIS_OS2_H */
+
+/** End of HostRTOS group */
+/** @} */
@@ -0,0 +1,38 @@
+/**
+ * @file rl_net.h
+ * @brief Network stack stub for the host build
+ * @details The host kernel is the network stack, so bringing it up is a no-op.
+ * Sockets are provided by udp_socket_posix.c.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#ifndef RL_NET_H
+#define RL_NET_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /** Network stack status codes */
+    typedef enum
+    {
+        netOK    = 0, /**< Operation succeeded */
+        netError = 8  /**< Unspecified error */
+    } netStatus;
+
+    /**
+     * @brief Initialize the network stack
+     * @return Always netOK
+     */
+    static inline netStatus netInitialize(void)
+    {
+        return netOK;
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RL_NET_H */
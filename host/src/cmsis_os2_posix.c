@@ -0,0 +1,903 @@
+/**
+ * @file cmsis_os2_posix.c
+ * @brief CMSIS-RTOS2 subset on POSIX threads for the host build
+ * @details A thread created with a stack size runs on a stack of
+ * HOST_STACK_SIZE painted with HOST_STACK_PATTERN, as RTX paints stacks with
+ * OS_STACK_WATERMARK. osThreadGetStackSpace() then reports the stack size asked
+ * for minus the deepest use below the entry point, 0 once that exceeds it.
+ * x86-64 frames are larger than Cortex-M3 ones, so the figure errs on the safe
+ * side for code from this tree, but it leaves out RL-NET and the target C
+ * library.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#define _GNU_SOURCE
+
+#include "cmsis_os2.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/** Longest thread name Linux accepts, without the terminator */
+#define THREAD_NAME_MAX 15
+/** Real stack of a thread with a stack size, ample for any target size */
+#define HOST_STACK_SIZE (1024U * 1024U)
+/** Fill of unused stack, as RTX uses */
+#define HOST_STACK_PATTERN 0xCCCCCCCCU
+
+/**
+ * @brief Thread control block
+ */
+typedef struct
+{
+    pthread_t      thread;     /**< POSIX thread */
+    osThreadFunc_t func;       /**< Entry point */
+    void          *argument;   /**< Entry point argument */
+    const char    *name;       /**< Name from the attributes */
+    uint32_t       stack_size; /**< Stack size on the target */
+    osPriority_t   priority;   /**< Priority on the target */
+    uint32_t      *stack;      /**< Painted stack, NULL without a stack size */
+    uintptr_t      entry_sp;   /**< Stack address at the entry point */
+} host_thread_t;
+
+typedef struct
+{
+    pthread_mutex_t mutex;
+} host_mutex_t;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  available;
+    uint32_t        count;
+    uint32_t        max_count;
+} host_semaphore_t;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  changed;
+    uint32_t        flags;
+} host_event_flags_t;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  not_empty;
+    pthread_cond_t  not_full;
+    uint32_t        msg_size;
+    uint32_t        capacity;
+    uint32_t        head;
+    uint32_t        count;
+    uint8_t         data[];
+} host_queue_t;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  available;
+    uint32_t        block_size;
+    uint32_t        block_count;
+    uint32_t        free_count;
+    void          **free_list;
+    uint8_t        *blocks;
+} host_pool_t;
+
+/** Kernel state, guarded by kernel_lock */
+static osKernelState_t kernel_state = osKernelInactive;
+static pthread_mutex_t kernel_lock  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  kernel_start = PTHREAD_COND_INITIALIZER;
+
+/** CLOCK_MONOTONIC time of osKernelInitialize() */
+static struct timespec kernel_epoch;
+
+/** Control block of the calling thread */
+static __thread host_thread_t *current_thread = NULL;
+
+static uint64_t timespec_ms(const struct timespec *ts)
+{
+    return (uint64_t)ts->tv_sec * 1000U + (uint64_t)ts->tv_nsec / 1000000U;
+}
+
+/**
+ * @brief CLOCK_MONOTONIC deadline ticks milliseconds from now
+ */
+static void deadline_after(uint32_t ticks, struct timespec *deadline)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+
+    deadline->tv_sec += ticks / 1000U;
+    deadline->tv_nsec += (long)(ticks % 1000U) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * @brief Create a condition variable waiting on CLOCK_MONOTONIC
+ */
+static void cond_init(pthread_cond_t *cond)
+{
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/**
+ * @brief Wait on cond until signalled or the deadline passes
+ * @return 0 when signalled, ETIMEDOUT after the deadline
+ */
+static int cond_wait(pthread_cond_t *cond, pthread_mutex_t *lock, uint32_t timeout,
+                     const struct timespec *deadline)
+{
+    if (timeout == osWaitForever)
+    {
+        return pthread_cond_wait(cond, lock);
+    }
+    return pthread_cond_timedwait(cond, lock, deadline);
+}
+
+static void *thread_entry(void *argument)
+{
+    host_thread_t *self = argument;
+
+    /* Like on the target, nothing runs before osKernelStart() */
+    pthread_mutex_lock(&kernel_lock);
+    while (kernel_state != osKernelRunning)
+    {
+        pthread_cond_wait(&kernel_start, &kernel_lock);
+    }
+    pthread_mutex_unlock(&kernel_lock);
+
+    current_thread = self;
+    self->entry_sp = (uintptr_t)__builtin_frame_address(0);
+    self->func(self->argument);
+
+    return NULL;
+}
+
+osStatus_t osKernelInitialize(void)
+{
+    pthread_mutex_lock(&kernel_lock);
+
+    if (kernel_state == osKernelInactive)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &kernel_epoch);
+        kernel_state = osKernelReady;
+    }
+
+    pthread_mutex_unlock(&kernel_lock);
+    return osOK;
+}
+
+osStatus_t osKernelStart(void)
+{
+    pthread_mutex_lock(&kernel_lock);
+
+    if (kernel_state != osKernelReady)
+    {
+        pthread_mutex_unlock(&kernel_lock);
+        return osError;
+    }
+
+    kernel_state = osKernelRunning;
+    pthread_cond_broadcast(&kernel_start);
+    pthread_mutex_unlock(&kernel_lock);
+
+    for (;;)
+    {
+        pause();
+    }
+}
+
+osKernelState_t osKernelGetState(void)
+{
+    return kernel_state;
+}
+
+uint32_t osKernelGetTickCount(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(timespec_ms(&now) - timespec_ms(&kernel_epoch));
+}
+
+uint32_t osKernelGetTickFreq(void)
+{
+    return 1000U;
+}
+
+osStatus_t osDelay(uint32_t ticks)
+{
+    if (ticks == 0)
+    {
+        return osErrorParameter;
+    }
+
+    struct timespec delay = {
+        .tv_sec  = ticks / 1000U,
+        .tv_nsec = (long)(ticks % 1000U) * 1000000L,
+    };
+
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR)
+    {
+    }
+
+    return osOK;
+}
+
+osThreadId_t
+osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr)
+{
+    if (func == NULL)
+    {
+        return NULL;
+    }
+
+    host_thread_t *thread = calloc(1, sizeof(*thread));
+    if (thread == NULL)
+    {
+        return NULL;
+    }
+
+    thread->func     = func;
+    thread->argument = argument;
+    thread->priority = osPriorityNormal;
+    if (attr != NULL)
+    {
+        thread->name       = attr->name;
+        thread->stack_size = attr->stack_size;
+        thread->priority   = attr->priority;
+    }
+
+    pthread_attr_t pattr;
+    pthread_attr_init(&pattr);
+    pthread_attr_setdetachstate(&pattr, PTHREAD_CREATE_DETACHED);
+
+    if (thread->stack_size != 0U)
+    {
+        thread->stack = malloc(HOST_STACK_SIZE);
+        if (thread->stack == NULL)
+        {
+            pthread_attr_destroy(&pattr);
+            free(thread);
+            return NULL;
+        }
+        for (size_t i = 0; i < HOST_STACK_SIZE / sizeof(uint32_t); i++)
+        {
+            thread->stack[i] = HOST_STACK_PATTERN;
+        }
+        pthread_attr_setstack(&pattr, thread->stack, HOST_STACK_SIZE);
+    }
+
+    int err = pthread_create(&thread->thread, &pattr, thread_entry, thread);
+    pthread_attr_destroy(&pattr);
+    if (err != 0)
+    {
+        free(thread->stack);
+        free(thread);
+        return NULL;
+    }
+
+    if (thread->name != NULL)
+    {
+        char name[THREAD_NAME_MAX + 1];
+
+        strncpy(name, thread->name, THREAD_NAME_MAX);
+        name[THREAD_NAME_MAX] = '\0';
+        pthread_setname_np(thread->thread, name);
+    }
+
+    /* The control block stays allocated: handles may outlive the thread */
+    return thread;
+}
+
+osThreadId_t osThreadGetId(void)
+{
+    return current_thread;
+}
+
+uint32_t osThreadGetStackSpace(osThreadId_t thread_id)
+{
+    host_thread_t *thread = thread_id;
+
+    if (thread == NULL || thread->stack == NULL || thread->entry_sp == 0U)
+    {
+        return 0;
+    }
+
+    /* The stack grows down, the first overwritten word is the deepest use */
+    size_t words = HOST_STACK_SIZE / sizeof(uint32_t);
+    size_t i     = 0;
+    while (i < words && thread->stack[i] == HOST_STACK_PATTERN)
+    {
+        i++;
+    }
+
+    uintptr_t deepest = (uintptr_t)&thread->stack[i];
+    uintptr_t used    = (thread->entry_sp > deepest) ? thread->entry_sp - deepest : 0U;
+
+    return (used < thread->stack_size) ? thread->stack_size - (uint32_t)used : 0U;
+}
+
+void osThreadExit(void)
+{
+    pthread_exit(NULL);
+}
+
+osMutexId_t osMutexNew(const osMutexAttr_t *attr)
+{
+    host_mutex_t *mutex = calloc(1, sizeof(*mutex));
+    if (mutex == NULL)
+    {
+        return NULL;
+    }
+
+    uint32_t            bits = (attr != NULL) ? attr->attr_bits : 0U;
+    pthread_mutexattr_t mattr;
+
+    pthread_mutexattr_init(&mattr);
+    pthread_mutexattr_settype(
+        &mattr,
+        (bits & osMutexRecursive) ? PTHREAD_MUTEX_RECURSIVE : PTHREAD_MUTEX_ERRORCHECK
+    );
+    if (bits & osMutexPrioInherit)
+    {
+        pthread_mutexattr_setprotocol(&mattr, PTHREAD_PRIO_INHERIT);
+    }
+    if (bits & osMutexRobust)
+    {
+        pthread_mutexattr_setrobust(&mattr, PTHREAD_MUTEX_ROBUST);
+    }
+
+    int err = pthread_mutex_init(&mutex->mutex, &mattr);
+    pthread_mutexattr_destroy(&mattr);
+    if (err != 0)
+    {
+        free(mutex);
+        return NULL;
+    }
+
+    return mutex;
+}
+
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout)
+{
+    host_mutex_t *mutex = mutex_id;
+    int           err;
+
+    if (mutex == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    if (timeout == 0)
+    {
+        err = pthread_mutex_trylock(&mutex->mutex);
+    }
+    else if (timeout == osWaitForever)
+    {
+        err = pthread_mutex_lock(&mutex->mutex);
+    }
+    else
+    {
+        struct timespec deadline;
+
+        deadline_after(timeout, &deadline);
+        err = pthread_mutex_clocklock(&mutex->mutex, CLOCK_MONOTONIC, &deadline);
+    }
+
+    switch (err)
+    {
+        case 0:
+            return osOK;
+        case ETIMEDOUT:
+            return osErrorTimeout;
+        case EBUSY:
+            return osErrorResource;
+        default:
+            return osError;
+    }
+}
+
+osStatus_t osMutexRelease(osMutexId_t mutex_id)
+{
+    host_mutex_t *mutex = mutex_id;
+
+    if (mutex == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    return (pthread_mutex_unlock(&mutex->mutex) == 0) ? osOK : osErrorResource;
+}
+
+osStatus_t osMutexDelete(osMutexId_t mutex_id)
+{
+    host_mutex_t *mutex = mutex_id;
+
+    if (mutex == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    pthread_mutex_destroy(&mutex->mutex);
+    free(mutex);
+    return osOK;
+}
+
+osSemaphoreId_t
+osSemaphoreNew(
+    uint32_t max_count, uint32_t initial_count, const osSemaphoreAttr_t *attr
+)
+{
+    (void)attr;
+
+    if (max_count == 0 || initial_count > max_count)
+    {
+        return NULL;
+    }
+
+    host_semaphore_t *sem = calloc(1, sizeof(*sem));
+    if (sem == NULL)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_init(&sem->lock, NULL);
+    cond_init(&sem->available);
+    sem->count     = initial_count;
+    sem->max_count = max_count;
+
+    return sem;
+}
+
+osStatus_t osSemaphoreAcquire(osSemaphoreId_t semaphore_id, uint32_t timeout)
+{
+    host_semaphore_t *sem = semaphore_id;
+    struct timespec   deadline;
+
+    if (sem == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    deadline_after(timeout, &deadline);
+    pthread_mutex_lock(&sem->lock);
+
+    while (sem->count == 0)
+    {
+        if (timeout == 0 ||
+            cond_wait(&sem->available, &sem->lock, timeout, &deadline) == ETIMEDOUT)
+        {
+            pthread_mutex_unlock(&sem->lock);
+            return (timeout == 0) ? osErrorResource : osErrorTimeout;
+        }
+    }
+
+    sem->count--;
+    pthread_mutex_unlock(&sem->lock);
+    return osOK;
+}
+
+osStatus_t osSemaphoreRelease(osSemaphoreId_t semaphore_id)
+{
+    host_semaphore_t *sem    = semaphore_id;
+    osStatus_t        status = osOK;
+
+    if (sem == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    pthread_mutex_lock(&sem->lock);
+    if (sem->count < sem->max_count)
+    {
+        sem->count++;
+        pthread_cond_signal(&sem->available);
+    }
+    else
+    {
+        status = osErrorResource;
+    }
+    pthread_mutex_unlock(&sem->lock);
+
+    return status;
+}
+
+osStatus_t osSemaphoreDelete(osSemaphoreId_t semaphore_id)
+{
+    host_semaphore_t *sem = semaphore_id;
+
+    if (sem == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    pthread_cond_destroy(&sem->available);
+    pthread_mutex_destroy(&sem->lock);
+    free(sem);
+    return osOK;
+}
+
+osEventFlagsId_t osEventFlagsNew(const osEventFlagsAttr_t *attr)
+{
+    (void)attr;
+
+    host_event_flags_t *ef = calloc(1, sizeof(*ef));
+    if (ef == NULL)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_init(&ef->lock, NULL);
+    cond_init(&ef->changed);
+
+    return ef;
+}
+
+uint32_t osEventFlagsSet(osEventFlagsId_t ef_id, uint32_t flags)
+{
+    host_event_flags_t *ef = ef_id;
+
+    if (ef == NULL || (flags & osFlagsError) != 0U)
+    {
+        return osFlagsErrorParameter;
+    }
+
+    pthread_mutex_lock(&ef->lock);
+    ef->flags |= flags;
+    uint32_t result = ef->flags;
+    pthread_cond_broadcast(&ef->changed);
+    pthread_mutex_unlock(&ef->lock);
+
+    return result;
+}
+
+uint32_t osEventFlagsClear(osEventFlagsId_t ef_id, uint32_t flags)
+{
+    host_event_flags_t *ef = ef_id;
+
+    if (ef == NULL || (flags & osFlagsError) != 0U)
+    {
+        return osFlagsErrorParameter;
+    }
+
+    pthread_mutex_lock(&ef->lock);
+    uint32_t result = ef->flags;
+    ef->flags &= ~flags;
+    pthread_mutex_unlock(&ef->lock);
+
+    return result;
+}
+
+uint32_t osEventFlagsWait(
+    osEventFlagsId_t ef_id, uint32_t flags, uint32_t options, uint32_t timeout
+)
+{
+    host_event_flags_t *ef = ef_id;
+    struct timespec     deadline;
+
+    if (ef == NULL || flags == 0U || (flags & osFlagsError) != 0U)
+    {
+        return osFlagsErrorParameter;
+    }
+
+    deadline_after(timeout, &deadline);
+    pthread_mutex_lock(&ef->lock);
+
+    for (;;)
+    {
+        uint32_t set = ef->flags & flags;
+        bool     met = (options & osFlagsWaitAll) ? (set == flags) : (set != 0U);
+
+        if (met)
+        {
+            uint32_t result = ef->flags;
+            if ((options & osFlagsNoClear) == 0U)
+            {
+                ef->flags &= ~flags;
+            }
+            pthread_mutex_unlock(&ef->lock);
+            return result;
+        }
+
+        if (timeout == 0 ||
+            cond_wait(&ef->changed, &ef->lock, timeout, &deadline) == ETIMEDOUT)
+        {
+            pthread_mutex_unlock(&ef->lock);
+            return (timeout == 0) ? osFlagsErrorResource : osFlagsErrorTimeout;
+        }
+    }
+}
+
+osStatus_t osEventFlagsDelete(osEventFlagsId_t ef_id)
+{
+    host_event_flags_t *ef = ef_id;
+
+    if (ef == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    pthread_cond_destroy(&ef->changed);
+    pthread_mutex_destroy(&ef->lock);
+    free(ef);
+    return osOK;
+}
+
+osMessageQueueId_t
+osMessageQueueNew(
+    uint32_t msg_count, uint32_t msg_size, const osMessageQueueAttr_t *attr
+)
+{
+    (void)attr;
+
+    if (msg_count == 0 || msg_size == 0)
+    {
+        return NULL;
+    }
+
+    host_queue_t *queue = calloc(1, sizeof(*queue) + (size_t)msg_count * msg_size);
+    if (queue == NULL)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_init(&queue->lock, NULL);
+    cond_init(&queue->not_empty);
+    cond_init(&queue->not_full);
+    queue->msg_size = msg_size;
+    queue->capacity = msg_count;
+
+    return queue;
+}
+
+osStatus_t osMessageQueuePut(
+    osMessageQueueId_t mq_id, const void *msg_ptr, uint8_t msg_prio, uint32_t timeout
+)
+{
+    host_queue_t   *queue = mq_id;
+    struct timespec deadline;
+
+    (void)msg_prio;
+
+    if (queue == NULL || msg_ptr == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    deadline_after(timeout, &deadline);
+    pthread_mutex_lock(&queue->lock);
+
+    while (queue->count == queue->capacity)
+    {
+        if (timeout == 0 ||
+            cond_wait(&queue->not_full, &queue->lock, timeout, &deadline) == ETIMEDOUT)
+        {
+            pthread_mutex_unlock(&queue->lock);
+            return (timeout == 0) ? osErrorResource : osErrorTimeout;
+        }
+    }
+
+    uint32_t slot = (queue->head + queue->count) % queue->capacity;
+    memcpy(&queue->data[(size_t)slot * queue->msg_size], msg_ptr, queue->msg_size);
+    queue->count++;
+
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+    return osOK;
+}
+
+osStatus_t osMessageQueueGet(
+    osMessageQueueId_t mq_id, void *msg_ptr, uint8_t *msg_prio, uint32_t timeout
+)
+{
+    host_queue_t   *queue = mq_id;
+    struct timespec deadline;
+
+    if (queue == NULL || msg_ptr == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    deadline_after(timeout, &deadline);
+    pthread_mutex_lock(&queue->lock);
+
+    while (queue->count == 0)
+    {
+        if (timeout == 0 ||
+            cond_wait(&queue->not_empty, &queue->lock, timeout, &deadline) == ETIMEDOUT)
+        {
+            pthread_mutex_unlock(&queue->lock);
+            return (timeout == 0) ? osErrorResource : osErrorTimeout;
+        }
+    }
+
+    size_t offset = (size_t)queue->head * queue->msg_size;
+    memcpy(msg_ptr, &queue->data[offset], queue->msg_size);
+    queue->head = (queue->head + 1U) % queue->capacity;
+    queue->count--;
+
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+
+    if (msg_prio != NULL)
+    {
+        *msg_prio = 0;
+    }
+    return osOK;
+}
+
+uint32_t osMessageQueueGetCount(osMessageQueueId_t mq_id)
+{
+    host_queue_t *queue = mq_id;
+
+    return (queue != NULL) ? queue->count : 0U;
+}
+
+osStatus_t osMessageQueueReset(osMessageQueueId_t mq_id)
+{
+    host_queue_t *queue = mq_id;
+
+    if (queue == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    pthread_mutex_lock(&queue->lock);
+    queue->head  = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+
+    return osOK;
+}
+
+osStatus_t osMessageQueueDelete(osMessageQueueId_t mq_id)
+{
+    host_queue_t *queue = mq_id;
+
+    if (queue == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue);
+    return osOK;
+}
+
+osMemoryPoolId_t
+osMemoryPoolNew(
+    uint32_t block_count, uint32_t block_size, const osMemoryPoolAttr_t *attr
+)
+{
+    (void)attr;
+
+    if (block_count == 0 || block_size == 0)
+    {
+        return NULL;
+    }
+
+    /* Keep blocks aligned like the RTX pool does */
+    block_size = (block_size + 7U) & ~7U;
+
+    host_pool_t *pool = calloc(1, sizeof(*pool));
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+
+    pool->blocks    = calloc(block_count, block_size);
+    pool->free_list = calloc(block_count, sizeof(void *));
+    if (pool->blocks == NULL || pool->free_list == NULL)
+    {
+        free(pool->blocks);
+        free(pool->free_list);
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    cond_init(&pool->available);
+    pool->block_size  = block_size;
+    pool->block_count = block_count;
+    pool->free_count  = block_count;
+    for (uint32_t i = 0; i < block_count; i++)
+    {
+        pool->free_list[i] = &pool->blocks[(size_t)i * block_size];
+    }
+
+    return pool;
+}
+
+void *osMemoryPoolAlloc(osMemoryPoolId_t mp_id, uint32_t timeout)
+{
+    host_pool_t    *pool = mp_id;
+    struct timespec deadline;
+
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+
+    deadline_after(timeout, &deadline);
+    pthread_mutex_lock(&pool->lock);
+
+    while (pool->free_count == 0)
+    {
+        if (timeout == 0 ||
+            cond_wait(&pool->available, &pool->lock, timeout, &deadline) == ETIMEDOUT)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+    }
+
+    void *block = pool->free_list[--pool->free_count];
+    pthread_mutex_unlock(&pool->lock);
+
+    return block;
+}
+
+osStatus_t osMemoryPoolFree(osMemoryPoolId_t mp_id, void *block)
+{
+    host_pool_t *pool = mp_id;
+
+    if (pool == NULL || block == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    size_t offset = (size_t)((uint8_t *)block - pool->blocks);
+    if ((uint8_t *)block < pool->blocks ||
+        offset >= (size_t)pool->block_count * pool->block_size ||
+        offset % pool->block_size != 0)
+    {
+        return osErrorParameter;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->free_count == pool->block_count)
+    {
+        pthread_mutex_unlock(&pool->lock);
+        return osErrorResource;
+    }
+    pool->free_list[pool->free_count++] = block;
+    pthread_cond_signal(&pool->available);
+    pthread_mutex_unlock(&pool->lock);
+
+    return osOK;
+}
+
+osStatus_t osMemoryPoolDelete(osMemoryPoolId_t mp_id)
+{
+    host_pool_t *pool = mp_id;
+
+    if (pool == NULL)
+    {
+        return osErrorParameter;
+    }
+
+    pthread_cond_destroy(&pool->available);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->free_list);
+    free(pool->blocks);
+    free(pool);
+    return osOK;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file logger_host.c
+ * @brief Logger module implementation writing to stdout for the host build
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "logger.h"
+
+#include "system.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOGGER_BUFFER_SIZE 256 /**< Internal buffer size, as on the target */
+
+static log_level_t    current_log_level = DEFAULT_LOG_LEVEL;
+static bool           initialized       = false;
+static char           log_buffer[LOGGER_BUFFER_SIZE];
+static logger_stats_t stats             = {0};
+
+static pthread_mutex_t logger_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @details SIM_LOG_LEVEL (0 = debug to 5 = none) overrides DEFAULT_LOG_LEVEL, so
+ * benchmarks are not slowed down by per-packet logging.
+ */
+logger_status_t logger_init(void)
+{
+    const char *level = getenv("SIM_LOG_LEVEL");
+
+    if (level != NULL && *level >= '0' && *level <= '5' && level[1] == '\0')
+    {
+        current_log_level = (log_level_t)(*level - '0');
+    }
+
+    initialized = true;
+    return LOGGER_OK;
+}
+
+logger_status_t logger_deinit(void)
+{
+    fflush(stdout);
+    initialized = false;
+    return LOGGER_OK;
+}
+
+void logger_set_level(log_level_t level)
+{
+    if (level <= LOG_LEVEL_NONE)
+    {
+        current_log_level = level;
+    }
+}
+
+log_level_t logger_get_level(void)
+{
+    return current_log_level;
+}
+
+void logger_get_stats(logger_stats_t *out_stats)
+{
+    if (out_stats != NULL)
+    {
+        *out_stats = stats;
+    }
+}
+
+int logger_log(log_level_t level, const char *format, ...)
+{
+    va_list args;
+    int     length;
+
+    if (!initialized)
+    {
+        return LOGGER_ERROR_INIT;
+    }
+
+    if (level < current_log_level || current_log_level == LOG_LEVEL_NONE)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&logger_mutex);
+
+    va_start(args, format);
+    length = vsnprintf(log_buffer, LOGGER_BUFFER_SIZE, format, args);
+    va_end(args);
+
+    if (length < 0)
+    {
+        stats.dropped++;
+        pthread_mutex_unlock(&logger_mutex);
+        return LOGGER_ERROR_PARAM;
+    }
+
+    /* Truncate like the target so the counters mean the same thing */
+    int chunk_size = (length < LOGGER_BUFFER_SIZE) ? length : LOGGER_BUFFER_SIZE - 1;
+
+    fwrite(log_buffer, 1, (size_t)chunk_size, stdout);
+    stats.messages++;
+    stats.bytes += (uint32_t)chunk_size;
+
+    if (length >= LOGGER_BUFFER_SIZE)
+    {
+        stats.truncated++;
+        fputs("...[TRUNCATED]...\r\n", stdout);
+    }
+
+    fflush(stdout);
+    pthread_mutex_unlock(&logger_mutex);
+
+    return chunk_size;
+}
+
+logger_status_t logger_write_raw(const void *data, uint32_t size)
+{
+    if (!initialized)
+    {
+        return LOGGER_ERROR_INIT;
+    }
+
+    if (data == NULL || size == 0)
+    {
+        return LOGGER_ERROR_PARAM;
+    }
+
+    pthread_mutex_lock(&logger_mutex);
+    fwrite(data, 1, size, stdout);
+    fflush(stdout);
+    pthread_mutex_unlock(&logger_mutex);
+
+    return LOGGER_OK;
+}
+
+logger_status_t logger_flush(uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+
+    if (!initialized)
+    {
+        return LOGGER_ERROR_INIT;
+    }
+
+    fflush(stdout);
+    return LOGGER_OK;
+}
@@ -0,0 +1,470 @@
+/**
+ * @file lpc17xx_sim.c
+ * @brief ADC and TIMER1 model driving the unmodified ADC driver on the host
+ * @details A simulator thread polls the register file the driver writes. A
+ * START_NOW request converts once; START_MAT10 with TIMER1 running converts at
+ * PCLK / (2 * (MR0 + 1)), the rate the real MAT1.0 toggle produces, optionally
+ * sped up. Each conversion loads ADGDR and calls ADC_IRQHandler() from the
+ * simulator thread, which plays the role of the interrupt.
+ *
+ * The input is configured from the environment by SystemCoreClockUpdate():
+ * - SIM_ADC_WAVE: sine (default), square, triangle, sawtooth, dc, noise or
+ *   count, the conversion number modulo 4096, which shows any lost or repeated
+ *   conversion
+ * - SIM_ADC_FREQ_HZ: waveform frequency, default 50
+ * - SIM_ADC_AMPLITUDE / SIM_ADC_OFFSET: in ADC codes, default 1500 / 2048
+ * - SIM_ADC_NOISE: RMS of gaussian noise added to the waveform, in ADC codes
+ * - SIM_ADC_CHANNEL_STEP: added to the offset per channel number, in ADC codes,
+ *   default 0, so each channel can be told apart by its level
+ * - SIM_ADC_FILE: play back codes from a file instead, one per line; the last
+ *   comma-separated field is used, so `capture` CSV output can be replayed
+ * - SIM_ADC_SPEED: timer rate multiplier, 1 for real time
+ *
+ * The waveform advances by one nominal sample period per conversion, so a
+ * sped-up run sees the same signal, only sooner. When the model falls more than
+ * SIM_MAX_BACKLOG_NS behind, it skips the conversions it owes the way the part
+ * keeps converting while the interrupt is not served: the waveform moves on
+ * and the next result carries the OVERRUN bit.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#define _GNU_SOURCE
+
+#include "LPC17xx.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Register fields the model reacts to, as in the user manual */
+#define ADCR_SEL_MASK      0xFFU
+#define ADCR_START_MASK    (7U << 24)
+#define ADCR_START_NOW     (1U << 24)
+#define ADCR_START_MAT10   (6U << 24)
+#define ADGDR_DONE         (1U << 31)
+#define ADGDR_OVERRUN      (1U << 30)
+#define ADGDR_CHN_SHIFT    24U
+#define ADGDR_RESULT_SHIFT 4U
+#define ADINTEN_GLOBAL     (1U << 8)
+#define TCR_ENABLE         (1U << 0)
+
+/** Peripheral clock divider of the ADC and TIMER1 */
+#define SIM_PCLK_DIV 4U
+/** Longest the model sleeps between register polls */
+#define SIM_POLL_NS 1000000L
+/** Conversions owed after a stall that are dropped rather than replayed */
+#define SIM_MAX_BACKLOG_NS 100000000LL
+/** Nominal rate of single conversions, only used as the waveform time base */
+#define SIM_SINGLE_RATE_HZ 1000.0
+/** Largest 12-bit code */
+#define SIM_ADC_MAX_CODE 4095
+
+/**
+ * @brief Simulated input waveforms
+ */
+typedef enum
+{
+    SIM_WAVE_SINE,
+    SIM_WAVE_SQUARE,
+    SIM_WAVE_TRIANGLE,
+    SIM_WAVE_SAWTOOTH,
+    SIM_WAVE_DC,
+    SIM_WAVE_NOISE,
+    SIM_WAVE_COUNT,
+    SIM_WAVE_FILE
+} sim_wave_t;
+
+static const char *const sim_wave_names[] = {
+    [SIM_WAVE_SINE]     = "sine",
+    [SIM_WAVE_SQUARE]   = "square",
+    [SIM_WAVE_TRIANGLE] = "triangle",
+    [SIM_WAVE_SAWTOOTH] = "sawtooth",
+    [SIM_WAVE_DC]       = "dc",
+    [SIM_WAVE_NOISE]    = "noise",
+    [SIM_WAVE_COUNT]    = "count",
+    [SIM_WAVE_FILE]     = "file",
+};
+
+/**
+ * @brief Input configuration, fixed before the simulator thread starts
+ */
+static struct
+{
+    sim_wave_t wave;         /**< Waveform */
+    double     freq_hz;      /**< Waveform frequency */
+    double     amplitude;    /**< Peak amplitude in codes */
+    double     offset;       /**< Offset in codes */
+    double     noise;        /**< Noise RMS in codes */
+    double     channel_step; /**< Offset added per channel number in codes */
+    double     speed;        /**< Timer rate multiplier */
+    uint16_t  *file_samples; /**< Codes of SIM_WAVE_FILE */
+    size_t     file_len;     /**< Number of codes in file_samples */
+} sim_config = {
+    .wave      = SIM_WAVE_SINE,
+    .freq_hz   = 50.0,
+    .amplitude = 1500.0,
+    .offset    = 2048.0,
+    .noise     = 0.0,
+    .speed     = 1.0,
+};
+
+LPC_ADC_TypeDef    sim_adc;
+LPC_TIM_TypeDef    sim_tim1;
+LPC_SC_TypeDef     sim_sc;
+LPC_PINCON_TypeDef sim_pincon;
+LPC_GPIO_TypeDef   sim_gpio1;
+LPC_EMAC_TypeDef   sim_emac;
+
+uint32_t SystemCoreClock = 100000000U;
+
+extern void ADC_IRQHandler(void);
+
+static pthread_once_t sim_once        = PTHREAD_ONCE_INIT;
+static volatile bool  sim_adc_enabled = false;
+
+/** Conversions since start, the time base of the waveform */
+static uint64_t sim_conversions;
+/** Results were lost since the last conversion the handler saw */
+static bool sim_overrun = false;
+/** State of the noise generator */
+static uint64_t sim_rng_state = 0x9E3779B97F4A7C15ULL;
+
+static int64_t monotonic_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static void sleep_until_ns(int64_t deadline)
+{
+    struct timespec ts = {
+        .tv_sec  = deadline / 1000000000LL,
+        .tv_nsec = deadline % 1000000000LL,
+    };
+
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+static __attribute__((noreturn)) void config_error(const char *name, const char *value)
+{
+    fprintf(stderr, "Invalid %s: %s\n", name, value);
+    exit(2);
+}
+
+/**
+ * @brief Uniform random number in (0, 1) from a xorshift64* generator
+ */
+static double random_uniform(void)
+{
+    sim_rng_state ^= sim_rng_state >> 12;
+    sim_rng_state ^= sim_rng_state << 25;
+    sim_rng_state ^= sim_rng_state >> 27;
+
+    uint64_t bits = (sim_rng_state * 0x2545F4914F6CDD1DULL) >> 11;
+    return ((double)bits + 0.5) / 9007199254740992.0;
+}
+
+/**
+ * @brief Standard normal random number (Box-Muller)
+ */
+static double random_gauss(void)
+{
+    double u1 = random_uniform();
+    double u2 = random_uniform();
+
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static double env_double(const char *name, double fallback, double min)
+{
+    const char *value = getenv(name);
+    char       *end;
+
+    if (value == NULL || *value == '\0')
+    {
+        return fallback;
+    }
+
+    double parsed = strtod(value, &end);
+    if (*end != '\0' || !(parsed >= min))
+    {
+        config_error(name, value);
+    }
+    return parsed;
+}
+
+/**
+ * @brief Load the codes of a playback file
+ */
+static void load_file(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        config_error("SIM_ADC_FILE", path);
+    }
+
+    char   line[256];
+    size_t capacity = 0;
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        const char *field = strrchr(line, ',');
+        char       *end;
+
+        field     = (field != NULL) ? field + 1 : line;
+        long code = strtol(field, &end, 10);
+        if (end == field)
+        {
+            /* Header or blank line */
+            continue;
+        }
+
+        if (sim_config.file_len == capacity)
+        {
+            capacity = (capacity != 0) ? 2 * capacity : 4096;
+            sim_config.file_samples =
+                realloc(sim_config.file_samples, capacity * sizeof(uint16_t));
+            if (sim_config.file_samples == NULL)
+            {
+                config_error("SIM_ADC_FILE", "out of memory");
+            }
+        }
+
+        code = (code < 0) ? 0 : (code > SIM_ADC_MAX_CODE) ? SIM_ADC_MAX_CODE : code;
+        sim_config.file_samples[sim_config.file_len++] = (uint16_t)code;
+    }
+
+    fclose(file);
+
+    if (sim_config.file_len == 0)
+    {
+        config_error("SIM_ADC_FILE", "no samples");
+    }
+}
+
+void SystemCoreClockUpdate(void)
+{
+    const char *wave = getenv("SIM_ADC_WAVE");
+    const char *file = getenv("SIM_ADC_FILE");
+
+    if (file != NULL && *file != '\0')
+    {
+        sim_config.wave = SIM_WAVE_FILE;
+        load_file(file);
+    }
+    else if (wave != NULL && *wave != '\0')
+    {
+        size_t i;
+
+        for (i = 0; i < SIM_WAVE_FILE; i++)
+        {
+            if (strcmp(wave, sim_wave_names[i]) == 0)
+            {
+                break;
+            }
+        }
+        if (i == SIM_WAVE_FILE)
+        {
+            config_error("SIM_ADC_WAVE", wave);
+        }
+        sim_config.wave = (sim_wave_t)i;
+    }
+
+    sim_config.freq_hz   = env_double("SIM_ADC_FREQ_HZ", sim_config.freq_hz, 0.0);
+    sim_config.amplitude = env_double("SIM_ADC_AMPLITUDE", sim_config.amplitude, 0.0);
+    sim_config.offset    = env_double("SIM_ADC_OFFSET", sim_config.offset, 0.0);
+    sim_config.noise     = env_double("SIM_ADC_NOISE", sim_config.noise, 0.0);
+    sim_config.channel_step =
+        env_double("SIM_ADC_CHANNEL_STEP", sim_config.channel_step, 0.0);
+    sim_config.speed     = env_double("SIM_ADC_SPEED", sim_config.speed, 1e-3);
+
+    if (sim_config.wave == SIM_WAVE_FILE)
+    {
+        fprintf(
+            stderr, "sim: ADC plays %zu samples from %s, speed x%g\n",
+            sim_config.file_len, file, sim_config.speed
+        );
+    }
+    else
+    {
+        fprintf(
+            stderr, "sim: ADC input %s %g Hz, %g +/- %g codes, noise %g, speed x%g\n",
+            sim_wave_names[sim_config.wave], sim_config.freq_hz, sim_config.offset,
+            sim_config.amplitude, sim_config.noise, sim_config.speed
+        );
+    }
+}
+
+/**
+ * @brief Input voltage as a 12-bit code
+ * @param channel Converted channel
+ * @param rate_hz Nominal conversion rate, the time base of the waveform
+ */
+static uint16_t sample_input(uint32_t channel, double rate_hz)
+{
+    double t     = (double)sim_conversions / rate_hz;
+    double phase = fmod(sim_config.freq_hz * t, 1.0);
+    double wave  = 0.0;
+
+    switch (sim_config.wave)
+    {
+        case SIM_WAVE_SINE:
+            wave = sin(2.0 * M_PI * phase);
+            break;
+        case SIM_WAVE_SQUARE:
+            wave = (phase < 0.5) ? 1.0 : -1.0;
+            break;
+        case SIM_WAVE_TRIANGLE:
+            wave = 4.0 * fabs(phase - 0.5) - 1.0;
+            break;
+        case SIM_WAVE_SAWTOOTH:
+            wave = 2.0 * phase - 1.0;
+            break;
+        case SIM_WAVE_NOISE:
+            wave = 2.0 * random_uniform() - 1.0;
+            break;
+        case SIM_WAVE_COUNT:
+            return (uint16_t)(sim_conversions % (SIM_ADC_MAX_CODE + 1U));
+        case SIM_WAVE_FILE:
+            return sim_config.file_samples[sim_conversions % sim_config.file_len];
+        default:
+            break;
+    }
+
+    double value = sim_config.offset + sim_config.channel_step * channel +
+                   sim_config.amplitude * wave;
+    if (sim_config.noise > 0.0)
+    {
+        value += sim_config.noise * random_gauss();
+    }
+
+    if (value < 0.0)
+    {
+        return 0;
+    }
+    if (value > SIM_ADC_MAX_CODE)
+    {
+        return SIM_ADC_MAX_CODE;
+    }
+    return (uint16_t)lrint(value);
+}
+
+/**
+ * @brief Finish one conversion and raise the interrupt
+ */
+static void convert(double rate_hz)
+{
+    uint32_t sel     = sim_adc.ADCR & ADCR_SEL_MASK;
+    uint32_t channel = (sel != 0U) ? (uint32_t)__builtin_ctz(sel) : 0U;
+    uint16_t value   = sample_input(channel, rate_hz);
+
+    uint32_t overrun = sim_overrun ? ADGDR_OVERRUN : 0U;
+
+    sim_conversions++;
+    sim_overrun   = false;
+    sim_adc.ADGDR = ADGDR_DONE | overrun | (channel << ADGDR_CHN_SHIFT) |
+                    ((uint32_t)value << ADGDR_RESULT_SHIFT);
+    sim_adc.ADSTAT = 1U << 16;
+
+    if (sim_adc_enabled && (sim_adc.ADINTEN & ADINTEN_GLOBAL))
+    {
+        ADC_IRQHandler();
+    }
+}
+
+static void *sim_thread(void *argument)
+{
+    int64_t next_ns = 0;
+    bool    running = false;
+
+    (void)argument;
+
+    for (;;)
+    {
+        uint32_t start = sim_adc.ADCR & ADCR_START_MASK;
+        int64_t  now   = monotonic_ns();
+
+        if (start == ADCR_START_NOW)
+        {
+            /* The real part converts once per write of START_NOW */
+            sim_adc.ADCR &= ~ADCR_START_MASK;
+            convert(SIM_SINGLE_RATE_HZ);
+        }
+
+        bool triggered = (start == ADCR_START_MAT10) && (sim_tim1.TCR & TCR_ENABLE);
+        if (!triggered)
+        {
+            running = false;
+            sleep_until_ns(now + SIM_POLL_NS);
+            continue;
+        }
+
+        uint32_t pclk      = SystemCoreClock / SIM_PCLK_DIV;
+        uint64_t ticks     = 2ULL * (sim_tim1.MR0 + 1U);
+        double   rate_hz   = (double)pclk / (double)ticks;
+        int64_t  period_ns = (int64_t)(1e9 / (rate_hz * sim_config.speed));
+
+        if (period_ns < 1)
+        {
+            period_ns = 1;
+        }
+
+        if (!running)
+        {
+            running = true;
+            next_ns = now + period_ns;
+        }
+        else if (now - next_ns > SIM_MAX_BACKLOG_NS)
+        {
+            sim_conversions += (uint64_t)((now - next_ns) / period_ns);
+            sim_overrun = true;
+            next_ns     = now + period_ns;
+        }
+
+        /* The handler may stop the timer, so check it before every conversion */
+        while (next_ns <= now && (sim_tim1.TCR & TCR_ENABLE) &&
+               (sim_adc.ADCR & ADCR_START_MASK) == ADCR_START_MAT10)
+        {
+            convert(rate_hz);
+            next_ns += period_ns;
+        }
+
+        sleep_until_ns((next_ns < now + SIM_POLL_NS) ? next_ns : now + SIM_POLL_NS);
+    }
+
+    return NULL;
+}
+
+static void sim_start(void)
+{
+    pthread_t thread;
+
+    pthread_create(&thread, NULL, sim_thread, NULL);
+    pthread_setname_np(thread, "lpc17xx_sim");
+    pthread_detach(thread);
+}
+
+void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    if (IRQn == ADC_IRQn)
+    {
+        sim_adc_enabled = true;
+        pthread_once(&sim_once, sim_start);
+    }
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    if (IRQn == ADC_IRQn)
+    {
+        sim_adc_enabled = false;
+    }
+}
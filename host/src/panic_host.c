@@ -0,0 +1,25 @@
+/**
+ * @file panic_host.c
+ * @brief Panic handler of the host build
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "panic.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+void panic(const char *msg, const char *info)
+{
+    fflush(stdout);
+    fprintf(stderr, "\n*** PANIC ***\n%s", msg);
+    if (info)
+    {
+        fprintf(stderr, ": %s", info);
+    }
+    fputc('\n', stderr);
+
+    /* abort() leaves a core dump where the target would halt for the debugger */
+    abort();
+}
@@ -0,0 +1,133 @@
+/**
+ * @file system_host.c
+ * @brief System services of the host build
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "system.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/** Shortest window the CPU load is averaged over */
+#define CPU_LOAD_WINDOW_NS 1000000000LL
+
+/** CLOCK_MONOTONIC time at process start */
+static int64_t epoch_ns;
+
+static pthread_mutex_t load_lock = PTHREAD_MUTEX_INITIALIZER;
+static int64_t         load_wall_ns;
+static int64_t         load_cpu_ns;
+static uint16_t        load_permille;
+
+/** Boot milestones in microseconds from process start, 0 = not reached */
+static volatile uint32_t boot_us[SYSTEM_BOOT_PHASE_COUNT];
+
+static int64_t clock_ns(clockid_t clock)
+{
+    struct timespec now;
+
+    clock_gettime(clock, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+__attribute__((constructor)) static void system_host_init(void)
+{
+    epoch_ns     = clock_ns(CLOCK_MONOTONIC);
+    load_wall_ns = epoch_ns;
+    load_cpu_ns  = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+uint64_t system_time_us(void)
+{
+    return (uint64_t)(clock_ns(CLOCK_MONOTONIC) - epoch_ns) / 1000U;
+}
+
+/**
+ * @details On the host the load is the process CPU time over wall time, as a
+ * share of one core, so it is comparable to the single-core target.
+ */
+uint16_t system_cpu_load_permille(void)
+{
+    pthread_mutex_lock(&load_lock);
+
+    int64_t wall = clock_ns(CLOCK_MONOTONIC);
+    if (wall - load_wall_ns >= CPU_LOAD_WINDOW_NS)
+    {
+        int64_t cpu     = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+        int64_t permill = (cpu - load_cpu_ns) * 1000 / (wall - load_wall_ns);
+
+        load_permille = (uint16_t)((permill > 1000) ? 1000 : permill);
+        load_wall_ns  = wall;
+        load_cpu_ns   = cpu;
+    }
+
+    uint16_t load = load_permille;
+    pthread_mutex_unlock(&load_lock);
+
+    return load;
+}
+
+void system_get_kernel_stack_free(uint32_t *idle_free, uint32_t *timer_free)
+{
+    /* There are no kernel threads with a fixed stack on the host */
+    if (idle_free != NULL)
+    {
+        *idle_free = 0;
+    }
+
+    if (timer_free != NULL)
+    {
+        *timer_free = 0;
+    }
+}
+
+void system_boot_start(void)
+{
+    /* system_time_us() already counts from process start */
+}
+
+bool system_boot_mark(system_boot_phase_t phase)
+{
+    if (phase >= SYSTEM_BOOT_PHASE_COUNT || boot_us[phase] != 0U)
+    {
+        return false;
+    }
+
+    uint32_t us    = (uint32_t)system_time_us();
+    boot_us[phase] = (us != 0U) ? us : 1U;
+    return true;
+}
+
+uint32_t system_boot_phase_us(system_boot_phase_t phase)
+{
+    return (phase < SYSTEM_BOOT_PHASE_COUNT) ? boot_us[phase] : 0U;
+}
+
+/**
+ * @details Read from `SIM_AUTOSTART` as `IP:PORT`, so the host build can
+ * stream from boot without rebuilding.
+ */
+const char *system_autostart_target(uint16_t *port)
+{
+    static char  host[16];
+    const char  *value = getenv("SIM_AUTOSTART");
+    unsigned int p;
+
+    if (value == NULL || sscanf(value, "%15[0-9.]:%u", host, &p) != 2 || p == 0U ||
+        p > 65535U)
+    {
+        return NULL;
+    }
+
+    if (port != NULL)
+    {
+        *port = (uint16_t)p;
+    }
+
+    return host;
+}
@@ -0,0 +1,1291 @@
+/**
+ * @file udp_socket_posix.c
+ * @brief UDP Socket implementation on POSIX sockets for the host build
+ * @details Each socket gets a receiver thread standing in for the network stack
+ * callback of the target: it stamps and queues datagrams into the same bounded
+ * queue, so a slow consumer drops packets exactly like on the board.
+ *
+ * Sends can be limited by a model of the RL-NET memory pool, set from the
+ * environment:
+ * - SIM_NET_POOL_BYTES: pool size, unlimited when unset or 0
+ * - SIM_NET_LINK_BPS: link rate in bit/s at which sent frames free the pool,
+ *   default 100 Mbit/s
+ * - SIM_NET_POOL_GUARD: 0 turns off the send buffer ledger, default 1
+ * - SIM_NET_FLAP: "UP_MS,DOWN_MS" takes the link down for DOWN_MS after every
+ *   UP_MS, the way netETH_Notify() reports a flapping cable. While it is down,
+ *   sends fail with UDP_STATUS_LINK_DOWN and received datagrams are discarded.
+ * - SIM_NET_LINK_DELAY_MS: keeps the link down for that long after start, as
+ *   auto-negotiation does on the target, default 0
+ * - SIM_NET_ARP_MS: ARP resolution time, default 0 (no ARP model). A datagram
+ *   to an address not in the modelled cache starts a resolution and, like every
+ *   datagram to it until the reply, is dropped silently, as RL-NET does.
+ *   Temporary entries age out after the ETH0_ARP_CACHE_TOUT default of 150 s.
+ * - SIM_NET_ARP_SILENT: an IPv4 address that never answers ARP, so datagrams
+ *   to it are always lost while the ARP model is on
+ * - SIM_NET_MCAST_IF: IPv4 address of the interface multicast datagrams leave
+ *   from, e.g. 127.0.0.1 for receivers on this machine; by default they follow
+ *   the routing table
+ *
+ * The model is the instrumented allocator: a datagram that does not fit it
+ * panics, as netHandleError() does on the target. The same ledger as in
+ * udp_socket.c runs in front of it and refuses sends with UDP_STATUS_NO_MEMORY
+ * first, so with the guard on an overload must never reach the panic.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#define _GNU_SOURCE
+
+#include "udp_socket.h"
+
+#include "Net_Config_UDP.h"
+#include "cmsis_os2.h"
+#include "logger.h"
+#include "net_pool.h"
+#include "panic.h"
+#include "system.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** Maximum receive buffer size in bytes */
+#define UDP_RECV_BUFFER_SIZE UDP_MAX_PAYLOAD_SIZE
+/** Datagrams passed to one sendmmsg() call */
+#define UDP_SEND_BATCH_MAX 16U
+/** Default link rate of the pool model in bit/s */
+#define SIM_LINK_DEFAULT_BPS 100000000U
+/** Event flag set while the simulated link is up */
+#define UDP_LINK_EVENT_UP (1U << 0)
+/** Entries of the ARP cache model, as ETH0_ARP_TAB_SIZE */
+#define SIM_ARP_TAB_SIZE 10U
+/** Lifetime of a temporary ARP entry in us, as ETH0_ARP_CACHE_TOUT */
+#define SIM_ARP_CACHE_TOUT_US 150000000ULL
+
+/** Socket state flags */
+#define SOCKET_FLAG_USED    (1U << 0)
+#define SOCKET_FLAG_BOUND   (1U << 1)
+#define SOCKET_FLAG_CLOSING (1U << 3)
+
+/* RX packet stored in queue (allocated from per-socket memory pool) */
+typedef struct
+{
+    udp_endpoint_t remote;
+    uint64_t       rx_time_us;
+    uint16_t       len;
+    uint8_t        data[]; /* Sized by the socket's rx_max_len */
+} udp_rx_pkt_t;
+
+/* Special queue item meaning: socket is closing */
+#define UDP_RX_PKT_CLOSING ((udp_rx_pkt_t *)(uintptr_t)1U)
+
+/**
+ * @brief Internal socket structure
+ */
+typedef struct udp_socket
+{
+    int                fd;                /**< POSIX socket descriptor */
+    uint16_t           local_port;        /**< Bound local port */
+    volatile uint8_t   flags;             /**< Socket state flags */
+    pthread_t          receiver;          /**< Thread feeding rx_queue */
+    osMessageQueueId_t rx_queue;          /**< Queue of udp_rx_pkt_t* */
+    osMemoryPoolId_t   rx_pool;           /**< Pool of udp_rx_pkt_t blocks */
+    uint32_t           rx_queue_len;      /**< Receive queue capacity */
+    uint32_t           rx_max_len;        /**< Longest datagram queued */
+    udp_rx_filter_t    rx_filter;         /**< Filter applied before queueing */
+    void              *rx_filter_context; /**< Passed to rx_filter */
+    uint32_t           rx_dropped;        /**< Dropped RX packets */
+    uint32_t           rx_rejected;       /**< RX packets refused by length/filter */
+} udp_socket_internal_t;
+
+/** Socket pool */
+static udp_socket_internal_t socket_pool[UDP_NUM_SOCKS];
+
+/** Module initialized flag */
+static bool module_initialized = false;
+
+/** Mutex for socket pool access */
+static osMutexId_t socket_mutex = NULL;
+
+/** Model of the network stack memory pool that sent datagrams occupy */
+static net_pool_t sim_pool;
+/** Send buffer ledger, kept below sim_pool like the target keeps it below RL-NET */
+static net_pool_t      tx_pool;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** Simulated link state, changed only by the link thread */
+static volatile bool sim_link_up = true;
+/** Mirrors sim_link_up in UDP_LINK_EVENT_UP for udp_socket_wait_for_link() */
+static osEventFlagsId_t link_events = NULL;
+/** Link bring-up delay from SIM_NET_LINK_DELAY_MS */
+static uint32_t sim_link_delay_ms = 0;
+/** Link flap periods from SIM_NET_FLAP, 0 = no flapping */
+static uint32_t sim_flap_up_ms   = 0;
+static uint32_t sim_flap_down_ms = 0;
+
+/**
+ * @brief Entry of the ARP cache model
+ */
+typedef struct
+{
+    udp_ipv4_addr_t ip;         /**< Cached address */
+    uint64_t        ready_us;   /**< When the reply arrives */
+    uint64_t        expires_us; /**< When a temporary entry ages out */
+    bool            fixed;      /**< Pinned, never ages out */
+    bool            used;       /**< Entry in use */
+} sim_arp_entry_t;
+
+/** ARP cache model, off while sim_arp_us is 0 */
+static sim_arp_entry_t sim_arp[SIM_ARP_TAB_SIZE];
+static uint64_t        sim_arp_us = 0;
+/** Address from SIM_NET_ARP_SILENT, zero for none */
+static udp_ipv4_addr_t sim_arp_silent;
+static pthread_mutex_t arp_lock   = PTHREAD_MUTEX_INITIALIZER;
+
+/** Interface from SIM_NET_MCAST_IF, INADDR_ANY for the routing table's */
+static struct in_addr sim_mcast_if;
+
+static void sim_link_set(bool up)
+{
+    sim_link_up = up;
+    if (up)
+    {
+        (void)osEventFlagsSet(link_events, UDP_LINK_EVENT_UP);
+    }
+    else
+    {
+        (void)osEventFlagsClear(link_events, UDP_LINK_EVENT_UP);
+    }
+    fprintf(stderr, "sim: link %s\n", up ? "up" : "down");
+}
+
+/**
+ * @brief Bring the simulated link up late and flap it, standing in for
+ * netETH_Notify()
+ */
+static void *sim_link_thread(void *argument)
+{
+    (void)argument;
+
+    if (sim_link_delay_ms != 0U)
+    {
+        usleep(sim_link_delay_ms * 1000U);
+        sim_link_set(true);
+    }
+
+    while (sim_flap_up_ms != 0U)
+    {
+        usleep(sim_flap_up_ms * 1000U);
+        sim_link_set(false);
+
+        usleep(sim_flap_down_ms * 1000U);
+        sim_link_set(true);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Start the link thread if SIM_NET_LINK_DELAY_MS or SIM_NET_FLAP is set
+ */
+static void sim_link_init(void)
+{
+    const char *delay = getenv("SIM_NET_LINK_DELAY_MS");
+    const char *flap  = getenv("SIM_NET_FLAP");
+    unsigned    up    = 0;
+    unsigned    down  = 0;
+
+    link_events = osEventFlagsNew(NULL);
+    if (link_events == NULL)
+    {
+        panic("Failed to create UDP link events", NULL);
+    }
+
+    sim_link_delay_ms = (delay != NULL) ? (uint32_t)strtoul(delay, NULL, 0) : 0U;
+    if (flap != NULL && sscanf(flap, "%u,%u", &up, &down) == 2 && up != 0U &&
+        down != 0U)
+    {
+        sim_flap_up_ms   = up;
+        sim_flap_down_ms = down;
+        fprintf(stderr, "sim: link up %u ms, down %u ms\n", up, down);
+    }
+
+    sim_link_up = (sim_link_delay_ms == 0U);
+    if (sim_link_up)
+    {
+        (void)osEventFlagsSet(link_events, UDP_LINK_EVENT_UP);
+    }
+
+    if (sim_link_delay_ms == 0U && sim_flap_up_ms == 0U)
+    {
+        return;
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, sim_link_thread, NULL) != 0)
+    {
+        panic("Failed to start the link thread", NULL);
+    }
+    pthread_detach(thread);
+}
+
+/**
+ * @brief Find or start the ARP entry of an address
+ * @note Caller must hold arp_lock.
+ */
+static sim_arp_entry_t *sim_arp_entry(const udp_ipv4_addr_t *ip, uint64_t now)
+{
+    sim_arp_entry_t *victim = NULL;
+
+    for (size_t i = 0; i < SIM_ARP_TAB_SIZE; i++)
+    {
+        sim_arp_entry_t *entry = &sim_arp[i];
+
+        if (entry->used && !entry->fixed && now >= entry->expires_us)
+        {
+            entry->used = false;
+        }
+        if (entry->used && memcmp(entry->ip.addr, ip->addr, sizeof(ip->addr)) == 0)
+        {
+            return entry;
+        }
+
+        /* A free entry, otherwise the temporary one closest to aging out */
+        bool older = victim == NULL ||
+                     (victim->used && entry->expires_us < victim->expires_us);
+        if (!entry->used || (!entry->fixed && older))
+        {
+            victim = entry;
+        }
+    }
+
+    if (victim == NULL)
+    {
+        return NULL;
+    }
+
+    victim->ip         = *ip;
+    victim->ready_us   = now + sim_arp_us;
+    victim->expires_us = victim->ready_us + SIM_ARP_CACHE_TOUT_US;
+    if (memcmp(ip->addr, sim_arp_silent.addr, sizeof(ip->addr)) == 0)
+    {
+        victim->ready_us   = UINT64_MAX;
+        victim->expires_us = UINT64_MAX;
+    }
+    victim->fixed      = false;
+    victim->used       = true;
+    fprintf(
+        stderr, "sim: ARP request for %u.%u.%u.%u\n", ip->addr[0], ip->addr[1],
+        ip->addr[2], ip->addr[3]
+    );
+    return victim;
+}
+
+/**
+ * @brief Check if a datagram to an address would leave the interface
+ * @return false while the address is being resolved, the datagram is lost
+ */
+static bool sim_arp_ready(const udp_ipv4_addr_t *ip)
+{
+    /* No resolution for multicast and broadcast */
+    if (sim_arp_us == 0U || ip->addr[0] >= 224U)
+    {
+        return true;
+    }
+
+    uint64_t now = system_time_us();
+
+    pthread_mutex_lock(&arp_lock);
+    sim_arp_entry_t *entry = sim_arp_entry(ip, now);
+    bool             ready = (entry != NULL && now >= entry->ready_us);
+    pthread_mutex_unlock(&arp_lock);
+
+    return ready;
+}
+
+/**
+ * @brief Load the pool model from the environment
+ */
+static void sim_pool_init(void)
+{
+    const char *size  = getenv("SIM_NET_POOL_BYTES");
+    const char *link  = getenv("SIM_NET_LINK_BPS");
+    const char *guard = getenv("SIM_NET_POOL_GUARD");
+    uint32_t    bps   = (link != NULL) ? (uint32_t)strtoul(link, NULL, 0) : 0U;
+    uint32_t    bytes = (size != NULL) ? (uint32_t)strtoul(size, NULL, 0) : 0U;
+    uint32_t    drain = ((bps != 0U) ? bps : SIM_LINK_DEFAULT_BPS) / 8U;
+    uint32_t    limit = 0U;
+    uint64_t    now   = system_time_us();
+
+    if (bytes > NET_POOL_RX_RESERVE && (guard == NULL || strcmp(guard, "0") != 0))
+    {
+        limit = bytes - NET_POOL_RX_RESERVE;
+    }
+
+    net_pool_init(&sim_pool, bytes, drain, now);
+    net_pool_init(&tx_pool, limit, drain, now);
+
+    if (bytes != 0U)
+    {
+        fprintf(
+            stderr, "sim: network pool %u bytes, send limit %u, link %u bit/s\n",
+            bytes, limit, drain * 8U
+        );
+    }
+}
+
+/**
+ * @brief Take pool memory for one datagram
+ * @return false if the ledger refused the datagram
+ */
+static bool sim_pool_take(size_t len)
+{
+    pthread_mutex_lock(&pool_lock);
+
+    uint64_t now = system_time_us();
+    bool     ok  = net_pool_take(&tx_pool, len, now);
+
+    if (ok && !net_pool_take(&sim_pool, len, now))
+    {
+        pthread_mutex_unlock(&pool_lock);
+        panic("NetHandleError: Out of mem error", NULL);
+    }
+
+    pthread_mutex_unlock(&pool_lock);
+    return ok;
+}
+
+/**
+ * @brief Give back the pool memory of a datagram the host did not send
+ */
+static void sim_pool_refund(size_t len)
+{
+    pthread_mutex_lock(&pool_lock);
+
+    uint64_t now = system_time_us();
+    net_pool_refund(&tx_pool, len, now);
+    net_pool_refund(&sim_pool, len, now);
+
+    pthread_mutex_unlock(&pool_lock);
+}
+
+/**
+ * @brief Allocate socket from pool
+ */
+static udp_socket_internal_t *allocate_socket(void)
+{
+    for (int i = 0; i < UDP_NUM_SOCKS; i++)
+    {
+        if (!(socket_pool[i].flags & SOCKET_FLAG_USED))
+        {
+            memset(&socket_pool[i], 0, sizeof(udp_socket_internal_t));
+            socket_pool[i].fd    = -1;
+            socket_pool[i].flags = SOCKET_FLAG_USED;
+            return &socket_pool[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Free socket back to pool
+ */
+static void free_socket(udp_socket_internal_t *sock)
+{
+    if (sock->rx_queue != NULL)
+    {
+        osMessageQueueDelete(sock->rx_queue);
+        sock->rx_queue = NULL;
+    }
+
+    if (sock->rx_pool != NULL)
+    {
+        osMemoryPoolDelete(sock->rx_pool);
+        sock->rx_pool = NULL;
+    }
+
+    if (sock->fd >= 0)
+    {
+        close(sock->fd);
+    }
+
+    memset(sock, 0, sizeof(udp_socket_internal_t));
+    sock->fd = -1;
+}
+
+static void
+sockaddr_to_endpoint(const struct sockaddr_in *addr, udp_endpoint_t *endpoint)
+{
+    memcpy(endpoint->ip.addr, &addr->sin_addr.s_addr, 4);
+    endpoint->port = ntohs(addr->sin_port);
+}
+
+static void
+endpoint_to_sockaddr(const udp_endpoint_t *endpoint, struct sockaddr_in *addr)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port   = htons(endpoint->port);
+    memcpy(&addr->sin_addr.s_addr, endpoint->ip.addr, 4);
+}
+
+/**
+ * @brief Receiver thread, the host counterpart of the network stack callback
+ */
+static void *udp_receiver_thread(void *argument)
+{
+    udp_socket_internal_t *sock = argument;
+    uint8_t                buf[UDP_RECV_BUFFER_SIZE];
+
+    for (;;)
+    {
+        struct sockaddr_in addr;
+        socklen_t          addr_len = sizeof(addr);
+
+        /* MSG_TRUNC reports the full length, so oversize datagrams can be refused */
+        ssize_t len = recvfrom(
+            sock->fd, buf, sizeof(buf), MSG_TRUNC, (struct sockaddr *)&addr, &addr_len
+        );
+        uint64_t rx_time_us = system_time_us();
+
+        if (sock->flags & SOCKET_FLAG_CLOSING)
+        {
+            break;
+        }
+        if (len < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            LOG_ERROR("UDP receive on port %u failed: %d", sock->local_port, errno);
+            break;
+        }
+
+        if (!sim_link_up)
+        {
+            continue;
+        }
+
+        LOG_DEBUG(
+            "Received UDP packet on port %u, length %d", sock->local_port, (int)len
+        );
+
+        udp_endpoint_t remote;
+        sockaddr_to_endpoint(&addr, &remote);
+
+        if ((size_t)len > sock->rx_max_len ||
+            (sock->rx_filter != NULL &&
+             !sock->rx_filter(&remote, buf, (size_t)len, sock->rx_filter_context)))
+        {
+            sock->rx_rejected++;
+            continue;
+        }
+
+        udp_rx_pkt_t *pkt = (udp_rx_pkt_t *)osMemoryPoolAlloc(sock->rx_pool, 0U);
+        if (pkt == NULL)
+        {
+            sock->rx_dropped++;
+            continue;
+        }
+
+        pkt->remote     = remote;
+        pkt->rx_time_us = rx_time_us;
+        pkt->len        = (uint16_t)len;
+        memcpy(pkt->data, buf, (size_t)len);
+
+        udp_rx_pkt_t *msg = pkt;
+        if (osMessageQueuePut(sock->rx_queue, &msg, 0U, 0U) != osOK)
+        {
+            (void)osMemoryPoolFree(sock->rx_pool, pkt);
+            sock->rx_dropped++;
+        }
+    }
+
+    return NULL;
+}
+
+udp_status_t udp_socket_init(void)
+{
+    if (module_initialized)
+    {
+        panic("UDP socket module already initialized", NULL);
+        return UDP_STATUS_ALREADY_INIT;
+    }
+
+    const osMutexAttr_t mutex_attr = {
+        .name      = "udp_mutex",
+        .attr_bits = osMutexRecursive | osMutexPrioInherit,
+        .cb_mem    = NULL,
+        .cb_size   = 0
+    };
+
+    socket_mutex = osMutexNew(&mutex_attr);
+    if (socket_mutex == NULL)
+    {
+        LOG_CRITICAL("Failed to create UDP socket mutex");
+        panic("Failed to create UDP socket mutex", NULL);
+        return UDP_STATUS_NO_MEMORY;
+    }
+
+    memset(socket_pool, 0, sizeof(socket_pool));
+    sim_pool_init();
+    sim_link_init();
+
+    const char *arp_ms = getenv("SIM_NET_ARP_MS");
+    sim_arp_us = (arp_ms != NULL) ? strtoull(arp_ms, NULL, 0) * 1000U : 0U;
+    memset(sim_arp, 0, sizeof(sim_arp));
+
+    const char *silent = getenv("SIM_NET_ARP_SILENT");
+    memset(&sim_arp_silent, 0, sizeof(sim_arp_silent));
+    if (silent != NULL)
+    {
+        (void)inet_pton(AF_INET, silent, sim_arp_silent.addr);
+    }
+
+    const char *mcast_if = getenv("SIM_NET_MCAST_IF");
+    sim_mcast_if.s_addr  = htonl(INADDR_ANY);
+    if (mcast_if != NULL)
+    {
+        (void)inet_pton(AF_INET, mcast_if, &sim_mcast_if);
+    }
+
+    module_initialized = true;
+    return UDP_STATUS_OK;
+}
+
+udp_status_t udp_socket_deinit(void)
+{
+    if (!module_initialized)
+    {
+        LOG_WARNING("UDP socket module not initialized");
+        return UDP_STATUS_NOT_INIT;
+    }
+
+    for (int i = 0; i < UDP_NUM_SOCKS; i++)
+    {
+        if (socket_pool[i].flags & SOCKET_FLAG_USED)
+        {
+            LOG_DEBUG("Closing UDP socket %d", i);
+            udp_socket_close(&socket_pool[i]);
+        }
+    }
+
+    if (socket_mutex != NULL)
+    {
+        LOG_DEBUG("Deleting UDP socket mutex");
+        osMutexDelete(socket_mutex);
+        socket_mutex = NULL;
+    }
+
+    module_initialized = false;
+    LOG_INFO("UDP socket module deinitialized");
+
+    return UDP_STATUS_OK;
+}
+
+udp_status_t udp_socket_create(udp_socket_handle_t *handle, uint16_t local_port)
+{
+    return udp_socket_create_rx(handle, local_port, NULL);
+}
+
+udp_status_t udp_socket_create_rx(
+    udp_socket_handle_t *handle, uint16_t local_port, const udp_rx_config_t *rx
+)
+{
+    static const udp_rx_config_t rx_default = {
+        .queue_len      = UDP_RX_QUEUE_LEN,
+        .max_len        = UDP_RECV_BUFFER_SIZE,
+        .filter         = NULL,
+        .filter_context = NULL,
+    };
+    udp_status_t           result;
+    udp_socket_internal_t *sock;
+
+    if (!module_initialized)
+    {
+        LOG_WARNING("UDP socket module not initialized");
+        return UDP_STATUS_NOT_INIT;
+    }
+
+    if (handle == NULL)
+    {
+        LOG_CRITICAL("UDP socket handle not provided");
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    if (rx == NULL)
+    {
+        rx = &rx_default;
+    }
+    if (rx->queue_len == 0U || rx->max_len == 0U || rx->max_len > UDP_RECV_BUFFER_SIZE)
+    {
+        LOG_ERROR(
+            "Invalid RX queue settings: %u x %u bytes", rx->queue_len, rx->max_len
+        );
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    osMutexAcquire(socket_mutex, osWaitForever);
+
+    sock = allocate_socket();
+    if (sock == NULL)
+    {
+        LOG_ERROR("No free UDP sockets available");
+        result = UDP_STATUS_NO_MEMORY;
+        goto cleanup_mutex;
+    }
+
+    sock->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock->fd < 0)
+    {
+        LOG_ERROR("Failed to create network UDP socket: %d", errno);
+        result = UDP_STATUS_NET_ERROR;
+        goto cleanup_alloc;
+    }
+
+    int reuse = 1;
+    (void)setsockopt(sock->fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (sim_mcast_if.s_addr != htonl(INADDR_ANY))
+    {
+        (void)setsockopt(
+            sock->fd, IPPROTO_IP, IP_MULTICAST_IF, &sim_mcast_if, sizeof(sim_mcast_if)
+        );
+    }
+
+    struct sockaddr_in addr = {0};
+    socklen_t          addr_len = sizeof(addr);
+    addr.sin_family             = AF_INET;
+    addr.sin_port               = htons(local_port);
+    addr.sin_addr.s_addr        = htonl(INADDR_ANY);
+
+    if (bind(sock->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        getsockname(sock->fd, (struct sockaddr *)&addr, &addr_len) != 0)
+    {
+        LOG_ERROR("Failed to bind UDP socket to port %u: %d", local_port, errno);
+        result = UDP_STATUS_NET_ERROR;
+        goto cleanup_alloc;
+    }
+
+    sock->rx_pool =
+        osMemoryPoolNew(rx->queue_len, sizeof(udp_rx_pkt_t) + rx->max_len, NULL);
+    if (sock->rx_pool == NULL)
+    {
+        LOG_ERROR("Failed to create RX memory pool");
+        result = UDP_STATUS_NO_MEMORY;
+        goto cleanup_alloc;
+    }
+
+    sock->rx_queue = osMessageQueueNew(rx->queue_len, sizeof(udp_rx_pkt_t *), NULL);
+    if (sock->rx_queue == NULL)
+    {
+        LOG_ERROR("Failed to create RX message queue");
+        result = UDP_STATUS_NO_MEMORY;
+        goto cleanup_alloc;
+    }
+
+    sock->local_port = ntohs(addr.sin_port);
+    sock->flags |= SOCKET_FLAG_BOUND;
+    sock->rx_queue_len      = rx->queue_len;
+    sock->rx_max_len        = rx->max_len;
+    sock->rx_filter         = rx->filter;
+    sock->rx_filter_context = rx->filter_context;
+
+    if (pthread_create(&sock->receiver, NULL, udp_receiver_thread, sock) != 0)
+    {
+        LOG_ERROR("Failed to start UDP receiver thread");
+        result = UDP_STATUS_NO_MEMORY;
+        goto cleanup_alloc;
+    }
+
+    *handle = sock;
+    osMutexRelease(socket_mutex);
+    return UDP_STATUS_OK;
+
+cleanup_alloc:
+    free_socket(sock);
+cleanup_mutex:
+    osMutexRelease(socket_mutex);
+    return result;
+}
+
+udp_status_t udp_socket_close(udp_socket_handle_t handle)
+{
+    if (!module_initialized)
+    {
+        LOG_WARNING("UDP socket module not initialized");
+        return UDP_STATUS_NOT_INIT;
+    }
+
+    if (handle == NULL)
+    {
+        LOG_CRITICAL("UDP socket handle not provided");
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    osMutexAcquire(socket_mutex, osWaitForever);
+
+    udp_socket_internal_t *sock = (udp_socket_internal_t *)handle;
+
+    if (!(sock->flags & SOCKET_FLAG_USED))
+    {
+        LOG_WARNING("UDP socket handle not in use");
+        osMutexRelease(socket_mutex);
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    /* shutdown() wakes the receiver blocked in recvfrom() */
+    sock->flags |= SOCKET_FLAG_CLOSING;
+    (void)shutdown(sock->fd, SHUT_RDWR);
+    pthread_join(sock->receiver, NULL);
+
+    uint16_t port = sock->local_port;
+    free_socket(sock);
+
+    osMutexRelease(socket_mutex);
+
+    LOG_DEBUG("UDP socket on port %u closed", port);
+    return UDP_STATUS_OK;
+}
+
+/**
+ * @brief Map a failed send to a status code
+ */
+static udp_status_t send_error_status(int error)
+{
+    /* A full socket buffer is what netUDP_GetBuffer() failing means on target */
+    if (error == ENOBUFS || error == EAGAIN)
+    {
+        LOG_ERROR("Failed to allocate UDP send buffer");
+        return UDP_STATUS_NO_MEMORY;
+    }
+
+    LOG_ERROR("UDP send failed: %d", error);
+    return UDP_STATUS_NET_ERROR;
+}
+
+udp_status_t udp_socket_send(
+    udp_socket_handle_t handle, const udp_endpoint_t *remote, const uint8_t *data,
+    size_t len
+)
+{
+    if (!module_initialized)
+    {
+        LOG_WARNING("UDP socket module not initialized");
+        return UDP_STATUS_NOT_INIT;
+    }
+
+    if (handle == NULL || remote == NULL || data == NULL || len == 0)
+    {
+        LOG_CRITICAL("Invalid parameter(s) provided to udp_socket_send");
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    if (len > UDP_MAX_PAYLOAD_SIZE)
+    {
+        LOG_WARNING("UDP payload too large: %u > %u", len, UDP_MAX_PAYLOAD_SIZE);
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    udp_socket_internal_t *sock = (udp_socket_internal_t *)handle;
+
+    if (!(sock->flags & SOCKET_FLAG_BOUND))
+    {
+        LOG_WARNING("UDP socket not bound");
+        return UDP_STATUS_NOT_INIT;
+    }
+
+    if (!sim_link_up)
+    {
+        LOG_WARNING("UDP link is down");
+        return UDP_STATUS_LINK_DOWN;
+    }
+
+    if (!sim_arp_ready(&remote->ip))
+    {
+        return UDP_STATUS_OK;
+    }
+
+    if (!sim_pool_take(len))
+    {
+        LOG_DEBUG("UDP send refused, network pool low");
+        return UDP_STATUS_NO_MEMORY;
+    }
+
+    struct sockaddr_in addr;
+    endpoint_to_sockaddr(remote, &addr);
+
+    ssize_t sent =
+        sendto(sock->fd, data, len, 0, (const struct sockaddr *)&addr, sizeof(addr));
+    if (sent < 0)
+    {
+        sim_pool_refund(len);
+        return send_error_status(errno);
+    }
+
+    return UDP_STATUS_OK;
+}
+
+/**
+ * @details Valid datagrams are handed to sendmmsg() up to UDP_SEND_BATCH_MAX at a
+ * time. When it stops early, the datagram it stopped at is retried alone, so its
+ * error is reported against it and the rest of the batch still goes out.
+ */
+udp_status_t udp_socket_send_batch(
+    udp_socket_handle_t handle, const udp_datagram_t *datagrams, size_t count,
+    udp_status_t *results
+)
+{
+    udp_status_t status = UDP_STATUS_OK;
+
+    if (!module_initialized)
+    {
+        LOG_WARNING("UDP socket module not initialized");
+        status = UDP_STATUS_NOT_INIT;
+    }
+    else if (handle == NULL || datagrams == NULL || results == NULL || count == 0)
+    {
+        LOG_CRITICAL("Invalid parameter(s) provided to udp_socket_send_batch");
+        status = UDP_STATUS_INVALID_PARAM;
+    }
+    else if (!(((udp_socket_internal_t *)handle)->flags & SOCKET_FLAG_BOUND))
+    {
+        LOG_WARNING("UDP socket not bound");
+        status = UDP_STATUS_NOT_INIT;
+    }
+    else if (!sim_link_up)
+    {
+        LOG_WARNING("UDP link is down");
+        status = UDP_STATUS_LINK_DOWN;
+    }
+
+    if (status != UDP_STATUS_OK)
+    {
+        for (size_t i = 0; results != NULL && i < count; i++)
+        {
+            results[i] = status;
+        }
+        return status;
+    }
+
+    udp_socket_internal_t *sock = (udp_socket_internal_t *)handle;
+    size_t                 next = 0;
+
+    while (next < count)
+    {
+        struct sockaddr_in addrs[UDP_SEND_BATCH_MAX];
+        struct iovec       iovs[UDP_SEND_BATCH_MAX];
+        struct mmsghdr     msgs[UDP_SEND_BATCH_MAX];
+        size_t             index[UDP_SEND_BATCH_MAX];
+        unsigned int       pending = 0;
+
+        for (; next < count && pending < UDP_SEND_BATCH_MAX; next++)
+        {
+            const udp_datagram_t *datagram = &datagrams[next];
+
+            if (datagram->remote == NULL || datagram->data == NULL ||
+                datagram->len == 0 || datagram->len > UDP_MAX_PAYLOAD_SIZE)
+            {
+                results[next] = UDP_STATUS_INVALID_PARAM;
+                continue;
+            }
+
+            if (!sim_arp_ready(&datagram->remote->ip))
+            {
+                results[next] = UDP_STATUS_OK;
+                continue;
+            }
+
+            if (!sim_pool_take(datagram->len))
+            {
+                LOG_DEBUG("UDP send refused, network pool low");
+                results[next] = UDP_STATUS_NO_MEMORY;
+                continue;
+            }
+
+            endpoint_to_sockaddr(datagram->remote, &addrs[pending]);
+            iovs[pending].iov_base = (void *)datagram->data;
+            iovs[pending].iov_len  = datagram->len;
+
+            memset(&msgs[pending], 0, sizeof(msgs[pending]));
+            msgs[pending].msg_hdr.msg_name    = &addrs[pending];
+            msgs[pending].msg_hdr.msg_namelen = sizeof(addrs[pending]);
+            msgs[pending].msg_hdr.msg_iov     = &iovs[pending];
+            msgs[pending].msg_hdr.msg_iovlen  = 1;
+            index[pending]                    = next;
+            pending++;
+        }
+
+        unsigned int done = 0;
+        while (done < pending)
+        {
+            int sent = sendmmsg(sock->fd, &msgs[done], pending - done, 0);
+            if (sent < 0)
+            {
+                sim_pool_refund(iovs[done].iov_len);
+                results[index[done]] = send_error_status(errno);
+                done++;
+                continue;
+            }
+
+            for (int i = 0; i < sent; i++)
+            {
+                results[index[done + (unsigned int)i]] = UDP_STATUS_OK;
+            }
+            done += (unsigned int)sent;
+        }
+    }
+
+    return UDP_STATUS_OK;
+}
+
+uint32_t udp_socket_tx_wait_us(size_t len, size_t count)
+{
+    pthread_mutex_lock(&pool_lock);
+    uint32_t wait_us = net_pool_wait_us(&tx_pool, len, count, system_time_us());
+    pthread_mutex_unlock(&pool_lock);
+
+    return wait_us;
+}
+
+udp_status_t udp_socket_sendto(
+    udp_socket_handle_t handle, const char *ip_addr, uint16_t port, const uint8_t *data,
+    size_t len
+)
+{
+    udp_endpoint_t endpoint;
+    udp_status_t   status;
+
+    status = udp_endpoint_create(ip_addr, port, &endpoint);
+    if (status != UDP_STATUS_OK)
+    {
+        LOG_CRITICAL("Invalid endpoint address: %s:%u", ip_addr, port);
+        return status;
+    }
+
+    return udp_socket_send(handle, &endpoint, data, len);
+}
+
+udp_status_t udp_socket_recv(
+    udp_socket_handle_t handle, udp_endpoint_t *remote, uint8_t *buffer,
+    size_t buffer_len, size_t *received, uint32_t timeout_ms
+)
+{
+    return udp_socket_recv_timestamped(
+        handle, remote, buffer, buffer_len, received, NULL, timeout_ms
+    );
+}
+
+udp_status_t udp_socket_recv_timestamped(
+    udp_socket_handle_t handle, udp_endpoint_t *remote, uint8_t *buffer,
+    size_t buffer_len, size_t *received, uint64_t *rx_time_us, uint32_t timeout_ms
+)
+{
+    if (!module_initialized)
+    {
+        LOG_WARNING("UDP socket module not initialized");
+        return UDP_STATUS_NOT_INIT;
+    }
+
+    if (handle == NULL || buffer == NULL || buffer_len == 0 || received == NULL)
+    {
+        LOG_CRITICAL("Invalid parameter(s) provided to udp_socket_recv");
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    udp_socket_internal_t *sock = (udp_socket_internal_t *)handle;
+
+    if (!(sock->flags & SOCKET_FLAG_BOUND))
+    {
+        LOG_WARNING("UDP socket not bound");
+        return UDP_STATUS_NOT_INIT;
+    }
+
+    *received = 0;
+
+    udp_rx_pkt_t *pkt       = NULL;
+    osStatus_t    os_status = osMessageQueueGet(sock->rx_queue, &pkt, NULL, timeout_ms);
+
+    if (os_status == osErrorTimeout || os_status == osErrorResource)
+    {
+        LOG_DEBUG("UDP receive timeout after %u ms", timeout_ms);
+        return UDP_STATUS_TIMEOUT;
+    }
+    if (os_status != osOK || pkt == NULL || pkt == UDP_RX_PKT_CLOSING)
+    {
+        LOG_ERROR("UDP receive error: %d", os_status);
+        return UDP_STATUS_ERROR;
+    }
+
+    size_t copy_len = (pkt->len < buffer_len) ? (size_t)pkt->len : buffer_len;
+    memcpy(buffer, pkt->data, copy_len);
+    *received = copy_len;
+
+    if (remote != NULL)
+    {
+        *remote = pkt->remote;
+    }
+
+    if (rx_time_us != NULL)
+    {
+        *rx_time_us = pkt->rx_time_us;
+    }
+
+    (void)osMemoryPoolFree(sock->rx_pool, pkt);
+
+    return UDP_STATUS_OK;
+}
+
+udp_status_t udp_socket_get_rx_stats(udp_socket_handle_t handle, udp_rx_stats_t *stats)
+{
+    if (handle == NULL || stats == NULL)
+    {
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    udp_socket_internal_t *sock = (udp_socket_internal_t *)handle;
+
+    stats->rx_dropped    = sock->rx_dropped;
+    stats->rx_rejected   = sock->rx_rejected;
+    stats->rx_queued     = 0;
+    stats->rx_queue_size = sock->rx_queue_len;
+    if (sock->rx_queue != NULL)
+    {
+        stats->rx_queued = osMessageQueueGetCount(sock->rx_queue);
+    }
+
+    return UDP_STATUS_OK;
+}
+
+udp_status_t udp_socket_get_pool_stats(udp_pool_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    stats->tx_pool_size = tx_pool.size;
+    stats->tx_pool_used = net_pool_used(&tx_pool, system_time_us());
+    stats->tx_pool_peak = tx_pool.peak;
+    stats->tx_refused   = tx_pool.refused;
+    pthread_mutex_unlock(&pool_lock);
+
+    return UDP_STATUS_OK;
+}
+
+void udp_socket_log_link_info(void)
+{
+    LOG_DEBUG("Host network, no PHY");
+}
+
+void udp_socket_log_driver_state(void)
+{
+    /* The host kernel owns the driver, there is nothing to dump */
+}
+
+bool udp_socket_is_link_up(void)
+{
+    return sim_link_up;
+}
+
+bool udp_socket_wait_for_link(uint32_t timeout_ms)
+{
+    if (sim_link_up)
+    {
+        return true;
+    }
+    if (link_events == NULL)
+    {
+        return false;
+    }
+
+    uint32_t flags = osEventFlagsWait(
+        link_events, UDP_LINK_EVENT_UP, osFlagsWaitAny | osFlagsNoClear, timeout_ms
+    );
+    return (flags & osFlagsError) == 0U;
+}
+
+udp_status_t udp_socket_arp_pin(const udp_ipv4_addr_t *ip)
+{
+    if (ip == NULL)
+    {
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    if (!module_initialized)
+    {
+        return UDP_STATUS_NOT_INIT;
+    }
+
+    if (!sim_link_up)
+    {
+        return UDP_STATUS_LINK_DOWN;
+    }
+
+    if (sim_arp_us == 0U)
+    {
+        return UDP_STATUS_OK;
+    }
+
+    uint64_t now = system_time_us();
+
+    pthread_mutex_lock(&arp_lock);
+    sim_arp_entry_t *entry = sim_arp_entry(ip, now);
+    bool             ready = false;
+    if (entry != NULL)
+    {
+        entry->fixed = true;
+        ready        = now >= entry->ready_us;
+    }
+    pthread_mutex_unlock(&arp_lock);
+
+    if (entry == NULL)
+    {
+        return UDP_STATUS_NET_ERROR;
+    }
+
+    return ready ? UDP_STATUS_OK : UDP_STATUS_TIMEOUT;
+}
+
+bool udp_socket_arp_cached(const udp_ipv4_addr_t *ip)
+{
+    if (ip == NULL || !module_initialized)
+    {
+        return false;
+    }
+
+    return sim_arp_ready(ip);
+}
+
+udp_status_t udp_socket_arp_unpin(const udp_ipv4_addr_t *ip)
+{
+    if (ip == NULL)
+    {
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    if (!module_initialized)
+    {
+        return UDP_STATUS_NOT_INIT;
+    }
+
+    pthread_mutex_lock(&arp_lock);
+    for (size_t i = 0; i < SIM_ARP_TAB_SIZE; i++)
+    {
+        if (sim_arp[i].used &&
+            memcmp(sim_arp[i].ip.addr, ip->addr, sizeof(ip->addr)) == 0)
+        {
+            sim_arp[i].fixed      = false;
+            sim_arp[i].expires_us = system_time_us() + SIM_ARP_CACHE_TOUT_US;
+        }
+    }
+    pthread_mutex_unlock(&arp_lock);
+
+    return UDP_STATUS_OK;
+}
+
+udp_status_t udp_socket_get_local_ip(udp_ipv4_addr_t *ip)
+{
+    struct ifaddrs *list;
+
+    if (ip == NULL)
+    {
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    /* Loopback unless an interface with a real address is up */
+    ip->addr[0] = 127;
+    ip->addr[1] = 0;
+    ip->addr[2] = 0;
+    ip->addr[3] = 1;
+
+    if (getifaddrs(&list) != 0)
+    {
+        return UDP_STATUS_OK;
+    }
+
+    for (struct ifaddrs *ifa = list; ifa != NULL; ifa = ifa->ifa_next)
+    {
+        if (ifa->ifa_addr == NULL || ifa->ifa_addr->sa_family != AF_INET ||
+            !(ifa->ifa_flags & IFF_UP) || (ifa->ifa_flags & IFF_LOOPBACK))
+        {
+            continue;
+        }
+
+        const struct sockaddr_in *addr = (const struct sockaddr_in *)ifa->ifa_addr;
+        memcpy(ip->addr, &addr->sin_addr.s_addr, 4);
+        break;
+    }
+
+    freeifaddrs(list);
+    return UDP_STATUS_OK;
+}
+
+udp_status_t udp_ipv4_from_string(const char *ip_str, udp_ipv4_addr_t *ip)
+{
+    if (ip_str == NULL || ip == NULL)
+    {
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    unsigned int a, b, c, d;
+    if (sscanf(ip_str, "%u.%u.%u.%u", &a, &b, &c, &d) != 4)
+    {
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    if (a > 255 || b > 255 || c > 255 || d > 255)
+    {
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    ip->addr[0] = (uint8_t)a;
+    ip->addr[1] = (uint8_t)b;
+    ip->addr[2] = (uint8_t)c;
+    ip->addr[3] = (uint8_t)d;
+
+    return UDP_STATUS_OK;
+}
+
+char *udp_ipv4_to_string(const udp_ipv4_addr_t *ip, char *buffer, size_t buffer_len)
+{
+    if (ip == NULL || buffer == NULL || buffer_len < 16)
+    {
+        return NULL;
+    }
+
+    snprintf(
+        buffer, buffer_len, "%u.%u.%u.%u", ip->addr[0], ip->addr[1], ip->addr[2],
+        ip->addr[3]
+    );
+
+    return buffer;
+}
+
+udp_status_t
+udp_endpoint_create(const char *ip_str, uint16_t port, udp_endpoint_t *endpoint)
+{
+    if (endpoint == NULL)
+    {
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    udp_status_t status = udp_ipv4_from_string(ip_str, &endpoint->ip);
+    if (status != UDP_STATUS_OK)
+    {
+        return status;
+    }
+
+    endpoint->port = port;
+    return UDP_STATUS_OK;
+}
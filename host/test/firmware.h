@@ -0,0 +1,304 @@
+/**
+ * @file firmware.h
+ * @brief In-process firmware and a minimal host client for the host test programs
+ * @details firmware_boot() brings the host build up the way main() does, minus
+ * the logger, and firmware_run() hands the test body a thread of its own. The
+ * client side talks to the device over plain POSIX sockets bound to a loopback
+ * address of its choosing, so one program can play several hosts: 127.0.0.2,
+ * 127.0.0.3 and so on all reach the device at 127.0.0.1.
+ *
+ * The simulation reads its SIM_* variables while booting, so a test sets them
+ * with setenv() before calling firmware_boot().
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#ifndef FIRMWARE_H
+#define FIRMWARE_H
+
+#include "LPC17xx.h"
+#include "cmsis_os2.h"
+#include "protocol.h"
+#include "rl_net.h"
+#include "system.h"
+#include "task_acquisition.h"
+#include "task_init.h"
+#include "task_network.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/** Address the device answers on */
+#define FIRMWARE_IP "127.0.0.1"
+/** Longest the network task may take to open its sockets */
+#define FIRMWARE_READY_TIMEOUT_MS 5000U
+
+/** Sequence number of the next client request, unique so none is a repeat */
+static uint16_t client_sequence = 0x1000U;
+
+/**
+ * @brief Bring the firmware up as main() does
+ * @param acquisition false leaves the acquisition task out, so the test thread
+ * can play the data path with network_send_raw()
+ */
+static inline void firmware_boot(bool acquisition)
+{
+    SystemCoreClockUpdate();
+    system_boot_start();
+
+    if (osKernelInitialize() != osOK || netInitialize() != netOK ||
+        network_init() != 0 || acquisition_init() != 0)
+    {
+        fprintf(stderr, "firmware: initialization failed\n");
+        exit(1);
+    }
+
+    int status = acquisition ? init_task_start() : network_task_start();
+    if (status != 0)
+    {
+        fprintf(stderr, "firmware: task start failed\n");
+        exit(1);
+    }
+}
+
+/**
+ * @brief Start the kernel with the test body in a thread of its own
+ * @note The body ends the program with exit(test_report(...)).
+ */
+static inline __attribute__((noreturn)) void firmware_run(osThreadFunc_t body)
+{
+    static const osThreadAttr_t attr = {
+        .name       = "test",
+        .priority   = osPriorityNormal,
+        .stack_size = 8192,
+    };
+
+    if (osThreadNew(body, NULL, &attr) == NULL)
+    {
+        fprintf(stderr, "firmware: test thread not created\n");
+        exit(1);
+    }
+
+    (void)osKernelStart();
+    exit(1);
+}
+
+/**
+ * @brief Wait for the network task to open its sockets
+ * @return false if it did not in FIRMWARE_READY_TIMEOUT_MS
+ */
+static inline bool firmware_wait_ready(void)
+{
+    for (uint32_t waited = 0; waited < FIRMWARE_READY_TIMEOUT_MS; waited++)
+    {
+        if (network_is_ready())
+        {
+            return true;
+        }
+        osDelay(1);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Open a client socket on a loopback address
+ * @param ip Local address, e.g. "127.0.0.2"
+ * @return Socket descriptor, the program exits if it cannot be opened
+ */
+static inline int client_open(const char *ip)
+{
+    struct sockaddr_in addr = {.sin_family = AF_INET};
+    int                fd   = socket(AF_INET, SOCK_DGRAM, 0);
+    int                size = 1 << 20;
+
+    (void)inet_pton(AF_INET, ip, &addr.sin_addr);
+    if (fd < 0 || bind(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        perror("client socket");
+        exit(1);
+    }
+    (void)setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+    return fd;
+}
+
+/**
+ * @brief Send a request to a device port
+ */
+static inline void client_send(
+    int fd, uint16_t port, uint8_t msg_type, const void *payload, size_t payload_len
+)
+{
+    uint8_t            packet[PROTOCOL_MAX_REQUEST_SIZE];
+    protocol_header_t  header = {
+        .magic       = PROTOCOL_MAGIC,
+        .msg_type    = msg_type,
+        .sequence    = client_sequence++,
+        .payload_len = (uint16_t)payload_len,
+    };
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port   = htons(port),
+    };
+
+    (void)inet_pton(AF_INET, FIRMWARE_IP, &addr.sin_addr);
+    memcpy(packet, &header, sizeof(header));
+    if (payload_len > 0)
+    {
+        memcpy(&packet[sizeof(header)], payload, payload_len);
+    }
+
+    (void)sendto(
+        fd, packet, sizeof(header) + payload_len, 0, (const struct sockaddr *)&addr,
+        sizeof(addr)
+    );
+}
+
+/**
+ * @brief Send a command to the control port
+ */
+static inline void
+client_command(int fd, uint8_t cmd, uint8_t param_type, uint16_t param)
+{
+    protocol_cmd_payload_t payload = {
+        .cmd        = cmd,
+        .param_type = param_type,
+        .param      = param,
+    };
+
+    client_send(fd, TASK_NETWORK_LOCAL_PORT, MSG_TYPE_CMD, &payload, sizeof(payload));
+}
+
+/**
+ * @brief Set one configuration parameter with a MSG_TYPE_CONFIG packet
+ * @details Unlike CMD_CONFIGURE this carries values above 16 bits.
+ */
+static inline void client_configure(int fd, uint8_t param_type, uint32_t value)
+{
+    uint8_t entry[PROTOCOL_CONFIG_TLV_HEADER_SIZE + PROTOCOL_CONFIG_VALUE_MAX_LEN] = {
+        param_type,
+        PROTOCOL_CONFIG_VALUE_MAX_LEN,
+        (uint8_t)value,
+        (uint8_t)(value >> 8),
+        (uint8_t)(value >> 16),
+        (uint8_t)(value >> 24),
+    };
+
+    client_send(fd, TASK_NETWORK_LOCAL_PORT, MSG_TYPE_CONFIG, entry, sizeof(entry));
+}
+
+/**
+ * @brief Receive and parse one packet from the device
+ * @param buffer Receive buffer, payload points into it
+ * @param timeout_ms Time to wait for a packet
+ * @return Payload length, -1 on timeout or a malformed packet
+ */
+static inline int client_recv(
+    int fd, uint8_t *buffer, size_t size, uint32_t timeout_ms,
+    protocol_header_t *header, const uint8_t **payload
+)
+{
+    struct pollfd pfd = {.fd = fd, .events = POLLIN};
+    size_t        payload_len;
+
+    if (poll(&pfd, 1, (int)timeout_ms) <= 0)
+    {
+        return -1;
+    }
+
+    ssize_t received = recv(fd, buffer, size, 0);
+    if (received <= 0 || protocol_parse_packet(
+                             buffer, (size_t)received, header, payload, &payload_len
+                         ) != PROTO_STATUS_OK)
+    {
+        return -1;
+    }
+
+    return (int)payload_len;
+}
+
+/**
+ * @brief Receive packets until one of the given type arrives
+ * @return Payload length, -1 if none arrived within timeout_ms
+ */
+static inline int client_expect(
+    int fd, uint8_t msg_type, uint8_t *buffer, size_t size, uint32_t timeout_ms,
+    const uint8_t **payload
+)
+{
+    uint64_t deadline = system_time_us() + (uint64_t)timeout_ms * 1000U;
+
+    for (;;)
+    {
+        uint64_t now = system_time_us();
+        if (now >= deadline)
+        {
+            return -1;
+        }
+
+        protocol_header_t header;
+        int               len = client_recv(
+            fd, buffer, size, (uint32_t)((deadline - now + 999U) / 1000U), &header,
+            payload
+        );
+        if (len >= 0 && header.msg_type == msg_type)
+        {
+            return len;
+        }
+    }
+}
+
+/**
+ * @brief Read one telemetry counter of the device
+ * @return false if no telemetry packet with the entry arrived
+ */
+static inline bool client_telemetry(int fd, uint8_t id, uint32_t *value)
+{
+    uint8_t        buffer[1500];
+    const uint8_t *payload;
+
+    client_command(fd, CMD_GET_TELEMETRY, 0, 0);
+    int len = client_expect(
+        fd, MSG_TYPE_TELEMETRY, buffer, sizeof(buffer), 1000U, &payload
+    );
+
+    for (int i = 0; i < len;)
+    {
+        uint8_t  entry   = payload[i++];
+        uint32_t decoded = 0;
+        unsigned shift   = 0;
+
+        while (i < len)
+        {
+            uint8_t byte = payload[i++];
+            if (shift < 32U)
+            {
+                decoded |= (uint32_t)(byte & 0x7FU) << shift;
+            }
+            shift += 7U;
+            if ((byte & 0x80U) == 0U)
+            {
+                break;
+            }
+        }
+
+        if (entry == id)
+        {
+            *value = decoded;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#endif /* FIRMWARE_H */
@@ -0,0 +1,38 @@
+/**
+ * @file Driver_ETH_PHY.h
+ * @brief CMSIS Ethernet PHY driver declarations used by udp_socket.c
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#ifndef DRIVER_ETH_PHY_H
+#define DRIVER_ETH_PHY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define ARM_ETH_SPEED_10M  0U /**< 10 Mbit/s */
+#define ARM_ETH_SPEED_100M 1U /**< 100 Mbit/s */
+
+    /** Link information */
+    typedef struct
+    {
+        uint32_t speed  : 2; /**< ARM_ETH_SPEED_* */
+        uint32_t duplex : 1; /**< Full duplex */
+    } ARM_ETH_LINK_INFO;
+
+    /** Access structure of a PHY driver, only what the socket layer calls */
+    typedef struct
+    {
+        ARM_ETH_LINK_INFO (*GetLinkInfo)(void); /**< Current link information */
+    } ARM_DRIVER_ETH_PHY;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVER_ETH_PHY_H */
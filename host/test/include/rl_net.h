@@ -0,0 +1,95 @@
+/**
+ * @file rl_net.h
+ * @brief RL-NET declarations used by udp_socket.c, implemented by the test
+ * @details Lets test_udp_socket and test_udp_overload build the target socket
+ * layer on the host and play the network stack themselves.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#ifndef RL_NET_H
+#define RL_NET_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Address type of an IPv4 NET_ADDR */
+#define NET_ADDR_IP4 0
+/** Length of an IPv4 address in bytes */
+#define NET_ADDR_IP4_LEN 4
+/** Length of an Ethernet MAC address in bytes */
+#define NET_ADDR_ETH_LEN 6
+/** Interface class of the Ethernet interfaces */
+#define NET_IF_CLASS_ETH (1U << 8)
+
+    /** Network stack status codes */
+    typedef enum
+    {
+        netOK               = 0, /**< Operation succeeded */
+        netBusy             = 1, /**< Process is busy */
+        netError            = 2, /**< Unspecified error */
+        netInvalidParameter = 3, /**< Invalid parameter specified */
+        netWrongState       = 4  /**< Wrong state */
+    } netStatus;
+
+    /** Ethernet link events passed to netETH_Notify() */
+    typedef enum
+    {
+        netETH_LinkDown = 0, /**< Link down */
+        netETH_LinkUp   = 1  /**< Link up */
+    } netETH_Event;
+
+    /** ARP cache entry types */
+    typedef enum
+    {
+        netARP_CacheFixedIP, /**< Fixed entry, refreshed instead of aging out */
+        netARP_CacheTempIP   /**< Temporary entry, ages out */
+    } netARP_CacheType;
+
+    /** Interface options */
+    typedef enum
+    {
+        netIF_OptionMAC_Address, /**< Ethernet MAC address */
+        netIF_OptionIP4_Address  /**< IPv4 address */
+    } netIF_Option;
+
+    /** Generic network address */
+    typedef struct
+    {
+        int16_t  addr_type; /**< NET_ADDR_IP4 */
+        uint16_t port;      /**< Port number */
+        uint8_t  addr[16];  /**< IP address, the first four bytes for IPv4 */
+    } NET_ADDR;
+
+    /** UDP receive callback, called from the network core thread */
+    typedef uint32_t (*netUDP_cb_t)(
+        int32_t socket, const NET_ADDR *addr, const uint8_t *buf, uint32_t len
+    );
+
+    int32_t   netUDP_GetSocket(netUDP_cb_t cb_func);
+    netStatus netUDP_ReleaseSocket(int32_t socket);
+    netStatus netUDP_Open(int32_t socket, uint16_t port);
+    netStatus netUDP_Close(int32_t socket);
+    uint8_t  *netUDP_GetBuffer(uint32_t size);
+    netStatus
+    netUDP_Send(int32_t socket, const NET_ADDR *addr, uint8_t *buf, uint32_t len);
+    netStatus
+    netIF_GetOption(
+        uint32_t if_id, netIF_Option option, uint8_t *buf, uint32_t buf_len
+    );
+    netStatus
+    netARP_CacheIP(uint32_t if_id, const uint8_t *ip4_addr, netARP_CacheType type);
+    netStatus netARP_GetMAC(uint32_t if_id, const uint8_t *ip4_addr, uint8_t *mac_addr);
+
+    /** Link event callback, implemented by udp_socket.c */
+    void netETH_Notify(uint32_t if_num, netETH_Event event, uint32_t val);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RL_NET_H */
@@ -0,0 +1,56 @@
+/**
+ * @file test.h
+ * @brief Minimal check helpers shared by the host test programs
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/** Checks that failed so far in this program */
+static int test_failures = 0;
+
+/**
+ * @brief Report a failed check without stopping the program
+ */
+#define TEST_CHECK(cond)                                                               \
+    do                                                                                 \
+    {                                                                                  \
+        if (!(cond))                                                                   \
+        {                                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);  \
+            test_failures++;                                                           \
+        }                                                                              \
+    } while (0)
+
+/**
+ * @brief Deterministic xorshift32 generator, so a failing run can be repeated
+ * @param state Generator state, must not be zero
+ * @return Next pseudo-random value
+ */
+static inline uint32_t test_random(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/**
+ * @brief Print the verdict of a test program
+ * @param name Test program name
+ * @return Process exit status, 0 if every check passed
+ */
+static inline int test_report(const char *name)
+{
+    printf("%s: %s\n", name, (test_failures == 0) ? "passed" : "FAILED");
+    return (test_failures == 0) ? 0 : 1;
+}
+
+#endif /* TEST_H */
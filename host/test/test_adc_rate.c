@@ -0,0 +1,136 @@
+/**
+ * @file test_adc_rate.c
+ * @brief Sweep of the ADC timer and clock settings over every sample rate
+ * @details For each rate from ADC_MIN_SAMPLE_RATE_HZ to ADC_MAX_CAPTURE_RATE_HZ
+ * the driver is started, through adc_start_sampling() up to
+ * ADC_MAX_SAMPLE_RATE_HZ and adc_start_capture() above, and the TIMER1 match
+ * and ADC clock divider it programmed are read back from the simulated
+ * registers. The limits come from the user manual rather than the driver:
+ * - the trigger period is the nearest whole number of timer ticks, so the
+ *   period error is at most one tick, and adc_sample_rate_millihz() reports
+ *   the rate those ticks give;
+ * - the ADC clock stays within 13 MHz;
+ * - a conversion of 65 clocks takes at most half a sample period, and the next
+ *   slower clock would not, unless the divider is at its limit. Above about
+ *   96 kHz even the fastest allowed clock needs longer than half a period, so
+ *   there the conversion must only end before the next trigger.
+ *
+ * The ADC interrupt stays disabled, so the registers are not touched by the
+ * simulated conversions while they are read.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "LPC17xx.h"
+#include "adc.h"
+#include "test.h"
+
+#include <stdbool.h>
+
+/** Peripheral clock of TIMER1 and the ADC, CCLK / 4 */
+#define PCLK_HZ (SystemCoreClock / 4U)
+/** Fastest ADC clock the part allows */
+#define ADC_CLOCK_LIMIT_HZ 13000000U
+/** ADC clocks per conversion */
+#define CONVERSION_CLOCKS 65U
+/** Largest ADC clock divider, CLKDIV + 1 */
+#define DIVIDER_LIMIT 256U
+/** CLKDIV field of ADCR */
+#define ADCR_CLKDIV_SHIFT 8U
+#define ADCR_CLKDIV_MASK  0xFFU
+/** Capture length, never reached with the interrupt off */
+#define CAPTURE_SAMPLES 16U
+
+static uint16_t capture_buffer[CAPTURE_SAMPLES];
+
+/** Worst relative rate error seen, printed with the verdict */
+static double worst = 0.0;
+
+/**
+ * @brief Check the registers the driver programmed for one rate
+ */
+static void check_rate(uint32_t rate_hz)
+{
+    uint64_t pclk    = PCLK_HZ;
+    uint64_t ticks   = 2ULL * ((uint64_t)LPC_TIM1->MR0 + 1U);
+    uint64_t divider = ((LPC_ADC->ADCR >> ADCR_CLKDIV_SHIFT) & ADCR_CLKDIV_MASK) + 1U;
+    uint64_t rate    = rate_hz;
+    uint64_t fastest = (pclk + ADC_CLOCK_LIMIT_HZ - 1U) / ADC_CLOCK_LIMIT_HZ;
+    bool     ok      = true;
+
+    /* |ticks - pclk / rate| <= 1, scaled by the rate */
+    uint64_t period = ticks * rate;
+    ok &= (period > pclk ? period - pclk : pclk - period) <= rate;
+
+    uint64_t millihz = (pclk * 1000U + ticks / 2U) / ticks;
+    ok &= adc_sample_rate_millihz(rate_hz) == millihz;
+
+    ok &= pclk / divider <= ADC_CLOCK_LIMIT_HZ;
+
+    /* Conversion time divider * 65 / pclk against half the period 1 / (2 rate) */
+    if (2U * CONVERSION_CLOCKS * fastest * rate <= pclk)
+    {
+        ok &= 2U * CONVERSION_CLOCKS * divider * rate <= pclk;
+        ok &= divider == DIVIDER_LIMIT ||
+              2U * CONVERSION_CLOCKS * (divider + 1U) * rate > pclk;
+    }
+    else
+    {
+        ok &= divider == fastest;
+        ok &= CONVERSION_CLOCKS * divider * rate <= pclk;
+    }
+
+    TEST_CHECK(ok);
+    if (!ok)
+    {
+        fprintf(
+            stderr, "%u Hz: MR0 %u, CLKDIV %u\n", rate_hz, LPC_TIM1->MR0,
+            (unsigned)(divider - 1U)
+        );
+    }
+
+    double error = ((double)pclk / (double)ticks - (double)rate) / (double)rate;
+    if (error < 0.0)
+    {
+        error = -error;
+    }
+    if (error > worst)
+    {
+        worst = error;
+    }
+}
+
+int main(void)
+{
+    TEST_CHECK(adc_init(ADC_CHANNEL_0) == ADC_OK);
+    NVIC_DisableIRQ(ADC_IRQn);
+
+    for (uint32_t rate = ADC_MIN_SAMPLE_RATE_HZ; rate <= ADC_MAX_CAPTURE_RATE_HZ;
+         rate++)
+    {
+        adc_status_t status =
+            (rate <= ADC_MAX_SAMPLE_RATE_HZ)
+                ? adc_start_sampling(rate)
+                : adc_start_capture(capture_buffer, CAPTURE_SAMPLES, rate);
+
+        TEST_CHECK(status == ADC_OK);
+        check_rate(rate);
+    }
+
+    /* Outside the range nothing is started */
+    TEST_CHECK(adc_start_sampling(0) == ADC_ERROR_PARAM);
+    TEST_CHECK(adc_start_sampling(ADC_MAX_SAMPLE_RATE_HZ + 1U) == ADC_ERROR_PARAM);
+    TEST_CHECK(
+        adc_start_capture(
+            capture_buffer, CAPTURE_SAMPLES, ADC_MAX_CAPTURE_RATE_HZ + 1U
+        ) == ADC_ERROR_PARAM
+    );
+    TEST_CHECK(adc_sample_rate_millihz(0) == 0);
+    TEST_CHECK(adc_sample_rate_millihz(ADC_MAX_CAPTURE_RATE_HZ + 1U) == 0);
+
+    TEST_CHECK(adc_stop_sampling() == ADC_OK);
+    TEST_CHECK((LPC_TIM1->TCR & 1U) == 0U);
+
+    printf("test_adc_rate: worst rate error %.2g\n", worst);
+    return test_report("test_adc_rate");
+}
@@ -0,0 +1,173 @@
+/**
+ * @file test_arp.c
+ * @brief Stream starts held back for the subscriber's ARP reply
+ * @details The whole firmware runs with the ARP model of the host socket layer:
+ * an address takes ARP_MS to resolve and datagrams sent to it meanwhile are
+ * lost, as RL-NET loses them. One address never answers. Each CMD_START_ACQ
+ * must go through the states of the network task:
+ * - a new host is pinned and only subscribed once its reply is in, so its first
+ *   data packet is not lost and arrives soon after ARP_MS rather than whenever
+ *   the stack asks again;
+ * - a host still in the cache is subscribed at once, without waiting for ARP;
+ * - a host that does not answer is subscribed at the ARP_RESOLVE_TIMEOUT of
+ *   task_network.c anyway and counted as failed;
+ * - a CMD_STOP_ACQ while the reply is awaited cancels the start.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "firmware.h"
+#include "session.h"
+#include "test.h"
+
+/** ARP resolution time of the model */
+#define ARP_MS 150U
+/** ARP_RESOLVE_TIMEOUT of task_network.c */
+#define RESOLVE_TIMEOUT_MS 200U
+/** Time the network task may take on top of the state it waits for */
+#define SLACK_MS 100U
+/** Time from a subscription to the first packet: the idle poll of the
+ * acquisition task and one packet of samples */
+#define ACQ_START_MS 200U
+
+/** Hosts of the test, the silent one never answers ARP */
+#define HOST_NEW      "127.0.0.2"
+#define HOST_SILENT   "127.0.0.3"
+#define HOST_CANCELED "127.0.0.4"
+
+/**
+ * @brief Check whether a host has a subscription
+ */
+static bool subscribed(const char *host)
+{
+    udp_ipv4_addr_t ip;
+
+    (void)inet_pton(AF_INET, host, ip.addr);
+    return session_has_host(&ip);
+}
+
+/**
+ * @brief Send CMD_START_ACQ and time the subscription and the first data packet
+ * @param subscribe_ms Milliseconds until the host was subscribed
+ * @return Milliseconds until its first data packet, UINT32_MAX if none came
+ */
+static uint32_t start(int fd, const char *host, uint32_t *subscribe_ms)
+{
+    uint8_t        buffer[1500];
+    const uint8_t *payload;
+    uint64_t       start_us = system_time_us();
+
+    client_command(fd, CMD_START_ACQ, 0, 0);
+
+    *subscribe_ms = UINT32_MAX;
+    for (uint32_t waited = 0; waited < 1000U; waited++)
+    {
+        if (subscribed(host))
+        {
+            *subscribe_ms = (uint32_t)((system_time_us() - start_us) / 1000U);
+            break;
+        }
+        osDelay(1);
+    }
+
+    if (client_expect(fd, MSG_TYPE_DATA, buffer, sizeof(buffer), 1000U, &payload) < 0)
+    {
+        return UINT32_MAX;
+    }
+
+    return (uint32_t)((system_time_us() - start_us) / 1000U);
+}
+
+/**
+ * @brief Drain a client socket
+ * @return true if any data packet was waiting
+ */
+static bool drain(int fd)
+{
+    uint8_t        buffer[1500];
+    const uint8_t *payload;
+    bool           data = false;
+
+    while (client_expect(fd, MSG_TYPE_DATA, buffer, sizeof(buffer), 50U, &payload) >= 0)
+    {
+        data = true;
+    }
+
+    return data;
+}
+
+static void test_body(void *argument)
+{
+    network_stats_t stats;
+
+    (void)argument;
+
+    TEST_CHECK(firmware_wait_ready());
+
+    int fresh = client_open(HOST_NEW);
+    client_configure(fresh, CONFIG_THRESHOLD_MV, 0);
+    client_configure(fresh, CONFIG_SAMPLE_RATE_HZ, ADC_MAX_SAMPLE_RATE_HZ);
+
+    /* New host: subscribed when the reply is in, not before or long after */
+    uint32_t resolved_ms;
+    uint32_t first_ms = start(fresh, HOST_NEW, &resolved_ms);
+    TEST_CHECK(resolved_ms >= ARP_MS && resolved_ms < ARP_MS + SLACK_MS);
+    TEST_CHECK(first_ms - resolved_ms < ACQ_START_MS);
+    network_get_stats(&stats);
+    TEST_CHECK(stats.arp_resolve_us >= ARP_MS * 1000U);
+    TEST_CHECK(stats.arp_resolve_us < (ARP_MS + SLACK_MS) * 1000U);
+    TEST_CHECK(stats.arp_failed == 0U);
+
+    /* The same host again: still cached, so no wait for ARP */
+    client_command(fresh, CMD_STOP_ACQ, 0, 0);
+    osDelay(50);
+    (void)drain(fresh);
+    TEST_CHECK(!subscribed(HOST_NEW));
+
+    uint32_t cached_ms;
+    uint32_t cached_first_ms = start(fresh, HOST_NEW, &cached_ms);
+    TEST_CHECK(cached_ms < SLACK_MS / 4U);
+    TEST_CHECK(cached_first_ms - cached_ms < ACQ_START_MS);
+
+    /* A host that never answers: subscribed at the timeout, counted as failed */
+    int silent = client_open(HOST_SILENT);
+    client_command(silent, CMD_START_ACQ, 0, 0);
+    osDelay(RESOLVE_TIMEOUT_MS / 2U);
+    TEST_CHECK(!subscribed(HOST_SILENT));
+    osDelay(RESOLVE_TIMEOUT_MS / 2U + SLACK_MS);
+    TEST_CHECK(subscribed(HOST_SILENT));
+    network_get_stats(&stats);
+    TEST_CHECK(stats.arp_failed == 1U);
+    TEST_CHECK(!drain(silent));
+
+    /* A stop while the reply is awaited cancels the start */
+    int canceled = client_open(HOST_CANCELED);
+    client_command(canceled, CMD_START_ACQ, 0, 0);
+    osDelay(ARP_MS / 3U);
+    client_command(canceled, CMD_STOP_ACQ, 0, 0);
+    osDelay(ARP_MS + SLACK_MS);
+    TEST_CHECK(!subscribed(HOST_CANCELED));
+    TEST_CHECK(!drain(canceled));
+
+    printf(
+        "test_arp: subscribed after %u ms with ARP, first packet after %u ms; "
+        "%u and %u ms without\n",
+        resolved_ms, first_ms, cached_ms, cached_first_ms
+    );
+
+    client_command(fresh, CMD_STOP_ACQ, 0, 0);
+    client_command(silent, CMD_STOP_ACQ, 0, 0);
+    exit(test_report("test_arp"));
+}
+
+int main(void)
+{
+    char arp_ms[16];
+
+    (void)snprintf(arp_ms, sizeof(arp_ms), "%u", ARP_MS);
+    setenv("SIM_NET_ARP_MS", arp_ms, 1);
+    setenv("SIM_NET_ARP_SILENT", HOST_SILENT, 1);
+
+    firmware_boot(true);
+    firmware_run(test_body);
+}
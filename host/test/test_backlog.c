@@ -0,0 +1,165 @@
+/**
+ * @file test_backlog.c
+ * @brief Backlog of held data packets across link outages and a stopped stream
+ * @details The firmware runs without the acquisition task, so the test thread
+ * plays the data path with network_send_raw(), and SIM_NET_FLAP takes the link
+ * down every LINK_UP_MS. Each data packet carries a sample count of its own, by
+ * which the client tells them apart.
+ *
+ * Packets sent during an outage are held and, with the first packet after it,
+ * delivered in order followed by a gap packet. When the only subscriber stops
+ * after the outage and before another packet is sent, its held packets must be
+ * discarded: after the next CMD_START_ACQ the client receives the new packet
+ * alone, with no stale packets and no gap packet.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "firmware.h"
+#include "test.h"
+
+/** Link flap periods, long enough up for a stop and a start */
+#define LINK_UP_MS   "600"
+#define LINK_DOWN_MS "200"
+/** Packets sent during each outage */
+#define HELD 5U
+/** Sample counts marking the packets of each phase */
+#define RESUMED_BASE 10U
+#define STOPPED_BASE 30U
+#define FRESH_COUNT  50U
+/** Time the network task gets to handle a command */
+#define COMMAND_MS 50U
+/** Longest wait for a link change */
+#define LINK_TIMEOUT_MS 2000U
+
+static int client;
+
+/**
+ * @brief Wait until the link is down, or back up with the network task ready
+ */
+static bool wait_link(bool up)
+{
+    for (uint32_t waited = 0; waited < LINK_TIMEOUT_MS; waited++)
+    {
+        if (up ? network_is_ready() && udp_socket_is_link_up()
+               : !udp_socket_is_link_up())
+        {
+            return true;
+        }
+        osDelay(1);
+    }
+
+    return false;
+}
+
+/**
+ * @brief Send one data packet marked by its sample count
+ */
+static void send_marked(uint16_t sample_count)
+{
+    static const uint16_t samples[FRESH_COUNT] = {0};
+    uint8_t               packet[PROTOCOL_MAX_DATA_SIZE];
+    size_t                len;
+
+    TEST_CHECK(
+        protocol_build_data_packet(
+            packet, sizeof(packet), 0, samples, sample_count, 0, system_time_us(), &len
+        ) == PROTO_STATUS_OK
+    );
+    TEST_CHECK(network_send_raw(0, packet, len) == 0);
+}
+
+/**
+ * @brief Receive what the device streams until it goes quiet
+ * @param marks Sample count of each data packet, 0 for a gap packet
+ * @return Number of packets received
+ */
+static size_t receive_stream(uint16_t *marks, size_t size)
+{
+    uint8_t buffer[1500];
+    size_t  count = 0;
+
+    for (;;)
+    {
+        protocol_header_t header;
+        const uint8_t    *payload;
+        int len = client_recv(client, buffer, sizeof(buffer), 200U, &header, &payload);
+
+        if (len < 0)
+        {
+            return count;
+        }
+        if (count == size)
+        {
+            continue;
+        }
+        if (header.msg_type == MSG_TYPE_DATA && len >= 4)
+        {
+            marks[count++] = (uint16_t)(payload[2] | (payload[3] << 8));
+        }
+        else if (header.msg_type == MSG_TYPE_GAP)
+        {
+            marks[count++] = 0;
+        }
+    }
+}
+
+static void test_body(void *argument)
+{
+    uint16_t marks[2U * HELD];
+
+    (void)argument;
+
+    TEST_CHECK(firmware_wait_ready());
+    client = client_open("127.0.0.2");
+    client_command(client, CMD_START_ACQ, 0, 0);
+    osDelay(COMMAND_MS);
+
+    /* An outage: the held packets follow once the link is back, then a gap */
+    TEST_CHECK(wait_link(false));
+    for (uint16_t i = 0; i < HELD; i++)
+    {
+        send_marked(RESUMED_BASE + i);
+    }
+    TEST_CHECK(wait_link(true));
+    send_marked(FRESH_COUNT);
+
+    size_t count = receive_stream(marks, sizeof(marks) / sizeof(marks[0]));
+    TEST_CHECK(count == HELD + 2U);
+    for (size_t i = 0; i < count && i < HELD; i++)
+    {
+        TEST_CHECK(marks[i] == RESUMED_BASE + i);
+    }
+    if (count == HELD + 2U)
+    {
+        TEST_CHECK(marks[HELD] == 0 && marks[HELD + 1U] == FRESH_COUNT);
+    }
+
+    /* Another outage, but the subscriber stops before the next packet */
+    TEST_CHECK(wait_link(false));
+    for (uint16_t i = 0; i < HELD; i++)
+    {
+        send_marked(STOPPED_BASE + i);
+    }
+    TEST_CHECK(wait_link(true));
+    client_command(client, CMD_STOP_ACQ, 0, 0);
+    osDelay(COMMAND_MS);
+    client_command(client, CMD_START_ACQ, 0, 0);
+    osDelay(COMMAND_MS);
+    send_marked(FRESH_COUNT);
+
+    count = receive_stream(marks, sizeof(marks) / sizeof(marks[0]));
+    TEST_CHECK(count == 1U && marks[0] == FRESH_COUNT);
+    printf("test_backlog: %u packets after the restart\n", (unsigned)count);
+
+    client_command(client, CMD_STOP_ACQ, 0, 0);
+    exit(test_report("test_backlog"));
+}
+
+int main(void)
+{
+    setenv("SIM_NET_FLAP", LINK_UP_MS "," LINK_DOWN_MS, 1);
+
+    firmware_boot(false);
+    firmware_run(test_body);
+}
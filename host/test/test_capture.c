@@ -0,0 +1,141 @@
+/**
+ * @file test_capture.c
+ * @brief Burst capture end to end on the simulated ADC
+ * @details The whole firmware runs with the counting input, which feeds the
+ * conversion number modulo 4096, so every captured sample must be one above the
+ * previous. A client takes a capture with CMD_CAPTURE, polls CMD_CAPTURE_READ
+ * until it is done and reads it back in chunks; the chunks must reassemble to
+ * exactly the requested number of consecutive values with no overrun, reported
+ * both in the packets and by adc_capture_overrun_count(). The capture is taken
+ * once with acquisition stopped and once while a stream is running, which
+ * run_capture() pauses and resumes.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "adc.h"
+#include "firmware.h"
+#include "test.h"
+
+/** Samples of the first capture, not a multiple of the chunk size */
+#define CAPTURE_SAMPLES 1500U
+/** Longest a capture may take to be reported done */
+#define CAPTURE_DONE_MS 2000U
+/** Modulus of the counting input */
+#define COUNT_MODULUS 4096U
+
+static uint16_t samples[ACQUISITION_CAPTURE_MAX_SAMPLES];
+
+/**
+ * @brief Send a capture command and decode the capture packet answering it
+ * @return Samples carried by the packet, -1 if no valid answer arrived
+ */
+static int capture_command(
+    int fd, uint8_t cmd, uint16_t param, protocol_capture_payload_t *info,
+    uint16_t *chunk
+)
+{
+    uint8_t        buffer[1500];
+    const uint8_t *payload;
+
+    client_command(fd, cmd, 0, param);
+    int len =
+        client_expect(fd, MSG_TYPE_CAPTURE, buffer, sizeof(buffer), 1000U, &payload);
+    if (len < (int)sizeof(*info))
+    {
+        return -1;
+    }
+
+    memcpy(info, payload, sizeof(*info));
+    if ((size_t)len != sizeof(*info) + 2U * info->sample_count)
+    {
+        return -1;
+    }
+    memcpy(chunk, &payload[sizeof(*info)], 2U * info->sample_count);
+
+    return info->sample_count;
+}
+
+/**
+ * @brief Take one capture of count samples and check it
+ */
+static void check_capture(int fd, uint16_t count)
+{
+    protocol_capture_payload_t info;
+    uint16_t                   chunk[PROTOCOL_CAPTURE_CHUNK_SAMPLES];
+
+    TEST_CHECK(capture_command(fd, CMD_CAPTURE, count, &info, chunk) == 0);
+    TEST_CHECK(info.state == CAPTURE_STATE_RUNNING);
+
+    uint64_t deadline = system_time_us() + CAPTURE_DONE_MS * 1000ULL;
+    do
+    {
+        osDelay(5);
+        TEST_CHECK(capture_command(fd, CMD_CAPTURE_READ, 0, &info, chunk) >= 0);
+    } while (info.state != CAPTURE_STATE_DONE && system_time_us() < deadline);
+
+    TEST_CHECK(info.state == CAPTURE_STATE_DONE);
+    TEST_CHECK(info.total == count);
+    TEST_CHECK(info.overruns == 0);
+    TEST_CHECK(info.sample_rate == adc_sample_rate_millihz(ADC_MAX_CAPTURE_RATE_HZ));
+    TEST_CHECK(adc_capture_overrun_count() == 0);
+
+    uint16_t offset = 0;
+    while (offset < info.total)
+    {
+        int got = capture_command(fd, CMD_CAPTURE_READ, offset, &info, chunk);
+        TEST_CHECK(got > 0 && info.offset == offset);
+        if (got <= 0)
+        {
+            return;
+        }
+        memcpy(&samples[offset], chunk, 2U * (size_t)got);
+        offset += (uint16_t)got;
+    }
+    TEST_CHECK(offset == count);
+
+    /* Reading past the end returns the state only */
+    TEST_CHECK(capture_command(fd, CMD_CAPTURE_READ, count, &info, chunk) == 0);
+
+    uint32_t steps = 0;
+    for (uint16_t i = 1; i < count; i++)
+    {
+        steps += (samples[i] != (samples[i - 1] + 1U) % COUNT_MODULUS);
+    }
+    TEST_CHECK(steps == 0);
+}
+
+static void test_body(void *argument)
+{
+    (void)argument;
+
+    TEST_CHECK(firmware_wait_ready());
+
+    int client = client_open("127.0.0.2");
+
+    check_capture(client, CAPTURE_SAMPLES);
+
+    /* Again while streaming, which the capture interrupts */
+    client_command(client, CMD_START_ACQ, 0, 0);
+    osDelay(300);
+    check_capture(client, ACQUISITION_CAPTURE_MAX_SAMPLES);
+    TEST_CHECK(acquisition_is_running());
+
+    uint8_t        buffer[1500];
+    const uint8_t *payload;
+    TEST_CHECK(
+        client_expect(client, MSG_TYPE_DATA, buffer, sizeof(buffer), 1000U, &payload) >
+        0
+    );
+    client_command(client, CMD_STOP_ACQ, 0, 0);
+
+    exit(test_report("test_capture"));
+}
+
+int main(void)
+{
+    setenv("SIM_ADC_WAVE", "count", 1);
+
+    firmware_boot(true);
+    firmware_run(test_body);
+}
@@ -0,0 +1,209 @@
+/**
+ * @file test_config_mailbox.c
+ * @brief Configuration mailbox of the acquisition task against a running stream
+ * @details The whole firmware runs with a dc input whose level depends on the
+ * channel, threshold 0 and the top sample rate. The test thread stands in for
+ * the network task, the only writer of the mailbox, and publishes a run of
+ * versions that each change channel and batch size together, while a client
+ * subscribed with CMD_START_ACQ records the data stream.
+ *
+ * Every packet has to belong to one published version: its channel, a sample
+ * count no larger than that version's batch size and samples at that channel's
+ * level. Only the last packet of a version may be short, versions only move
+ * forward and the sequence numbers leave no hole.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "firmware.h"
+#include "test.h"
+
+/** Configuration versions published after the first */
+#define VERSIONS 64U
+/** Time between two publications */
+#define PUBLISH_INTERVAL_MS 25U
+/** Level of channel 0 and the step to the next channel, in ADC codes */
+#define LEVEL_BASE 100U
+#define LEVEL_STEP 500U
+/** Most data packets recorded */
+#define MAX_PACKETS 4096U
+/** Time the stream gets to drain after CMD_STOP_ACQ */
+#define DRAIN_MS 300U
+
+/**
+ * @brief What a data packet says about the configuration it was built under
+ */
+typedef struct
+{
+    uint16_t sequence; /**< Header sequence number */
+    uint8_t  channel;  /**< Channel of the payload */
+    uint16_t count;    /**< Samples in the payload */
+    bool     mixed;    /**< A sample is not at the channel's level */
+} packet_t;
+
+static packet_t packets[MAX_PACKETS];
+static uint32_t packet_count = 0;
+
+static uint8_t version_channel(uint32_t version)
+{
+    return (uint8_t)(version % ADC_CHANNEL_MAX);
+}
+
+static uint16_t version_batch(uint32_t version)
+{
+    return (uint16_t)(5U + (version * 37U) % (ACQUISITION_MAX_BATCH_SIZE - 4U));
+}
+
+static void publish_version(uint32_t version)
+{
+    acquisition_config_begin();
+    TEST_CHECK(acquisition_set_channel((adc_channel_t)version_channel(version)) == 0);
+    TEST_CHECK(acquisition_set_batch_size(version_batch(version)) == 0);
+    acquisition_config_commit();
+}
+
+/**
+ * @brief Record the data packets arriving within timeout_ms
+ */
+static void record(int fd, uint32_t timeout_ms)
+{
+    uint64_t deadline = system_time_us() + (uint64_t)timeout_ms * 1000U;
+    uint8_t  buffer[1500];
+
+    while (system_time_us() < deadline)
+    {
+        protocol_header_t header;
+        const uint8_t    *payload;
+        int len = client_recv(fd, buffer, sizeof(buffer), 1U, &header, &payload);
+
+        if (len < (int)sizeof(protocol_data_payload_t) ||
+            header.msg_type != MSG_TYPE_DATA || packet_count == MAX_PACKETS)
+        {
+            continue;
+        }
+
+        protocol_data_payload_t data;
+        memcpy(&data, payload, sizeof(data));
+
+        packet_t *packet = &packets[packet_count++];
+        packet->sequence = header.sequence;
+        packet->channel  = data.channel;
+        packet->count    = data.sample_count;
+        packet->mixed    = false;
+
+        uint16_t level = (uint16_t)(LEVEL_BASE + LEVEL_STEP * data.channel);
+        for (uint16_t i = 0; i < data.sample_count; i++)
+        {
+            uint16_t sample;
+            memcpy(&sample, &payload[sizeof(data) + 2U * i], sizeof(sample));
+            packet->mixed |= (sample != level);
+        }
+    }
+}
+
+static bool matches(const packet_t *packet, uint32_t version)
+{
+    return packet->channel == version_channel(version) &&
+           packet->count <= version_batch(version) && packet->count > 0;
+}
+
+/**
+ * @brief Check the recorded stream against the published versions
+ */
+static void check_stream(void)
+{
+    uint32_t version = 0;
+    uint32_t adopted = 1;
+    bool     short_  = false;
+
+    TEST_CHECK(packet_count > VERSIONS);
+
+    for (uint32_t i = 0; i < packet_count; i++)
+    {
+        const packet_t *packet = &packets[i];
+
+        TEST_CHECK(!packet->mixed);
+        if (i > 0)
+        {
+            TEST_CHECK(packet->sequence == (uint16_t)(packets[i - 1].sequence + 1U));
+        }
+
+        if (!matches(packet, version) || short_)
+        {
+            uint32_t next = version + 1;
+            while (next <= VERSIONS && !matches(packet, next))
+            {
+                next++;
+            }
+            TEST_CHECK(next <= VERSIONS);
+            if (next > VERSIONS)
+            {
+                fprintf(
+                    stderr, "packet %u: channel %u, %u samples, after version %u\n", i,
+                    packet->channel, packet->count, version
+                );
+                continue;
+            }
+            version = next;
+            adopted++;
+        }
+
+        short_ = packet->count < version_batch(version);
+    }
+
+    /* Most versions live long enough to send a packet */
+    TEST_CHECK(adopted > VERSIONS / 2U);
+}
+
+static void test_body(void *argument)
+{
+    (void)argument;
+
+    TEST_CHECK(firmware_wait_ready());
+
+    int client = client_open("127.0.0.2");
+
+    acquisition_config_begin();
+    TEST_CHECK(acquisition_set_threshold_mv(0) == 0);
+    TEST_CHECK(acquisition_set_sample_rate(ADC_MAX_SAMPLE_RATE_HZ) == 0);
+    TEST_CHECK(acquisition_set_channel((adc_channel_t)version_channel(0)) == 0);
+    TEST_CHECK(acquisition_set_batch_size(version_batch(0)) == 0);
+    acquisition_config_commit();
+    osDelay(200);
+
+    client_command(client, CMD_START_ACQ, 0, 0);
+    record(client, PUBLISH_INTERVAL_MS);
+
+    for (uint32_t version = 1; version <= VERSIONS; version++)
+    {
+        publish_version(version);
+        record(client, PUBLISH_INTERVAL_MS);
+    }
+
+    client_command(client, CMD_STOP_ACQ, 0, 0);
+    record(client, DRAIN_MS);
+
+    check_stream();
+
+    uint32_t errors = UINT32_MAX;
+    TEST_CHECK(client_telemetry(client, TELEM_ACQ_ERRORS, &errors));
+    TEST_CHECK(errors == 0);
+
+    printf("test_config_mailbox: %u packets\n", packet_count);
+    exit(test_report("test_config_mailbox"));
+}
+
+int main(void)
+{
+    char base[16];
+    char step[16];
+
+    (void)snprintf(base, sizeof(base), "%u", LEVEL_BASE);
+    (void)snprintf(step, sizeof(step), "%u", LEVEL_STEP);
+    setenv("SIM_ADC_WAVE", "dc", 1);
+    setenv("SIM_ADC_OFFSET", base, 1);
+    setenv("SIM_ADC_CHANNEL_STEP", step, 1);
+
+    firmware_boot(true);
+    firmware_run(test_body);
+}
@@ -0,0 +1,90 @@
+/**
+ * @file test_crc32c.c
+ * @brief Check of the slice-by-8 CRC32C against a bitwise reference
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "crc32c.h"
+#include "test.h"
+
+#include <string.h>
+
+/** Longest buffer checked, covers every tail length around the 8-byte loop */
+#define MAX_LEN 1100U
+/** Random buffers checked per run */
+#define ITERATIONS 20000U
+
+/**
+ * @brief One bit at a time over the reflected polynomial 0x82F63B78
+ */
+static uint32_t reference_crc32c(uint32_t crc, const uint8_t *data, size_t len)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0x82F63B78U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+int main(void)
+{
+    static uint8_t buffer[MAX_LEN + 8];
+    uint32_t       rng = 0x9E3779B9U;
+
+    /* Check value of the CRC-32C catalogue entry, and RFC 3720 B.4 vectors */
+    static const uint8_t digits[] = "123456789";
+    TEST_CHECK(crc32c_update(0, digits, 9) == 0xE3069283U);
+    memset(buffer, 0x00, 32);
+    TEST_CHECK(crc32c_update(0, buffer, 32) == 0x8A9136AAU);
+    memset(buffer, 0xFF, 32);
+    TEST_CHECK(crc32c_update(0, buffer, 32) == 0x62A8AB43U);
+    for (uint8_t i = 0; i < 32; i++)
+    {
+        buffer[i] = i;
+    }
+    TEST_CHECK(crc32c_update(0, buffer, 32) == 0x46DD794EU);
+    TEST_CHECK(crc32c_update(0, buffer, 0) == 0U);
+
+    for (size_t i = 0; i < sizeof(buffer); i++)
+    {
+        buffer[i] = (uint8_t)test_random(&rng);
+    }
+
+    /* Every length at every alignment of the start pointer */
+    for (size_t offset = 0; offset < 8; offset++)
+    {
+        for (size_t len = 0; len <= 64; len++)
+        {
+            TEST_CHECK(
+                crc32c_update(0, buffer + offset, len) ==
+                reference_crc32c(0, buffer + offset, len)
+            );
+        }
+    }
+
+    /* Random lengths, split into two updates at a random point */
+    for (uint32_t i = 0; i < ITERATIONS; i++)
+    {
+        size_t   offset   = test_random(&rng) % 8U;
+        size_t   len      = test_random(&rng) % (MAX_LEN + 1U);
+        size_t   split    = test_random(&rng) % (len + 1U);
+        uint32_t seed     = (i % 2U == 0U) ? 0U : test_random(&rng);
+        uint32_t expected = reference_crc32c(seed, buffer + offset, len);
+
+        TEST_CHECK(crc32c_update(seed, buffer + offset, len) == expected);
+        TEST_CHECK(
+            crc32c_update(
+                crc32c_update(seed, buffer + offset, split), buffer + offset + split,
+                len - split
+            ) == expected
+        );
+    }
+
+    return test_report("test_crc32c");
+}
@@ -0,0 +1,183 @@
+/**
+ * @file test_decimator.c
+ * @brief Check of the CIC decimator and its compensation FIR against a direct
+ * form reference
+ * @details The reference convolves the input with the cascaded boxcar response
+ * of the CIC in double precision, so it needs neither the integrator wrap-around
+ * nor the integer scaling of the firmware.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "decimator.h"
+#include "test.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Outputs compared per ratio and input pattern */
+#define OUTPUTS 3000U
+/** Largest output error in LSB: CIC rounding through the FIR gain, final rounding */
+#define TOLERANCE 2.0
+/** Impulse response length of the cascaded CIC */
+#define CIC_TAPS(ratio) (DECIMATOR_STAGES * ((ratio) - 1U) + 1U)
+
+/** Compensation FIR in Q14, as documented in decimator.c */
+static const double fir_taps[DECIMATOR_FIR_TAPS] = {590, -4194, 23592, -4194, 590};
+
+/** Worst error seen, printed with the verdict */
+static double worst = 0.0;
+
+/**
+ * @brief Impulse response of DECIMATOR_STAGES boxcars of length ratio
+ */
+static void cic_response(uint16_t ratio, double *response)
+{
+    double scratch[CIC_TAPS(DECIMATOR_MAX_RATIO)];
+    size_t len = 1;
+
+    response[0] = 1.0;
+    for (int stage = 0; stage < DECIMATOR_STAGES; stage++)
+    {
+        memset(scratch, 0, sizeof(scratch));
+        for (size_t i = 0; i < len; i++)
+        {
+            for (size_t j = 0; j < ratio; j++)
+            {
+                scratch[i + j] += response[i];
+            }
+        }
+        len += ratio - 1U;
+        memcpy(response, scratch, len * sizeof(double));
+    }
+}
+
+/**
+ * @brief Input sample n of one of the test patterns
+ */
+static uint16_t pattern(int kind, size_t n, uint32_t *rng)
+{
+    switch (kind)
+    {
+    case 0:
+        /* Full-scale noise, worst case for the integrator wrap-around */
+        return (uint16_t)(test_random(rng) % 4096U);
+    case 1:
+        /* Steps between the rails */
+        return ((n / 997U) % 2U == 0U) ? 0U : 4095U;
+    default:
+        /* Slow sine with a little noise */
+        return (uint16_t)(2048.0 + 1900.0 * sin((double)n * 0.001) +
+                          (double)(test_random(rng) % 17U) - 8.0);
+    }
+}
+
+/**
+ * @brief Run one ratio over one pattern and compare every output
+ */
+static void check_ratio(uint16_t ratio, int kind)
+{
+    static uint16_t input[(OUTPUTS + DECIMATOR_STAGES) * DECIMATOR_MAX_RATIO];
+    double          response[CIC_TAPS(DECIMATOR_MAX_RATIO)];
+    double          history[DECIMATOR_FIR_TAPS];
+    size_t          inputs  = (OUTPUTS + DECIMATOR_STAGES - 1U) * ratio;
+    size_t          outputs = 0;
+    uint32_t        rng     = 0xBB67AE85U + ratio;
+    double          gain    = pow(ratio, DECIMATOR_STAGES);
+    decimator_t     dec;
+
+    cic_response(ratio, response);
+    TEST_CHECK(decimator_init(&dec, ratio) == 0);
+
+    for (size_t n = 0; n < inputs; n++)
+    {
+        uint16_t out;
+
+        input[n] = pattern(kind, n, &rng);
+        if (!decimator_process(&dec, input[n], &out))
+        {
+            continue;
+        }
+
+        /* Outputs fall on every ratio-th input once the CIC is full */
+        TEST_CHECK((n + 1U) % ratio == 0U);
+        TEST_CHECK(n + 1U >= (size_t)DECIMATOR_STAGES * ratio);
+
+        double cic = 0.0;
+        for (size_t j = 0; j < CIC_TAPS(ratio); j++)
+        {
+            cic += response[j] * input[n - j];
+        }
+        cic /= gain;
+
+        /* The FIR history starts filled with the first output */
+        if (outputs == 0U)
+        {
+            for (size_t i = 0; i < DECIMATOR_FIR_TAPS; i++)
+            {
+                history[i] = cic;
+            }
+        }
+        memmove(&history[1], &history[0], (DECIMATOR_FIR_TAPS - 1) * sizeof(double));
+        history[0] = cic;
+
+        double expected = 0.0;
+        for (size_t i = 0; i < DECIMATOR_FIR_TAPS; i++)
+        {
+            expected += fir_taps[i] * history[i];
+        }
+        expected = expected / 16384.0 * (1U << DECIMATOR_FRAC_BITS);
+        expected = fmin(fmax(expected, 0.0), 4095U << DECIMATOR_FRAC_BITS);
+
+        double error = fabs(out - expected);
+        worst        = fmax(worst, error);
+        TEST_CHECK(error <= TOLERANCE);
+        outputs++;
+    }
+
+    TEST_CHECK(outputs == OUTPUTS);
+}
+
+int main(void)
+{
+    static const uint16_t ratios[] = {2, 3, 4, 5, 8, 13, 16, 32, 63, 64};
+    decimator_t           dec;
+    uint16_t              out;
+
+    TEST_CHECK(decimator_init(&dec, 0) < 0);
+    TEST_CHECK(decimator_init(&dec, DECIMATOR_MAX_RATIO + 1) < 0);
+    TEST_CHECK(decimator_init(NULL, 4) < 0);
+
+    /* Ratio 1 passes every sample through, only shifted */
+    TEST_CHECK(decimator_init(&dec, 1) == 0);
+    for (uint16_t sample = 0; sample < 4096U; sample++)
+    {
+        TEST_CHECK(decimator_process(&dec, sample, &out));
+        TEST_CHECK(out == (uint16_t)(sample << DECIMATOR_FRAC_BITS));
+    }
+
+    for (size_t i = 0; i < sizeof(ratios) / sizeof(ratios[0]); i++)
+    {
+        for (int kind = 0; kind < 3; kind++)
+        {
+            check_ratio(ratios[i], kind);
+        }
+    }
+
+    /* A constant comes out unchanged, whatever the ratio */
+    for (uint16_t ratio = 2; ratio <= DECIMATOR_MAX_RATIO; ratio++)
+    {
+        TEST_CHECK(decimator_init(&dec, ratio) == 0);
+        for (uint32_t n = 0; n < 10U * ratio; n++)
+        {
+            if (decimator_process(&dec, 1234, &out))
+            {
+                TEST_CHECK(out == (uint16_t)(1234U << DECIMATOR_FRAC_BITS));
+            }
+        }
+    }
+
+    printf("test_decimator: worst error %.2f LSB\n", worst);
+    return test_report("test_decimator");
+}
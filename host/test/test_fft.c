@@ -0,0 +1,158 @@
+/**
+ * @file test_fft.c
+ * @brief Check of the Q15 real FFT against a double precision DFT
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "fft.h"
+#include "test.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+/** Random frames checked per run */
+#define ITERATIONS 2000U
+/** Largest error of a spectrum value in Q15 LSB, the shifts round down */
+#define SPECTRUM_TOLERANCE 6.0
+/** Largest error of a windowed sample in Q15 LSB */
+#define WINDOW_TOLERANCE 3.0
+
+static const double pi = 3.14159265358979323846;
+
+/** Worst errors seen, printed with the verdict */
+static double worst_spectrum = 0.0;
+static double worst_window   = 0.0;
+
+static double track(double error, double *worst)
+{
+    error = fabs(error);
+    if (error > *worst)
+    {
+        *worst = error;
+    }
+    return error;
+}
+
+/**
+ * @brief Transform a frame and compare every packed value with the DFT / FFT_SIZE
+ */
+static void check_frame(const int16_t *input)
+{
+    int16_t data[FFT_SIZE];
+
+    for (size_t n = 0; n < FFT_SIZE; n++)
+    {
+        data[n] = input[n];
+    }
+    fft_real_q15(data);
+
+    for (size_t k = 0; k <= FFT_BINS; k++)
+    {
+        double re = 0.0;
+        double im = 0.0;
+
+        for (size_t n = 0; n < FFT_SIZE; n++)
+        {
+            double phase = 2.0 * pi * (double)((k * n) % FFT_SIZE) / FFT_SIZE;
+            re += input[n] * cos(phase);
+            im -= input[n] * sin(phase);
+        }
+        re /= FFT_SIZE;
+        im /= FFT_SIZE;
+
+        if (k == 0)
+        {
+            TEST_CHECK(track(data[0] - re, &worst_spectrum) <= SPECTRUM_TOLERANCE);
+        }
+        else if (k == FFT_BINS)
+        {
+            TEST_CHECK(track(data[1] - re, &worst_spectrum) <= SPECTRUM_TOLERANCE);
+        }
+        else
+        {
+            TEST_CHECK(
+                track(data[2 * k] - re, &worst_spectrum) <= SPECTRUM_TOLERANCE
+            );
+            TEST_CHECK(
+                track(data[2 * k + 1] - im, &worst_spectrum) <= SPECTRUM_TOLERANCE
+            );
+        }
+    }
+}
+
+int main(void)
+{
+    int16_t  frame[FFT_SIZE];
+    uint32_t rng = 0x6A09E667U;
+
+    /* Window: centered 12-bit sample scaled to Q15, times the Hann window */
+    for (size_t n = 0; n < FFT_SIZE; n++)
+    {
+        double window = 0.5 * (1.0 - cos(2.0 * pi * (double)n / FFT_SIZE));
+
+        for (uint32_t adc = 0; adc < 4096U; adc += 13U)
+        {
+            double expected = (double)((int32_t)adc - 2048) * 16.0 * window;
+            double error    = fft_window_sample((uint16_t)adc, n) - expected;
+            TEST_CHECK(track(error, &worst_window) <= WINDOW_TOLERANCE);
+        }
+    }
+
+    /* Full-scale random frames and windowed random ADC frames */
+    for (uint32_t i = 0; i < ITERATIONS; i++)
+    {
+        for (size_t n = 0; n < FFT_SIZE; n++)
+        {
+            uint32_t value = test_random(&rng);
+            frame[n]       = (i % 2U == 0U)
+                                 ? (int16_t)value
+                                 : fft_window_sample((uint16_t)(value % 4096U), n);
+        }
+        check_frame(frame);
+    }
+
+    /* A full-scale tone lands in its bin, with half the amplitude per side */
+    for (size_t bin = 1; bin < FFT_BINS; bin++)
+    {
+        for (size_t n = 0; n < FFT_SIZE; n++)
+        {
+            frame[n] = (int16_t)lrint(
+                32000.0 * cos(2.0 * pi * (double)((bin * n) % FFT_SIZE) / FFT_SIZE)
+            );
+        }
+        check_frame(frame);
+        fft_real_q15(frame);
+
+        TEST_CHECK(abs((int)fft_magnitude(frame, bin) - 16000) <= 4);
+        for (size_t other = 0; other < FFT_BINS; other++)
+        {
+            if (other != bin)
+            {
+                TEST_CHECK(fft_magnitude(frame, other) <= 4U);
+            }
+        }
+    }
+
+    /* Magnitude is the integer square root of the power */
+    for (uint32_t i = 0; i < ITERATIONS; i++)
+    {
+        int16_t spectrum[4];
+        for (size_t n = 0; n < 4; n++)
+        {
+            spectrum[n] = (int16_t)test_random(&rng);
+        }
+
+        double re   = spectrum[2];
+        double im   = spectrum[3];
+        double root = fmin(floor(sqrt(re * re + im * im)), UINT16_MAX);
+        TEST_CHECK(fft_magnitude(spectrum, 0) == (uint16_t)abs(spectrum[0]));
+        TEST_CHECK(fft_magnitude(spectrum, 1) == (uint16_t)root);
+    }
+
+    printf(
+        "test_fft: worst error %.2f LSB spectrum, %.2f LSB window\n", worst_spectrum,
+        worst_window
+    );
+    return test_report("test_fft");
+}
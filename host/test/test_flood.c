@@ -0,0 +1,256 @@
+/**
+ * @file test_flood.c
+ * @brief Command latency while junk floods the control port
+ * @details The firmware runs without the acquisition task. A client times
+ * ROUNDS requests, pings and CMD_GET_STATUS in turn, each waiting for its reply,
+ * first on a quiet network and then while JUNK_HOSTS threads flood the control
+ * port with datagrams the receive filter must refuse: random bytes, oversize
+ * datagrams with a valid header, message types the task does not handle and
+ * one valid ping repeated with the same sequence number.
+ *
+ * Under the flood no request may go unanswered and the slowest reply must stay
+ * within MAX_LATENCY_MS, since junk never takes one of the receive buffers.
+ * TELEM_SOCK_RX_REJECTED must count all the junk but the repeated ping, which
+ * each flood host gets through once a REPEAT_WINDOW_MS.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "firmware.h"
+#include "test.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+/** Requests timed in each phase */
+#define ROUNDS 200U
+/** Time between two requests */
+#define ROUND_GAP_MS 5U
+/** Time a reply is waited for before the request counts as lost */
+#define REPLY_TIMEOUT_MS 250U
+/** Slowest reply allowed under the flood */
+#define MAX_LATENCY_MS 50U
+/** Threads flooding the control port, each from an address of its own */
+#define JUNK_HOSTS 3U
+/** Datagrams each flood thread sends before it yields for a tick, few enough
+ * that the host socket in front of the network task never drops one */
+#define JUNK_BURST 20U
+/** REQUEST_REPEAT_WINDOW of task_network.c */
+#define REPEAT_WINDOW_MS 1000U
+/** Length of the oversize datagrams */
+#define JUNK_OVERSIZE 1400U
+
+static atomic_bool  flooding = false;
+static atomic_ulong junk     = 0;
+
+/**
+ * @brief Latencies of one phase
+ */
+typedef struct
+{
+    uint32_t us[ROUNDS]; /**< Reply time of each answered request */
+    uint32_t answered;   /**< Requests answered */
+} phase_t;
+
+/**
+ * @brief Send one junk datagram of the given kind to the control port
+ */
+static void send_junk(int fd, uint32_t kind, uint32_t *rng)
+{
+    uint8_t            packet[JUNK_OVERSIZE];
+    size_t             len    = 0;
+    protocol_header_t  header = {.magic = PROTOCOL_MAGIC};
+    struct sockaddr_in addr   = {
+        .sin_family = AF_INET,
+        .sin_port   = htons(TASK_NETWORK_LOCAL_PORT),
+    };
+
+    (void)inet_pton(AF_INET, FIRMWARE_IP, &addr.sin_addr);
+
+    switch (kind % 4U)
+    {
+        case 0:
+            /* Random bytes */
+            len = 1U + test_random(rng) % sizeof(packet);
+            for (size_t i = 0; i < len; i++)
+            {
+                packet[i] = (uint8_t)test_random(rng);
+            }
+            break;
+
+        case 1:
+            /* A valid ping header on a datagram longer than any request */
+            header.msg_type    = MSG_TYPE_PING;
+            header.sequence    = (uint16_t)test_random(rng);
+            header.payload_len = (uint16_t)(sizeof(packet) - sizeof(header));
+            memset(packet, 0, sizeof(packet));
+            memcpy(packet, &header, sizeof(header));
+            len = sizeof(packet);
+            break;
+
+        case 2:
+            /* A message type the device sends but does not handle */
+            header.msg_type = MSG_TYPE_DATA;
+            header.sequence = (uint16_t)test_random(rng);
+            memcpy(packet, &header, sizeof(header));
+            len = sizeof(header);
+            break;
+
+        default:
+            /* The same ping over and over */
+            header.msg_type = MSG_TYPE_PING;
+            header.sequence = 0xBEEFU;
+            memcpy(packet, &header, sizeof(header));
+            len = sizeof(header);
+            break;
+    }
+
+    if (sendto(fd, packet, len, 0, (const struct sockaddr *)&addr, sizeof(addr)) > 0)
+    {
+        atomic_fetch_add(&junk, 1);
+    }
+}
+
+/**
+ * @brief Flood the control port while flooding is set
+ */
+static void flood(void *argument)
+{
+    static const char *const hosts[JUNK_HOSTS] = {
+        "127.0.0.3", "127.0.0.4", "127.0.0.5"
+    };
+    uintptr_t id   = (uintptr_t)argument;
+    int       fd   = client_open(hosts[id]);
+    uint32_t  rng  = 0x2545F491U + (uint32_t)id;
+    uint32_t  kind = 0;
+
+    while (atomic_load(&flooding))
+    {
+        for (uint32_t i = 0; i < JUNK_BURST; i++)
+        {
+            send_junk(fd, kind++, &rng);
+        }
+        osDelay(1);
+    }
+
+    close(fd);
+}
+
+/**
+ * @brief Time ROUNDS requests, pings and status queries in turn
+ */
+static void time_requests(int fd, phase_t *phase)
+{
+    uint8_t        buffer[1500];
+    const uint8_t *payload;
+
+    phase->answered = 0;
+    for (uint32_t i = 0; i < ROUNDS; i++)
+    {
+        uint64_t start_us = system_time_us();
+        uint8_t  reply    = MSG_TYPE_PONG;
+
+        if (i % 2U == 0U)
+        {
+            client_send(fd, TASK_NETWORK_LOCAL_PORT, MSG_TYPE_PING, NULL, 0);
+        }
+        else
+        {
+            client_command(fd, CMD_GET_STATUS, 0, 0);
+            reply = MSG_TYPE_STATUS;
+        }
+
+        int len = client_expect(
+            fd, reply, buffer, sizeof(buffer), REPLY_TIMEOUT_MS, &payload
+        );
+        if (len >= 0)
+        {
+            phase->us[phase->answered++] = (uint32_t)(system_time_us() - start_us);
+        }
+        osDelay(ROUND_GAP_MS);
+    }
+}
+
+static int compare_us(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Print the median, 99th percentile and slowest reply of a phase
+ * @return Slowest reply in microseconds
+ */
+static uint32_t report(const char *name, phase_t *phase)
+{
+    if (phase->answered == 0U)
+    {
+        printf("test_flood: %s: no replies\n", name);
+        return UINT32_MAX;
+    }
+
+    qsort(phase->us, phase->answered, sizeof(phase->us[0]), compare_us);
+    printf(
+        "test_flood: %s: %u of %u answered, median %u us, p99 %u us, max %u us\n",
+        name, phase->answered, ROUNDS, phase->us[phase->answered / 2U],
+        phase->us[phase->answered * 99U / 100U], phase->us[phase->answered - 1U]
+    );
+
+    return phase->us[phase->answered - 1U];
+}
+
+static void test_body(void *argument)
+{
+    static phase_t quiet;
+    static phase_t loaded;
+    uint32_t       rejected_before = 0;
+    uint32_t       rejected_after  = 0;
+
+    (void)argument;
+
+    TEST_CHECK(firmware_wait_ready());
+    int client = client_open("127.0.0.2");
+
+    time_requests(client, &quiet);
+    TEST_CHECK(quiet.answered == ROUNDS);
+    (void)report("quiet", &quiet);
+    TEST_CHECK(client_telemetry(client, TELEM_SOCK_RX_REJECTED, &rejected_before));
+
+    atomic_store(&flooding, true);
+    for (uintptr_t i = 0; i < JUNK_HOSTS; i++)
+    {
+        TEST_CHECK(osThreadNew(flood, (void *)i, NULL) != NULL);
+    }
+    uint64_t flood_us = system_time_us();
+    osDelay(50);
+
+    time_requests(client, &loaded);
+    atomic_store(&flooding, false);
+    osDelay(50);
+    flood_us = system_time_us() - flood_us;
+
+    TEST_CHECK(loaded.answered == ROUNDS);
+    TEST_CHECK(report("flood", &loaded) <= MAX_LATENCY_MS * 1000U);
+
+    /* The repeated ping gets through once a window from each host, everything
+     * else is refused */
+    uint32_t windows = (uint32_t)(flood_us / 1000U / REPEAT_WINDOW_MS) + 1U;
+    uint32_t passed  = JUNK_HOSTS * windows;
+    TEST_CHECK(client_telemetry(client, TELEM_SOCK_RX_REJECTED, &rejected_after));
+    uint32_t rejected = rejected_after - rejected_before;
+    TEST_CHECK(rejected + passed >= atomic_load(&junk));
+    printf(
+        "test_flood: %lu junk datagrams sent, %u rejected (%u may pass)\n",
+        (unsigned long)atomic_load(&junk), rejected, passed
+    );
+
+    exit(test_report("test_flood"));
+}
+
+int main(void)
+{
+    firmware_boot(false);
+    firmware_run(test_body);
+}
@@ -0,0 +1,170 @@
+/**
+ * @file test_multicast.c
+ * @brief Data published to a multicast group, received by several hosts at once
+ * @details The firmware runs without the acquisition task, so the test thread
+ * plays the data path with network_send_raw(). SIM_NET_MCAST_IF sends its group
+ * datagrams out of the loopback interface, where RECEIVERS sockets join GROUP
+ * as join_group() of the Python client does. One host subscribes with
+ * CMD_START_ACQ to keep the run alive.
+ *
+ * With CONFIG_MCAST_GROUP set, every receiver must get each packet, in order,
+ * while the device sends each packet once and the unicast subscriber gets
+ * none. With the group set back to 0 the stream returns to the subscriber and
+ * the receivers get nothing more.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "firmware.h"
+#include "test.h"
+
+/** Group and port the device publishes to */
+#define GROUP      "239.1.2.3"
+#define GROUP_PORT 5101U
+/** Hosts listening to the group */
+#define RECEIVERS 3U
+/** Packets published, each marked by its sample count */
+#define PACKETS 20U
+/** Time the network task gets to handle a command */
+#define COMMAND_MS 50U
+
+/**
+ * @brief Open a socket that joins GROUP on the loopback interface
+ */
+static int join_group(void)
+{
+    struct sockaddr_in addr = {
+        .sin_family      = AF_INET,
+        .sin_port        = htons(GROUP_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    struct ip_mreq     mreq;
+    int                fd    = socket(AF_INET, SOCK_DGRAM, 0);
+    int                reuse = 1;
+
+    (void)inet_pton(AF_INET, GROUP, &mreq.imr_multiaddr);
+    (void)inet_pton(AF_INET, FIRMWARE_IP, &mreq.imr_interface);
+    (void)setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (fd < 0 || bind(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0)
+    {
+        perror("group socket");
+        exit(1);
+    }
+
+    return fd;
+}
+
+/**
+ * @brief Send one data packet marked by its sample count
+ */
+static void send_marked(uint16_t sample_count)
+{
+    static const uint16_t samples[PACKETS + 1U] = {0};
+    uint8_t               packet[PROTOCOL_MAX_DATA_SIZE];
+    size_t                len;
+
+    TEST_CHECK(
+        protocol_build_data_packet(
+            packet, sizeof(packet), 0, samples, sample_count, 0, system_time_us(), &len
+        ) == PROTO_STATUS_OK
+    );
+    TEST_CHECK(network_send_raw(0, packet, len) == 0);
+}
+
+/**
+ * @brief Receive the data packets waiting on a socket
+ * @param marks Sample count of each packet, in the order received
+ * @return Number of data packets received
+ */
+static size_t receive_marks(int fd, uint16_t *marks, size_t size)
+{
+    uint8_t buffer[1500];
+    size_t  count = 0;
+
+    for (;;)
+    {
+        protocol_header_t header;
+        const uint8_t    *payload;
+        int len = client_recv(fd, buffer, sizeof(buffer), 100U, &header, &payload);
+
+        if (len < 0)
+        {
+            return count;
+        }
+        if (header.msg_type == MSG_TYPE_DATA && len >= 4 && count < size)
+        {
+            marks[count++] = (uint16_t)(payload[2] | (payload[3] << 8));
+        }
+    }
+}
+
+static void test_body(void *argument)
+{
+    int             receivers[RECEIVERS];
+    uint16_t        marks[PACKETS + 1U];
+    network_stats_t before;
+    network_stats_t after;
+    struct in_addr  group;
+
+    (void)argument;
+
+    TEST_CHECK(firmware_wait_ready());
+    for (size_t r = 0; r < RECEIVERS; r++)
+    {
+        receivers[r] = join_group();
+    }
+
+    int subscriber = client_open("127.0.0.2");
+    (void)inet_pton(AF_INET, GROUP, &group);
+    client_configure(subscriber, CONFIG_MCAST_GROUP, ntohl(group.s_addr));
+    client_configure(subscriber, CONFIG_MCAST_PORT, GROUP_PORT);
+    client_command(subscriber, CMD_START_ACQ, 0, 0);
+    osDelay(COMMAND_MS);
+
+    /* Published: every receiver gets every packet from a single send */
+    network_get_stats(&before);
+    for (uint16_t i = 1; i <= PACKETS; i++)
+    {
+        send_marked(i);
+    }
+    network_get_stats(&after);
+    TEST_CHECK(after.packets_sent - before.packets_sent == PACKETS);
+
+    for (size_t r = 0; r < RECEIVERS; r++)
+    {
+        size_t count = receive_marks(receivers[r], marks, PACKETS + 1U);
+        TEST_CHECK(count == PACKETS);
+        for (size_t i = 0; i < count; i++)
+        {
+            TEST_CHECK(marks[i] == i + 1U);
+        }
+    }
+    TEST_CHECK(receive_marks(subscriber, marks, PACKETS + 1U) == 0U);
+
+    /* Group off: back to the subscriber, nothing more for the group */
+    client_configure(subscriber, CONFIG_MCAST_GROUP, 0);
+    osDelay(COMMAND_MS);
+    send_marked(1);
+    TEST_CHECK(receive_marks(subscriber, marks, PACKETS + 1U) == 1U);
+    for (size_t r = 0; r < RECEIVERS; r++)
+    {
+        TEST_CHECK(receive_marks(receivers[r], marks, PACKETS + 1U) == 0U);
+    }
+
+    printf(
+        "test_multicast: %u packets sent once to %s:%u, received by %u hosts\n",
+        PACKETS, GROUP, GROUP_PORT, RECEIVERS
+    );
+
+    client_command(subscriber, CMD_STOP_ACQ, 0, 0);
+    exit(test_report("test_multicast"));
+}
+
+int main(void)
+{
+    setenv("SIM_NET_MCAST_IF", FIRMWARE_IP, 1);
+
+    firmware_boot(false);
+    firmware_run(test_body);
+}
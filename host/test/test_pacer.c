@@ -0,0 +1,212 @@
+/**
+ * @file test_pacer.c
+ * @brief Data path pacing of a burst against a small network pool
+ * @details The firmware runs without the acquisition task, so the test thread
+ * plays the data path and hands a burst of data packets to network_send_raw()
+ * as fast as it returns. The simulated pool holds only a few packets and drains
+ * at a modest link rate.
+ *
+ * With CONFIG_PACE_BYTES_PER_S set, the burst must leave at that rate: the
+ * sends take as long as the rate says, no window of arrivals carries more than
+ * the rate plus the PACER_BURST_MS bucket, and a recorder thread receives every
+ * packet. With the pacer off the same burst is held back by the pool ledger
+ * alone. Either way no send may fail and the pool model must not panic.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "firmware.h"
+#include "pacer.h"
+#include "test.h"
+
+/** Simulated pool and link, a few packets deep and 1 MB/s */
+#define POOL_BYTES "12000"
+#define LINK_BPS   8000000U
+/** Configured stream rate, a fifth of the link */
+#define PACE_BYTES_PER_S 200000U
+/** Packets in each burst */
+#define PACKETS 300U
+/** Samples per packet */
+#define PACKET_SAMPLES 400U
+/** Window the arrival rate is checked over */
+#define WINDOW_US 250000U
+/** Time the last packets get to arrive */
+#define DRAIN_MS 500U
+
+/**
+ * @brief One received data packet
+ */
+typedef struct
+{
+    uint64_t time_us;  /**< Arrival time */
+    uint16_t sequence; /**< Header sequence number */
+    uint16_t len;      /**< Packet length */
+} arrival_t;
+
+static arrival_t         arrivals[PACKETS];
+static volatile uint32_t arrival_count = 0;
+static int               client;
+
+/**
+ * @brief Record data packets as they arrive
+ */
+static void recorder(void *argument)
+{
+    (void)argument;
+
+    uint8_t buffer[1500];
+
+    for (;;)
+    {
+        protocol_header_t header;
+        const uint8_t    *payload;
+        int len = client_recv(client, buffer, sizeof(buffer), 100U, &header, &payload);
+
+        if (len < 0 || header.msg_type != MSG_TYPE_DATA || arrival_count == PACKETS)
+        {
+            continue;
+        }
+
+        arrival_t *arrival = &arrivals[arrival_count];
+        arrival->time_us   = system_time_us();
+        arrival->sequence  = header.sequence;
+        arrival->len       = (uint16_t)(sizeof(header) + (size_t)len);
+        arrival_count      = arrival_count + 1U;
+    }
+}
+
+/**
+ * @brief Send one burst and check it went out whole
+ * @return Microseconds from the first send to the return of the last one
+ */
+static uint64_t send_burst(size_t *packet_len)
+{
+    static uint8_t  packet[PROTOCOL_MAX_DATA_SIZE + 64U];
+    static uint16_t samples[PACKET_SAMPLES];
+    uint32_t        failed = 0;
+
+    arrival_count = 0;
+
+    uint64_t start_us = system_time_us();
+    for (uint32_t i = 0; i < PACKETS; i++)
+    {
+        samples[0] = (uint16_t)i;
+        TEST_CHECK(
+            protocol_build_data_packet(
+                packet, sizeof(packet), 0, samples, PACKET_SAMPLES, 0, system_time_us(),
+                packet_len
+            ) == PROTO_STATUS_OK
+        );
+        failed += (network_send_raw(0, packet, *packet_len) != 0);
+    }
+    uint64_t elapsed_us = system_time_us() - start_us;
+
+    osDelay(DRAIN_MS);
+    TEST_CHECK(failed == 0);
+    TEST_CHECK(arrival_count == PACKETS);
+    for (uint32_t i = 1; i < arrival_count; i++)
+    {
+        TEST_CHECK(arrivals[i].sequence == (uint16_t)(arrivals[i - 1].sequence + 1U));
+    }
+
+    return elapsed_us;
+}
+
+/**
+ * @brief Most bytes that arrived within any WINDOW_US
+ */
+static uint64_t busiest_window(void)
+{
+    uint64_t most  = 0;
+    uint64_t bytes = 0;
+    uint32_t first = 0;
+
+    for (uint32_t i = 0; i < arrival_count; i++)
+    {
+        bytes += arrivals[i].len;
+        while (arrivals[i].time_us - arrivals[first].time_us >= WINDOW_US)
+        {
+            bytes -= arrivals[first++].len;
+        }
+        most = (bytes > most) ? bytes : most;
+    }
+
+    return most;
+}
+
+static void test_body(void *argument)
+{
+    (void)argument;
+
+    static const osThreadAttr_t attr = {
+        .name       = "recorder",
+        .priority   = osPriorityNormal,
+        .stack_size = 8192,
+    };
+    size_t   len;
+    uint32_t value;
+
+    TEST_CHECK(firmware_wait_ready());
+
+    /* Telemetry on a socket of its own, the recorder drains the other */
+    int control = client_open("127.0.0.3");
+
+    client = client_open("127.0.0.2");
+    client_command(client, CMD_START_ACQ, 0, 0);
+    client_configure(control, CONFIG_PACE_BYTES_PER_S, PACE_BYTES_PER_S);
+    osDelay(100);
+    TEST_CHECK(osThreadNew(recorder, NULL, &attr) != NULL);
+
+    /* Paced: the rate, with at most one bucket ahead of it */
+    uint64_t paced_us = send_burst(&len);
+    uint64_t total    = (uint64_t)PACKETS * len;
+    uint64_t bucket   = (uint64_t)PACE_BYTES_PER_S * PACER_BURST_MS / 1000U;
+    uint64_t ideal_us = (total - bucket) * 1000000U / PACE_BYTES_PER_S;
+    uint64_t window   = busiest_window();
+    uint64_t allowed  = PACE_BYTES_PER_S * (uint64_t)WINDOW_US / 1000000U + bucket;
+
+    /* Plus the packet that finds the bucket not quite empty */
+    allowed += len;
+
+    TEST_CHECK(paced_us * 100U >= ideal_us * 95U);
+    TEST_CHECK(paced_us * 100U <= ideal_us * 125U);
+    TEST_CHECK(window <= allowed);
+    TEST_CHECK(client_telemetry(control, TELEM_NET_PACED, &value) && value > 0);
+    printf(
+        "test_pacer: %llu bytes paced in %llu ms (ideal %llu), busiest %u ms "
+        "window %llu bytes (allowed %llu)\n",
+        (unsigned long long)total, (unsigned long long)(paced_us / 1000U),
+        (unsigned long long)(ideal_us / 1000U), WINDOW_US / 1000U,
+        (unsigned long long)window, (unsigned long long)allowed
+    );
+
+    /* Pacer off: only the pool holds the burst back, to about the link rate */
+    client_configure(control, CONFIG_PACE_BYTES_PER_S, 0);
+    osDelay(100);
+    uint64_t pooled_us = send_burst(&len);
+    uint64_t link_us   = total * 8U * 1000000U / LINK_BPS;
+
+    TEST_CHECK(pooled_us < paced_us);
+    TEST_CHECK(pooled_us * 100U >= link_us * 90U);
+    printf(
+        "test_pacer: pool alone sent them in %llu ms (link %llu ms)\n",
+        (unsigned long long)(pooled_us / 1000U), (unsigned long long)(link_us / 1000U)
+    );
+
+    TEST_CHECK(client_telemetry(control, TELEM_NET_ERRORS, &value) && value == 0);
+    client_command(client, CMD_STOP_ACQ, 0, 0);
+
+    exit(test_report("test_pacer"));
+}
+
+int main(void)
+{
+    char link[16];
+
+    (void)snprintf(link, sizeof(link), "%u", LINK_BPS);
+    setenv("SIM_NET_POOL_BYTES", POOL_BYTES, 1);
+    setenv("SIM_NET_LINK_BPS", link, 1);
+
+    firmware_boot(false);
+    firmware_run(test_body);
+}
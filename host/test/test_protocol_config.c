@@ -0,0 +1,295 @@
+/**
+ * @file test_protocol_config.c
+ * @brief Fuzz test of the MSG_TYPE_CONFIG TLV parser
+ * @details Random, well formed and corrupted payloads are fed to
+ * protocol_parse_config() and checked against a plain reference decoder. Every
+ * payload sits in a buffer of exactly its length, so an over-read shows up under
+ * AddressSanitizer or Valgrind.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "protocol.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** Payloads generated per run */
+#define FUZZ_ITERATIONS 200000U
+/** Parameter types the parser knows */
+#define PARAM_TYPES (CONFIG_PACE_PACKETS_PER_S + 1U)
+
+/**
+ * @brief Reference decoder, written for clarity rather than speed
+ */
+static protocol_status_t reference_parse(
+    const uint8_t *payload, size_t len, protocol_config_entry_t *entries,
+    size_t *count
+)
+{
+    bool   seen[PARAM_TYPES] = {false};
+    size_t n                 = 0;
+    size_t pos               = 0;
+
+    *count = 0;
+    while (pos < len)
+    {
+        if (len - pos < PROTOCOL_CONFIG_TLV_HEADER_SIZE)
+        {
+            return PROTO_STATUS_INVALID_MSG;
+        }
+
+        uint8_t type  = payload[pos];
+        uint8_t width = payload[pos + 1];
+        pos += PROTOCOL_CONFIG_TLV_HEADER_SIZE;
+
+        if (width < 1 || width > 4 || width > len - pos || type >= PARAM_TYPES ||
+            seen[type])
+        {
+            return PROTO_STATUS_INVALID_MSG;
+        }
+        if (n == PROTOCOL_MAX_CONFIG_ENTRIES)
+        {
+            return PROTO_STATUS_BUFFER_TOO_SMALL;
+        }
+
+        uint32_t value = 0;
+        for (uint8_t i = width; i > 0; i--)
+        {
+            value = (value << 8) | payload[pos + i - 1U];
+        }
+        pos += width;
+
+        if (!protocol_config_value_valid(type, value))
+        {
+            return PROTO_STATUS_INVALID_MSG;
+        }
+
+        seen[type]            = true;
+        entries[n].param_type = type;
+        entries[n].value      = value;
+        n++;
+    }
+
+    *count = n;
+    return PROTO_STATUS_OK;
+}
+
+/**
+ * @brief Parse into a full-size entry array
+ */
+static protocol_status_t parse(
+    const uint8_t *payload, size_t len, protocol_config_entry_t *entries, size_t *count
+)
+{
+    return protocol_parse_config(
+        payload, len, entries, PROTOCOL_MAX_CONFIG_ENTRIES, count
+    );
+}
+
+/**
+ * @brief Parse a payload from an exactly sized copy and compare with the reference
+ */
+static void check_payload(const uint8_t *payload, size_t len)
+{
+    protocol_config_entry_t entries[PROTOCOL_MAX_CONFIG_ENTRIES];
+    protocol_config_entry_t expected[PROTOCOL_MAX_CONFIG_ENTRIES];
+    size_t                  count          = 99;
+    size_t                  expected_count = 0;
+
+    uint8_t *copy = malloc((len != 0U) ? len : 1U);
+    if (copy == NULL)
+    {
+        abort();
+    }
+    memcpy(copy, payload, len);
+
+    protocol_status_t status = parse(copy, len, entries, &count);
+    protocol_status_t reference =
+        reference_parse(payload, len, expected, &expected_count);
+    free(copy);
+
+    TEST_CHECK(status == reference);
+    TEST_CHECK(count == expected_count);
+    if (status != PROTO_STATUS_OK)
+    {
+        /* All-or-nothing: a rejected payload reports no entries */
+        TEST_CHECK(count == 0U);
+        return;
+    }
+
+    for (size_t i = 0; i < count && i < expected_count; i++)
+    {
+        TEST_CHECK(entries[i].param_type == expected[i].param_type);
+        TEST_CHECK(entries[i].value == expected[i].value);
+    }
+}
+
+/**
+ * @brief Append one TLV entry, widths above 4 are padded with zeros
+ * @return New payload length
+ */
+static size_t
+put_entry(uint8_t *payload, size_t len, uint8_t type, uint8_t width, uint32_t value)
+{
+    payload[len++] = type;
+    payload[len++] = width;
+    for (uint8_t i = 0; i < width; i++)
+    {
+        payload[len++] = (i < 4U) ? (uint8_t)(value >> (8U * i)) : 0U;
+    }
+    return len;
+}
+
+/**
+ * @brief Build a payload of distinct parameters, mostly with accepted values
+ * @return Payload length
+ */
+static size_t build_packet(uint8_t *payload, uint32_t *rng)
+{
+    uint8_t types[PARAM_TYPES];
+    size_t  len     = 0;
+    size_t  entries = 1U + test_random(rng) % PROTOCOL_MAX_CONFIG_ENTRIES;
+
+    for (uint8_t i = 0; i < PARAM_TYPES; i++)
+    {
+        types[i] = i;
+    }
+    for (size_t i = 0; i < entries; i++)
+    {
+        size_t  pick = i + test_random(rng) % (PARAM_TYPES - i);
+        uint8_t type = types[pick];
+        types[pick]  = types[i];
+        types[i]     = type;
+
+        uint8_t  width = (uint8_t)(1U + test_random(rng) % 4U);
+        uint32_t value = test_random(rng) % 3U;
+        if (test_random(rng) % 4U == 0U)
+        {
+            value = test_random(rng);
+        }
+        if (type == CONFIG_MCAST_GROUP && test_random(rng) % 2U == 0U)
+        {
+            value = 0xEF000001U;
+        }
+        if (width < 4U && (value >> (8U * width)) != 0U)
+        {
+            width = 4;
+        }
+        len = put_entry(payload, len, type, width, value);
+    }
+
+    return len;
+}
+
+/**
+ * @brief Known payloads and their verdicts
+ */
+static void test_vectors(void)
+{
+    uint8_t                 payload[PROTOCOL_MAX_REQUEST_SIZE + 8] = {0};
+    protocol_config_entry_t entries[PROTOCOL_MAX_CONFIG_ENTRIES];
+    size_t                  count;
+    size_t                  len;
+
+    /* Empty payload: nothing to apply */
+    TEST_CHECK(parse(payload, 0, entries, &count) == PROTO_STATUS_OK);
+    TEST_CHECK(count == 0U);
+
+    /* Mixed value widths, little-endian */
+    len = put_entry(payload, 0, CONFIG_THRESHOLD_MV, 2, 1650);
+    len = put_entry(payload, len, CONFIG_CHANNEL, 1, 3);
+    len = put_entry(payload, len, CONFIG_MCAST_GROUP, 4, 0xEF010203U);
+    TEST_CHECK(parse(payload, len, entries, &count) == PROTO_STATUS_OK);
+    TEST_CHECK(count == 3U);
+    TEST_CHECK(entries[0].param_type == CONFIG_THRESHOLD_MV);
+    TEST_CHECK(entries[0].value == 1650U);
+    TEST_CHECK(entries[1].param_type == CONFIG_CHANNEL);
+    TEST_CHECK(entries[1].value == 3U);
+    TEST_CHECK(entries[2].value == 0xEF010203U);
+
+    /* One bad entry rejects the packet: range, multicast group, duplicate */
+    static const uint32_t bad[][2] = {
+        {CONFIG_CHANNEL, 8},
+        {CONFIG_MCAST_GROUP, 0xC0A80001U},
+        {CONFIG_MCAST_PORT, 0},
+        {CONFIG_THRESHOLD_MV, 1000},
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+    {
+        len   = put_entry(payload, 0, CONFIG_THRESHOLD_MV, 2, 1000);
+        len   = put_entry(payload, len, (uint8_t)bad[i][0], 4, bad[i][1]);
+        count = 99;
+        TEST_CHECK(parse(payload, len, entries, &count) == PROTO_STATUS_INVALID_MSG);
+        TEST_CHECK(count == 0U);
+    }
+
+    /* Truncated header and value, zero and oversized widths */
+    len          = put_entry(payload, 0, CONFIG_CHANNEL, 1, 1);
+    payload[len] = CONFIG_BATCH_SIZE;
+    TEST_CHECK(parse(payload, len + 1U, entries, &count) == PROTO_STATUS_INVALID_MSG);
+    len = put_entry(payload, 0, CONFIG_BATCH_SIZE, 2, 100);
+    TEST_CHECK(parse(payload, len - 1U, entries, &count) == PROTO_STATUS_INVALID_MSG);
+    len = put_entry(payload, 0, CONFIG_CHANNEL, 0, 0);
+    TEST_CHECK(parse(payload, len, entries, &count) == PROTO_STATUS_INVALID_MSG);
+    len = put_entry(payload, 0, CONFIG_CHANNEL, 5, 1);
+    TEST_CHECK(parse(payload, len, entries, &count) == PROTO_STATUS_INVALID_MSG);
+
+    /* One entry more than a packet may carry */
+    len = 0;
+    for (uint8_t type = 0; type <= PROTOCOL_MAX_CONFIG_ENTRIES + 1U; type++)
+    {
+        if (type != CONFIG_MCAST_GROUP)
+        {
+            len = put_entry(payload, len, type, 1, 1);
+        }
+    }
+    TEST_CHECK(parse(payload, len, entries, &count) == PROTO_STATUS_BUFFER_TOO_SMALL);
+    TEST_CHECK(count == 0U);
+}
+
+int main(void)
+{
+    uint8_t  payload[PROTOCOL_MAX_REQUEST_SIZE + 8];
+    uint32_t rng = 0x2545F491U;
+
+    test_vectors();
+
+    for (uint32_t i = 0; i < FUZZ_ITERATIONS; i++)
+    {
+        size_t len;
+
+        switch (i % 3U)
+        {
+        case 0:
+            /* Random bytes */
+            len = test_random(&rng) % (PROTOCOL_MAX_REQUEST_SIZE + 1U);
+            for (size_t k = 0; k < len; k++)
+            {
+                payload[k] = (uint8_t)test_random(&rng);
+            }
+            break;
+        case 1:
+            /* Well formed */
+            len = build_packet(payload, &rng);
+            break;
+        default:
+            /* Well formed, then corrupted or cut short */
+            len = build_packet(payload, &rng);
+            for (uint32_t k = test_random(&rng) % 3U; k > 0; k--)
+            {
+                payload[test_random(&rng) % len] = (uint8_t)test_random(&rng);
+            }
+            if (test_random(&rng) % 2U == 0U)
+            {
+                len = test_random(&rng) % (len + 1U);
+            }
+            break;
+        }
+
+        check_payload(payload, len);
+    }
+
+    return test_report("test_protocol_config");
+}
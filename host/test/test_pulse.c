@@ -0,0 +1,176 @@
+/**
+ * @file test_pulse.c
+ * @brief Check of the threshold pulse detector on hand-made signals
+ * @details Each case feeds a short signal whose pulses are known by
+ * construction and compares every reported pulse field by field, including the
+ * sample that ends it. Covered are a plain pulse, a sample exactly at the
+ * threshold, the dead time after a pulse, a signal already above the threshold
+ * at start and the saturation of width and area.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "pulse.h"
+#include "test.h"
+
+#include <stddef.h>
+
+/** Time between two samples of a signal, in us */
+#define SAMPLE_US 10U
+/** Time of the first sample, so that start 0 is never a valid answer */
+#define START_US 1000000U
+/** Most pulses a case reports */
+#define MAX_PULSES 8U
+
+/**
+ * @brief Pulse as reported, with the index of the sample that ended it
+ */
+typedef struct
+{
+    pulse_t pulse; /**< Reported pulse */
+    size_t  end;   /**< Index of the sample below threshold that ended it */
+} report_t;
+
+static uint64_t sample_time(size_t n)
+{
+    return START_US + (uint64_t)n * SAMPLE_US;
+}
+
+/**
+ * @brief Run a signal through a fresh detector
+ * @return Number of pulses reported
+ */
+static size_t run(
+    const uint16_t *signal, size_t len, uint16_t threshold, uint16_t dead_time,
+    report_t *reports
+)
+{
+    pulse_detector_t det;
+    size_t           count = 0;
+
+    pulse_detector_init(&det, threshold, dead_time);
+    for (size_t n = 0; n < len; n++)
+    {
+        pulse_t pulse;
+
+        if (pulse_detector_process(&det, signal[n], sample_time(n), &pulse))
+        {
+            TEST_CHECK(count < MAX_PULSES);
+            if (count < MAX_PULSES)
+            {
+                reports[count].pulse = pulse;
+                reports[count].end   = n;
+            }
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static void check_pulse(
+    const report_t *report, size_t start, uint16_t peak, uint16_t width,
+    uint32_t area
+)
+{
+    TEST_CHECK(report->pulse.start_us == sample_time(start));
+    TEST_CHECK(report->pulse.peak == peak);
+    TEST_CHECK(report->pulse.width == width);
+    TEST_CHECK(report->pulse.area == area);
+    TEST_CHECK(report->end == start + width);
+}
+
+/**
+ * @brief One pulse, reported on the first sample below threshold
+ */
+static void test_single(void)
+{
+    static const uint16_t signal[] = {500, 999, 1200, 1500, 1100, 900, 1000};
+    report_t              reports[MAX_PULSES];
+
+    TEST_CHECK(run(signal, sizeof(signal) / sizeof(signal[0]), 1000, 0, reports) == 1);
+    check_pulse(&reports[0], 2, 1500, 3, 200 + 500 + 100);
+}
+
+/**
+ * @brief A sample at the threshold is above it and adds nothing to the area
+ */
+static void test_at_threshold(void)
+{
+    static const uint16_t signal[] = {0, 1000, 1000, 1300, 0, 1000, 0};
+    report_t              reports[MAX_PULSES];
+
+    TEST_CHECK(run(signal, sizeof(signal) / sizeof(signal[0]), 1000, 0, reports) == 2);
+    check_pulse(&reports[0], 1, 1300, 3, 300);
+    check_pulse(&reports[1], 5, 1000, 1, 0);
+}
+
+/**
+ * @brief Samples in the dead time are ignored, and the signal must then fall
+ * below the threshold before the next pulse
+ */
+static void test_dead_time(void)
+{
+    /* Pulse at 1 ends at 2; 3..5 are dead; 6 is above but not armed; 7 arms */
+    static const uint16_t signal[] = {0, 200, 0, 300, 300, 0, 250, 0, 220, 240, 0};
+    report_t              reports[MAX_PULSES];
+
+    TEST_CHECK(run(signal, sizeof(signal) / sizeof(signal[0]), 100, 3, reports) == 2);
+    check_pulse(&reports[0], 1, 200, 1, 100);
+    check_pulse(&reports[1], 8, 240, 2, 120 + 140);
+
+    /* Without dead time every excursion is a pulse */
+    TEST_CHECK(run(signal, sizeof(signal) / sizeof(signal[0]), 100, 0, reports) == 4);
+    check_pulse(&reports[1], 3, 300, 2, 400);
+    check_pulse(&reports[2], 6, 250, 1, 150);
+}
+
+/**
+ * @brief A signal above the threshold at start is not a truncated pulse
+ */
+static void test_start_above(void)
+{
+    static const uint16_t signal[] = {3000, 3500, 2000, 500, 1800, 0};
+    report_t              reports[MAX_PULSES];
+
+    TEST_CHECK(run(signal, sizeof(signal) / sizeof(signal[0]), 1000, 0, reports) == 1);
+    check_pulse(&reports[0], 4, 1800, 1, 800);
+
+    /* Nothing at all while the signal never falls below */
+    TEST_CHECK(run(signal, 3, 1000, 0, reports) == 0);
+}
+
+/**
+ * @brief Width saturates at UINT16_MAX and area at UINT32_MAX
+ */
+static void test_saturation(void)
+{
+    pulse_detector_t det;
+    pulse_t          pulse;
+    const uint32_t   long_pulse = 1100000U; /* 4095 * this exceeds UINT32_MAX */
+    bool             ended      = false;
+
+    pulse_detector_init(&det, 1, 0);
+    TEST_CHECK(!pulse_detector_process(&det, 0, sample_time(0), &pulse));
+    for (uint32_t n = 1; n <= long_pulse; n++)
+    {
+        ended |= pulse_detector_process(&det, 4096, sample_time(n), &pulse);
+    }
+    TEST_CHECK(!ended);
+    TEST_CHECK(pulse_detector_process(&det, 0, sample_time(long_pulse + 1U), &pulse));
+    TEST_CHECK(pulse.start_us == sample_time(1));
+    TEST_CHECK(pulse.width == UINT16_MAX);
+    TEST_CHECK(pulse.area == UINT32_MAX);
+    TEST_CHECK(pulse.peak == 4096);
+}
+
+int main(void)
+{
+    test_single();
+    test_at_threshold();
+    test_dead_time();
+    test_start_above();
+    test_saturation();
+
+    return test_report("test_pulse");
+}
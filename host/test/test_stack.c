@@ -0,0 +1,93 @@
+/**
+ * @file test_stack.c
+ * @brief Stack watermark of the firmware tasks on their deepest paths
+ * @details The whole firmware runs with every subscriber slot taken, CRC on,
+ * the pacer and a small pool holding the stream back and a flapping link, so
+ * the acquisition task goes through network_send_raw(), stream(), the backlog
+ * replay and publish() while it also builds packets in every acquisition mode.
+ * Afterwards TELEM_STACK_ACQUISITION, from the painted stack of the host
+ * kernel, must leave STACK_SPARE bytes of TASK_ACQUISITION_STACK_SIZE unused.
+ *
+ * The host figure counts the sendmmsg() arrays of udp_socket_posix.c, about
+ * 1.7 KB the target does not have, and leaves out RL-NET and the formatting of
+ * log messages, which the target does. The network task is not checked: on the
+ * host its deepest use is getifaddrs() and the receiver threads of the socket
+ * layer, neither of which runs on the target.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "firmware.h"
+#include "session.h"
+#include "test.h"
+
+/** Stack that must stay unused: exception frame, RTX context and some slack */
+#define STACK_SPARE 256U
+/** Time spent in each acquisition mode */
+#define MODE_MS 600U
+
+static void test_body(void *argument)
+{
+    (void)argument;
+
+    static const char *const hosts[SESSION_MAX_SUBSCRIBERS] = {
+        "127.0.0.2", "127.0.0.3", "127.0.0.4", "127.0.0.5"
+    };
+    int clients[SESSION_MAX_SUBSCRIBERS];
+
+    TEST_CHECK(firmware_wait_ready());
+
+    for (size_t i = 0; i < SESSION_MAX_SUBSCRIBERS; i++)
+    {
+        clients[i] = client_open(hosts[i]);
+        client_command(clients[i], CMD_START_ACQ, 0, 0);
+    }
+
+    int control = clients[0];
+    client_configure(control, CONFIG_THRESHOLD_MV, 0);
+    client_configure(control, CONFIG_DATA_CRC, 1);
+    client_configure(control, CONFIG_PACE_BYTES_PER_S, 100000);
+    client_configure(control, CONFIG_SAMPLE_RATE_HZ, ADC_MAX_SAMPLE_RATE_HZ);
+
+    static const uint8_t modes[] = {
+        ACQ_MODE_RAW, ACQ_MODE_SUMMARY, ACQ_MODE_SPECTRUM, ACQ_MODE_EVENT
+    };
+    for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++)
+    {
+        client_configure(control, CONFIG_ACQ_MODE, modes[i]);
+        client_configure(control, CONFIG_DECIMATION, 1U + 3U * (i % 2U));
+        osDelay(MODE_MS);
+    }
+
+    /* The stream went through the fan-out, the pacer and the backlog */
+    uint32_t value = 0;
+    TEST_CHECK(client_telemetry(control, TELEM_NET_SUBSCRIBERS, &value));
+    TEST_CHECK(value == SESSION_MAX_SUBSCRIBERS);
+    TEST_CHECK(client_telemetry(control, TELEM_NET_PACED, &value) && value > 0);
+    TEST_CHECK(client_telemetry(control, TELEM_NET_HELD, &value) && value > 0);
+
+    uint32_t unused = 0;
+    TEST_CHECK(client_telemetry(control, TELEM_STACK_ACQUISITION, &unused));
+    TEST_CHECK(unused >= STACK_SPARE);
+    printf(
+        "test_stack: acquisition uses %u of %u bytes\n",
+        TASK_ACQUISITION_STACK_SIZE - unused, TASK_ACQUISITION_STACK_SIZE
+    );
+
+    for (size_t i = 0; i < SESSION_MAX_SUBSCRIBERS; i++)
+    {
+        client_command(clients[i], CMD_STOP_ACQ, 0, 0);
+    }
+
+    exit(test_report("test_stack"));
+}
+
+int main(void)
+{
+    setenv("SIM_NET_POOL_BYTES", "12000", 1);
+    setenv("SIM_NET_LINK_BPS", "8000000", 1);
+    setenv("SIM_NET_FLAP", "200,50", 1);
+
+    firmware_boot(true);
+    firmware_run(test_body);
+}
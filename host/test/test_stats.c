@@ -0,0 +1,158 @@
+/**
+ * @file test_stats.c
+ * @brief Stress test of the seqlock counter snapshots
+ * @details Writer threads update their own counter blocks, each as a run of
+ * fields that must always agree, while reader threads take snapshots with
+ * stats_read() the way network_get_stats() does. A torn snapshot shows up as
+ * fields that disagree, a lost increment as a final sum short of the writes.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "stats.h"
+#include "test.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** Writer threads, one counter block each */
+#define WRITERS 3
+/** Reader threads */
+#define READERS 2
+/** Updates per writer */
+#define UPDATES 10000U
+/** Busy loop iterations of a writer between updates */
+#define WRITER_IDLE 20000U
+/** Fields per block, enough for a preemption to land inside a copy */
+#define FIELDS 1024
+
+/**
+ * @brief Counters of one writer, consistent outside an update
+ */
+typedef struct
+{
+    uint32_t count[FIELDS]; /**< Updates so far, in every field */
+    uint64_t bytes;         /**< 1000 per update, wider than a word */
+} counters_t;
+
+/**
+ * @brief Counters guarded by their sequence counter, as in task_network.c
+ */
+typedef struct
+{
+    stats_seq_t seq;      /**< Snapshot sequence counter */
+    counters_t  counters; /**< Counters */
+} counter_block_t;
+
+static counter_block_t blocks[WRITERS];
+static atomic_int      writers_done = 0;
+static atomic_ulong    torn         = 0;
+static atomic_ulong    backwards    = 0;
+static atomic_ulong    snapshots    = 0;
+
+static void *writer(void *argument)
+{
+    counter_block_t *block = argument;
+
+    for (uint32_t i = 0; i < UPDATES; i++)
+    {
+        stats_write_begin(&block->seq);
+        for (size_t k = 0; k < FIELDS; k++)
+        {
+            block->counters.count[k]++;
+        }
+        block->counters.bytes += 1000U;
+        stats_write_end(&block->seq);
+
+        /* Work between updates, so readers also find the block idle */
+        for (volatile uint32_t spin = 0; spin < WRITER_IDLE; spin++)
+        {
+        }
+    }
+
+    atomic_fetch_add(&writers_done, 1);
+    return NULL;
+}
+
+static void *reader(void *argument)
+{
+    uint64_t last_sum = 0;
+
+    (void)argument;
+    while (atomic_load(&writers_done) < WRITERS)
+    {
+        uint64_t sum = 0;
+
+        for (size_t w = 0; w < WRITERS; w++)
+        {
+            counter_block_t *block = &blocks[w];
+            counters_t       snapshot;
+
+            stats_read(&block->seq, &snapshot, &block->counters, sizeof(snapshot));
+
+            bool consistent = snapshot.bytes == snapshot.count[0] * 1000ULL;
+            for (size_t k = 1; k < FIELDS; k++)
+            {
+                consistent = consistent && snapshot.count[k] == snapshot.count[0];
+            }
+            if (!consistent)
+            {
+                atomic_fetch_add(&torn, 1);
+            }
+            sum += snapshot.count[0];
+        }
+
+        /* Per-writer blocks summed by the reader never go backwards */
+        if (sum < last_sum)
+        {
+            atomic_fetch_add(&backwards, 1);
+        }
+        last_sum = sum;
+        atomic_fetch_add(&snapshots, 1);
+    }
+
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t writers[WRITERS];
+    pthread_t readers[READERS];
+
+    for (size_t i = 0; i < READERS; i++)
+    {
+        TEST_CHECK(pthread_create(&readers[i], NULL, reader, NULL) == 0);
+    }
+    for (size_t i = 0; i < WRITERS; i++)
+    {
+        TEST_CHECK(pthread_create(&writers[i], NULL, writer, &blocks[i]) == 0);
+    }
+    for (size_t i = 0; i < WRITERS; i++)
+    {
+        pthread_join(writers[i], NULL);
+    }
+    for (size_t i = 0; i < READERS; i++)
+    {
+        pthread_join(readers[i], NULL);
+    }
+
+    uint64_t total = 0;
+    for (size_t w = 0; w < WRITERS; w++)
+    {
+        TEST_CHECK(blocks[w].seq.sequence == 2U * UPDATES);
+        total += blocks[w].counters.count[0];
+    }
+
+    TEST_CHECK(total == (uint64_t)WRITERS * UPDATES);
+    TEST_CHECK(atomic_load(&torn) == 0U);
+    TEST_CHECK(atomic_load(&backwards) == 0U);
+    TEST_CHECK(atomic_load(&snapshots) > 0U);
+
+    printf(
+        "test_stats: %lu snapshots, %lu torn\n", (unsigned long)atomic_load(&snapshots),
+        (unsigned long)atomic_load(&torn)
+    );
+    return test_report("test_stats");
+}
@@ -0,0 +1,207 @@
+/**
+ * @file test_summary.c
+ * @brief Check of the window summary against a double precision reference
+ * @details The reference takes the mean and the root of the mean square of the
+ * same samples in double precision, which is exact for the sums involved, so
+ * the only difference left is the rounding of the firmware: half an LSB of the
+ * fixed point mean and less than one LSB of the RMS, i.e. the 1/16 of a count
+ * the protocol documentation promises for PROTOCOL_SUMMARY_FRAC_BITS.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "protocol.h"
+#include "summary.h"
+#include "test.h"
+
+#include <math.h>
+
+/** Random windows compared */
+#define WINDOWS 2000U
+/** Largest window, the sample count is 16 bits */
+#define MAX_WINDOW 65535U
+/** Random values given to summary_isqrt() */
+#define ROOTS 1000000U
+/** Time of the first sample of each window */
+#define START_US 123456789ULL
+
+/** Worst errors seen in LSB, printed with the verdict */
+static double worst_mean = 0.0;
+static double worst_rms  = 0.0;
+
+static uint16_t samples[MAX_WINDOW];
+
+/**
+ * @brief Summarize samples and compare with the reference
+ */
+static void check_window(const uint16_t *window, uint32_t count, unsigned frac_bits)
+{
+    summary_acc_t acc;
+    summary_t     result;
+    double        sum    = 0.0;
+    double        sum_sq = 0.0;
+    uint16_t      min    = UINT16_MAX;
+    uint16_t      max    = 0;
+
+    summary_reset(&acc);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        /* Only the first sample's time is kept */
+        summary_add(&acc, window[i], START_US + i);
+
+        sum += window[i];
+        sum_sq += (double)window[i] * window[i];
+        min = (window[i] < min) ? window[i] : min;
+        max = (window[i] > max) ? window[i] : max;
+    }
+    summary_finish(&acc, frac_bits, &result);
+
+    TEST_CHECK(result.count == count);
+    TEST_CHECK(result.min == min);
+    TEST_CHECK(result.max == max);
+    TEST_CHECK(result.start_us == START_US);
+
+    double scale = (double)(1U << frac_bits);
+    double mean  = sum / count * scale;
+    double rms   = sqrt(sum_sq / count) * scale;
+
+    double mean_error = fabs(result.mean - mean);
+    double rms_error  = fabs(result.rms - rms);
+    worst_mean        = fmax(worst_mean, mean_error);
+    worst_rms         = fmax(worst_rms, rms_error);
+    TEST_CHECK(mean_error <= 0.5);
+    TEST_CHECK(rms_error < 1.0);
+}
+
+/**
+ * @brief Windows of random length and content, including the longest
+ */
+static void test_random_windows(void)
+{
+    uint32_t rng = 0x3C6EF372U;
+
+    for (uint32_t w = 0; w < WINDOWS; w++)
+    {
+        uint32_t count = (w == 0) ? MAX_WINDOW : 1U + test_random(&rng) % MAX_WINDOW;
+        uint16_t base  = (uint16_t)(test_random(&rng) % 4096U);
+        uint16_t span  = (uint16_t)(1U + test_random(&rng) % 4096U);
+
+        /* A narrow span around a random level as well as full-scale noise */
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t sample = base + test_random(&rng) % span;
+            samples[i]      = (uint16_t)(sample > 4095U ? 4095U : sample);
+        }
+        check_window(samples, count, PROTOCOL_SUMMARY_FRAC_BITS);
+        check_window(samples, count, w % (SUMMARY_MAX_FRAC_BITS + 1U));
+    }
+}
+
+/**
+ * @brief Constant windows come out exact, up to the rails
+ */
+static void test_constant(void)
+{
+    static const uint16_t levels[] = {0, 1, 2, 1000, 2048, 4094, 4095};
+
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++)
+    {
+        summary_acc_t acc;
+        summary_t     result;
+
+        summary_reset(&acc);
+        for (uint32_t n = 0; n < MAX_WINDOW; n++)
+        {
+            summary_add(&acc, levels[i], START_US);
+        }
+        summary_finish(&acc, SUMMARY_MAX_FRAC_BITS, &result);
+
+        TEST_CHECK(result.mean == (uint16_t)(levels[i] << SUMMARY_MAX_FRAC_BITS));
+        TEST_CHECK(result.rms == (uint16_t)(levels[i] << SUMMARY_MAX_FRAC_BITS));
+        TEST_CHECK(result.min == levels[i] && result.max == levels[i]);
+    }
+
+    /* A reset window starts over, including its start time */
+    summary_acc_t acc;
+    summary_t     result;
+
+    summary_reset(&acc);
+    summary_add(&acc, 4095, 1);
+    summary_reset(&acc);
+    summary_add(&acc, 7, 2);
+    summary_finish(&acc, 0, &result);
+    TEST_CHECK(result.count == 1 && result.min == 7 && result.max == 7);
+    TEST_CHECK(result.mean == 7 && result.rms == 7 && result.start_us == 2);
+}
+
+/**
+ * @brief root * root <= value < (root + 1) * (root + 1)
+ */
+static void check_root(uint64_t value)
+{
+    uint64_t root = summary_isqrt(value);
+    bool     ok   = root * root <= value;
+
+    /* (root + 1)^2 overflows only for the root of UINT64_MAX */
+    if (root < UINT32_MAX)
+    {
+        ok &= (root + 1U) * (root + 1U) > value;
+    }
+    else
+    {
+        ok &= root == UINT32_MAX;
+    }
+
+    TEST_CHECK(ok);
+    if (!ok)
+    {
+        fprintf(
+            stderr, "isqrt(%llu) = %llu\n", (unsigned long long)value,
+            (unsigned long long)root
+        );
+    }
+}
+
+static void test_isqrt(void)
+{
+    uint32_t rng = 0xA54FF53AU;
+
+    for (uint64_t value = 0; value < 70000U; value++)
+    {
+        check_root(value);
+    }
+
+    /* Squares and their neighbours across the whole range */
+    for (unsigned bits = 1; bits <= 32U; bits++)
+    {
+        uint64_t root = (bits == 32U) ? UINT32_MAX : (1ULL << bits) - 1U;
+        for (uint64_t r = root - 1U; r <= root + 1U && r <= UINT32_MAX; r++)
+        {
+            check_root(r * r - 1U);
+            check_root(r * r);
+            check_root(r * r + 1U);
+        }
+    }
+    check_root(UINT64_MAX);
+
+    for (uint32_t i = 0; i < ROOTS; i++)
+    {
+        uint64_t value = ((uint64_t)test_random(&rng) << 32) | test_random(&rng);
+
+        /* Spread the values over every magnitude */
+        check_root(value >> (i % 64U));
+    }
+}
+
+int main(void)
+{
+    test_random_windows();
+    test_constant();
+    test_isqrt();
+
+    printf(
+        "test_summary: worst mean error %.3f LSB, worst RMS error %.3f LSB\n",
+        worst_mean, worst_rms
+    );
+    return test_report("test_summary");
+}
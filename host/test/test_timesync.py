@@ -0,0 +1,156 @@
+"""Check of the clock estimator against a simulated drifting device clock.
+
+The device clock runs DRIFT_PPM fast and starts at an arbitrary offset from the
+epoch-based host clock. Each exchange takes a fixed path delay plus random
+queueing, independent in each direction, and the device times are whole
+microseconds as on the wire. Since the truth is known, the estimate is judged by
+its residual: the error of ClockSync.to_host() on device timestamps around the
+latest exchange, and of the drift it reports.
+
+Run from the repository root with the package on the path, as make host-test
+does:
+
+    PYTHONPATH=. python3 host/test/test_timesync.py
+"""
+
+from __future__ import annotations
+
+import random
+import unittest
+
+from data_acquisition.timesync import ClockSync, SyncSample
+
+HOST_START = 1.7e9
+"""Host time of the first exchange, epoch-based like time.time()."""
+
+DEVICE_START_US = 123_456_789
+"""Device time at HOST_START, in microseconds since its boot."""
+
+DRIFT_PPM = 47.0
+"""Rate error of the device clock."""
+
+PATH_DELAY = 150e-6
+"""One-way delay of an idle link, in seconds."""
+
+QUEUE_MEAN = 100e-6
+"""Mean of the exponential queueing delay added in each direction, in seconds."""
+
+CONGESTION = 20e-3
+"""Delay added to the response of every CONGESTED_EVERY-th exchange."""
+
+CONGESTED_EVERY = 7
+"""Period of the congested exchanges, whose delay is all in one direction."""
+
+PROCESSING = 80e-6
+"""Time the device takes to answer, in seconds."""
+
+INTERVAL = 1.0
+"""Time between exchanges, as the client resyncs while receiving."""
+
+EXCHANGES = 600
+"""Exchanges per run, ten times the default window."""
+
+MAX_RESIDUAL = 100e-6
+"""Largest error of a converted timestamp once the window is full, in seconds."""
+
+MAX_DRIFT_ERROR_PPM = 2.5
+"""Largest error of the reported drift once the window is full."""
+
+
+def device_us(host: float) -> int:
+    """Device clock reading at a host time.
+
+    Args:
+        host (float): Host time in seconds
+
+    Returns:
+        int: Device time in whole microseconds
+    """
+    return DEVICE_START_US + int((host - HOST_START) * (1 + DRIFT_PPM * 1e-6) * 1e6)
+
+
+def exchange(host_t1: float, rng: random.Random, congested: bool = False) -> SyncSample:
+    """Simulate one two-way exchange starting at host_t1.
+
+    Args:
+        host_t1 (float): Host send time in seconds
+        rng (random.Random): Source of the queueing delays
+        congested (bool): Hold the response back by CONGESTION
+
+    Returns:
+        SyncSample: The exchange as the client records it
+    """
+    arrival = host_t1 + PATH_DELAY + rng.expovariate(1 / QUEUE_MEAN)
+    departure = arrival + PROCESSING
+    host_t4 = departure + PATH_DELAY + rng.expovariate(1 / QUEUE_MEAN)
+    if congested:
+        host_t4 += CONGESTION
+    return SyncSample(host_t1, device_us(arrival), device_us(departure), host_t4)
+
+
+class ClockSyncTest(unittest.TestCase):
+    """ClockSync on the simulated clock."""
+
+    def residual(self, sync: ClockSync, host: float) -> float:
+        """Error of the conversion of the device time at a host time.
+
+        Args:
+            sync (ClockSync): Estimator under test
+            host (float): Host time in seconds
+
+        Returns:
+            float: Absolute error in seconds
+        """
+        return abs(sync.to_host(device_us(host)) - host)
+
+    def test_drifting_clock(self) -> None:
+        """Offset and drift follow the device clock through queueing noise.
+
+        The congested exchanges would each move the offset by CONGESTION / 2
+        if they were used; the residual shows they are not.
+        """
+        rng = random.Random(0x5EED)
+        sync = ClockSync()
+        worst = 0.0
+
+        for n in range(EXCHANGES):
+            host_t1 = HOST_START + n * INTERVAL
+            sync.add(exchange(host_t1, rng, n % CONGESTED_EVERY == 0))
+            if n + 1 < sync.window:
+                continue
+
+            # The timestamps a client converts lie between two exchanges
+            for ahead in (0.0, 0.5 * INTERVAL, INTERVAL):
+                worst = max(worst, self.residual(sync, host_t1 + ahead))
+            self.assertLess(abs(sync.drift_ppm - DRIFT_PPM), MAX_DRIFT_ERROR_PPM)
+
+        self.assertLess(worst, MAX_RESIDUAL)
+        print(f"test_timesync: worst residual {worst * 1e6:.1f} us")
+
+    def test_without_drift_compensation(self) -> None:
+        """The same clock read with a fixed offset only is off by the drift."""
+        rng = random.Random(0x5EED)
+        sync = ClockSync(window=1, keep=1)
+
+        sync.add(exchange(HOST_START, rng))
+        later = HOST_START + 60.0
+        self.assertGreater(self.residual(sync, later), 60.0 * DRIFT_PPM * 1e-6 / 2)
+
+    def test_single_exchange(self) -> None:
+        """One exchange fixes the offset, with no drift assumed."""
+        sample = SyncSample(HOST_START, 5_000_000, 5_000_100, HOST_START + 0.002)
+        sync = ClockSync()
+
+        self.assertFalse(sync.ready)
+        with self.assertRaises(RuntimeError):
+            sync.to_host(0)
+
+        sync.add(sample)
+        self.assertTrue(sync.ready)
+        self.assertEqual(sync.drift_ppm, 0.0)
+        self.assertAlmostEqual(sample.delay, 0.0019, delta=1e-6)
+        self.assertAlmostEqual(sync.to_host(5_000_050), sample.host_mid, delta=1e-6)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,379 @@
+/**
+ * @file test_udp_overload.c
+ * @brief Send buffer ledger of the target udp_socket.c against a modelled pool
+ * @details The test plays RL-NET with a memory pool of NET_MEM_POOL_SIZE bytes.
+ * netUDP_GetBuffer() takes the payload plus NET_POOL_FRAME_OVERHEAD from it, or
+ * returns NULL where the stack would call netHandleError(). netUDP_Send() queues
+ * the frame on a 100 Mbit/s wire, where it takes its Ethernet, IP and UDP
+ * headers, FCS, preamble and inter-frame gap, and its memory is freed when the
+ * driver starts sending it.
+ *
+ * Several threads send as fast as the socket layer lets them, with single and
+ * batched sends, full-size and small datagrams, for OVERLOAD_MS. The ledger must
+ * refuse some of them, netUDP_GetBuffer() must never run dry and the pool must
+ * never fill. Sends the stack fails afterwards must not stay charged.
+ *
+ * The pool may hold more than the ledger by the datagrams charged but not yet
+ * handed to netUDP_Send(), one per sender, which is what the receive reserve
+ * absorbs; the small sender keeps that within NET_MEM_POOL_SIZE.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "udp_socket.h"
+
+#include "Driver_ETH_PHY.h"
+#include "Net_Config.h"
+#include "Net_Config_UDP.h"
+#include "cmsis_os2.h"
+#include "net_pool.h"
+#include "rl_net.h"
+#include "system.h"
+#include "test.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Run time of the overload phase in ms */
+#define OVERLOAD_MS 1000U
+/** Sending threads */
+#define SENDERS 3U
+/** Datagrams per batched send */
+#define BATCH 8U
+/** Payload of the small datagrams, padded to a minimum frame on the wire */
+#define SMALL_LEN 10U
+/** Link rate of the modelled wire */
+#define WIRE_BYTES_PER_S 12500000U
+/** Ethernet, IPv4 and UDP headers and FCS */
+#define FRAME_HEADERS 46U
+/** Shortest Ethernet frame */
+#define FRAME_MIN 64U
+/** Preamble, start delimiter and inter-frame gap */
+#define FRAME_GAP 20U
+/** Frames the pool can hold at once, rounded up */
+#define WIRE_QUEUE 256U
+
+/**
+ * @brief Frame waiting for the wire
+ */
+typedef struct
+{
+    uint64_t start_ns; /**< Time the driver starts sending it */
+    uint32_t bytes;    /**< Pool memory it holds */
+} queued_frame_t;
+
+static pthread_mutex_t stack_lock = PTHREAD_MUTEX_INITIALIZER;
+static queued_frame_t  wire_queue[WIRE_QUEUE];
+static uint32_t        wire_head = 0;
+static uint32_t        wire_tail = 0;
+static uint64_t        wire_free_ns = 0;
+static uint32_t        pool_used    = 0;
+static uint32_t        pool_peak    = 0;
+static uint32_t        no_buffer    = 0;
+static uint32_t        frames       = 0;
+static int32_t         next_socket  = 0;
+
+/** Make the stack fail the next send, with no buffer or with an error */
+static atomic_bool fail_buffer = false;
+static atomic_bool fail_send   = false;
+
+/** Every socket the layer has, shared by the senders */
+static udp_socket_handle_t sockets[UDP_NUM_SOCKS];
+static const udp_endpoint_t remote = {.ip = {{192, 168, 0, 2}}, .port = 5000};
+
+static atomic_bool  stop     = false;
+static atomic_int   running  = 0;
+static atomic_ulong refused  = 0;
+static atomic_ulong sent     = 0;
+static atomic_ulong failures = 0;
+
+static ARM_ETH_LINK_INFO phy_link_info(void)
+{
+    ARM_ETH_LINK_INFO info = {.speed = ARM_ETH_SPEED_100M, .duplex = 1};
+    return info;
+}
+
+ARM_DRIVER_ETH_PHY Driver_ETH_PHY0 = {.GetLinkInfo = phy_link_info};
+
+/**
+ * @brief Free the frames the driver has started sending by now
+ * @note Called with stack_lock held.
+ */
+static void wire_advance(uint64_t now_ns)
+{
+    while (wire_head != wire_tail && wire_queue[wire_head].start_ns <= now_ns)
+    {
+        pool_used -= wire_queue[wire_head].bytes;
+        wire_head = (wire_head + 1U) % WIRE_QUEUE;
+    }
+}
+
+int32_t netUDP_GetSocket(netUDP_cb_t cb_func)
+{
+    (void)cb_func;
+
+    pthread_mutex_lock(&stack_lock);
+    int32_t socket = ++next_socket;
+    pthread_mutex_unlock(&stack_lock);
+
+    return socket;
+}
+
+netStatus netUDP_ReleaseSocket(int32_t socket)
+{
+    (void)socket;
+    return netOK;
+}
+
+netStatus netUDP_Open(int32_t socket, uint16_t port)
+{
+    (void)socket;
+    (void)port;
+    return netOK;
+}
+
+netStatus netUDP_Close(int32_t socket)
+{
+    (void)socket;
+    return netOK;
+}
+
+uint8_t *netUDP_GetBuffer(uint32_t size)
+{
+    uint32_t bytes = size + NET_POOL_FRAME_OVERHEAD;
+
+    if (atomic_exchange(&fail_buffer, false))
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&stack_lock);
+    wire_advance(system_time_us() * 1000U);
+    if (pool_used + bytes > NET_MEM_POOL_SIZE)
+    {
+        no_buffer++;
+        pthread_mutex_unlock(&stack_lock);
+        return NULL;
+    }
+    pool_used += bytes;
+    pool_peak = (pool_used > pool_peak) ? pool_used : pool_peak;
+    pthread_mutex_unlock(&stack_lock);
+
+    return malloc(size);
+}
+
+netStatus netUDP_Send(int32_t socket, const NET_ADDR *addr, uint8_t *buf, uint32_t len)
+{
+    uint32_t bytes = len + NET_POOL_FRAME_OVERHEAD;
+    uint32_t frame = len + FRAME_HEADERS;
+    uint32_t wire  = ((frame > FRAME_MIN) ? frame : FRAME_MIN) + FRAME_GAP;
+
+    (void)socket;
+    (void)addr;
+    free(buf);
+
+    pthread_mutex_lock(&stack_lock);
+    if (atomic_exchange(&fail_send, false))
+    {
+        /* The stack frees the frame it could not send */
+        pool_used -= bytes;
+        pthread_mutex_unlock(&stack_lock);
+        return netError;
+    }
+
+    uint64_t now_ns = system_time_us() * 1000U;
+    uint64_t start  = (wire_free_ns > now_ns) ? wire_free_ns : now_ns;
+
+    wire_free_ns = start + (uint64_t)wire * 1000000000U / WIRE_BYTES_PER_S;
+    wire_queue[wire_tail] = (queued_frame_t){.start_ns = start, .bytes = bytes};
+    wire_tail             = (wire_tail + 1U) % WIRE_QUEUE;
+    frames++;
+    pthread_mutex_unlock(&stack_lock);
+
+    return netOK;
+}
+
+netStatus
+netIF_GetOption(uint32_t if_id, netIF_Option option, uint8_t *buf, uint32_t buf_len)
+{
+    (void)if_id;
+    (void)option;
+    memset(buf, 0, buf_len);
+    return netOK;
+}
+
+netStatus
+netARP_CacheIP(uint32_t if_id, const uint8_t *ip4_addr, netARP_CacheType type)
+{
+    (void)if_id;
+    (void)ip4_addr;
+    (void)type;
+    return netOK;
+}
+
+netStatus netARP_GetMAC(uint32_t if_id, const uint8_t *ip4_addr, uint8_t *mac_addr)
+{
+    (void)if_id;
+    (void)ip4_addr;
+    memset(mac_addr, 0, NET_ADDR_ETH_LEN);
+    return netOK;
+}
+
+/**
+ * @brief Count the outcome of one send
+ */
+static void count(udp_status_t status)
+{
+    if (status == UDP_STATUS_OK)
+    {
+        atomic_fetch_add(&sent, 1);
+    }
+    else if (status == UDP_STATUS_NO_MEMORY)
+    {
+        atomic_fetch_add(&refused, 1);
+    }
+    else
+    {
+        atomic_fetch_add(&failures, 1);
+    }
+}
+
+/**
+ * @brief Send without waiting until stopped
+ * @details Sender 0 sends full-size datagrams one at a time, sender 1 in
+ * batches and sender 2 small ones, which cost the wire more than their size.
+ */
+static void sender(void *argument)
+{
+    static uint8_t      payload[UDP_MAX_PAYLOAD_SIZE];
+    uintptr_t           id     = (uintptr_t)argument;
+    udp_socket_handle_t handle = sockets[id % UDP_NUM_SOCKS];
+    size_t              len    = (id == 2U) ? SMALL_LEN : UDP_MAX_PAYLOAD_SIZE;
+
+    while (!atomic_load(&stop))
+    {
+        if (id == 1U)
+        {
+            udp_datagram_t datagrams[BATCH];
+            udp_status_t   results[BATCH];
+
+            for (size_t i = 0; i < BATCH; i++)
+            {
+                datagrams[i] = (udp_datagram_t){
+                    .remote = &remote, .data = payload, .len = len
+                };
+            }
+            (void)udp_socket_send_batch(handle, datagrams, BATCH, results);
+            for (size_t i = 0; i < BATCH; i++)
+            {
+                count(results[i]);
+            }
+        }
+        else
+        {
+            count(udp_socket_send(handle, &remote, payload, len));
+        }
+    }
+
+    atomic_fetch_sub(&running, 1);
+}
+
+/**
+ * @brief A send the stack fails leaves the ledger where it was
+ */
+static void check_refund(void)
+{
+    static const uint8_t payload[UDP_MAX_PAYLOAD_SIZE];
+    udp_socket_handle_t  handle = sockets[0];
+    udp_pool_stats_t     stats;
+
+    /* Idle long enough for the ledger to drain */
+    osDelay(100);
+    atomic_store(&fail_buffer, true);
+    TEST_CHECK(
+        udp_socket_send(handle, &remote, payload, sizeof(payload)) ==
+        UDP_STATUS_NO_MEMORY
+    );
+    TEST_CHECK(udp_socket_get_pool_stats(&stats) == UDP_STATUS_OK);
+    TEST_CHECK(stats.tx_pool_used == 0U);
+
+    atomic_store(&fail_send, true);
+    TEST_CHECK(
+        udp_socket_send(handle, &remote, payload, sizeof(payload)) ==
+        UDP_STATUS_NET_ERROR
+    );
+    TEST_CHECK(udp_socket_get_pool_stats(&stats) == UDP_STATUS_OK);
+    TEST_CHECK(stats.tx_pool_used == 0U);
+}
+
+/**
+ * @brief Stop the overload phase and report
+ */
+static void control(void *argument)
+{
+    udp_pool_stats_t stats;
+
+    (void)argument;
+
+    osDelay(OVERLOAD_MS);
+    atomic_store(&stop, true);
+    while (atomic_load(&running) > 0)
+    {
+        osDelay(1);
+    }
+
+    TEST_CHECK(udp_socket_get_pool_stats(&stats) == UDP_STATUS_OK);
+    pthread_mutex_lock(&stack_lock);
+    uint32_t peak  = pool_peak;
+    uint32_t empty = no_buffer;
+    pthread_mutex_unlock(&stack_lock);
+
+    TEST_CHECK(atomic_load(&failures) == 0U);
+    TEST_CHECK(atomic_load(&sent) > 0U);
+    TEST_CHECK(atomic_load(&refused) > 0U);
+    TEST_CHECK(stats.tx_refused == atomic_load(&refused));
+    TEST_CHECK(empty == 0U);
+    TEST_CHECK(peak < NET_MEM_POOL_SIZE);
+    TEST_CHECK(stats.tx_pool_peak <= stats.tx_pool_size);
+
+    printf(
+        "test_udp_overload: %lu sent, %lu refused, %u frames, pool peak %u of %u "
+        "bytes, ledger peak %u of %u\n",
+        (unsigned long)atomic_load(&sent), (unsigned long)atomic_load(&refused),
+        frames, peak, NET_MEM_POOL_SIZE, stats.tx_pool_peak, stats.tx_pool_size
+    );
+
+    check_refund();
+
+    fflush(stdout);
+    exit(test_report("test_udp_overload"));
+}
+
+int main(void)
+{
+    osKernelInitialize();
+    if (udp_socket_init() != UDP_STATUS_OK)
+    {
+        return 1;
+    }
+    netETH_Notify(0, netETH_LinkUp, 0);
+    for (size_t i = 0; i < UDP_NUM_SOCKS; i++)
+    {
+        if (udp_socket_create(&sockets[i], (uint16_t)(6000U + i)) != UDP_STATUS_OK)
+        {
+            return 1;
+        }
+    }
+
+    atomic_store(&running, SENDERS);
+    for (uintptr_t i = 0; i < SENDERS; i++)
+    {
+        osThreadNew(sender, (void *)i, NULL);
+    }
+    osThreadNew(control, NULL, NULL);
+
+    osKernelStart();
+    return 1;
+}
@@ -0,0 +1,315 @@
+/**
+ * @file test_udp_socket.c
+ * @brief Stress test of the lock-free receive callback of the target udp_socket.c
+ * @details The test plays RL-NET: a core thread keeps delivering datagrams
+ * through the callback registered for each stack handle, looked up before the
+ * call as the stack does, so it races sockets being closed and reopened by
+ * other threads. The receive filter runs inside the callback and sleeps to
+ * widen the window. udp_socket_close() must not return while a callback is
+ * still inside the socket it frees.
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "udp_socket.h"
+
+#include "Driver_ETH_PHY.h"
+#include "Net_Config_UDP.h"
+#include "cmsis_os2.h"
+#include "rl_net.h"
+#include "test.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** Run time of the stress phase in ms */
+#define STRESS_MS 2000U
+/** Time the filter holds the callback inside a socket, in ns */
+#define FILTER_HOLD_NS 20000L
+/** Receives of up to 1 ms tried between opening and closing a socket */
+#define RECEIVES_PER_CYCLE 3
+/** Longest random pause before a close, in ns */
+#define CLOSE_JITTER_NS 100000U
+
+/**
+ * @brief State of one churn thread's socket, seen by the filter
+ */
+typedef struct
+{
+    atomic_int  inside; /**< Callbacks currently in the filter */
+    atomic_bool closed; /**< Set once udp_socket_close() has returned */
+} socket_probe_t;
+
+static netUDP_cb_t     stack_callbacks[UDP_NUM_SOCKS + 1];
+static pthread_mutex_t stack_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static socket_probe_t probes[UDP_NUM_SOCKS];
+static atomic_bool    stop           = false;
+static atomic_int     churn_running  = 0;
+static atomic_ulong   delivered      = 0;
+static atomic_ulong   accepted       = 0;
+static atomic_ulong   filtered       = 0;
+static atomic_ulong   received       = 0;
+static atomic_ulong   cycles         = 0;
+static atomic_ulong   close_early    = 0;
+static atomic_ulong   after_close    = 0;
+static atomic_ulong   churn_failures = 0;
+
+static ARM_ETH_LINK_INFO phy_link_info(void)
+{
+    ARM_ETH_LINK_INFO info = {.speed = ARM_ETH_SPEED_100M, .duplex = 1};
+    return info;
+}
+
+ARM_DRIVER_ETH_PHY Driver_ETH_PHY0 = {.GetLinkInfo = phy_link_info};
+
+int32_t netUDP_GetSocket(netUDP_cb_t cb_func)
+{
+    int32_t socket = -1;
+
+    pthread_mutex_lock(&stack_lock);
+    for (int32_t i = 1; i <= UDP_NUM_SOCKS && socket < 0; i++)
+    {
+        if (stack_callbacks[i] == NULL)
+        {
+            stack_callbacks[i] = cb_func;
+            socket             = i;
+        }
+    }
+    pthread_mutex_unlock(&stack_lock);
+
+    return socket;
+}
+
+netStatus netUDP_ReleaseSocket(int32_t socket)
+{
+    pthread_mutex_lock(&stack_lock);
+    stack_callbacks[socket] = NULL;
+    pthread_mutex_unlock(&stack_lock);
+    return netOK;
+}
+
+netStatus netUDP_Open(int32_t socket, uint16_t port)
+{
+    (void)socket;
+    (void)port;
+    return netOK;
+}
+
+netStatus netUDP_Close(int32_t socket)
+{
+    (void)socket;
+    return netOK;
+}
+
+uint8_t *netUDP_GetBuffer(uint32_t size)
+{
+    return malloc(size);
+}
+
+netStatus netUDP_Send(int32_t socket, const NET_ADDR *addr, uint8_t *buf, uint32_t len)
+{
+    (void)socket;
+    (void)addr;
+    (void)len;
+    free(buf);
+    return netOK;
+}
+
+netStatus
+netIF_GetOption(uint32_t if_id, netIF_Option option, uint8_t *buf, uint32_t buf_len)
+{
+    (void)if_id;
+    (void)option;
+    memset(buf, 0, buf_len);
+    return netOK;
+}
+
+netStatus
+netARP_CacheIP(uint32_t if_id, const uint8_t *ip4_addr, netARP_CacheType type)
+{
+    (void)if_id;
+    (void)ip4_addr;
+    (void)type;
+    return netOK;
+}
+
+netStatus netARP_GetMAC(uint32_t if_id, const uint8_t *ip4_addr, uint8_t *mac_addr)
+{
+    (void)if_id;
+    (void)ip4_addr;
+    memset(mac_addr, 0, NET_ADDR_ETH_LEN);
+    return netOK;
+}
+
+/**
+ * @brief Receive filter, runs inside udp_net_callback()
+ */
+static bool probe_filter(
+    const udp_endpoint_t *remote, const uint8_t *data, size_t len, void *context
+)
+{
+    socket_probe_t       *probe = context;
+    const struct timespec hold  = {.tv_sec = 0, .tv_nsec = FILTER_HOLD_NS};
+
+    (void)remote;
+    (void)data;
+    (void)len;
+
+    atomic_fetch_add(&probe->inside, 1);
+    atomic_fetch_add(&filtered, 1);
+    nanosleep(&hold, NULL);
+    if (atomic_load(&probe->closed))
+    {
+        atomic_fetch_add(&after_close, 1);
+    }
+    atomic_fetch_sub(&probe->inside, 1);
+
+    return true;
+}
+
+/**
+ * @brief Network core thread, delivering to every handle in turn
+ */
+static void stack_core(void *argument)
+{
+    static const uint8_t payload[64];
+    const NET_ADDR       addr = {
+        .addr_type = NET_ADDR_IP4, .port = 1234, .addr = {127, 0, 0, 1}
+    };
+
+    (void)argument;
+    while (!atomic_load(&stop))
+    {
+        for (int32_t socket = 1; socket <= UDP_NUM_SOCKS; socket++)
+        {
+            /* Looked up before the call: the socket may be closing meanwhile */
+            pthread_mutex_lock(&stack_lock);
+            netUDP_cb_t callback = stack_callbacks[socket];
+            pthread_mutex_unlock(&stack_lock);
+
+            if (callback != NULL)
+            {
+                atomic_fetch_add(&delivered, 1);
+                if (callback(socket, &addr, payload, sizeof(payload)) != 0U)
+                {
+                    atomic_fetch_add(&accepted, 1);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Open a socket, drain it a little and close it, over and over
+ */
+static void churn(void *argument)
+{
+    socket_probe_t       *probe = argument;
+    uint8_t               buffer[128];
+    uint32_t              rng = 0x9E3779B9U ^ (uint32_t)(uintptr_t)probe;
+    const udp_rx_config_t rx = {
+        .queue_len      = 2,
+        .max_len        = sizeof(buffer),
+        .filter         = probe_filter,
+        .filter_context = probe,
+    };
+
+    while (!atomic_load(&stop))
+    {
+        udp_socket_handle_t handle;
+
+        atomic_store(&probe->closed, false);
+        if (udp_socket_create_rx(&handle, 5000, &rx) != UDP_STATUS_OK)
+        {
+            atomic_fetch_add(&churn_failures, 1);
+            break;
+        }
+
+        for (int i = 0; i < RECEIVES_PER_CYCLE; i++)
+        {
+            size_t len;
+            if (udp_socket_recv(handle, NULL, buffer, sizeof(buffer), &len, 1) ==
+                UDP_STATUS_OK)
+            {
+                atomic_fetch_add(&received, 1);
+            }
+        }
+
+        /* Without it the core thread is always at the other socket by now */
+        const struct timespec jitter = {
+            .tv_sec = 0, .tv_nsec = (long)(test_random(&rng) % CLOSE_JITTER_NS)
+        };
+        nanosleep(&jitter, NULL);
+
+        if (udp_socket_close(handle) != UDP_STATUS_OK)
+        {
+            atomic_fetch_add(&churn_failures, 1);
+            break;
+        }
+
+        /* No callback may still be inside the freed socket */
+        if (atomic_load(&probe->inside) != 0)
+        {
+            atomic_fetch_add(&close_early, 1);
+        }
+        atomic_store(&probe->closed, true);
+        atomic_fetch_add(&cycles, 1);
+    }
+
+    atomic_fetch_sub(&churn_running, 1);
+}
+
+/**
+ * @brief Stop the stress phase and report
+ */
+static void control(void *argument)
+{
+    (void)argument;
+
+    osDelay(STRESS_MS);
+    atomic_store(&stop, true);
+    while (atomic_load(&churn_running) > 0)
+    {
+        osDelay(1);
+    }
+
+    TEST_CHECK(atomic_load(&churn_failures) == 0U);
+    TEST_CHECK(atomic_load(&close_early) == 0U);
+    TEST_CHECK(atomic_load(&after_close) == 0U);
+    TEST_CHECK(atomic_load(&cycles) > 0U);
+    TEST_CHECK(atomic_load(&filtered) > 0U);
+    TEST_CHECK(atomic_load(&received) > 0U);
+    TEST_CHECK(atomic_load(&received) <= atomic_load(&accepted));
+
+    printf(
+        "test_udp_socket: %lu cycles, %lu delivered, %lu accepted, %lu received\n",
+        (unsigned long)atomic_load(&cycles), (unsigned long)atomic_load(&delivered),
+        (unsigned long)atomic_load(&accepted), (unsigned long)atomic_load(&received)
+    );
+    fflush(stdout);
+    exit(test_report("test_udp_socket"));
+}
+
+int main(void)
+{
+    osKernelInitialize();
+    if (udp_socket_init() != UDP_STATUS_OK)
+    {
+        return 1;
+    }
+
+    atomic_store(&churn_running, UDP_NUM_SOCKS);
+    osThreadNew(stack_core, NULL, NULL);
+    for (size_t i = 0; i < UDP_NUM_SOCKS; i++)
+    {
+        osThreadNew(churn, &probes[i], NULL);
+    }
+    osThreadNew(control, NULL, NULL);
+
+    osKernelStart();
+    return 1;
+}
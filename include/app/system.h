@@ -15,6 +15,9 @@
 
 #include "logger.h"
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -22,6 +25,81 @@ extern "C"
 
 #define DEFAULT_LOG_LEVEL LOG_LEVEL_DEBUG
 
+/** Host streamed to from boot without a START command, NULL to wait for one */
+#define SYSTEM_AUTOSTART_HOST NULL
+/** UDP port of the auto-start host */
+#define SYSTEM_AUTOSTART_PORT 5001U
+
+    /**
+     * @brief Boot milestones, timed from the start of main()
+     */
+    typedef enum
+    {
+        SYSTEM_BOOT_LOGGER       = 0, /**< Logger initialized */
+        SYSTEM_BOOT_NET_STACK    = 1, /**< netInitialize() returned */
+        SYSTEM_BOOT_KERNEL       = 2, /**< osKernelStart() called */
+        SYSTEM_BOOT_LINK_UP      = 3, /**< Ethernet link first up */
+        SYSTEM_BOOT_NET_READY    = 4, /**< Address set and socket created */
+        SYSTEM_BOOT_FIRST_SAMPLE = 5, /**< First ADC sample processed */
+        SYSTEM_BOOT_FIRST_SEND   = 6, /**< First data packet sent */
+        SYSTEM_BOOT_PHASE_COUNT  = 7  /**< Number of milestones */
+    } system_boot_phase_t;
+
+    /**
+     * @brief Get time since kernel start with microsecond resolution
+     * @details Combines the RTOS tick counter with the current SysTick value, so it
+     * is not limited to the 1 ms tick granularity. Wraps together with the 32-bit
+     * tick counter.
+     * @return Time in microseconds
+     */
+    uint64_t system_time_us(void);
+
+    /**
+     * @brief Get CPU load measured by the idle thread
+     * @details The idle thread counts the DWT cycles it spends spinning and
+     * publishes the busy share once per second.
+     * @return CPU load in permille over the last full second
+     */
+    uint16_t system_cpu_load_permille(void);
+
+    /**
+     * @brief Get unused stack of the RTX idle and timer threads
+     * @param idle_free Pointer to store idle thread stack space in bytes
+     * @param timer_free Pointer to store timer thread stack space in bytes, 0 if
+     * the timer thread does not exist
+     */
+    void system_get_kernel_stack_free(uint32_t *idle_free, uint32_t *timer_free);
+
+    /**
+     * @brief Start the boot clock, first thing in main()
+     * @details Before the kernel runs there is no tick, so the milestones up to
+     * SYSTEM_BOOT_KERNEL are timed with the DWT cycle counter.
+     */
+    void system_boot_start(void);
+
+    /**
+     * @brief Record when a boot milestone was reached
+     * @details Only the first call for a milestone counts, so the callers can
+     * mark it on every pass through a hot path.
+     * @param phase Milestone
+     * @return true if this call recorded it
+     */
+    bool system_boot_mark(system_boot_phase_t phase);
+
+    /**
+     * @brief Get when a boot milestone was reached
+     * @param phase Milestone
+     * @return Microseconds from the start of main(), 0 if not reached yet
+     */
+    uint32_t system_boot_phase_us(system_boot_phase_t phase);
+
+    /**
+     * @brief Get the host to stream to from boot
+     * @param port Pointer to store the UDP port
+     * @return IPv4 address string, NULL if auto-start is off
+     */
+    const char *system_autostart_target(uint16_t *port);
+
 #ifdef __cplusplus
 }
 #endif
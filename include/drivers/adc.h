@@ -22,6 +22,14 @@ extern "C"
 {
 #endif
 #define ADC_RESOLUTION 12U
+/** Lowest sample rate of timer-triggered sampling */
+#define ADC_MIN_SAMPLE_RATE_HZ 1U
+/** Highest sample rate of timer-triggered sampling */
+#define ADC_MAX_SAMPLE_RATE_HZ 20000U
+/** Highest sample rate of a burst capture */
+#define ADC_MAX_CAPTURE_RATE_HZ 100000U
+/** Samples buffered between the ADC interrupt and the reader (power of 2) */
+#define ADC_BUFFER_SIZE 256U
 
     /** ADC channel definitions */
     typedef enum
@@ -86,6 +94,85 @@ extern "C"
      */
     adc_status_t adc_read_sync(uint16_t *value);
 
+    /**
+     * @brief Start timer-triggered sampling into the sample buffer
+     * @details TIMER1 match output MAT1.0 starts every conversion, so the
+     * sample rate does not depend on when the reader runs. The ADC clock
+     * divider is set to the slowest clock that converts within half a sample
+     * period. Previously buffered samples are discarded.
+     * @param rate_hz Requested sample rate (ADC_MIN_SAMPLE_RATE_HZ to
+     * ADC_MAX_SAMPLE_RATE_HZ)
+     * @return ADC status code
+     */
+    adc_status_t adc_start_sampling(uint32_t rate_hz);
+
+    /**
+     * @brief Stop timer-triggered sampling or abort a burst capture
+     * @return ADC status code
+     */
+    adc_status_t adc_stop_sampling(void);
+
+    /**
+     * @brief Take the oldest sample from the sample buffer
+     * @param value Pointer to store the sample (12-bit)
+     * @return ADC_OK, or ADC_ERROR_BUSY if the buffer is empty
+     * @note Only one thread may read the buffer.
+     */
+    adc_status_t adc_read_buffered(uint16_t *value);
+
+    /**
+     * @brief Get number of samples waiting in the sample buffer
+     * @return Buffered samples
+     */
+    uint32_t adc_buffered_count(void);
+
+    /**
+     * @brief Get number of samples lost because the sample buffer was full
+     * @return Overrun count since boot
+     */
+    uint32_t adc_get_overruns(void);
+
+    /**
+     * @brief Capture a burst of samples straight into memory
+     * @details Conversions are triggered by the timer as in
+     * adc_start_sampling(), but the interrupt handler writes each result to
+     * the next element of buffer and stops the timer once it is full, so the
+     * rate is not limited by how fast a task can consume samples.
+     * @param buffer Destination, must stay valid until the capture is done
+     * @param count Number of samples to capture
+     * @param rate_hz Sample rate (ADC_MIN_SAMPLE_RATE_HZ to
+     * ADC_MAX_CAPTURE_RATE_HZ)
+     * @return ADC status code
+     */
+    adc_status_t adc_start_capture(uint16_t *buffer, uint32_t count, uint32_t rate_hz);
+
+    /**
+     * @brief Check if the last burst capture is complete
+     * @return 1 if every requested sample was stored, 0 otherwise
+     */
+    int adc_capture_done(void);
+
+    /**
+     * @brief Get number of samples stored by the current or last burst capture
+     * @return Stored samples
+     */
+    uint32_t adc_capture_progress(void);
+
+    /**
+     * @brief Get number of conversions the last burst capture lost
+     * @details Counts results that carried the ADC OVERRUN flag, i.e. the
+     * interrupt ran too late and the previous result was overwritten.
+     * @return Overrun count
+     */
+    uint32_t adc_capture_overrun_count(void);
+
+    /**
+     * @brief Sample rate the timer achieves for a requested rate
+     * @param rate_hz Requested sample rate in Hz, up to ADC_MAX_CAPTURE_RATE_HZ
+     * @return Achieved sample rate in millihertz
+     */
+    uint32_t adc_sample_rate_millihz(uint32_t rate_hz);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,78 @@
+/**
+ * @file decimator.h
+ * @brief CIC decimator with FIR droop compensation
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+/**
+ * @defgroup Decimator Decimator
+ * @{
+ */
+
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Largest supported decimation ratio */
+#define DECIMATOR_MAX_RATIO 64
+/** Number of CIC integrator and comb stages */
+#define DECIMATOR_STAGES 3
+/** Number of taps of the compensation FIR */
+#define DECIMATOR_FIR_TAPS 5
+/** Fractional bits of the decimator output */
+#define DECIMATOR_FRAC_BITS 4
+
+    /**
+     * @brief Decimator state
+     * @details CIC registers use unsigned wrap-around arithmetic: the final
+     * result fits 32 bits, so overflow in the integrators cancels out in the
+     * combs.
+     */
+    typedef struct
+    {
+        uint32_t integrator[DECIMATOR_STAGES];    /**< Integrator outputs */
+        uint32_t comb_delay[DECIMATOR_STAGES];    /**< Previous comb inputs */
+        int32_t  fir_history[DECIMATOR_FIR_TAPS]; /**< CIC outputs, newest first */
+        uint32_t gain;                            /**< CIC gain, ratio^stages */
+        uint16_t ratio;                           /**< Decimation ratio */
+        uint16_t phase;                           /**< Inputs since last output */
+        uint8_t  settle;                          /**< Outputs until the CIC is full */
+    } decimator_t;
+
+    /**
+     * @brief Reset a decimator and set its ratio
+     * @param dec Decimator state
+     * @param ratio Decimation ratio (1 to DECIMATOR_MAX_RATIO), 1 passes samples
+     * through unfiltered
+     * @return 0 on success, negative if the ratio is out of range
+     */
+    int decimator_init(decimator_t *dec, uint16_t ratio);
+
+    /**
+     * @brief Feed one ADC sample
+     * @details Every ratio-th input produces an output. After a reset the first
+     * DECIMATOR_STAGES - 1 outputs are discarded while the CIC fills.
+     * @param dec Decimator state
+     * @param sample 12-bit ADC sample
+     * @param out Output sample in ADC counts with DECIMATOR_FRAC_BITS fractional
+     * bits, written only when true is returned
+     * @return true if an output sample was produced
+     */
+    bool decimator_process(decimator_t *dec, uint16_t sample, uint16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DECIMATOR_H */
+
+/** End of Decimator group */
+/** @} */
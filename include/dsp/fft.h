@@ -0,0 +1,65 @@
+/**
+ * @file fft.h
+ * @brief Fixed-point real FFT for spectrum acquisition
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+/**
+ * @defgroup FFT FFT
+ * @{
+ */
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Number of real samples per transform */
+#define FFT_SIZE 256
+/** Number of magnitude bins per transform (DC to just below Nyquist) */
+#define FFT_BINS (FFT_SIZE / 2)
+
+    /**
+     * @brief Convert one ADC sample to a Hann-windowed Q15 value
+     * @details The 12-bit sample is centered on mid-scale and scaled to Q15
+     * before the window is applied, so samples can be windowed as they arrive.
+     * @param adc_value 12-bit ADC sample
+     * @param index Position of the sample in the frame (0 to FFT_SIZE - 1)
+     * @return Windowed sample in Q15
+     */
+    int16_t fft_window_sample(uint16_t adc_value, size_t index);
+
+    /**
+     * @brief In-place real FFT of FFT_SIZE Q15 samples
+     * @details Runs a radix-2 complex FFT of FFT_SIZE / 2 points on the even and
+     * odd samples and splits the result. Every stage halves its output, so the
+     * result is the DFT divided by FFT_SIZE and cannot overflow. On return
+     * data[0] holds the real DC bin, data[1] the real Nyquist bin and
+     * data[2k], data[2k + 1] the real and imaginary parts of bin k.
+     * @param data FFT_SIZE samples on input, packed spectrum on output
+     */
+    void fft_real_q15(int16_t *data);
+
+    /**
+     * @brief Magnitude of one bin of a packed spectrum
+     * @param spectrum Output of fft_real_q15()
+     * @param bin Bin index (0 to FFT_BINS - 1)
+     * @return Bin magnitude in Q15
+     */
+    uint16_t fft_magnitude(const int16_t *spectrum, size_t bin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FFT_H */
+
+/** End of FFT group */
+/** @} */
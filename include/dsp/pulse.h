@@ -0,0 +1,82 @@
+/**
+ * @file pulse.h
+ * @brief Threshold pulse detector for event acquisition
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+/**
+ * @defgroup Pulse Pulse detector
+ * @{
+ */
+
+#ifndef PULSE_H
+#define PULSE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief One detected pulse
+     */
+    typedef struct
+    {
+        uint64_t start_us; /**< Device time of the first sample above threshold */
+        uint16_t peak;     /**< Largest sample of the pulse */
+        uint16_t width;    /**< Samples above threshold, saturates at UINT16_MAX */
+        uint32_t area;     /**< Sum of (sample - threshold) over the pulse */
+    } pulse_t;
+
+    /**
+     * @brief Pulse detector state
+     * @details A pulse starts at the first sample at or above the threshold
+     * and ends at the first sample below it. After a pulse, dead_time samples
+     * are ignored, and the signal must then fall below the threshold before
+     * the next pulse can start, so a pulse is never counted from its middle.
+     */
+    typedef struct
+    {
+        pulse_t  current;   /**< Pulse in progress */
+        uint16_t threshold; /**< Trigger level in ADC counts */
+        uint16_t dead_time; /**< Samples ignored after each pulse */
+        uint16_t holdoff;   /**< Dead time samples left */
+        bool     armed;     /**< Signal was below threshold since the last pulse */
+        bool     in_pulse;  /**< A pulse is in progress */
+    } pulse_detector_t;
+
+    /**
+     * @brief Reset a detector
+     * @details The detector starts disarmed, so a signal that is already
+     * above the threshold is not reported as a truncated pulse.
+     * @param det Detector state
+     * @param threshold Trigger level in ADC counts
+     * @param dead_time Samples ignored after each pulse
+     */
+    void
+    pulse_detector_init(pulse_detector_t *det, uint16_t threshold, uint16_t dead_time);
+
+    /**
+     * @brief Feed one sample
+     * @param det Detector state
+     * @param sample Sample in ADC counts
+     * @param now_us Device time of the sample, only used when a pulse starts
+     * @param out Completed pulse, written only when true is returned
+     * @return true if the sample ended a pulse
+     */
+    bool pulse_detector_process(
+        pulse_detector_t *det, uint16_t sample, uint64_t now_us, pulse_t *out
+    );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PULSE_H */
+
+/** End of Pulse group */
+/** @} */
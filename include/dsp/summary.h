@@ -0,0 +1,91 @@
+/**
+ * @file summary.h
+ * @brief Exact min, max, mean and RMS of a window of ADC samples
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+/**
+ * @defgroup Summary Summary statistics
+ * @{
+ */
+
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Most fractional bits of the mean and RMS that still fit 16 bits */
+#define SUMMARY_MAX_FRAC_BITS 4
+
+    /**
+     * @brief Running statistics of a summary window
+     * @details Integer accumulators are exact: a 65535-sample window of 12-bit
+     * samples needs 28 bits for the sum and 40 bits for the sum of squares.
+     */
+    typedef struct
+    {
+        uint32_t count;    /**< Samples accumulated */
+        uint32_t sum;      /**< Sum of samples */
+        uint64_t sum_sq;   /**< Sum of squared samples */
+        uint16_t min;      /**< Smallest sample */
+        uint16_t max;      /**< Largest sample */
+        uint64_t start_us; /**< Device time of the first sample */
+    } summary_acc_t;
+
+    /**
+     * @brief Statistics of a completed window
+     */
+    typedef struct
+    {
+        uint16_t count;    /**< Samples in the window */
+        uint16_t min;      /**< Smallest sample */
+        uint16_t max;      /**< Largest sample */
+        uint16_t mean;     /**< Mean, rounded, with the requested fractional bits */
+        uint16_t rms;      /**< Root mean square, rounded down, same format */
+        uint64_t start_us; /**< Device time of the first sample */
+    } summary_t;
+
+    /**
+     * @brief Start a new window
+     * @param acc Accumulators
+     */
+    void summary_reset(summary_acc_t *acc);
+
+    /**
+     * @brief Add one sample to the window
+     * @param acc Accumulators
+     * @param sample 12-bit ADC sample
+     * @param time_us Device time of the sample, kept if it is the first
+     */
+    void summary_add(summary_acc_t *acc, uint16_t sample, uint64_t time_us);
+
+    /**
+     * @brief Reduce the accumulators to the statistics of the window
+     * @param acc Accumulators holding 1 to 65535 samples
+     * @param frac_bits Fractional bits of mean and RMS, up to
+     * SUMMARY_MAX_FRAC_BITS
+     * @param out Statistics
+     */
+    void summary_finish(const summary_acc_t *acc, unsigned frac_bits, summary_t *out);
+
+    /**
+     * @brief Integer square root
+     * @param value Radicand
+     * @return floor(sqrt(value))
+     */
+    uint32_t summary_isqrt(uint64_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SUMMARY_H */
+
+/** End of Summary group */
+/** @} */
@@ -0,0 +1,43 @@
+/**
+ * @file crc32c.h
+ * @brief CRC32C (Castagnoli) checksum used for data packet integrity
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+/**
+ * @defgroup CRC32C CRC32C
+ * @{
+ */
+
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Update a CRC32C checksum with more data
+     * @details Uses a slice-by-8 table lookup (8 KB of constant tables kept in
+     * flash), processing eight bytes per iteration. The result is compatible with
+     * the SSE4.2 `crc32` instruction and common host libraries.
+     * @param crc Previous checksum, 0 for the first block
+     * @param data Data to checksum
+     * @param len Data length in bytes
+     * @return Updated checksum
+     */
+    uint32_t crc32c_update(uint32_t crc, const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CRC32C_H */
+
+/** End of CRC32C group */
+/** @} */
@@ -0,0 +1,125 @@
+/**
+ * @file net_pool.h
+ * @brief Estimate of the network stack memory held by sent datagrams
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+/**
+ * @defgroup NetPool Network Pool
+ * @{
+ */
+
+#ifndef NET_POOL_H
+#define NET_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Pool bytes a datagram holds besides its payload: frame headers and block header */
+#define NET_POOL_FRAME_OVERHEAD 56U
+/** Wire bytes of a datagram besides its payload: headers, FCS, preamble and gap */
+#define NET_POOL_WIRE_OVERHEAD 66U
+/** Wire bytes of the shortest frame, which short datagrams are padded to */
+#define NET_POOL_WIRE_MIN 84U
+/** Pool bytes left to received frames: two full-size Ethernet frames */
+#define NET_POOL_RX_RESERVE (2U * (1514U + NET_POOL_FRAME_OVERHEAD))
+/** Room net_pool_wait_us() leaves for senders that do not wait: one full frame */
+#define NET_POOL_WAIT_HEADROOM (1514U + NET_POOL_FRAME_OVERHEAD)
+
+    /**
+     * @brief Send buffer ledger
+     * @details A sent datagram is charged with its payload plus
+     * NET_POOL_FRAME_OVERHEAD and paid back at the link rate, the pace at which
+     * the stack can hand frames to the wire. A frame takes more bytes on the wire
+     * than in the pool, so it is charged its wire size when that is larger;
+     * otherwise a sustained overload would be paid back faster than the link
+     * frees the memory. The level is kept in millionths of a
+     * byte, as in the pacer. Not thread safe, callers hold their own lock.
+     */
+    typedef struct
+    {
+        uint32_t size;    /**< Bytes sends may hold, 0 = unlimited */
+        uint32_t drain;   /**< Bytes per second freed by the link */
+        int64_t  used;    /**< Bytes held times 1e6 */
+        uint64_t last_us; /**< Time used was last drained */
+        uint32_t peak;    /**< Most bytes held at once */
+        uint32_t refused; /**< Datagrams refused for lack of room */
+    } net_pool_t;
+
+    /**
+     * @brief Reset a ledger to empty
+     * @param pool Ledger
+     * @param size Bytes sends may hold, 0 for unlimited
+     * @param drain_bytes_per_s Link rate in bytes per second
+     * @param now_us Current time in microseconds
+     */
+    void net_pool_init(
+        net_pool_t *pool, uint32_t size, uint32_t drain_bytes_per_s, uint64_t now_us
+    );
+
+    /**
+     * @brief Change the link rate, e.g. after the link renegotiated
+     * @param pool Ledger
+     * @param drain_bytes_per_s Link rate in bytes per second
+     * @param now_us Current time in microseconds
+     */
+    void
+    net_pool_set_drain(net_pool_t *pool, uint32_t drain_bytes_per_s, uint64_t now_us);
+
+    /**
+     * @brief Charge one datagram if it fits
+     * @param pool Ledger
+     * @param len Payload length
+     * @param now_us Current time in microseconds
+     * @return true if charged, false if refused (counted in refused)
+     */
+    bool net_pool_take(net_pool_t *pool, size_t len, uint64_t now_us);
+
+    /**
+     * @brief Pay back a datagram charged by net_pool_take() that was not sent
+     * @details For a send the stack refused, e.g. for want of a buffer, so the
+     * ledger does not count memory nothing holds. peak is left as it was.
+     * @param pool Ledger
+     * @param len Payload length it was charged with
+     * @param now_us Current time in microseconds
+     */
+    void net_pool_refund(net_pool_t *pool, size_t len, uint64_t now_us);
+
+    /**
+     * @brief Microseconds until count datagrams of len bytes fit
+     * @details Waiting senders are admitted only while NET_POOL_WAIT_HEADROOM
+     * bytes stay free, so a bulk sender that waits here cannot starve senders that
+     * go straight to net_pool_take(). A request larger than that waits for the
+     * pool to empty.
+     * @param pool Ledger
+     * @param len Payload length of each datagram
+     * @param count Number of datagrams
+     * @param now_us Current time in microseconds
+     * @return 0 if they fit now
+     */
+    uint32_t
+    net_pool_wait_us(net_pool_t *pool, size_t len, size_t count, uint64_t now_us);
+
+    /**
+     * @brief Bytes held right now
+     * @param pool Ledger
+     * @param now_us Current time in microseconds
+     * @return Bytes held, rounded up
+     */
+    uint32_t net_pool_used(net_pool_t *pool, uint64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NET_POOL_H */
+
+/** End of NetPool group */
+/** @} */
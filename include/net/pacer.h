@@ -0,0 +1,81 @@
+/**
+ * @file pacer.h
+ * @brief Token-bucket pacer limiting the byte and packet rate of a stream
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+/**
+ * @defgroup Pacer Pacer
+ * @{
+ */
+
+#ifndef PACER_H
+#define PACER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Bucket capacity in milliseconds of the configured rate */
+#define PACER_BURST_MS 20U
+
+    /**
+     * @brief One token bucket
+     * @details The level is kept in millionths of a token, so refilling by
+     * elapsed microseconds times the rate per second needs no division.
+     */
+    typedef struct
+    {
+        uint32_t rate;  /**< Tokens per second, 0 = unlimited */
+        uint32_t burst; /**< Bucket capacity in tokens */
+        int64_t  level; /**< Available tokens times 1e6, negative while in debt */
+    } pacer_bucket_t;
+
+    /**
+     * @brief Pacer state, one bucket for bytes and one for packets
+     */
+    typedef struct
+    {
+        pacer_bucket_t bytes;   /**< Byte rate limit */
+        pacer_bucket_t packets; /**< Packet rate limit */
+        uint64_t       last_us; /**< Time of the last refill */
+    } pacer_t;
+
+    /**
+     * @brief Set the pacer rates and fill both buckets
+     * @param pacer Pacer state
+     * @param bytes_per_s Byte rate limit, 0 for unlimited
+     * @param packets_per_s Packet rate limit, 0 for unlimited
+     * @param now_us Current time in microseconds
+     */
+    void pacer_init(
+        pacer_t *pacer, uint32_t bytes_per_s, uint32_t packets_per_s, uint64_t now_us
+    );
+
+    /**
+     * @brief Take tokens for a send if both buckets allow it
+     * @details A send larger than a bucket is admitted once the bucket is full
+     * and leaves it in debt, so oversized sends are slowed down rather than
+     * blocked forever.
+     * @param pacer Pacer state
+     * @param bytes Bytes about to be sent
+     * @param packets Packets about to be sent
+     * @param now_us Current time in microseconds
+     * @return 0 if the tokens were taken, otherwise the microseconds to wait
+     * before trying again
+     */
+    uint32_t
+    pacer_reserve(pacer_t *pacer, uint32_t bytes, uint32_t packets, uint64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PACER_H */
+
+/** End of Pacer group */
+/** @} */
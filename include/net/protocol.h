@@ -22,17 +22,60 @@
  *
  * DATA PACKET (MSG_TYPE = 0x10)
  * +--------+--------+--------+--------+--------+--------+--------+---
- * |      HEADER (7B)        |CHANNEL |RESERVED|SAMPLE_CNT (2B)  | ...
+ * |      HEADER (7B)        |CHANNEL | FLAGS  |SAMPLE_CNT (2B)  | ...
  * +--------+--------+--------+--------+--------+--------+--------+---
- * |                         |   ch   |  0x00  | cnt_lo | cnt_hi | samples[]
+ * |                         |   ch   | flags  | cnt_lo | cnt_hi | samples[]
  * +--------+--------+--------+--------+--------+--------+--------+---
  *                              +7       +8       +9       +10      +11...
  *
- * SAMPLES ARRAY (each sample 2 bytes, little-endian)
+ * SAMPLES ARRAY (each sample 2 bytes, little-endian, 4 fractional bits if
+ * FLAGS & PROTOCOL_DATA_FLAG_FRAC4)
  * +--------+--------+--------+--------+--------+--------+
  * | sample[0] (2B)  | sample[1] (2B)  | sample[N] (2B)  |
  * +--------+--------+--------+--------+--------+--------+
  *
+ * TIMESTAMP TRAILER (FLAGS & PROTOCOL_DATA_FLAG_TIMESTAMP), device time of sample[0]
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ * |                      TIMESTAMP_US (8B, little-endian)                 |
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ *
+ * CRC32C TRAILER (only if FLAGS & PROTOCOL_DATA_FLAG_CRC32C)
+ * +--------+--------+--------+--------+
+ * |     CRC32C over header+payload    |
+ * +--------+--------+--------+--------+
+ *
+ * SUMMARY PACKET (MSG_TYPE = 0x11), one window in ACQ_MODE_SUMMARY
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ * |CHANNEL | FLAGS  |SAMPLE_CNT (2B)  |    MIN (2B)     |    MAX (2B)     |
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ * |  MEAN (2B, Q12.4)  |  RMS (2B, Q12.4)  |  TIMESTAMP_US (8B, LE) ...    |
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ *   +7 ... +26, then the optional CRC32C trailer (FLAGS as in DATA PACKET)
+ *
+ * SPECTRUM PACKET (MSG_TYPE = 0x12), FFT magnitudes in ACQ_MODE_SPECTRUM
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ * |CHANNEL | FLAGS  |FFT_SIZE (2B)    | FRAMES (2B)     |BIN_COUNT (2B)   |
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ * |            TIMESTAMP_US (8B, little-endian)           | bins[] (2B each)
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ *   +7 ... +22, bins from +23, then the optional CRC32C trailer
+ *
+ * EVENT PACKET (MSG_TYPE = 0x13), detected pulses in ACQ_MODE_EVENT
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ * |CHANNEL | FLAGS  |EVENT_CNT (2B)   |  TIMESTAMP_US (8B, LE) ...        |
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ * |   OFFSET_US (4B)  |  PEAK (2B)  |  WIDTH (2B)  |    AREA (4B)   | ...
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ *   +7 ... +18, 12-byte events from +19, then the optional CRC32C trailer
+ *
+ * CAPTURE PACKET (MSG_TYPE = 0x14), reply to CMD_CAPTURE and CMD_CAPTURE_READ
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ * |CHANNEL | FLAGS  | STATE  |OVERRUNS|   TOTAL (2B)    |   OFFSET (2B)   |
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ * |SAMPLE_CNT (2B)  | SAMPLE_RATE (4B, mHz)             | TIMESTAMP_US ...
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ *   +7 ... +28, samples from +29, then the optional CRC32C trailer
+ *
  * COMMAND PACKET (MSG_TYPE = 0x20)
  * +--------+--------+--------+--------+--------+--------+--------+
  * |      HEADER (7B)        |  CMD   |PARAM_T |   PARAM (2B)    |
@@ -54,6 +97,38 @@
  * | upt[0] | upt[1] | upt[2] | upt[3] | smp[0] | smp[1] | smp[2] | smp[3] |
  * +--------+--------+--------+--------+--------+--------+--------+--------+
  *   +11      +12      +13      +14      +15      +16      +17      +18
+ * +--------+--------+--------+--------+
+ * |     SAMPLE_RATE_MHZ (4B, mHz)     |
+ * +--------+--------+--------+--------+
+ *   +19      +20      +21      +22
+ *
+ * CONFIG PACKET (MSG_TYPE = 0x21), sequence of TLV entries
+ * +--------+--------+--------+--------+--------+--------+--------+---
+ * |      HEADER (7B)        |PARAM_T |  LEN   | VALUE (LEN bytes, LE)    | ...
+ * +--------+--------+--------+--------+--------+--------+--------+---
+ * |                         |  type  | 1..4   | val[0] ... val[LEN-1]    | next TLV
+ * +--------+--------+--------+--------+--------+--------+--------+---
+ *                              +7       +8       +9...
+ *
+ * SYNC REQUEST PACKET (MSG_TYPE = 0x03)
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ * |                  HOST_T1 (8B, opaque, echoed back)                    |
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ *   +7 ... +14
+ *
+ * SYNC RESPONSE PACKET (MSG_TYPE = 0x04)
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ * |                       HOST_T1 (8B, echoed)                            |
+ * |                 DEVICE_RX_US (8B, request arrival time)               |
+ * |                 DEVICE_TX_US (8B, response departure time)            |
+ * +--------+--------+--------+--------+--------+--------+--------+--------+
+ *   +7 ... +30
+ *
+ * TELEMETRY PACKET (MSG_TYPE = 0x31), repeated until PAYLOAD_LEN is consumed
+ * +--------+--------+--------+---
+ * |   ID   | VALUE (LEB128, 1-5B) | ...
+ * +--------+--------+--------+---
+ *   +7       +8...
  *
  * PING/PONG PACKET (MSG_TYPE = 0x01 / 0x02)
  * +--------+--------+--------+--------+--------+--------+--------+
@@ -78,19 +153,55 @@ extern "C"
 
 /** Maximum data payload size */
 #define PROTOCOL_MAX_DATA_SIZE 1400
+/** Maximum number of samples in one capture packet */
+#define PROTOCOL_CAPTURE_CHUNK_SAMPLES 512
 /** Protocol magic number for packet identification */
 #define PROTOCOL_MAGIC 0xDA7A
+/** Maximum number of TLV entries in a single MSG_TYPE_CONFIG packet */
+#define PROTOCOL_MAX_CONFIG_ENTRIES 8
+/** Maximum length of a single TLV value in bytes */
+#define PROTOCOL_CONFIG_VALUE_MAX_LEN 4
+/** Size of the TLV entry header (type + length) in bytes */
+#define PROTOCOL_CONFIG_TLV_HEADER_SIZE 2
+/** Longest request a host sends: a MSG_TYPE_CONFIG with every TLV entry */
+#define PROTOCOL_MAX_REQUEST_SIZE                                                      \
+    (sizeof(protocol_header_t) +                                                       \
+     PROTOCOL_MAX_CONFIG_ENTRIES *                                                     \
+         (PROTOCOL_CONFIG_TLV_HEADER_SIZE + PROTOCOL_CONFIG_VALUE_MAX_LEN))
+/** Data packet flag: a CRC32C trailer follows the samples */
+#define PROTOCOL_DATA_FLAG_CRC32C (1U << 0)
+/** Size of the optional CRC32C trailer in bytes */
+#define PROTOCOL_CRC32C_SIZE 4
+/** Data packet flag: an 8-byte device timestamp of the first sample follows */
+#define PROTOCOL_DATA_FLAG_TIMESTAMP (1U << 1)
+/** Size of the data packet timestamp trailer in bytes */
+#define PROTOCOL_TIMESTAMP_SIZE 8
+/** Data packet flag: samples are decimated and carry 4 fractional bits */
+#define PROTOCOL_DATA_FLAG_FRAC4 (1U << 2)
+/** Fractional bits of the mean and RMS fields of a summary packet */
+#define PROTOCOL_SUMMARY_FRAC_BITS 4
+/** Maximum encoded size of one telemetry entry (ID + 32-bit LEB128 value) */
+#define PROTOCOL_TELEMETRY_ENTRY_MAX_SIZE 6
 
     /**
      * @brief Protocol message types
      */
     typedef enum
     {
-        MSG_TYPE_PING   = 0x01, /**< Ping request */
-        MSG_TYPE_PONG   = 0x02, /**< Pong response */
-        MSG_TYPE_DATA   = 0x10, /**< ADC data packet */
-        MSG_TYPE_CMD    = 0x20, /**< Command from host */
-        MSG_TYPE_STATUS = 0x30  /**< Status report */
+        MSG_TYPE_PING      = 0x01, /**< Ping request */
+        MSG_TYPE_PONG      = 0x02, /**< Pong response */
+        MSG_TYPE_SYNC_REQ  = 0x03, /**< Clock synchronization request */
+        MSG_TYPE_SYNC_RESP = 0x04, /**< Clock synchronization response */
+        MSG_TYPE_DATA      = 0x10, /**< ADC data packet */
+        MSG_TYPE_SUMMARY   = 0x11, /**< Per-window ADC statistics */
+        MSG_TYPE_SPECTRUM  = 0x12, /**< FFT magnitude bins */
+        MSG_TYPE_EVENT     = 0x13, /**< Detected pulses */
+        MSG_TYPE_CAPTURE   = 0x14, /**< Burst capture state and samples */
+        MSG_TYPE_GAP       = 0x15, /**< Data stream resumed after a link outage */
+        MSG_TYPE_CMD       = 0x20, /**< Command from host */
+        MSG_TYPE_CONFIG    = 0x21, /**< Multi-parameter TLV configuration from host */
+        MSG_TYPE_STATUS    = 0x30, /**< Status report */
+        MSG_TYPE_TELEMETRY = 0x31  /**< Telemetry counters */
     } protocol_msg_type_t;
 
     /**
@@ -98,10 +209,13 @@ extern "C"
      */
     typedef enum
     {
-        CMD_START_ACQ  = 0x01, /**< Start data acquisition */
-        CMD_STOP_ACQ   = 0x02, /**< Stop data acquisition */
-        CMD_GET_STATUS = 0x03, /**< Request status */
-        CMD_CONFIGURE  = 0x04  /**< Configure measurement parameters */
+        CMD_START_ACQ     = 0x01, /**< Start data acquisition */
+        CMD_STOP_ACQ      = 0x02, /**< Stop data acquisition */
+        CMD_GET_STATUS    = 0x03, /**< Request status */
+        CMD_CONFIGURE     = 0x04, /**< Configure measurement parameters */
+        CMD_GET_TELEMETRY = 0x05, /**< Request telemetry counters */
+        CMD_CAPTURE       = 0x06, /**< Start a burst capture of PARAM samples */
+        CMD_CAPTURE_READ  = 0x07  /**< Read captured samples from offset PARAM */
     } protocol_cmd_t;
 
     /**
@@ -132,24 +246,129 @@ extern "C"
     typedef struct __attribute__((packed))
     {
         uint8_t  channel;      /**< ADC channel */
-        uint8_t  reserved;     /**< Reserved for alignment */
+        uint8_t  flags;        /**< PROTOCOL_DATA_FLAG_* bits */
         uint16_t sample_count; /**< Number of samples */
         uint16_t samples[];    /**< ADC samples (flexible array) */
     } protocol_data_payload_t;
 
+    /**
+     * @brief Summary payload, statistics of one window of samples
+     * @details Mean and RMS are in ADC counts with PROTOCOL_SUMMARY_FRAC_BITS
+     * fractional bits. The window covers every sample, regardless of threshold.
+     */
+    typedef struct __attribute__((packed))
+    {
+        uint8_t  channel;      /**< ADC channel */
+        uint8_t  flags;        /**< PROTOCOL_DATA_FLAG_* bits */
+        uint16_t sample_count; /**< Samples in the window */
+        uint16_t min;          /**< Smallest sample */
+        uint16_t max;          /**< Largest sample */
+        uint16_t mean;         /**< Mean, Q12.4 ADC counts */
+        uint16_t rms;          /**< Root mean square, Q12.4 ADC counts */
+        uint64_t timestamp_us; /**< Device time of the first sample */
+    } protocol_summary_payload_t;
+
+    /**
+     * @brief Spectrum payload, averaged FFT magnitudes of one or more frames
+     */
+    typedef struct __attribute__((packed))
+    {
+        uint8_t  channel;      /**< ADC channel */
+        uint8_t  flags;        /**< PROTOCOL_DATA_FLAG_* bits */
+        uint16_t fft_size;     /**< Samples per FFT frame */
+        uint16_t frame_count;  /**< Frames averaged into the bins */
+        uint16_t bin_count;    /**< Number of bins */
+        uint64_t timestamp_us; /**< Device time of the first sample */
+        uint16_t bins[];       /**< Magnitudes, bin k at k / fft_size of the rate */
+    } protocol_spectrum_payload_t;
+
+    /**
+     * @brief One detected pulse of an event packet
+     */
+    typedef struct __attribute__((packed))
+    {
+        uint32_t offset_us; /**< Pulse start relative to the packet timestamp */
+        uint16_t peak;      /**< Largest sample of the pulse */
+        uint16_t width;     /**< Samples above threshold */
+        uint32_t area;      /**< Sum of (sample - threshold) over the pulse */
+    } protocol_event_t;
+
+    /**
+     * @brief Event payload, pulses detected above the threshold
+     */
+    typedef struct __attribute__((packed))
+    {
+        uint8_t          channel;      /**< ADC channel */
+        uint8_t          flags;        /**< PROTOCOL_DATA_FLAG_* bits */
+        uint16_t         event_count;  /**< Number of events */
+        uint64_t         timestamp_us; /**< Device time of the first pulse start */
+        protocol_event_t events[];     /**< Events, oldest first */
+    } protocol_event_payload_t;
+
+    /**
+     * @brief Capture payload, state of a burst capture and one chunk of it
+     */
+    typedef struct __attribute__((packed))
+    {
+        uint8_t  channel;      /**< ADC channel */
+        uint8_t  flags;        /**< PROTOCOL_DATA_FLAG_* bits */
+        uint8_t  state;        /**< acquisition_capture_state_t */
+        uint8_t  overruns;     /**< Conversions lost during the capture */
+        uint16_t total;        /**< Samples in the whole capture */
+        uint16_t offset;       /**< Index of the first sample of this chunk */
+        uint16_t sample_count; /**< Samples in this chunk */
+        uint32_t sample_rate;  /**< Capture sample rate in millihertz */
+        uint64_t timestamp_us; /**< Device time of the first captured sample */
+        uint16_t samples[];    /**< Samples offset to offset + sample_count - 1 */
+    } protocol_capture_payload_t;
+
+    /**
+     * @brief Gap payload, sent when the data stream resumes after a link outage
+     * @details Packets built while the link was down are held and sent before
+     * this packet. Those that did not fit were dropped, so their sequence numbers
+     * are missing from the stream.
+     */
+    typedef struct __attribute__((packed))
+    {
+        uint32_t outage_ms;    /**< Time the stream was held */
+        uint32_t held;         /**< Packets held and sent late */
+        uint32_t dropped;      /**< Packets dropped because the backlog was full */
+        uint64_t timestamp_us; /**< Device time when the first packet was held */
+    } protocol_gap_payload_t;
+
     /**
      * @brief Configuration parameter types for CMD_CONFIGURE
      */
     typedef enum
     {
-        CONFIG_THRESHOLD_PERCENT = 0, /**< Threshold as percentage (0-100) */
-        CONFIG_THRESHOLD_MV      = 1, /**< Threshold in millivolts (0-3300) */
-        CONFIG_BATCH_SIZE        = 2, /**< Batch size, samples per packet (1-500) */
-        CONFIG_CHANNEL           = 3, /**< ADC channel (0-7) */
-        CONFIG_RESET_SEQUENCE    = 4, /**< Reset sequence counter (param ignored) */
-        CONFIG_LOG_LEVEL         = 5  /**< Set log level (0=DEBUG..5=NONE) */
+        CONFIG_THRESHOLD_PERCENT  = 0,  /**< Threshold as percentage (0-100) */
+        CONFIG_THRESHOLD_MV       = 1,  /**< Threshold in millivolts (0-3300) */
+        CONFIG_BATCH_SIZE         = 2,  /**< Batch size, samples per packet (1-500) */
+        CONFIG_CHANNEL            = 3,  /**< ADC channel (0-7) */
+        CONFIG_RESET_SEQUENCE     = 4,  /**< Reset sequence counter (param ignored) */
+        CONFIG_LOG_LEVEL          = 5,  /**< Set log level (0=DEBUG..5=NONE) */
+        CONFIG_DATA_CRC           = 6,  /**< Append CRC32C to data packets (0/1) */
+        CONFIG_MCAST_GROUP        = 7,  /**< IPv4 multicast group, MSB first (0=off) */
+        CONFIG_MCAST_PORT         = 8,  /**< Multicast destination port (1-65535) */
+        CONFIG_ACQ_MODE           = 9,  /**< Acquisition mode (acquisition_mode_t) */
+        CONFIG_SUMMARY_WINDOW     = 10, /**< Samples per summary window (1-65535) */
+        CONFIG_SPECTRUM_AVERAGE   = 11, /**< FFT frames averaged per packet (1-256) */
+        CONFIG_DECIMATION         = 12, /**< CIC decimation ratio, 1 = off (1-64) */
+        CONFIG_EVENT_DEAD_TIME    = 13, /**< Samples ignored after a pulse (0-65535) */
+        CONFIG_SAMPLE_RATE_HZ     = 14, /**< ADC sample rate in Hz (1-20000) */
+        CONFIG_PACE_BYTES_PER_S   = 15, /**< Data stream byte rate limit, 0 = off */
+        CONFIG_PACE_PACKETS_PER_S = 16  /**< Data stream packet rate limit, 0 = off */
     } protocol_config_param_t;
 
+    /**
+     * @brief Single decoded entry of a MSG_TYPE_CONFIG packet
+     */
+    typedef struct
+    {
+        uint8_t  param_type; /**< Parameter type (protocol_config_param_t) */
+        uint32_t value;      /**< Parameter value */
+    } protocol_config_entry_t;
+
     /**
      * @brief Command payload
      */
@@ -170,8 +389,88 @@ extern "C"
         uint16_t threshold_mv; /**< Current threshold in millivolts */
         uint32_t uptime;       /**< System uptime in seconds */
         uint32_t samples_sent; /**< Total samples sent */
+        uint32_t sample_rate;  /**< Achieved ADC sample rate in millihertz */
     } protocol_status_payload_t;
 
+    /**
+     * @brief Telemetry entry identifiers
+     * @note The high nibble groups entries by source. Identifiers are never
+     * reused, so hosts can skip the ones they do not know.
+     */
+    typedef enum
+    {
+        TELEM_UPTIME_MS          = 0x01, /**< Time since kernel start in ms */
+        TELEM_CPU_LOAD           = 0x02, /**< CPU load in permille over the last 1 s */
+        TELEM_ACQ_SAMPLES        = 0x10, /**< Samples above threshold collected */
+        TELEM_ACQ_SAMPLES_SENT   = 0x11, /**< Samples handed to the network */
+        TELEM_ACQ_PACKETS_SENT   = 0x12, /**< Data packets handed to the network */
+        TELEM_ACQ_ERRORS         = 0x13, /**< ADC and packet errors */
+        TELEM_ACQ_ADC_OVERRUNS   = 0x14, /**< Samples lost to a full ADC buffer */
+        TELEM_NET_PACKETS_SENT   = 0x20, /**< UDP datagrams sent */
+        TELEM_NET_PACKETS_RECV   = 0x21, /**< UDP datagrams received */
+        TELEM_NET_BYTES_SENT     = 0x22, /**< UDP payload bytes sent */
+        TELEM_NET_BYTES_RECV     = 0x23, /**< UDP payload bytes received */
+        TELEM_NET_ERRORS         = 0x24, /**< Network task errors */
+        TELEM_NET_SUBSCRIBERS    = 0x25, /**< Active data subscribers */
+        TELEM_NET_PACED          = 0x26, /**< Data sends held back by pacer or pool */
+        TELEM_NET_PACED_MS       = 0x27, /**< Time the data path waited for either */
+        TELEM_NET_OUTAGES        = 0x28, /**< Link outages ridden out */
+        TELEM_NET_HELD           = 0x29, /**< Data packets held during outages */
+        TELEM_NET_HELD_DROPPED   = 0x2A, /**< Data packets dropped, backlog full */
+        TELEM_NET_ARP_RESOLVE_US = 0x2B, /**< Last subscriber ARP resolution time */
+        TELEM_NET_ARP_FAILED     = 0x2C, /**< Subscribers not resolved in time */
+        TELEM_SOCK_RX_DROPPED    = 0x30, /**< Datagrams dropped by the socket layer */
+        TELEM_SOCK_RX_QUEUED     = 0x31, /**< Datagrams waiting in the receive queues */
+        TELEM_SOCK_RX_QUEUE_SIZE = 0x32, /**< Receive queue capacity of both sockets */
+        TELEM_SOCK_TX_POOL_SIZE  = 0x33, /**< Stack memory sends may hold */
+        TELEM_SOCK_TX_POOL_USED  = 0x34, /**< Stack memory held by sends (estimate) */
+        TELEM_SOCK_TX_POOL_PEAK  = 0x35, /**< High-water mark of TX_POOL_USED */
+        TELEM_SOCK_TX_REFUSED    = 0x36, /**< Sends refused before the pool ran out */
+        TELEM_SOCK_RX_REJECTED   = 0x37, /**< Datagrams refused as too long or junk */
+        TELEM_LOG_MESSAGES       = 0x40, /**< Log messages written */
+        TELEM_LOG_DROPPED        = 0x41, /**< Log messages lost (busy or UART error) */
+        TELEM_LOG_TRUNCATED      = 0x42, /**< Log messages cut to the buffer size */
+        TELEM_LOG_BYTES          = 0x43, /**< Bytes written to the UART */
+        TELEM_STACK_NETWORK      = 0x50, /**< Unused stack of the network task */
+        TELEM_STACK_ACQUISITION  = 0x51, /**< Unused stack of the acquisition task */
+        TELEM_STACK_IDLE         = 0x52, /**< Unused stack of the RTX idle thread */
+        TELEM_STACK_TIMER        = 0x53, /**< Unused stack of the RTX timer thread */
+        TELEM_BOOT_LOGGER        = 0x60, /**< Boot time to logger ready in us */
+        TELEM_BOOT_NET_STACK     = 0x61, /**< Boot time to network stack ready in us */
+        TELEM_BOOT_KERNEL        = 0x62, /**< Boot time to kernel start in us */
+        TELEM_BOOT_LINK_UP       = 0x63, /**< Boot time to first link up in us */
+        TELEM_BOOT_NET_READY     = 0x64, /**< Boot time to socket ready in us */
+        TELEM_BOOT_FIRST_SAMPLE  = 0x65, /**< Boot time to first ADC sample in us */
+        TELEM_BOOT_FIRST_SEND    = 0x66  /**< Boot time to first data packet in us */
+    } protocol_telemetry_id_t;
+
+    /**
+     * @brief Single telemetry entry before encoding
+     */
+    typedef struct
+    {
+        uint8_t  id;    /**< Entry identifier (protocol_telemetry_id_t) */
+        uint32_t value; /**< Entry value */
+    } protocol_telemetry_entry_t;
+
+    /**
+     * @brief Clock synchronization request payload
+     */
+    typedef struct __attribute__((packed))
+    {
+        uint64_t host_t1; /**< Host send time, opaque to the device */
+    } protocol_sync_req_payload_t;
+
+    /**
+     * @brief Clock synchronization response payload
+     */
+    typedef struct __attribute__((packed))
+    {
+        uint64_t host_t1;      /**< Host send time echoed from the request */
+        uint64_t device_rx_us; /**< Device time when the request was received */
+        uint64_t device_tx_us; /**< Device time when the response was sent */
+    } protocol_sync_resp_payload_t;
+
     /**
      * @brief Complete packet structure
      */
@@ -187,19 +486,115 @@ extern "C"
      */
     protocol_status_t protocol_init(void);
 
+    /**
+     * @brief Enable or disable the CRC32C trailer on data packets
+     * @param enable true to append a CRC32C trailer to every data packet
+     */
+    void protocol_set_data_crc(bool enable);
+
+    /**
+     * @brief Check whether data packets carry a CRC32C trailer
+     * @return true if the trailer is enabled
+     */
+    bool protocol_get_data_crc(void);
+
     /**
      * @brief Build a data packet with ADC samples
+     * @note Appends a CRC32C trailer when enabled with protocol_set_data_crc()
      * @param buffer Output buffer
      * @param buffer_len Buffer size
      * @param channel ADC channel
      * @param samples Array of samples
      * @param sample_count Number of samples
+     * @param sample_flags PROTOCOL_DATA_FLAG_FRAC4 or 0
+     * @param timestamp_us Device time of the first sample (system_time_us())
      * @param out_len Pointer to store actual packet length
      * @return PROTO_STATUS_OK on success
      */
     protocol_status_t protocol_build_data_packet(
         uint8_t *buffer, size_t buffer_len, uint8_t channel, const uint16_t *samples,
-        uint16_t sample_count, size_t *out_len
+        uint16_t sample_count, uint8_t sample_flags, uint64_t timestamp_us,
+        size_t *out_len
+    );
+
+    /**
+     * @brief Build a summary packet
+     * @note Appends a CRC32C trailer when enabled with protocol_set_data_crc()
+     * @param buffer Output buffer
+     * @param buffer_len Buffer size
+     * @param summary Window statistics, flags are set by this function
+     * @param out_len Pointer to store actual packet length
+     * @return PROTO_STATUS_OK on success
+     */
+    protocol_status_t protocol_build_summary_packet(
+        uint8_t *buffer, size_t buffer_len, const protocol_summary_payload_t *summary,
+        size_t *out_len
+    );
+
+    /**
+     * @brief Build a spectrum packet
+     * @note Appends a CRC32C trailer when enabled with protocol_set_data_crc()
+     * @param buffer Output buffer
+     * @param buffer_len Buffer size
+     * @param channel ADC channel
+     * @param bins Magnitude bins
+     * @param bin_count Number of bins
+     * @param fft_size Samples per FFT frame
+     * @param frame_count Frames averaged into the bins
+     * @param timestamp_us Device time of the first sample (system_time_us())
+     * @param out_len Pointer to store actual packet length
+     * @return PROTO_STATUS_OK on success
+     */
+    protocol_status_t protocol_build_spectrum_packet(
+        uint8_t *buffer, size_t buffer_len, uint8_t channel, const uint16_t *bins,
+        uint16_t bin_count, uint16_t fft_size, uint16_t frame_count,
+        uint64_t timestamp_us, size_t *out_len
+    );
+
+    /**
+     * @brief Build an event packet
+     * @note Appends a CRC32C trailer when enabled with protocol_set_data_crc()
+     * @param buffer Output buffer
+     * @param buffer_len Buffer size
+     * @param channel ADC channel
+     * @param events Detected pulses, offsets relative to timestamp_us
+     * @param event_count Number of events
+     * @param timestamp_us Device time of the first pulse start (system_time_us())
+     * @param out_len Pointer to store actual packet length
+     * @return PROTO_STATUS_OK on success
+     */
+    protocol_status_t protocol_build_event_packet(
+        uint8_t *buffer, size_t buffer_len, uint8_t channel,
+        const protocol_event_t *events, uint16_t event_count, uint64_t timestamp_us,
+        size_t *out_len
+    );
+
+    /**
+     * @brief Build a capture packet
+     * @note Appends a CRC32C trailer when enabled with protocol_set_data_crc()
+     * @param buffer Output buffer
+     * @param buffer_len Buffer size
+     * @param info Payload fields, flags are set by the builder
+     * @param samples info->sample_count samples, may be NULL if there are none
+     * @param out_len Pointer to store actual packet length
+     * @return PROTO_STATUS_OK on success
+     */
+    protocol_status_t protocol_build_capture_packet(
+        uint8_t *buffer, size_t buffer_len, const protocol_capture_payload_t *info,
+        const uint16_t *samples, size_t *out_len
+    );
+
+    /**
+     * @brief Build a gap packet
+     * @param buffer Output buffer
+     * @param buffer_len Buffer size
+     * @param gap Outage summary
+     * @param out_len Pointer to store actual packet length
+     * @return PROTO_STATUS_OK on success
+     */
+    protocol_status_t protocol_build_gap_packet(
+        uint8_t *buffer, size_t buffer_len, const protocol_gap_payload_t *gap,
+        size_t *out_len
     );
 
     /**
@@ -222,6 +617,35 @@ extern "C"
     protocol_status_t
     protocol_build_pong(uint8_t *buffer, size_t buffer_len, size_t *out_len);
 
+    /**
+     * @brief Build a clock synchronization response packet
+     * @param buffer Output buffer
+     * @param buffer_len Buffer size
+     * @param sync Synchronization timestamps
+     * @param out_len Pointer to store actual packet length
+     * @return PROTO_STATUS_OK on success
+     */
+    protocol_status_t protocol_build_sync_response(
+        uint8_t *buffer, size_t buffer_len, const protocol_sync_resp_payload_t *sync,
+        size_t *out_len
+    );
+
+    /**
+     * @brief Build a telemetry packet
+     * @details Each entry is encoded as its ID byte followed by the value as an
+     * unsigned LEB128 varint, so small counters take two bytes.
+     * @param buffer Output buffer
+     * @param buffer_len Buffer size
+     * @param entries Entries to encode
+     * @param entry_count Number of entries
+     * @param out_len Pointer to store actual packet length
+     * @return PROTO_STATUS_OK on success
+     */
+    protocol_status_t protocol_build_telemetry(
+        uint8_t *buffer, size_t buffer_len, const protocol_telemetry_entry_t *entries,
+        size_t entry_count, size_t *out_len
+    );
+
     /**
      * @brief Build a status packet
      * @param buffer Output buffer
@@ -260,6 +684,34 @@ extern "C"
         const uint8_t *payload, size_t payload_len, protocol_cmd_payload_t *cmd
     );
 
+    /**
+     * @brief Check a configuration value against the documented limits of its type
+     * @param param_type Parameter type (protocol_config_param_t)
+     * @param value Parameter value
+     * @return true if the type is known and the value is accepted
+     */
+    bool protocol_config_value_valid(uint8_t param_type, uint32_t value);
+
+    /**
+     * @brief Parse and validate a TLV configuration payload
+     * @details The whole payload is validated before anything is returned: every
+     * entry must be well formed, have a known parameter type, carry a value
+     * accepted by protocol_config_value_valid() and appear at most once. On
+     * failure no entries are reported, so the caller can apply the result as a
+     * single atomic update.
+     * @param payload Payload data
+     * @param payload_len Payload length
+     * @param entries Array to store decoded entries
+     * @param max_entries Capacity of the entries array
+     * @param entry_count Pointer to store number of decoded entries
+     * @return PROTO_STATUS_OK on success, PROTO_STATUS_INVALID_MSG if any entry is
+     * invalid
+     */
+    protocol_status_t protocol_parse_config(
+        const uint8_t *payload, size_t payload_len, protocol_config_entry_t *entries,
+        size_t max_entries, size_t *entry_count
+    );
+
     /**
      * @brief Get current sequence number
      * @return Current sequence number
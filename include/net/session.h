@@ -0,0 +1,136 @@
+/**
+ * @file session.h
+ * @brief Table of hosts subscribed to the acquisition data stream
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+/**
+ * @defgroup Session Session Table
+ * @{
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "udp_socket.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Maximum number of simultaneous data subscribers */
+#define SESSION_MAX_SUBSCRIBERS 4
+/** Channel mask selecting every ADC channel */
+#define SESSION_CHANNEL_ALL 0xFFu
+/** Lease value for subscribers that never expire */
+#define SESSION_LEASE_FOREVER 0u
+
+    /**
+     * @brief Session table status codes
+     */
+    typedef enum
+    {
+        SESSION_STATUS_OK            = 0, /**< Operation successful */
+        SESSION_STATUS_FULL          = 1, /**< No free subscriber slot */
+        SESSION_STATUS_NOT_FOUND     = 2, /**< Endpoint is not subscribed */
+        SESSION_STATUS_INVALID_PARAM = 3, /**< Invalid parameter */
+        SESSION_STATUS_NOT_INIT      = 4  /**< Module not initialized */
+    } session_status_t;
+
+    /**
+     * @brief Initialize the session table
+     * @return SESSION_STATUS_OK on success
+     */
+    session_status_t session_init(void);
+
+    /**
+     * @brief Add a subscriber or update an existing one
+     * @details A host that is already subscribed keeps its slot; its channel mask
+     * and lease are replaced.
+     * @param remote Subscriber endpoint
+     * @param channel_mask Bit N selects ADC channel N
+     * @param lease_ms Lease length in milliseconds, SESSION_LEASE_FOREVER for none
+     * @return SESSION_STATUS_OK on success, SESSION_STATUS_FULL if no slot is free
+     */
+    session_status_t session_subscribe(
+        const udp_endpoint_t *remote, uint8_t channel_mask, uint32_t lease_ms
+    );
+
+    /**
+     * @brief Remove a subscriber
+     * @param remote Subscriber endpoint
+     * @return SESSION_STATUS_OK on success, SESSION_STATUS_NOT_FOUND if not subscribed
+     */
+    session_status_t session_unsubscribe(const udp_endpoint_t *remote);
+
+    /**
+     * @brief Extend the lease of a subscriber
+     * @details Called for every valid packet, so any traffic from a host (pings,
+     * clock synchronization, status requests) keeps its subscription alive.
+     * @param remote Endpoint the packet came from
+     * @return true if the endpoint is subscribed
+     */
+    bool session_touch(const udp_endpoint_t *remote);
+
+    /**
+     * @brief Restart the lease of every subscriber
+     * @details Used when the link comes back, since hosts could not renew their
+     * leases while it was down.
+     */
+    void session_renew_all(void);
+
+    /**
+     * @brief Drop subscribers whose lease has run out
+     * @return Number of subscribers removed
+     */
+    size_t session_expire(void);
+
+    /**
+     * @brief Publish to a multicast group instead of each subscriber
+     * @details While a group is set, session_get_targets() returns only the group
+     * endpoint, so every packet is sent once regardless of the number of hosts.
+     * Subscribers still keep the acquisition running through their leases.
+     * @param group Multicast endpoint, NULL to go back to unicast fan-out
+     * @return SESSION_STATUS_OK on success
+     */
+    session_status_t session_set_multicast(const udp_endpoint_t *group);
+
+    /**
+     * @brief Get the number of active subscribers
+     * @return Subscriber count
+     */
+    size_t session_count(void);
+
+    /**
+     * @brief Check if any subscriber uses an IP address, on whatever port
+     * @param ip IPv4 address
+     * @return true if at least one subscriber has that address
+     */
+    bool session_has_host(const udp_ipv4_addr_t *ip);
+
+    /**
+     * @brief Copy the endpoints subscribed to a channel
+     * @details The copy lets the caller send without holding the table lock. In
+     * multicast mode the group is the only target while anyone is subscribed.
+     * @param channel ADC channel of the data to send
+     * @param targets Output array of endpoints
+     * @param max_targets Capacity of targets
+     * @return Number of endpoints stored in targets
+     */
+    size_t
+    session_get_targets(uint8_t channel, udp_endpoint_t *targets, size_t max_targets);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SESSION_H */
+
+/** End of Session group */
+/** @} */
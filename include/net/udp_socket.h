@@ -26,7 +26,7 @@ extern "C"
 #define UDP_MAX_PAYLOAD_SIZE 1452u
 /** Default receive timeout in milliseconds. Zero means no timeout */
 #define UDP_DEFAULT_RECV_TIMEOUT 1000
-/** Number of UDP receive queue length */
+/** Default length of a socket's receive queue */
 #define UDP_RX_QUEUE_LEN 5u
     /**
      * @brief UDP socket status codes
@@ -61,11 +61,68 @@ extern "C"
         uint16_t        port; /**< Port number in host order */
     } udp_endpoint_t;
 
+    /**
+     * @brief Receive path counters of a socket
+     */
+    typedef struct
+    {
+        uint32_t rx_dropped;    /**< Datagrams dropped (queue full or no buffer) */
+        uint32_t rx_rejected;   /**< Datagrams refused by length or filter */
+        uint32_t rx_queued;     /**< Datagrams waiting in the receive queue */
+        uint32_t rx_queue_size; /**< Receive queue capacity */
+    } udp_rx_stats_t;
+
+    /**
+     * @brief Send buffer counters of the module
+     */
+    typedef struct
+    {
+        uint32_t tx_pool_size; /**< Stack memory sends may hold, 0 = unlimited */
+        uint32_t tx_pool_used; /**< Estimated stack memory held by sent datagrams */
+        uint32_t tx_pool_peak; /**< Highest tx_pool_used since start */
+        uint32_t tx_refused;   /**< Datagrams refused before the pool ran out */
+    } udp_pool_stats_t;
+
+    /**
+     * @brief One datagram of a batched send
+     */
+    typedef struct
+    {
+        const udp_endpoint_t *remote; /**< Remote endpoint */
+        const uint8_t        *data;   /**< Data to send */
+        size_t                len;    /**< Length of data */
+    } udp_datagram_t;
+
     /**
      * @brief UDP socket handle
      */
     typedef struct udp_socket *udp_socket_handle_t;
 
+    /**
+     * @brief Filter deciding whether a received datagram is queued
+     * @details Runs in the network stack's receive path for every datagram, so it
+     * must be short and must not block.
+     * @param remote Remote endpoint information
+     * @param data Pointer to received data
+     * @param len Length of received data
+     * @param context filter_context of the socket's udp_rx_config_t
+     * @return true to queue the datagram, false to reject it
+     */
+    typedef bool (*udp_rx_filter_t)(
+        const udp_endpoint_t *remote, const uint8_t *data, size_t len, void *context
+    );
+
+    /**
+     * @brief Receive queue settings of a socket
+     */
+    typedef struct
+    {
+        uint32_t        queue_len;      /**< Datagrams the receive queue holds */
+        uint32_t        max_len;        /**< Longest datagram queued */
+        udp_rx_filter_t filter;         /**< Applied before queueing, NULL = none */
+        void           *filter_context; /**< Passed to the filter */
+    } udp_rx_config_t;
+
     /**
      * @brief Callback function type for received data
      * @param handle Socket handle
@@ -100,6 +157,21 @@ extern "C"
      */
     udp_status_t udp_socket_create(udp_socket_handle_t *handle, uint16_t local_port);
 
+    /**
+     * @brief Create a new UDP socket with its own receive queue settings
+     * @details Each socket owns its receive queue and buffers, so a flood on one
+     * port cannot take buffers from another. Datagrams longer than rx->max_len or
+     * refused by rx->filter are rejected before they take a buffer.
+     * @param handle Pointer to store socket handle
+     * @param local_port Local port to bind, 0 for auto-assign
+     * @param rx Receive queue settings, NULL for UDP_RX_QUEUE_LEN full-size
+     * buffers without a filter
+     * @return UDP_STATUS_OK on success
+     */
+    udp_status_t udp_socket_create_rx(
+        udp_socket_handle_t *handle, uint16_t local_port, const udp_rx_config_t *rx
+    );
+
     /**
      * @brief Close and destroy a UDP socket
      * @param handle Socket handle
@@ -120,6 +192,37 @@ extern "C"
         size_t len
     );
 
+    /**
+     * @brief Send several datagrams with one validation and link check
+     * @details The module, handle and link are checked once for the whole batch,
+     * then the datagrams are sent in order. A failed datagram does not stop the
+     * ones after it. Each datagram may have its own endpoint, so one packet can be
+     * fanned out to several subscribers in one call.
+     * @param handle Socket handle
+     * @param datagrams Datagrams to send
+     * @param count Number of datagrams
+     * @param results Array of count entries receiving the status of each datagram.
+     * When the whole batch is rejected, every entry holds the returned status
+     * @return UDP_STATUS_OK if the batch was sent, see results for each datagram
+     */
+    udp_status_t udp_socket_send_batch(
+        udp_socket_handle_t handle, const udp_datagram_t *datagrams, size_t count,
+        udp_status_t *results
+    );
+
+    /**
+     * @brief Time until the send buffer budget has room for a fan-out
+     * @details Every send is checked against a budget of network stack memory
+     * before a stack buffer is taken, and refused with UDP_STATUS_NO_MEMORY when
+     * it does not fit. Callers that would rather wait than lose the data sleep for
+     * the returned time and ask again.
+     * @param len Payload length of each datagram
+     * @param count Number of datagrams
+     * @return 0 if the datagrams fit now, otherwise the estimated microseconds
+     * until they do
+     */
+    uint32_t udp_socket_tx_wait_us(size_t len, size_t count);
+
     /**
      * @brief Send data to a remote endpoint
      * @param handle Socket handle
@@ -150,12 +253,98 @@ extern "C"
         size_t buffer_len, size_t *received, uint32_t timeout_ms
     );
 
+    /**
+     * @brief Receive data together with the time it arrived from the network stack
+     * @details Same as udp_socket_recv(), but also reports the system_time_us()
+     * value captured in the network stack callback, before the packet waited in
+     * the receive queue.
+     * @param handle Socket handle
+     * @param remote Pointer to store remote endpoint info, can be NULL
+     * @param buffer Buffer to store received data
+     * @param buffer_len Size of buffer
+     * @param received Pointer to store actual received length
+     * @param rx_time_us Pointer to store receive timestamp in microseconds, can be
+     * NULL
+     * @param timeout_ms Timeout in milliseconds. Zero means no wait, UINT32_MAX means
+     * infinite
+     * @return UDP_STATUS_OK on success, UDP_STATUS_TIMEOUT if no data
+     */
+    udp_status_t udp_socket_recv_timestamped(
+        udp_socket_handle_t handle, udp_endpoint_t *remote, uint8_t *buffer,
+        size_t buffer_len, size_t *received, uint64_t *rx_time_us, uint32_t timeout_ms
+    );
+
     /**
      * @brief Check if Ethernet link is up
      * @return true if link is up, false otherwise
      */
     bool udp_socket_is_link_up(void);
 
+    /**
+     * @brief Wait for the Ethernet link to come up
+     * @details Blocks on the link events of the network stack instead of polling,
+     * so the caller wakes as soon as the link is back.
+     * @param timeout_ms Timeout in milliseconds, osWaitForever to block
+     * @return true if the link is up, false on timeout
+     */
+    bool udp_socket_wait_for_link(uint32_t timeout_ms);
+
+    /**
+     * @brief Pin the ARP entry of a host, resolving its MAC address if needed
+     * @details Without a cached address the stack sends an ARP request on the
+     * first datagram and may drop the datagrams sent until the reply, and a lost
+     * request is only repeated after the ARP resend timeout. Resolving up front
+     * keeps that off the data path. The entry is fixed, so it is refreshed
+     * instead of aging out, until udp_socket_arp_unpin(). Does not wait for the
+     * reply; poll udp_socket_arp_cached() for it.
+     * @param ip IPv4 address on the local subnet
+     * @return UDP_STATUS_OK if the address is already resolved,
+     * UDP_STATUS_TIMEOUT if the reply is still pending (the stack keeps asking)
+     */
+    udp_status_t udp_socket_arp_pin(const udp_ipv4_addr_t *ip);
+
+    /**
+     * @brief Check if the MAC address of a host is in the ARP cache
+     * @param ip IPv4 address
+     * @return true if datagrams to the address leave without an ARP exchange
+     */
+    bool udp_socket_arp_cached(const udp_ipv4_addr_t *ip);
+
+    /**
+     * @brief Hand a pinned ARP entry back to the normal cache timeout
+     * @param ip IPv4 address pinned with udp_socket_arp_pin()
+     * @return UDP_STATUS_OK on success
+     */
+    udp_status_t udp_socket_arp_unpin(const udp_ipv4_addr_t *ip);
+
+    /**
+     * @brief Log the negotiated link parameters at debug level
+     */
+    void udp_socket_log_link_info(void);
+
+    /**
+     * @brief Log the state of the network driver below the stack at debug level
+     * @note Only meant for debugging the Ethernet driver, does nothing unless
+     * debug logging is enabled.
+     */
+    void udp_socket_log_driver_state(void);
+
+    /**
+     * @brief Get receive path counters of a socket
+     * @param handle Socket handle
+     * @param stats Pointer to store counters
+     * @return UDP_STATUS_OK on success
+     */
+    udp_status_t
+    udp_socket_get_rx_stats(udp_socket_handle_t handle, udp_rx_stats_t *stats);
+
+    /**
+     * @brief Get send buffer counters of the module
+     * @param stats Pointer to store counters
+     * @return UDP_STATUS_OK on success
+     */
+    udp_status_t udp_socket_get_pool_stats(udp_pool_stats_t *stats);
+
     /**
      * @brief Get local IP address
      * @param ip Pointer to store IP address
@@ -24,8 +24,8 @@ extern "C"
 {
 #endif
 
-/**< Stack size for the acquisition task */
-#define TASK_ACQUISITION_STACK_SIZE 1024
+/**< Stack size for the acquisition task, deep enough to send through publish() */
+#define TASK_ACQUISITION_STACK_SIZE 3072
 /**< Priority for the acquisition task */
 #define TASK_ACQUISITION_PRIORITY osPriorityBelowNormal
 /**< Default ADC channel for acquisition */
@@ -38,6 +38,18 @@ extern "C"
 #define ACQUISITION_DEFAULT_BATCH_SIZE 100
 /**< Maximum batch size (samples per packet) */
 #define ACQUISITION_MAX_BATCH_SIZE 100
+/**< Default number of samples summarized per window */
+#define ACQUISITION_DEFAULT_SUMMARY_WINDOW 1000
+/**< Maximum number of FFT frames averaged per spectrum */
+#define ACQUISITION_MAX_SPECTRUM_AVERAGE 256
+/**< Default ADC sample rate in Hz */
+#define ACQUISITION_DEFAULT_SAMPLE_RATE_HZ 1000
+/**< Maximum number of pulses per event packet */
+#define ACQUISITION_MAX_EVENTS 32
+/**< Maximum number of samples of a burst capture */
+#define ACQUISITION_CAPTURE_MAX_SAMPLES 2048
+/**< Sample rate of a burst capture in Hz */
+#define ACQUISITION_CAPTURE_RATE_HZ ADC_MAX_CAPTURE_RATE_HZ
 
     /**
      * @brief Acquisition task state
@@ -49,12 +61,47 @@ extern "C"
         ACQ_STATE_ERROR     /**< Error state */
     } acquisition_state_t;
 
+    /**
+     * @brief What the acquisition task sends for the sampled signal
+     */
+    typedef enum
+    {
+        ACQ_MODE_RAW      = 0, /**< Samples above threshold, in batches */
+        ACQ_MODE_SUMMARY  = 1, /**< Min, max, mean and RMS of every window */
+        ACQ_MODE_SPECTRUM = 2, /**< Averaged FFT magnitudes of every frame */
+        ACQ_MODE_EVENT    = 3  /**< Peak, width and area of pulses above threshold */
+    } acquisition_mode_t;
+
+    /**
+     * @brief Progress of a burst capture
+     */
+    typedef enum
+    {
+        CAPTURE_STATE_IDLE    = 0, /**< No capture taken yet */
+        CAPTURE_STATE_RUNNING = 1, /**< Capture requested or in progress */
+        CAPTURE_STATE_DONE    = 2  /**< Capture complete, samples can be read */
+    } acquisition_capture_state_t;
+
+    /**
+     * @brief Result of a completed burst capture
+     */
+    typedef struct
+    {
+        const uint16_t *samples;     /**< Captured samples */
+        uint16_t        count;       /**< Number of captured samples */
+        uint8_t         channel;     /**< ADC channel */
+        uint8_t         overruns;    /**< Conversions lost (saturated) */
+        uint32_t        sample_rate; /**< Actual sample rate in millihertz */
+        uint64_t        start_us;    /**< Timestamp of the first sample */
+    } acquisition_capture_t;
+
     /**
      * @brief Acquisition statistics
      */
     typedef struct
     {
         uint32_t samples_collected; /**< Total samples collected */
+        uint32_t samples_sent;      /**< Total samples sent */
         uint32_t packets_sent;      /**< Total packets sent */
         uint32_t errors;            /**< Error count */
     } acquisition_stats_t;
@@ -95,6 +142,22 @@ extern "C"
      */
     acquisition_state_t acquisition_get_state(void);
 
+    /**
+     * @brief Start collecting configuration changes into one update
+     * @details Until acquisition_config_commit(), the acquisition_set_*()
+     * functions change a staged copy that the getters also report, and nothing
+     * reaches the acquisition task.
+     * @note Only the network task may call this, like the setters.
+     */
+    void acquisition_config_begin(void);
+
+    /**
+     * @brief Publish the changes staged since acquisition_config_begin()
+     * @details The acquisition task adopts them together at its next batch
+     * boundary. Nothing is published if no setter changed anything.
+     */
+    void acquisition_config_commit(void);
+
     /**
      * @brief Set ADC threshold (trigger level)
      * @param threshold_mv Threshold in millivolts
@@ -134,6 +197,12 @@ extern "C"
      */
     void acquisition_get_stats(acquisition_stats_t *stats);
 
+    /**
+     * @brief Get unused stack of the acquisition task
+     * @return Stack space in bytes, 0 if the task is not running
+     */
+    uint32_t acquisition_get_stack_free(void);
+
     /**
      * @brief Set batch size (samples per packet)
      * @param batch_size Number of samples per packet (1 to ACQUISITION_MAX_BATCH_SIZE)
@@ -147,6 +216,120 @@ extern "C"
      */
     uint16_t acquisition_get_batch_size(void);
 
+    /**
+     * @brief Set acquisition mode
+     * @param mode Acquisition mode
+     * @return 0 on success, negative on error
+     */
+    int acquisition_set_mode(acquisition_mode_t mode);
+
+    /**
+     * @brief Get current acquisition mode
+     * @return Current mode
+     */
+    acquisition_mode_t acquisition_get_mode(void);
+
+    /**
+     * @brief Set summary window length
+     * @param window Samples per summary (1 to 65535)
+     * @return 0 on success, negative on error
+     */
+    int acquisition_set_summary_window(uint16_t window);
+
+    /**
+     * @brief Get current summary window length
+     * @return Samples per summary
+     */
+    uint16_t acquisition_get_summary_window(void);
+
+    /**
+     * @brief Set number of FFT frames averaged per spectrum packet
+     * @param frames Frames per packet (1 to ACQUISITION_MAX_SPECTRUM_AVERAGE)
+     * @return 0 on success, negative on error
+     */
+    int acquisition_set_spectrum_average(uint16_t frames);
+
+    /**
+     * @brief Get number of FFT frames averaged per spectrum packet
+     * @return Frames per packet
+     */
+    uint16_t acquisition_get_spectrum_average(void);
+
+    /**
+     * @brief Set decimation ratio of the filter between ADC and batching
+     * @details With a ratio above 1 every mode receives the CIC and FIR
+     * filtered stream at 1/ratio of the sample rate, and data packets carry
+     * samples with 4 fractional bits.
+     * @param ratio Decimation ratio (1 to DECIMATOR_MAX_RATIO), 1 disables the
+     * filter
+     * @return 0 on success, negative on error
+     */
+    int acquisition_set_decimation(uint16_t ratio);
+
+    /**
+     * @brief Get decimation ratio
+     * @return Decimation ratio, 1 if the filter is off
+     */
+    uint16_t acquisition_get_decimation(void);
+
+    /**
+     * @brief Set dead time of the pulse detector in event mode
+     * @param samples Samples ignored after each pulse, at the decimated rate
+     * @return 0 on success, negative on error
+     */
+    int acquisition_set_event_dead_time(uint16_t samples);
+
+    /**
+     * @brief Get dead time of the pulse detector
+     * @return Samples ignored after each pulse
+     */
+    uint16_t acquisition_get_event_dead_time(void);
+
+    /**
+     * @brief Set ADC sample rate
+     * @details The acquisition task reprograms the sampling timer and the ADC
+     * clock at the next batch boundary.
+     * @param rate_hz Sample rate (ADC_MIN_SAMPLE_RATE_HZ to ADC_MAX_SAMPLE_RATE_HZ)
+     * @return 0 on success, negative on error
+     */
+    int acquisition_set_sample_rate(uint32_t rate_hz);
+
+    /**
+     * @brief Get requested ADC sample rate
+     * @return Sample rate in Hz
+     */
+    uint32_t acquisition_get_sample_rate(void);
+
+    /**
+     * @brief Get sample rate the ADC timer achieves for the requested rate
+     * @return Sample rate in millihertz
+     */
+    uint32_t acquisition_get_actual_sample_rate_millihz(void);
+
+    /**
+     * @brief Request a burst capture
+     * @details The acquisition task pauses streaming, lets the ADC write
+     * samples at ACQUISITION_CAPTURE_RATE_HZ straight into a dedicated RAM
+     * buffer and resumes streaming when the buffer is full. The samples stay
+     * available until the next capture is requested.
+     * @param samples Number of samples (1 to ACQUISITION_CAPTURE_MAX_SAMPLES)
+     * @return 0 on success, negative on error or if a capture is in progress
+     */
+    int acquisition_capture_start(uint16_t samples);
+
+    /**
+     * @brief Get progress of the last burst capture
+     * @return Capture state
+     */
+    acquisition_capture_state_t acquisition_capture_state(void);
+
+    /**
+     * @brief Get result of the last burst capture
+     * @param capture Pointer to store the result
+     * @return 0 on success, negative if no capture is complete
+     */
+    int acquisition_capture_get(acquisition_capture_t *capture);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,8 +29,16 @@ extern "C"
 #define TASK_NETWORK_STACK_SIZE 4096
 /**< Priority for the network task */
 #define TASK_NETWORK_PRIORITY osPriorityNormal
-/**< Local UDP port for the network task */
+/**< Local UDP port of the control socket: commands, pings and clock sync */
 #define TASK_NETWORK_LOCAL_PORT 5000
+/**< Local UDP port of the data socket, the source port of the data stream */
+#define TASK_NETWORK_DATA_PORT 5002
+/**< Subscriber lease in ms, renewed by any packet from the subscriber */
+#define TASK_NETWORK_SESSION_LEASE_MS 15000
+/**< Default UDP port of multicast data packets */
+#define TASK_NETWORK_MCAST_PORT 5001
+/**< Bytes of data packets held while the link is down */
+#define TASK_NETWORK_BACKLOG_SIZE 4096
 
     /**
      * @brief Network task state
@@ -54,6 +62,13 @@ extern "C"
         uint32_t bytes_sent;       /**< Total bytes sent */
         uint32_t bytes_received;   /**< Total bytes received */
         uint32_t errors;           /**< Error count */
+        uint32_t paced;            /**< Data sends held back by the pacer */
+        uint32_t paced_ms;         /**< Time the data path waited for the pacer */
+        uint32_t outages;          /**< Link outages ridden out */
+        uint32_t held;             /**< Data packets held during outages */
+        uint32_t held_dropped;     /**< Data packets dropped, backlog full */
+        uint32_t arp_resolve_us;   /**< Time the last subscriber took to resolve */
+        uint32_t arp_failed;       /**< Subscribers whose ARP reply did not come */
     } network_stats_t;
 
     /**
@@ -81,7 +96,17 @@ extern "C"
     bool network_is_ready(void);
 
     /**
-     * @brief Set remote target endpoint
+     * @brief Check if data can be handed to the network
+     * @details True while ready and also during a link outage, when data packets
+     * are held in a backlog and sent once the link is back.
+     * @return true if network_send_data() and network_send_raw() accept data
+     */
+    bool network_is_streaming(void);
+
+    /**
+     * @brief Add a permanent data subscriber
+     * @details The endpoint receives every channel and its lease never expires.
+     * Hosts sending CMD_START_ACQ are added with a lease instead.
      * @param ip_addr IP address string
      * @param port Port number
      * @return 0 on success
@@ -89,7 +114,7 @@ extern "C"
     int network_set_target(const char *ip_addr, uint16_t port);
 
     /**
-     * @brief Send ADC data packet to remote target
+     * @brief Send ADC data packet to every subscriber of the channel
      * @param channel ADC channel
      * @param samples Sample array
      * @param sample_count Number of samples
@@ -99,12 +124,13 @@ extern "C"
     network_send_data(uint8_t channel, const uint16_t *samples, uint16_t sample_count);
 
     /**
-     * @brief Send raw data to remote target
+     * @brief Send a prebuilt packet to every subscriber of a channel
+     * @param channel ADC channel the packet belongs to
      * @param data Data buffer
      * @param len Data length
      * @return 0 on success
      */
-    int network_send_raw(const uint8_t *data, size_t len);
+    int network_send_raw(uint8_t channel, const uint8_t *data, size_t len);
 
     /**
      * @brief Get network statistics
@@ -52,6 +52,17 @@ extern "C"
         LOGGER_ERROR_UNKNOWN = -7  /**< Unknown error */
     } logger_status_t;
 
+    /**
+     * @brief Logger counters
+     */
+    typedef struct
+    {
+        uint32_t messages;  /**< Messages written */
+        uint32_t dropped;   /**< Messages lost because the logger was busy or failed */
+        uint32_t truncated; /**< Messages cut to the internal buffer size */
+        uint32_t bytes;     /**< Bytes written to the UART */
+    } logger_stats_t;
+
     /**
      * @brief Initialize logger with USART
      * @return Logger status code
@@ -76,6 +87,12 @@ extern "C"
      */
     log_level_t logger_get_level(void);
 
+    /**
+     * @brief Get logger counters
+     * @param stats Pointer to store counters
+     */
+    void logger_get_stats(logger_stats_t *stats);
+
     /**
      * @brief Log a message with specified level
      * @param level Log level
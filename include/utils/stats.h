@@ -0,0 +1,68 @@
+/**
+ * @file stats.h
+ * @brief Lock-free statistics snapshots using a sequence counter
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+/**
+ * @defgroup Stats Statistics
+ * @{
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Sequence counter guarding one block of counters
+     * @details Each block has exactly one writer thread. The writer makes the
+     * sequence odd while it updates the block and even again afterwards, so it
+     * never waits. Readers copy the block and retry if the sequence was odd or
+     * changed during the copy. Counters shared by several threads are split
+     * into one block per writer and summed by the reader.
+     */
+    typedef struct
+    {
+        volatile uint32_t sequence; /**< Odd while an update is in progress */
+    } stats_seq_t;
+
+    /**
+     * @brief Start updating the counters guarded by seq
+     * @param seq Sequence counter of the block
+     * @note Only the block's writer thread may call this.
+     */
+    void stats_write_begin(stats_seq_t *seq);
+
+    /**
+     * @brief Finish updating the counters guarded by seq
+     * @param seq Sequence counter of the block
+     */
+    void stats_write_end(stats_seq_t *seq);
+
+    /**
+     * @brief Copy a consistent snapshot of a counter block
+     * @details If the writer was preempted mid-update, the reader sleeps for one
+     * tick so that a lower priority writer can finish.
+     * @param seq Sequence counter of the block
+     * @param dst Destination of the snapshot
+     * @param src Counter block
+     * @param size Size of the counter block in bytes
+     */
+    void stats_read(const stats_seq_t *seq, void *dst, const void *src, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STATS_H */
+
+/** End of Stats group */
+/** @} */
@@ -10,6 +10,7 @@
 #include "logger.h"
 #include "panic.h"
 #include "rl_net.h"
+#include "system.h"
 #include "task_acquisition.h"
 #include "task_init.h"
 #include "task_network.h"
@@ -17,6 +18,7 @@
 int main(void)
 {
     SystemCoreClockUpdate();
+    system_boot_start();
 
     osStatus_t st = osKernelInitialize();
     if (st != osOK)
@@ -33,11 +35,13 @@ int main(void)
     {
         panic("Logger init failed", NULL);
     }
+    (void)system_boot_mark(SYSTEM_BOOT_LOGGER);
 
     if (netInitialize() != netOK)
     {
         panic("Network stack initialization failed", NULL);
     }
+    (void)system_boot_mark(SYSTEM_BOOT_NET_STACK);
 
     if (network_init() != 0)
     {
@@ -49,6 +53,7 @@ int main(void)
         panic("Acquisition init failed", NULL);
     }
 
+    (void)system_boot_mark(SYSTEM_BOOT_KERNEL);
     st = osKernelStart();
     if (st != osOK)
     {
@@ -8,12 +8,149 @@
 #include "system.h"
 
 #include "LPC17xx.h"
+#include "cmsis_os2.h"
 #include "panic.h"
 #include "rl_net.h"
 #include "rtx_os.h"
 
 #include <stddef.h>
 
+/** Idle loop gap in cycles above which the idle thread is assumed preempted */
+#define IDLE_GAP_MAX_CYCLES 256U
+
+/** CPU load over the last full second, written by the idle thread */
+static volatile uint16_t cpu_load_permille = 0;
+
+/** Boot milestones in microseconds from the start of main(), 0 = not reached */
+static volatile uint32_t boot_us[SYSTEM_BOOT_PHASE_COUNT];
+
+uint64_t system_time_us(void)
+{
+    uint32_t tick;
+    uint32_t val;
+
+    /* Re-read if the tick interrupt fired between the two reads */
+    do
+    {
+        tick = osKernelGetTickCount();
+        val  = SysTick->VAL;
+    } while (tick != osKernelGetTickCount());
+
+    uint32_t tick_freq = osKernelGetTickFreq();
+    uint32_t load      = (SysTick->LOAD & SysTick_LOAD_RELOAD_Msk) + 1U;
+    uint64_t us        = (uint64_t)tick * 1000000U / tick_freq;
+
+    /* SysTick counts down from LOAD to 0 within one tick period */
+    us += (uint64_t)(load - 1U - val) * (1000000U / tick_freq) / load;
+
+    return us;
+}
+
+uint16_t system_cpu_load_permille(void)
+{
+    return cpu_load_permille;
+}
+
+void system_get_kernel_stack_free(uint32_t *idle_free, uint32_t *timer_free)
+{
+    if (idle_free != NULL)
+    {
+        *idle_free = osThreadGetStackSpace((osThreadId_t)osRtxInfo.thread.idle);
+    }
+
+    if (timer_free != NULL)
+    {
+        *timer_free = (osRtxInfo.timer.thread != NULL)
+                          ? osThreadGetStackSpace((osThreadId_t)osRtxInfo.timer.thread)
+                          : 0U;
+    }
+}
+
+void system_boot_start(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @details The tick starts at zero in osKernelStart(), so after it the kernel
+ * time is added to the SYSTEM_BOOT_KERNEL mark.
+ */
+bool system_boot_mark(system_boot_phase_t phase)
+{
+    if (phase >= SYSTEM_BOOT_PHASE_COUNT || boot_us[phase] != 0U)
+    {
+        return false;
+    }
+
+    uint32_t us;
+    if (osKernelGetState() == osKernelRunning)
+    {
+        us = boot_us[SYSTEM_BOOT_KERNEL] + (uint32_t)system_time_us();
+    }
+    else
+    {
+        us = DWT->CYCCNT / (SystemCoreClock / 1000000U);
+    }
+
+    boot_us[phase] = (us != 0U) ? us : 1U;
+    return true;
+}
+
+uint32_t system_boot_phase_us(system_boot_phase_t phase)
+{
+    return (phase < SYSTEM_BOOT_PHASE_COUNT) ? boot_us[phase] : 0U;
+}
+
+const char *system_autostart_target(uint16_t *port)
+{
+    if (port != NULL)
+    {
+        *port = SYSTEM_AUTOSTART_PORT;
+    }
+
+    return SYSTEM_AUTOSTART_HOST;
+}
+
+/**
+ * @brief osRtxIdleThread override measuring CPU load
+ * @note A short gap between two loop iterations is time spent idling; a long one
+ * means other threads or interrupts ran in between.
+ */
+__NO_RETURN void osRtxIdleThread(void *argument)
+{
+    (void)argument;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    uint32_t window_start = DWT->CYCCNT;
+    uint32_t last         = window_start;
+    uint32_t idle_cycles  = 0;
+
+    for (;;)
+    {
+        uint32_t now = DWT->CYCCNT;
+        uint32_t gap = now - last;
+        last         = now;
+
+        if (gap < IDLE_GAP_MAX_CYCLES)
+        {
+            idle_cycles += gap;
+        }
+
+        uint32_t window = now - window_start;
+        if (window >= SystemCoreClock)
+        {
+            uint32_t idle_permille = (uint32_t)((uint64_t)idle_cycles * 1000U / window);
+            cpu_load_permille      = (uint16_t)(1000U - idle_permille);
+            window_start           = now;
+            idle_cycles            = 0;
+        }
+    }
+}
+
 /**
  * @brief Hard Fault Handler override
  */
@@ -49,6 +186,9 @@ uint32_t osRtxErrorNotify(uint32_t code, void *object_id)
 
 /**
  * @brief netHandleError override
+ * @note The socket layer refuses sends before they can empty the memory pool
+ * (see net_pool.h), so netErrorMemAlloc here means reception or the stack
+ * itself ran out. RL-NET cannot continue after it.
  */
 void netHandleError(netErrorCode error)
 {
@@ -14,15 +14,37 @@
 
 #define ADC_CLOCK_DIV 4U /**< ADC clock = PCLK / (DIV+1), 25MHz/5 = 5MHz */
 
+/** Peripheral clock divider of the ADC and TIMER1 (PCLKSEL reset value) */
+#define ADC_PCLK_DIV 4U
+/** Highest ADC clock allowed by the datasheet */
+#define ADC_MAX_CLOCK_HZ 13000000U
+/** ADC clocks per 12-bit conversion */
+#define ADC_CONVERSION_CLOCKS 65U
+/** Largest CLKDIV register value */
+#define ADC_CLKDIV_MAX 255U
+
 /* LPC17xx Power Control (PCONP) register bits */
+#define PCONP_TIM1_BIT  2U
 #define PCONP_ADC_BIT   12U
 #define PCONP_IOCON_BIT 15U
 
+/* Peripheral Clock Selection (PCLKSEL0) fields */
+#define PCLKSEL0_TIM1_MASK (3U << 4)
+
 /* ADC Control Register (ADCR) bits */
 #define ADCR_PDN_BIT      21U
 #define ADCR_START_MASK   (7U << 24) /**< START field mask (bits 24-26) */
 #define ADCR_START_NOW    (1U << 24) /**< Start conversion immediately */
+#define ADCR_START_MAT10  (6U << 24) /**< Start conversion on a MAT1.0 edge */
+#define ADCR_EDGE_FALLING (1U << 27) /**< Start on falling instead of rising edge */
 #define ADCR_CLKDIV_SHIFT 8U
+#define ADCR_CLKDIV_MASK  (0xFFU << ADCR_CLKDIV_SHIFT)
+
+/* Timer registers */
+#define TCR_ENABLE      (1U << 0)
+#define TCR_RESET       (1U << 1)
+#define MCR_MR0_RESET   (1U << 1)
+#define EMR_EMC0_TOGGLE (3U << 4) /**< Toggle MAT1.0 on every MR0 match */
 
 /* ADC Interrupt Enable Register (ADINTEN) bits */
 #define ADINTEN_GLOBAL_BIT 8U
@@ -31,6 +53,7 @@
 #define ADGDR_RESULT_SHIFT 4U
 #define ADGDR_RESULT_MASK  0xFFFU
 #define ADGDR_DONE_BIT     31U
+#define ADGDR_OVERRUN      (1U << 30) /**< A result was overwritten before read */
 
 /** ADC pin configuration per channel */
 static const struct
@@ -54,6 +77,48 @@ static volatile uint8_t  adc_done;
 static volatile uint8_t  adc_initialized;
 static adc_channel_t     adc_current_channel;
 
+/**
+ * Sample buffer, written by ADC_IRQHandler and read by one thread. The
+ * indices run freely and are masked on access, so head - tail is the fill
+ * level even after they wrap.
+ */
+static volatile uint16_t adc_ring[ADC_BUFFER_SIZE];
+static volatile uint32_t adc_ring_head;
+static volatile uint32_t adc_ring_tail;
+static volatile uint32_t adc_overruns;
+static volatile uint8_t  adc_sampling;
+
+/** Burst capture target, written only by ADC_IRQHandler while capturing */
+static uint16_t         *adc_capture_buffer;
+static uint32_t          adc_capture_size;
+static volatile uint32_t adc_capture_count;
+static volatile uint32_t adc_capture_overruns;
+static volatile uint8_t  adc_capturing;
+
+static void stop_timer(void);
+
+/**
+ * @brief Store one burst capture result, stopping the timer when full
+ */
+static void capture_store(uint16_t value, uint32_t gdr)
+{
+    uint32_t count = adc_capture_count;
+
+    if ((gdr & ADGDR_OVERRUN) != 0U)
+    {
+        adc_capture_overruns++;
+    }
+
+    adc_capture_buffer[count] = value;
+    adc_capture_count         = count + 1U;
+
+    if (count + 1U >= adc_capture_size)
+    {
+        stop_timer();
+        adc_capturing = 0U;
+    }
+}
+
 /**
  * @brief ADC Interrupt Handler
  */
@@ -65,8 +130,101 @@ void ADC_IRQHandler(void)
     adstat = LPC_ADC->ADSTAT;
     (void)adstat;
 
-    adc_last_value = (LPC_ADC->ADGDR >> ADGDR_RESULT_SHIFT) & ADGDR_RESULT_MASK;
+    uint32_t gdr   = LPC_ADC->ADGDR;
+    uint16_t value = (gdr >> ADGDR_RESULT_SHIFT) & ADGDR_RESULT_MASK;
+
+    adc_last_value = value;
     adc_done       = 1U;
+
+    if (adc_capturing)
+    {
+        capture_store(value, gdr);
+    }
+    else if (adc_sampling)
+    {
+        uint32_t head = adc_ring_head;
+
+        if (head - adc_ring_tail >= ADC_BUFFER_SIZE)
+        {
+            adc_overruns++;
+            return;
+        }
+        adc_ring[head & (ADC_BUFFER_SIZE - 1U)] = value;
+        adc_ring_head                           = head + 1U;
+    }
+}
+
+static uint32_t peripheral_clock_hz(void)
+{
+    return SystemCoreClock / ADC_PCLK_DIV;
+}
+
+/**
+ * @brief TIMER1 MR0 value for a sample rate
+ * @details MAT1.0 toggles on every match, so one conversion starts every
+ * second match.
+ */
+static uint32_t timer_match(uint32_t rate_hz)
+{
+    uint32_t ticks = 2U * rate_hz;
+
+    return (peripheral_clock_hz() + ticks / 2U) / ticks - 1U;
+}
+
+/**
+ * @brief CLKDIV value of the slowest ADC clock that converts in half a period
+ * @details A slower clock gives the sample-and-hold more time to settle on
+ * high-impedance sources. Above about 96 kHz no allowed clock converts in half
+ * a period; the fastest one is used, which still finishes before the next
+ * trigger.
+ */
+static uint32_t clock_div(uint32_t rate_hz)
+{
+    uint32_t pclk    = peripheral_clock_hz();
+    uint32_t div     = pclk / (2U * ADC_CONVERSION_CLOCKS * rate_hz);
+    uint32_t min_div = (pclk + ADC_MAX_CLOCK_HZ - 1U) / ADC_MAX_CLOCK_HZ;
+
+    if (div < min_div)
+    {
+        div = min_div;
+    }
+    if (div > ADC_CLKDIV_MAX + 1U)
+    {
+        div = ADC_CLKDIV_MAX + 1U;
+    }
+    return div - 1U;
+}
+
+/**
+ * @brief Let TIMER1 start a conversion on every rising edge of MAT1.0
+ */
+static void start_timer(uint32_t rate_hz)
+{
+    /* TIMER1 runs from CCLK / 4 like the ADC */
+    LPC_SC->PCONP |= (1U << PCONP_TIM1_BIT);
+    LPC_SC->PCLKSEL0 &= ~PCLKSEL0_TIM1_MASK;
+
+    LPC_TIM1->TCR = TCR_RESET;
+    LPC_TIM1->PR  = 0;
+    LPC_TIM1->MR0 = timer_match(rate_hz);
+    LPC_TIM1->MCR = MCR_MR0_RESET;
+    LPC_TIM1->EMR = EMR_EMC0_TOGGLE;
+
+    LPC_ADC->ADCR =
+        (LPC_ADC->ADCR & ~(ADCR_START_MASK | ADCR_CLKDIV_MASK | ADCR_EDGE_FALLING)) |
+        (clock_div(rate_hz) << ADCR_CLKDIV_SHIFT) | ADCR_START_MAT10;
+
+    LPC_TIM1->TCR = TCR_ENABLE;
+}
+
+/**
+ * @brief Stop triggered conversions and restore the single-conversion clock
+ */
+static void stop_timer(void)
+{
+    LPC_TIM1->TCR = 0;
+    LPC_ADC->ADCR = (LPC_ADC->ADCR & ~(ADCR_START_MASK | ADCR_CLKDIV_MASK)) |
+                    (ADC_CLOCK_DIV << ADCR_CLKDIV_SHIFT);
 }
 
 adc_status_t adc_init(adc_channel_t channel)
@@ -116,6 +274,8 @@ adc_status_t adc_deinit(void)
         return ADC_OK;
     }
 
+    (void)adc_stop_sampling();
+
     NVIC_DisableIRQ(ADC_IRQn);
 
     /* Disable global ADC interrupt */
@@ -200,3 +360,129 @@ adc_status_t adc_read_sync(uint16_t *value)
     *value = adc_last_value;
     return ADC_OK;
 }
+
+adc_status_t adc_start_sampling(uint32_t rate_hz)
+{
+    if (!adc_initialized)
+    {
+        return ADC_ERROR_INIT;
+    }
+
+    if (rate_hz < ADC_MIN_SAMPLE_RATE_HZ || rate_hz > ADC_MAX_SAMPLE_RATE_HZ)
+    {
+        return ADC_ERROR_PARAM;
+    }
+
+    (void)adc_stop_sampling();
+
+    adc_ring_head = 0;
+    adc_ring_tail = 0;
+    adc_sampling  = 1U;
+
+    start_timer(rate_hz);
+
+    return ADC_OK;
+}
+
+adc_status_t adc_stop_sampling(void)
+{
+    if (!adc_initialized)
+    {
+        return ADC_ERROR_INIT;
+    }
+
+    if (!adc_sampling && !adc_capturing)
+    {
+        return ADC_OK;
+    }
+
+    stop_timer();
+
+    adc_sampling  = 0U;
+    adc_capturing = 0U;
+    adc_ring_tail = adc_ring_head;
+
+    return ADC_OK;
+}
+
+adc_status_t adc_read_buffered(uint16_t *value)
+{
+    if (value == NULL)
+    {
+        return ADC_ERROR_PARAM;
+    }
+
+    uint32_t tail = adc_ring_tail;
+    if (tail == adc_ring_head)
+    {
+        return ADC_ERROR_BUSY;
+    }
+
+    *value        = adc_ring[tail & (ADC_BUFFER_SIZE - 1U)];
+    adc_ring_tail = tail + 1U;
+
+    return ADC_OK;
+}
+
+uint32_t adc_buffered_count(void)
+{
+    return adc_ring_head - adc_ring_tail;
+}
+
+uint32_t adc_get_overruns(void)
+{
+    return adc_overruns;
+}
+
+adc_status_t adc_start_capture(uint16_t *buffer, uint32_t count, uint32_t rate_hz)
+{
+    if (!adc_initialized)
+    {
+        return ADC_ERROR_INIT;
+    }
+
+    if (buffer == NULL || count == 0 || rate_hz < ADC_MIN_SAMPLE_RATE_HZ ||
+        rate_hz > ADC_MAX_CAPTURE_RATE_HZ)
+    {
+        return ADC_ERROR_PARAM;
+    }
+
+    (void)adc_stop_sampling();
+
+    adc_capture_buffer   = buffer;
+    adc_capture_size     = count;
+    adc_capture_count    = 0;
+    adc_capture_overruns = 0;
+    adc_capturing        = 1U;
+
+    start_timer(rate_hz);
+
+    return ADC_OK;
+}
+
+int adc_capture_done(void)
+{
+    return (adc_capture_size > 0 && adc_capture_count >= adc_capture_size) ? 1 : 0;
+}
+
+uint32_t adc_capture_progress(void)
+{
+    return adc_capture_count;
+}
+
+uint32_t adc_capture_overrun_count(void)
+{
+    return adc_capture_overruns;
+}
+
+uint32_t adc_sample_rate_millihz(uint32_t rate_hz)
+{
+    if (rate_hz < ADC_MIN_SAMPLE_RATE_HZ || rate_hz > ADC_MAX_CAPTURE_RATE_HZ)
+    {
+        return 0;
+    }
+
+    uint64_t ticks = 2ULL * (timer_match(rate_hz) + 1U);
+
+    return (uint32_t)(((uint64_t)peripheral_clock_hz() * 1000U + ticks / 2U) / ticks);
+}
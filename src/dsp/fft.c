@@ -0,0 +1,234 @@
+/**
+ * @file fft.c
+ * @brief Fixed-point real FFT for spectrum acquisition
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "fft.h"
+
+/** Number of complex points of the inner FFT */
+#define FFT_COMPLEX_SIZE (FFT_SIZE / 2)
+/** Offset between sine and cosine in the sine table index space */
+#define FFT_QUARTER (FFT_SIZE / 4)
+/** Rounding term for Q15 products */
+#define FFT_Q15_ROUND (1L << 14)
+/** Mid-scale of the 12-bit ADC */
+#define FFT_ADC_MIDSCALE 2048
+
+/** sin(2 * pi * k / FFT_SIZE) in Q15 for the first quarter wave */
+static const int16_t sine_table[FFT_QUARTER + 1] = {
+    0,     804,   1608,  2410,  3212,  4011,  4808,  5602,  6393,  7179,  7962,
+    8739,  9512,  10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151,
+    16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594, 23170,
+    23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510,
+    28898, 29268, 29621, 29956, 30273, 30571, 30852, 31113, 31356, 31580, 31785,
+    31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757, 32767,
+};
+
+/**
+ * @brief sin(2 * pi * k / FFT_SIZE) in Q15
+ */
+static int16_t sin_q15(size_t k)
+{
+    k &= FFT_SIZE - 1;
+
+    if (k <= FFT_QUARTER)
+    {
+        return sine_table[k];
+    }
+    if (k <= 2 * FFT_QUARTER)
+    {
+        return sine_table[2 * FFT_QUARTER - k];
+    }
+    if (k <= 3 * FFT_QUARTER)
+    {
+        return (int16_t)-sine_table[k - 2 * FFT_QUARTER];
+    }
+    return (int16_t)-sine_table[FFT_SIZE - k];
+}
+
+/**
+ * @brief cos(2 * pi * k / FFT_SIZE) in Q15
+ */
+static int16_t cos_q15(size_t k)
+{
+    return sin_q15(k + FFT_QUARTER);
+}
+
+static int16_t saturate_q15(int32_t value)
+{
+    if (value > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+    if (value < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+    return (int16_t)value;
+}
+
+static uint32_t isqrt_u32(uint32_t value)
+{
+    uint32_t root = 0;
+    uint32_t bit  = 1UL << 30;
+
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+
+    while (bit != 0)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return root;
+}
+
+/**
+ * @brief Reorder interleaved complex points into bit-reversed order
+ */
+static void bit_reverse(int16_t *data)
+{
+    size_t j = 0;
+
+    for (size_t i = 0; i < FFT_COMPLEX_SIZE - 1; i++)
+    {
+        if (i < j)
+        {
+            int16_t re      = data[2 * i];
+            int16_t im      = data[2 * i + 1];
+            data[2 * i]     = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j]     = re;
+            data[2 * j + 1] = im;
+        }
+
+        size_t bit = FFT_COMPLEX_SIZE / 2;
+        while (j >= bit && bit > 0)
+        {
+            j -= bit;
+            bit >>= 1;
+        }
+        j += bit;
+    }
+}
+
+/**
+ * @brief Radix-2 decimation-in-time complex FFT, scaled by 1/2 per stage
+ */
+static void fft_complex_q15(int16_t *data)
+{
+    bit_reverse(data);
+
+    for (size_t size = 2; size <= FFT_COMPLEX_SIZE; size <<= 1)
+    {
+        size_t half = size / 2;
+        size_t step = FFT_SIZE / size;
+
+        for (size_t j = 0; j < half; j++)
+        {
+            int32_t wr = cos_q15(j * step);
+            int32_t wi = -sin_q15(j * step);
+
+            for (size_t a = j; a < FFT_COMPLEX_SIZE; a += size)
+            {
+                size_t b = a + half;
+
+                /* Halving both inputs keeps the butterfly inside Q15 */
+                int32_t ar = (data[2 * a] + 1) >> 1;
+                int32_t ai = (data[2 * a + 1] + 1) >> 1;
+                int32_t br = (data[2 * b] + 1) >> 1;
+                int32_t bi = (data[2 * b + 1] + 1) >> 1;
+
+                int32_t tr = (br * wr - bi * wi + FFT_Q15_ROUND) >> 15;
+                int32_t ti = (br * wi + bi * wr + FFT_Q15_ROUND) >> 15;
+
+                data[2 * a]     = saturate_q15(ar + tr);
+                data[2 * a + 1] = saturate_q15(ai + ti);
+                data[2 * b]     = saturate_q15(ar - tr);
+                data[2 * b + 1] = saturate_q15(ai - ti);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Compute bin k of the real spectrum from complex bins p = Z[k], q = Z[M-k]
+ * @details X[k] = (E + W^k * O) / 2 with E = (p + conj(q)) / 2 and
+ * O = -i * (p - conj(q)) / 2.
+ */
+static void split_bin(
+    int32_t pr, int32_t pi, int32_t qr, int32_t qi, size_t k, int16_t *out
+)
+{
+    int32_t even_r = (pr + qr) >> 2;
+    int32_t even_i = (pi - qi) >> 2;
+    int32_t odd_r  = (pi + qi) >> 2;
+    int32_t odd_i  = (qr - pr) >> 2;
+    int32_t wr     = cos_q15(k);
+    int32_t wi     = -sin_q15(k);
+
+    out[0] = saturate_q15(even_r + ((odd_r * wr - odd_i * wi + FFT_Q15_ROUND) >> 15));
+    out[1] = saturate_q15(even_i + ((odd_r * wi + odd_i * wr + FFT_Q15_ROUND) >> 15));
+}
+
+int16_t fft_window_sample(uint16_t adc_value, size_t index)
+{
+    /* Hann window: (1 - cos(2 * pi * n / N)) / 2 */
+    int32_t window = (32768 - cos_q15(index)) >> 1;
+    int32_t sample = ((int32_t)adc_value - FFT_ADC_MIDSCALE) * 16;
+
+    return saturate_q15((sample * window) >> 15);
+}
+
+void fft_real_q15(int16_t *data)
+{
+    /* Even samples are the real parts, odd samples the imaginary parts */
+    fft_complex_q15(data);
+
+    int32_t z0r = data[0];
+    int32_t z0i = data[1];
+    data[0]     = saturate_q15((z0r + z0i) >> 1);
+    data[1]     = saturate_q15((z0r - z0i) >> 1);
+
+    for (size_t k = 1; k <= FFT_COMPLEX_SIZE / 2; k++)
+    {
+        size_t  m  = FFT_COMPLEX_SIZE - k;
+        int32_t pr = data[2 * k];
+        int32_t pi = data[2 * k + 1];
+        int32_t qr = data[2 * m];
+        int32_t qi = data[2 * m + 1];
+
+        split_bin(pr, pi, qr, qi, k, &data[2 * k]);
+        if (m != k)
+        {
+            split_bin(qr, qi, pr, pi, m, &data[2 * m]);
+        }
+    }
+}
+
+uint16_t fft_magnitude(const int16_t *spectrum, size_t bin)
+{
+    if (bin == 0)
+    {
+        return (uint16_t)(spectrum[0] < 0 ? -spectrum[0] : spectrum[0]);
+    }
+
+    int32_t  re  = spectrum[2 * bin];
+    int32_t  im  = spectrum[2 * bin + 1];
+    uint32_t mag = isqrt_u32((uint32_t)(re * re) + (uint32_t)(im * im));
+
+    return (uint16_t)(mag > UINT16_MAX ? UINT16_MAX : mag);
+}
@@ -0,0 +1,75 @@
+/**
+ * @file pulse.c
+ * @brief Threshold pulse detector for event acquisition
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "pulse.h"
+
+#include <string.h>
+
+void pulse_detector_init(pulse_detector_t *det, uint16_t threshold, uint16_t dead_time)
+{
+    memset(det, 0, sizeof(*det));
+    det->threshold = threshold;
+    det->dead_time = dead_time;
+}
+
+bool pulse_detector_process(
+    pulse_detector_t *det, uint16_t sample, uint64_t now_us, pulse_t *out
+)
+{
+    bool above = (sample >= det->threshold);
+
+    if (det->in_pulse)
+    {
+        if (!above)
+        {
+            *out          = det->current;
+            det->in_pulse = false;
+            det->holdoff  = det->dead_time;
+            /* This sample is below threshold, so only dead time delays re-arming */
+            det->armed = (det->dead_time == 0);
+            return true;
+        }
+
+        pulse_t  *pulse  = &det->current;
+        uint32_t  excess = (uint32_t)(sample - det->threshold);
+
+        if (sample > pulse->peak)
+        {
+            pulse->peak = sample;
+        }
+        if (pulse->width < UINT16_MAX)
+        {
+            pulse->width++;
+        }
+        pulse->area = (pulse->area > UINT32_MAX - excess) ? UINT32_MAX
+                                                          : pulse->area + excess;
+        return false;
+    }
+
+    if (det->holdoff > 0)
+    {
+        det->holdoff--;
+        return false;
+    }
+
+    if (!above)
+    {
+        det->armed = true;
+        return false;
+    }
+
+    if (det->armed)
+    {
+        det->in_pulse         = true;
+        det->current.start_us = now_us;
+        det->current.peak     = sample;
+        det->current.width    = 1;
+        det->current.area     = (uint32_t)(sample - det->threshold);
+    }
+
+    return false;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file summary.c
+ * @brief Exact min, max, mean and RMS of a window of ADC samples
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "summary.h"
+
+uint32_t summary_isqrt(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit  = 1ULL << 62;
+
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+
+    while (bit != 0)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)root;
+}
+
+void summary_reset(summary_acc_t *acc)
+{
+    acc->count  = 0;
+    acc->sum    = 0;
+    acc->sum_sq = 0;
+    acc->min    = UINT16_MAX;
+    acc->max    = 0;
+}
+
+void summary_add(summary_acc_t *acc, uint16_t sample, uint64_t time_us)
+{
+    if (acc->count == 0)
+    {
+        acc->start_us = time_us;
+    }
+
+    acc->count++;
+    acc->sum += sample;
+    acc->sum_sq += (uint32_t)sample * sample;
+    if (sample < acc->min)
+    {
+        acc->min = sample;
+    }
+    if (sample > acc->max)
+    {
+        acc->max = sample;
+    }
+}
+
+void summary_finish(const summary_acc_t *acc, unsigned frac_bits, summary_t *out)
+{
+    uint64_t n   = acc->count;
+    uint64_t sum = acc->sum;
+
+    out->count    = (uint16_t)acc->count;
+    out->min      = acc->min;
+    out->max      = acc->max;
+    out->start_us = acc->start_us;
+
+    /* Scale before dividing so the fraction is rounded, not truncated */
+    out->mean = (uint16_t)(((sum << frac_bits) + n / 2) / n);
+    out->rms =
+        (uint16_t)summary_isqrt(((acc->sum_sq << (2 * frac_bits)) + n / 2) / n);
+}
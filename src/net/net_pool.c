@@ -0,0 +1,151 @@
+/**
+ * @file net_pool.c
+ * @brief Estimate of the network stack memory held by sent datagrams
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "net_pool.h"
+
+/** Ledger level units per byte */
+#define NET_POOL_SCALE 1000000LL
+
+static void drain(net_pool_t *pool, uint64_t now_us)
+{
+    uint64_t elapsed_us = (now_us > pool->last_us) ? now_us - pool->last_us : 0U;
+
+    pool->last_us = now_us;
+
+    /* Anything past one second empties any pool the stack can have */
+    if (elapsed_us > (uint64_t)NET_POOL_SCALE)
+    {
+        elapsed_us = (uint64_t)NET_POOL_SCALE;
+    }
+
+    pool->used -= (int64_t)elapsed_us * pool->drain;
+    if (pool->used < 0)
+    {
+        pool->used = 0;
+    }
+}
+
+static int64_t cost(size_t len, size_t count)
+{
+    size_t memory = len + NET_POOL_FRAME_OVERHEAD;
+    size_t wire   = len + NET_POOL_WIRE_OVERHEAD;
+
+    wire = (wire > NET_POOL_WIRE_MIN) ? wire : NET_POOL_WIRE_MIN;
+    return (int64_t)((wire > memory) ? wire : memory) * (int64_t)count * NET_POOL_SCALE;
+}
+
+void net_pool_init(
+    net_pool_t *pool, uint32_t size, uint32_t drain_bytes_per_s, uint64_t now_us
+)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    pool->size    = size;
+    pool->drain   = drain_bytes_per_s;
+    pool->used    = 0;
+    pool->last_us = now_us;
+    pool->peak    = 0;
+    pool->refused = 0;
+}
+
+void net_pool_set_drain(net_pool_t *pool, uint32_t drain_bytes_per_s, uint64_t now_us)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    drain(pool, now_us);
+    pool->drain = drain_bytes_per_s;
+}
+
+bool net_pool_take(net_pool_t *pool, size_t len, uint64_t now_us)
+{
+    if (pool == NULL || pool->size == 0U)
+    {
+        return true;
+    }
+
+    drain(pool, now_us);
+
+    int64_t charge = cost(len, 1U);
+
+    if (pool->used + charge > (int64_t)pool->size * NET_POOL_SCALE)
+    {
+        pool->refused++;
+        return false;
+    }
+
+    pool->used += charge;
+
+    uint32_t used = (uint32_t)((pool->used + NET_POOL_SCALE - 1) / NET_POOL_SCALE);
+    if (used > pool->peak)
+    {
+        pool->peak = used;
+    }
+
+    return true;
+}
+
+void net_pool_refund(net_pool_t *pool, size_t len, uint64_t now_us)
+{
+    if (pool == NULL || pool->size == 0U)
+    {
+        return;
+    }
+
+    drain(pool, now_us);
+
+    /* What the link already drained of it is not paid back twice */
+    pool->used -= cost(len, 1U);
+    if (pool->used < 0)
+    {
+        pool->used = 0;
+    }
+}
+
+uint32_t net_pool_wait_us(net_pool_t *pool, size_t len, size_t count, uint64_t now_us)
+{
+    if (pool == NULL || pool->size == 0U)
+    {
+        return 0;
+    }
+
+    drain(pool, now_us);
+
+    uint32_t limit  = (pool->size > NET_POOL_WAIT_HEADROOM)
+                          ? pool->size - NET_POOL_WAIT_HEADROOM
+                          : pool->size;
+    int64_t  full   = (int64_t)limit * NET_POOL_SCALE;
+    int64_t  needed = cost(len, count);
+    int64_t  excess = pool->used + ((needed < full) ? needed : full) - full;
+
+    if (excess <= 0)
+    {
+        return 0;
+    }
+    if (pool->drain == 0U)
+    {
+        return UINT32_MAX;
+    }
+
+    return (uint32_t)((excess + pool->drain - 1) / pool->drain);
+}
+
+uint32_t net_pool_used(net_pool_t *pool, uint64_t now_us)
+{
+    if (pool == NULL)
+    {
+        return 0;
+    }
+
+    drain(pool, now_us);
+    return (uint32_t)((pool->used + NET_POOL_SCALE - 1) / NET_POOL_SCALE);
+}
@@ -0,0 +1,108 @@
+/**
+ * @file pacer.c
+ * @brief Token-bucket pacer limiting the byte and packet rate of a stream
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "pacer.h"
+
+#include <stddef.h>
+
+/** Bucket level units per token */
+#define PACER_SCALE 1000000LL
+
+static void bucket_init(pacer_bucket_t *bucket, uint32_t rate)
+{
+    uint32_t burst = (uint32_t)(((uint64_t)rate * PACER_BURST_MS) / 1000U);
+
+    bucket->rate  = rate;
+    bucket->burst = (burst > 0U) ? burst : 1U;
+    bucket->level = (int64_t)bucket->burst * PACER_SCALE;
+}
+
+static void bucket_refill(pacer_bucket_t *bucket, uint64_t elapsed_us)
+{
+    int64_t full = (int64_t)bucket->burst * PACER_SCALE;
+
+    /* Anything past one second refills the bucket anyway */
+    if (elapsed_us > (uint64_t)PACER_SCALE)
+    {
+        elapsed_us = (uint64_t)PACER_SCALE;
+    }
+
+    bucket->level += (int64_t)elapsed_us * bucket->rate;
+    if (bucket->level > full)
+    {
+        bucket->level = full;
+    }
+}
+
+/**
+ * @brief Microseconds until a bucket holds enough tokens for a send
+ */
+static uint32_t bucket_wait_us(const pacer_bucket_t *bucket, uint32_t tokens)
+{
+    if (bucket->rate == 0U)
+    {
+        return 0;
+    }
+
+    uint32_t needed  = (tokens < bucket->burst) ? tokens : bucket->burst;
+    int64_t  missing = (int64_t)needed * PACER_SCALE - bucket->level;
+
+    if (missing <= 0)
+    {
+        return 0;
+    }
+
+    return (uint32_t)((missing + bucket->rate - 1) / bucket->rate);
+}
+
+void pacer_init(
+    pacer_t *pacer, uint32_t bytes_per_s, uint32_t packets_per_s, uint64_t now_us
+)
+{
+    if (pacer == NULL)
+    {
+        return;
+    }
+
+    bucket_init(&pacer->bytes, bytes_per_s);
+    bucket_init(&pacer->packets, packets_per_s);
+    pacer->last_us = now_us;
+}
+
+uint32_t
+pacer_reserve(pacer_t *pacer, uint32_t bytes, uint32_t packets, uint64_t now_us)
+{
+    if (pacer == NULL)
+    {
+        return 0;
+    }
+
+    uint64_t elapsed_us = (now_us > pacer->last_us) ? now_us - pacer->last_us : 0U;
+
+    bucket_refill(&pacer->bytes, elapsed_us);
+    bucket_refill(&pacer->packets, elapsed_us);
+    pacer->last_us = now_us;
+
+    uint32_t wait_bytes   = bucket_wait_us(&pacer->bytes, bytes);
+    uint32_t wait_packets = bucket_wait_us(&pacer->packets, packets);
+
+    if (wait_bytes > 0U || wait_packets > 0U)
+    {
+        return (wait_bytes > wait_packets) ? wait_bytes : wait_packets;
+    }
+
+    if (pacer->bytes.rate != 0U)
+    {
+        pacer->bytes.level -= (int64_t)bytes * PACER_SCALE;
+    }
+    if (pacer->packets.rate != 0U)
+    {
+        pacer->packets.level -= (int64_t)packets * PACER_SCALE;
+    }
+
+    return 0;
+}
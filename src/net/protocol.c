@@ -7,6 +7,7 @@
 
 #include "protocol.h"
 
+#include "crc32c.h"
 #include "logger.h"
 
 #include <string.h>
@@ -17,6 +18,65 @@ static uint16_t sequence_counter = 0;
 /** Module initialized flag */
 static bool initialized = false;
 
+/** Append CRC32C trailer to data packets */
+static volatile bool data_crc_enabled = false;
+
+/**
+ * @brief Accepted value range of a configuration parameter
+ */
+typedef struct
+{
+    uint32_t min; /**< Minimum accepted value */
+    uint32_t max; /**< Maximum accepted value */
+} config_param_range_t;
+
+/**
+ * Accepted value ranges indexed by protocol_config_param_t. Together with the
+ * checks in protocol_config_value_valid() they cover everything the network
+ * task's handlers refuse, so a validated packet applies as a whole.
+ */
+static const config_param_range_t config_param_ranges[] = {
+    [CONFIG_THRESHOLD_PERCENT]  = {0, 100},
+    [CONFIG_THRESHOLD_MV]       = {0, 3300},
+    [CONFIG_BATCH_SIZE]         = {1, 100},
+    [CONFIG_CHANNEL]            = {0, 7},
+    [CONFIG_RESET_SEQUENCE]     = {0, UINT32_MAX},
+    [CONFIG_LOG_LEVEL]          = {0, 5},
+    [CONFIG_DATA_CRC]           = {0, 1},
+    [CONFIG_MCAST_GROUP]        = {0, 0xEFFFFFFFu},
+    [CONFIG_MCAST_PORT]         = {1, UINT16_MAX},
+    [CONFIG_ACQ_MODE]           = {0, 3},
+    [CONFIG_SUMMARY_WINDOW]     = {1, UINT16_MAX},
+    [CONFIG_SPECTRUM_AVERAGE]   = {1, 256},
+    [CONFIG_DECIMATION]         = {1, 64},
+    [CONFIG_EVENT_DEAD_TIME]    = {0, UINT16_MAX},
+    [CONFIG_SAMPLE_RATE_HZ]     = {1, 20000},
+    [CONFIG_PACE_BYTES_PER_S]   = {0, 12500000},
+    [CONFIG_PACE_PACKETS_PER_S] = {0, 100000},
+};
+
+/** Number of known configuration parameter types */
+#define CONFIG_PARAM_COUNT                                                             \
+    (sizeof(config_param_ranges) / sizeof(config_param_ranges[0]))
+
+bool protocol_config_value_valid(uint8_t param_type, uint32_t value)
+{
+    if (param_type >= CONFIG_PARAM_COUNT ||
+        value < config_param_ranges[param_type].min ||
+        value > config_param_ranges[param_type].max)
+    {
+        return false;
+    }
+
+    /* Zero disables multicast, anything else must be in 224.0.0.0/4 */
+    if (param_type == CONFIG_MCAST_GROUP && value != 0 && (value >> 28) != 0xEU)
+    {
+        return false;
+    }
+
+    return true;
+}
+
 /**
  * @brief Build packet header
  */
@@ -29,6 +89,17 @@ build_header(protocol_header_t *header, protocol_msg_type_t type, uint16_t paylo
     header->payload_len = payload_len;
 }
 
+/**
+ * @brief Write the CRC32C trailer into the last bytes of a packet
+ */
+static void append_crc32c(uint8_t *buffer, size_t total_size)
+{
+    /* CRC covers everything before the trailer, header included */
+    size_t   crc_offset = total_size - PROTOCOL_CRC32C_SIZE;
+    uint32_t crc        = crc32c_update(0, buffer, crc_offset);
+    memcpy(buffer + crc_offset, &crc, sizeof(crc));
+}
+
 protocol_status_t protocol_init(void)
 {
     sequence_counter = 0;
@@ -36,9 +107,20 @@ protocol_status_t protocol_init(void)
     return PROTO_STATUS_OK;
 }
 
+void protocol_set_data_crc(bool enable)
+{
+    data_crc_enabled = enable;
+}
+
+bool protocol_get_data_crc(void)
+{
+    return data_crc_enabled;
+}
+
 protocol_status_t protocol_build_data_packet(
     uint8_t *buffer, size_t buffer_len, uint8_t channel, const uint16_t *samples,
-    uint16_t sample_count, size_t *out_len
+    uint16_t sample_count, uint8_t sample_flags, uint64_t timestamp_us,
+    size_t *out_len
 )
 {
     if (buffer == NULL || samples == NULL || out_len == NULL)
@@ -46,8 +128,15 @@ protocol_status_t protocol_build_data_packet(
         return PROTO_STATUS_ERROR;
     }
 
+    bool with_crc = data_crc_enabled;
+
+    size_t samples_size = sample_count * sizeof(uint16_t);
     size_t payload_size =
-        sizeof(protocol_data_payload_t) + (sample_count * sizeof(uint16_t));
+        sizeof(protocol_data_payload_t) + samples_size + PROTOCOL_TIMESTAMP_SIZE;
+    if (with_crc)
+    {
+        payload_size += PROTOCOL_CRC32C_SIZE;
+    }
     size_t total_size = sizeof(protocol_header_t) + payload_size;
 
     if (buffer_len < total_size)
@@ -62,11 +151,243 @@ protocol_status_t protocol_build_data_packet(
         (protocol_data_payload_t *)(buffer + sizeof(protocol_header_t));
 
     payload->channel      = channel;
-    payload->reserved     = 0;
+    payload->flags        = PROTOCOL_DATA_FLAG_TIMESTAMP | sample_flags;
     payload->sample_count = sample_count;
+    if (with_crc)
+    {
+        payload->flags |= PROTOCOL_DATA_FLAG_CRC32C;
+    }
 
     /* Copy samples */
-    memcpy(payload->samples, samples, sample_count * sizeof(uint16_t));
+    memcpy(payload->samples, samples, samples_size);
+
+    /* Timestamp trailer follows the samples */
+    memcpy((uint8_t *)payload->samples + samples_size, &timestamp_us, sizeof(uint64_t));
+
+    if (with_crc)
+    {
+        append_crc32c(buffer, total_size);
+    }
+
+    *out_len = total_size;
+
+    return PROTO_STATUS_OK;
+}
+
+protocol_status_t protocol_build_summary_packet(
+    uint8_t *buffer, size_t buffer_len, const protocol_summary_payload_t *summary,
+    size_t *out_len
+)
+{
+    if (buffer == NULL || summary == NULL || out_len == NULL)
+    {
+        return PROTO_STATUS_ERROR;
+    }
+
+    bool with_crc = data_crc_enabled;
+
+    size_t payload_size = sizeof(protocol_summary_payload_t);
+    if (with_crc)
+    {
+        payload_size += PROTOCOL_CRC32C_SIZE;
+    }
+    size_t total_size = sizeof(protocol_header_t) + payload_size;
+
+    if (buffer_len < total_size)
+    {
+        return PROTO_STATUS_BUFFER_TOO_SMALL;
+    }
+
+    protocol_header_t *header = (protocol_header_t *)buffer;
+    build_header(header, MSG_TYPE_SUMMARY, (uint16_t)payload_size);
+
+    protocol_summary_payload_t *payload =
+        (protocol_summary_payload_t *)(buffer + sizeof(protocol_header_t));
+
+    memcpy(payload, summary, sizeof(*payload));
+    payload->flags = PROTOCOL_DATA_FLAG_TIMESTAMP;
+    if (with_crc)
+    {
+        payload->flags |= PROTOCOL_DATA_FLAG_CRC32C;
+        append_crc32c(buffer, total_size);
+    }
+
+    *out_len = total_size;
+
+    return PROTO_STATUS_OK;
+}
+
+protocol_status_t protocol_build_spectrum_packet(
+    uint8_t *buffer, size_t buffer_len, uint8_t channel, const uint16_t *bins,
+    uint16_t bin_count, uint16_t fft_size, uint16_t frame_count, uint64_t timestamp_us,
+    size_t *out_len
+)
+{
+    if (buffer == NULL || bins == NULL || out_len == NULL)
+    {
+        return PROTO_STATUS_ERROR;
+    }
+
+    bool with_crc = data_crc_enabled;
+
+    size_t bins_size    = bin_count * sizeof(uint16_t);
+    size_t payload_size = sizeof(protocol_spectrum_payload_t) + bins_size;
+    if (with_crc)
+    {
+        payload_size += PROTOCOL_CRC32C_SIZE;
+    }
+    size_t total_size = sizeof(protocol_header_t) + payload_size;
+
+    if (buffer_len < total_size)
+    {
+        return PROTO_STATUS_BUFFER_TOO_SMALL;
+    }
+
+    protocol_header_t *header = (protocol_header_t *)buffer;
+    build_header(header, MSG_TYPE_SPECTRUM, (uint16_t)payload_size);
+
+    protocol_spectrum_payload_t *payload =
+        (protocol_spectrum_payload_t *)(buffer + sizeof(protocol_header_t));
+
+    payload->channel      = channel;
+    payload->flags        = PROTOCOL_DATA_FLAG_TIMESTAMP;
+    payload->fft_size     = fft_size;
+    payload->frame_count  = frame_count;
+    payload->bin_count    = bin_count;
+    payload->timestamp_us = timestamp_us;
+    memcpy(payload->bins, bins, bins_size);
+
+    if (with_crc)
+    {
+        payload->flags |= PROTOCOL_DATA_FLAG_CRC32C;
+        append_crc32c(buffer, total_size);
+    }
+
+    *out_len = total_size;
+
+    return PROTO_STATUS_OK;
+}
+
+protocol_status_t protocol_build_event_packet(
+    uint8_t *buffer, size_t buffer_len, uint8_t channel, const protocol_event_t *events,
+    uint16_t event_count, uint64_t timestamp_us, size_t *out_len
+)
+{
+    if (buffer == NULL || events == NULL || out_len == NULL)
+    {
+        return PROTO_STATUS_ERROR;
+    }
+
+    bool with_crc = data_crc_enabled;
+
+    size_t events_size  = event_count * sizeof(protocol_event_t);
+    size_t payload_size = sizeof(protocol_event_payload_t) + events_size;
+    if (with_crc)
+    {
+        payload_size += PROTOCOL_CRC32C_SIZE;
+    }
+    size_t total_size = sizeof(protocol_header_t) + payload_size;
+
+    if (buffer_len < total_size)
+    {
+        return PROTO_STATUS_BUFFER_TOO_SMALL;
+    }
+
+    protocol_header_t *header = (protocol_header_t *)buffer;
+    build_header(header, MSG_TYPE_EVENT, (uint16_t)payload_size);
+
+    protocol_event_payload_t *payload =
+        (protocol_event_payload_t *)(buffer + sizeof(protocol_header_t));
+
+    payload->channel      = channel;
+    payload->flags        = PROTOCOL_DATA_FLAG_TIMESTAMP;
+    payload->event_count  = event_count;
+    payload->timestamp_us = timestamp_us;
+    memcpy(payload->events, events, events_size);
+
+    if (with_crc)
+    {
+        payload->flags |= PROTOCOL_DATA_FLAG_CRC32C;
+        append_crc32c(buffer, total_size);
+    }
+
+    *out_len = total_size;
+
+    return PROTO_STATUS_OK;
+}
+
+protocol_status_t protocol_build_capture_packet(
+    uint8_t *buffer, size_t buffer_len, const protocol_capture_payload_t *info,
+    const uint16_t *samples, size_t *out_len
+)
+{
+    if (buffer == NULL || info == NULL || out_len == NULL ||
+        (samples == NULL && info->sample_count > 0))
+    {
+        return PROTO_STATUS_ERROR;
+    }
+
+    bool with_crc = data_crc_enabled;
+
+    size_t samples_size = info->sample_count * sizeof(uint16_t);
+    size_t payload_size = sizeof(protocol_capture_payload_t) + samples_size;
+    if (with_crc)
+    {
+        payload_size += PROTOCOL_CRC32C_SIZE;
+    }
+    size_t total_size = sizeof(protocol_header_t) + payload_size;
+
+    if (buffer_len < total_size)
+    {
+        return PROTO_STATUS_BUFFER_TOO_SMALL;
+    }
+
+    protocol_header_t *header = (protocol_header_t *)buffer;
+    build_header(header, MSG_TYPE_CAPTURE, (uint16_t)payload_size);
+
+    protocol_capture_payload_t *payload =
+        (protocol_capture_payload_t *)(buffer + sizeof(protocol_header_t));
+
+    *payload       = *info;
+    payload->flags = PROTOCOL_DATA_FLAG_TIMESTAMP;
+    if (samples_size > 0)
+    {
+        memcpy(payload->samples, samples, samples_size);
+    }
+
+    if (with_crc)
+    {
+        payload->flags |= PROTOCOL_DATA_FLAG_CRC32C;
+        append_crc32c(buffer, total_size);
+    }
+
+    *out_len = total_size;
+
+    return PROTO_STATUS_OK;
+}
+
+protocol_status_t protocol_build_gap_packet(
+    uint8_t *buffer, size_t buffer_len, const protocol_gap_payload_t *gap,
+    size_t *out_len
+)
+{
+    if (buffer == NULL || gap == NULL || out_len == NULL)
+    {
+        return PROTO_STATUS_ERROR;
+    }
+
+    size_t payload_size = sizeof(protocol_gap_payload_t);
+    size_t total_size   = sizeof(protocol_header_t) + payload_size;
+
+    if (buffer_len < total_size)
+    {
+        return PROTO_STATUS_BUFFER_TOO_SMALL;
+    }
+
+    protocol_header_t *header = (protocol_header_t *)buffer;
+    build_header(header, MSG_TYPE_GAP, (uint16_t)payload_size);
+
+    memcpy(buffer + sizeof(protocol_header_t), gap, payload_size);
 
     *out_len = total_size;
 
@@ -117,6 +438,91 @@ protocol_build_pong(uint8_t *buffer, size_t buffer_len, size_t *out_len)
     return PROTO_STATUS_OK;
 }
 
+protocol_status_t protocol_build_sync_response(
+    uint8_t *buffer, size_t buffer_len, const protocol_sync_resp_payload_t *sync,
+    size_t *out_len
+)
+{
+    if (buffer == NULL || sync == NULL || out_len == NULL)
+    {
+        return PROTO_STATUS_ERROR;
+    }
+
+    size_t payload_size = sizeof(protocol_sync_resp_payload_t);
+    size_t total_size   = sizeof(protocol_header_t) + payload_size;
+
+    if (buffer_len < total_size)
+    {
+        return PROTO_STATUS_BUFFER_TOO_SMALL;
+    }
+
+    protocol_header_t *header = (protocol_header_t *)buffer;
+    build_header(header, MSG_TYPE_SYNC_RESP, (uint16_t)payload_size);
+
+    memcpy(buffer + sizeof(protocol_header_t), sync, payload_size);
+
+    *out_len = total_size;
+
+    return PROTO_STATUS_OK;
+}
+
+/**
+ * @brief Encode a value as unsigned LEB128
+ * @return Number of bytes written
+ */
+static size_t encode_leb128(uint8_t *out, uint32_t value)
+{
+    size_t len = 0;
+
+    do
+    {
+        uint8_t byte = (uint8_t)(value & 0x7FU);
+        value >>= 7;
+        if (value != 0)
+        {
+            byte |= 0x80U;
+        }
+        out[len++] = byte;
+    } while (value != 0);
+
+    return len;
+}
+
+protocol_status_t protocol_build_telemetry(
+    uint8_t *buffer, size_t buffer_len, const protocol_telemetry_entry_t *entries,
+    size_t entry_count, size_t *out_len
+)
+{
+    if (buffer == NULL || entries == NULL || out_len == NULL)
+    {
+        return PROTO_STATUS_ERROR;
+    }
+
+    /* Worst case size, so encoding needs no per-entry bounds check */
+    size_t max_size =
+        sizeof(protocol_header_t) + entry_count * PROTOCOL_TELEMETRY_ENTRY_MAX_SIZE;
+    if (buffer_len < max_size || max_size > UINT16_MAX)
+    {
+        return PROTO_STATUS_BUFFER_TOO_SMALL;
+    }
+
+    uint8_t *payload     = buffer + sizeof(protocol_header_t);
+    size_t   payload_len = 0;
+
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        payload[payload_len++] = entries[i].id;
+        payload_len += encode_leb128(&payload[payload_len], entries[i].value);
+    }
+
+    protocol_header_t *header = (protocol_header_t *)buffer;
+    build_header(header, MSG_TYPE_TELEMETRY, (uint16_t)payload_len);
+
+    *out_len = sizeof(protocol_header_t) + payload_len;
+
+    return PROTO_STATUS_OK;
+}
+
 protocol_status_t protocol_build_status(
     uint8_t *buffer, size_t buffer_len, const protocol_status_payload_t *status,
     size_t *out_len
@@ -211,6 +617,83 @@ protocol_status_t protocol_parse_command(
     return PROTO_STATUS_OK;
 }
 
+protocol_status_t protocol_parse_config(
+    const uint8_t *payload, size_t payload_len, protocol_config_entry_t *entries,
+    size_t max_entries, size_t *entry_count
+)
+{
+    if (payload == NULL || entries == NULL || entry_count == NULL)
+    {
+        return PROTO_STATUS_ERROR;
+    }
+
+    *entry_count = 0;
+
+    uint32_t seen   = 0;
+    size_t   count  = 0;
+    size_t   offset = 0;
+
+    while (offset < payload_len)
+    {
+        if (payload_len - offset < PROTOCOL_CONFIG_TLV_HEADER_SIZE)
+        {
+            LOG_WARNING("Truncated config TLV header at offset %u", offset);
+            return PROTO_STATUS_INVALID_MSG;
+        }
+
+        uint8_t type = payload[offset];
+        uint8_t len  = payload[offset + 1];
+        offset += PROTOCOL_CONFIG_TLV_HEADER_SIZE;
+
+        if (len == 0 || len > PROTOCOL_CONFIG_VALUE_MAX_LEN ||
+            len > payload_len - offset)
+        {
+            LOG_WARNING("Invalid config TLV length %u for param %u", len, type);
+            return PROTO_STATUS_INVALID_MSG;
+        }
+
+        if (type >= CONFIG_PARAM_COUNT)
+        {
+            LOG_WARNING("Unknown config param_type: %u", type);
+            return PROTO_STATUS_INVALID_MSG;
+        }
+
+        if (seen & (1UL << type))
+        {
+            LOG_WARNING("Duplicate config param_type: %u", type);
+            return PROTO_STATUS_INVALID_MSG;
+        }
+
+        if (count >= max_entries)
+        {
+            LOG_WARNING("Too many config entries (max %u)", max_entries);
+            return PROTO_STATUS_BUFFER_TOO_SMALL;
+        }
+
+        /* Value is little-endian, 1 to 4 bytes long */
+        uint32_t value = 0;
+        for (uint8_t i = 0; i < len; i++)
+        {
+            value |= (uint32_t)payload[offset + i] << (8U * i);
+        }
+        offset += len;
+
+        if (!protocol_config_value_valid(type, value))
+        {
+            LOG_WARNING("Config param %u value %u out of range", type, value);
+            return PROTO_STATUS_INVALID_MSG;
+        }
+
+        seen |= (1UL << type);
+        entries[count].param_type = type;
+        entries[count].value      = value;
+        count++;
+    }
+
+    *entry_count = count;
+    return PROTO_STATUS_OK;
+}
+
 uint16_t protocol_get_sequence(void)
 {
     return sequence_counter;
@@ -0,0 +1,322 @@
+/**
+ * @file session.c
+ * @brief Table of hosts subscribed to the acquisition data stream
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "session.h"
+
+#include "cmsis_os2.h"
+#include "logger.h"
+#include "panic.h"
+
+#include <string.h>
+
+/**
+ * @brief Subscriber slot
+ */
+typedef struct
+{
+    udp_endpoint_t remote;       /**< Subscriber endpoint */
+    uint32_t       lease_ms;     /**< Lease length, SESSION_LEASE_FOREVER for none */
+    uint32_t       last_seen;    /**< Kernel tick of the last packet from remote */
+    uint8_t        channel_mask; /**< Subscribed ADC channels */
+    bool           used;         /**< Slot in use */
+} session_slot_t;
+
+/** Subscriber slots */
+static session_slot_t slots[SESSION_MAX_SUBSCRIBERS];
+
+/** Number of used slots */
+static size_t slot_count = 0;
+
+/** Multicast group the data is published to */
+static udp_endpoint_t mcast_group;
+
+/** Multicast publishing enabled */
+static bool mcast_enabled = false;
+
+/** Mutex for slot access */
+static osMutexId_t session_mutex = NULL;
+
+static bool endpoint_equal(const udp_endpoint_t *a, const udp_endpoint_t *b)
+{
+    return a->port == b->port &&
+           memcmp(a->ip.addr, b->ip.addr, sizeof(a->ip.addr)) == 0;
+}
+
+/**
+ * @brief Find the slot of an endpoint
+ * @note Caller must hold session_mutex.
+ */
+static session_slot_t *find_slot(const udp_endpoint_t *remote)
+{
+    for (size_t i = 0; i < SESSION_MAX_SUBSCRIBERS; i++)
+    {
+        if (slots[i].used && endpoint_equal(&slots[i].remote, remote))
+        {
+            return &slots[i];
+        }
+    }
+
+    return NULL;
+}
+
+static bool lease_expired(const session_slot_t *slot, uint32_t now)
+{
+    return slot->lease_ms != SESSION_LEASE_FOREVER &&
+           (uint64_t)(now - slot->last_seen) * 1000U >=
+               (uint64_t)slot->lease_ms * osKernelGetTickFreq();
+}
+
+session_status_t session_init(void)
+{
+    if (session_mutex != NULL)
+    {
+        panic("Session table already initialized", NULL);
+        return SESSION_STATUS_OK;
+    }
+
+    const osMutexAttr_t mutex_attr = {
+        .name      = "session_mutex",
+        .attr_bits = osMutexPrioInherit,
+        .cb_mem    = NULL,
+        .cb_size   = 0
+    };
+
+    session_mutex = osMutexNew(&mutex_attr);
+    if (session_mutex == NULL)
+    {
+        panic("Failed to create session mutex", NULL);
+        return SESSION_STATUS_NOT_INIT;
+    }
+
+    memset(slots, 0, sizeof(slots));
+    slot_count = 0;
+
+    return SESSION_STATUS_OK;
+}
+
+session_status_t session_subscribe(
+    const udp_endpoint_t *remote, uint8_t channel_mask, uint32_t lease_ms
+)
+{
+    if (session_mutex == NULL)
+    {
+        return SESSION_STATUS_NOT_INIT;
+    }
+
+    if (remote == NULL || channel_mask == 0)
+    {
+        return SESSION_STATUS_INVALID_PARAM;
+    }
+
+    osMutexAcquire(session_mutex, osWaitForever);
+
+    session_slot_t *slot = find_slot(remote);
+    for (size_t i = 0; slot == NULL && i < SESSION_MAX_SUBSCRIBERS; i++)
+    {
+        if (!slots[i].used)
+        {
+            slot         = &slots[i];
+            slot->remote = *remote;
+            slot->used   = true;
+            slot_count++;
+        }
+    }
+
+    if (slot == NULL)
+    {
+        osMutexRelease(session_mutex);
+        return SESSION_STATUS_FULL;
+    }
+
+    slot->channel_mask = channel_mask;
+    slot->lease_ms     = lease_ms;
+    slot->last_seen    = osKernelGetTickCount();
+
+    osMutexRelease(session_mutex);
+    return SESSION_STATUS_OK;
+}
+
+session_status_t session_unsubscribe(const udp_endpoint_t *remote)
+{
+    if (session_mutex == NULL)
+    {
+        return SESSION_STATUS_NOT_INIT;
+    }
+
+    if (remote == NULL)
+    {
+        return SESSION_STATUS_INVALID_PARAM;
+    }
+
+    osMutexAcquire(session_mutex, osWaitForever);
+
+    session_slot_t *slot = find_slot(remote);
+    if (slot == NULL)
+    {
+        osMutexRelease(session_mutex);
+        return SESSION_STATUS_NOT_FOUND;
+    }
+
+    slot->used = false;
+    slot_count--;
+
+    osMutexRelease(session_mutex);
+    return SESSION_STATUS_OK;
+}
+
+bool session_touch(const udp_endpoint_t *remote)
+{
+    if (session_mutex == NULL || remote == NULL)
+    {
+        return false;
+    }
+
+    osMutexAcquire(session_mutex, osWaitForever);
+
+    session_slot_t *slot = find_slot(remote);
+    if (slot != NULL)
+    {
+        slot->last_seen = osKernelGetTickCount();
+    }
+
+    osMutexRelease(session_mutex);
+    return slot != NULL;
+}
+
+void session_renew_all(void)
+{
+    if (session_mutex == NULL)
+    {
+        return;
+    }
+
+    uint32_t now = osKernelGetTickCount();
+
+    osMutexAcquire(session_mutex, osWaitForever);
+
+    for (size_t i = 0; i < SESSION_MAX_SUBSCRIBERS; i++)
+    {
+        if (slots[i].used)
+        {
+            slots[i].last_seen = now;
+        }
+    }
+
+    osMutexRelease(session_mutex);
+}
+
+size_t session_expire(void)
+{
+    if (session_mutex == NULL)
+    {
+        return 0;
+    }
+
+    size_t   removed = 0;
+    uint32_t now     = osKernelGetTickCount();
+
+    osMutexAcquire(session_mutex, osWaitForever);
+
+    for (size_t i = 0; i < SESSION_MAX_SUBSCRIBERS; i++)
+    {
+        if (slots[i].used && lease_expired(&slots[i], now))
+        {
+            LOG_INFO(
+                "Subscriber %u.%u.%u.%u:%u lease expired", slots[i].remote.ip.addr[0],
+                slots[i].remote.ip.addr[1], slots[i].remote.ip.addr[2],
+                slots[i].remote.ip.addr[3], slots[i].remote.port
+            );
+            slots[i].used = false;
+            slot_count--;
+            removed++;
+        }
+    }
+
+    osMutexRelease(session_mutex);
+    return removed;
+}
+
+session_status_t session_set_multicast(const udp_endpoint_t *group)
+{
+    if (session_mutex == NULL)
+    {
+        return SESSION_STATUS_NOT_INIT;
+    }
+
+    osMutexAcquire(session_mutex, osWaitForever);
+
+    mcast_enabled = (group != NULL);
+    if (group != NULL)
+    {
+        mcast_group = *group;
+    }
+
+    osMutexRelease(session_mutex);
+    return SESSION_STATUS_OK;
+}
+
+size_t session_count(void)
+{
+    return slot_count;
+}
+
+bool session_has_host(const udp_ipv4_addr_t *ip)
+{
+    bool found = false;
+
+    if (session_mutex == NULL || ip == NULL)
+    {
+        return false;
+    }
+
+    osMutexAcquire(session_mutex, osWaitForever);
+
+    for (size_t i = 0; i < SESSION_MAX_SUBSCRIBERS && !found; i++)
+    {
+        found = slots[i].used &&
+                memcmp(slots[i].remote.ip.addr, ip->addr, sizeof(ip->addr)) == 0;
+    }
+
+    osMutexRelease(session_mutex);
+    return found;
+}
+
+size_t
+session_get_targets(uint8_t channel, udp_endpoint_t *targets, size_t max_targets)
+{
+    if (session_mutex == NULL || targets == NULL)
+    {
+        return 0;
+    }
+
+    uint8_t channel_bit = (channel < 8U) ? (uint8_t)(1U << channel) : 0U;
+    size_t  count       = 0;
+
+    osMutexAcquire(session_mutex, osWaitForever);
+
+    if (mcast_enabled)
+    {
+        if (slot_count > 0 && max_targets > 0)
+        {
+            targets[count++] = mcast_group;
+        }
+
+        osMutexRelease(session_mutex);
+        return count;
+    }
+
+    for (size_t i = 0; i < SESSION_MAX_SUBSCRIBERS && count < max_targets; i++)
+    {
+        if (slots[i].used && (slots[i].channel_mask & channel_bit) != 0U)
+        {
+            targets[count++] = slots[i].remote;
+        }
+    }
+
+    osMutexRelease(session_mutex);
+    return count;
+}
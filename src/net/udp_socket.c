@@ -7,18 +7,33 @@
 
 #include "udp_socket.h"
 
+#include "Driver_ETH_PHY.h"
+#include "LPC17xx.h"
+#include "Net_Config.h"
 #include "Net_Config_UDP.h"
 #include "cmsis_os2.h"
 #include "logger.h"
+#include "net_pool.h"
 #include "panic.h"
 #include "rl_net.h"
+#include "system.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+extern ARM_DRIVER_ETH_PHY Driver_ETH_PHY0;
+
 /** Maximum receive buffer size in bytes */
 #define UDP_RECV_BUFFER_SIZE UDP_MAX_PAYLOAD_SIZE
+/** Network stack memory sent datagrams may hold */
+#define UDP_TX_POOL_SIZE (NET_MEM_POOL_SIZE - NET_POOL_RX_RESERVE)
+/** Link rate assumed until the PHY reports one: 10 Mbit/s in bytes per second */
+#define UDP_TX_DRAIN_DEFAULT 1250000U
+/** Event flag set while the Ethernet link is up */
+#define UDP_LINK_EVENT_UP (1U << 0)
+/** Link poll interval in ms until the stack has reported the link state */
+#define UDP_LINK_POLL_MS 500U
 
 /** Socket state flags */
 #define SOCKET_FLAG_USED     (1U << 0)
@@ -30,8 +45,9 @@
 typedef struct
 {
     udp_endpoint_t remote;
+    uint64_t       rx_time_us;
     uint16_t       len;
-    uint8_t        data[UDP_RECV_BUFFER_SIZE];
+    uint8_t        data[]; /* Sized by the socket's rx_max_len */
 } udp_rx_pkt_t;
 
 /* Special queue item meaning: socket is closing */
@@ -47,12 +63,14 @@ typedef struct udp_socket
     uint8_t             flags;              /**< Socket state flags */
     udp_recv_callback_t callback;           /**< Receive callback */
     void               *callback_user_data; /**< User data for callback */
-    uint8_t             recv_buffer[UDP_RECV_BUFFER_SIZE]; /**< Receive buffer */
-    size_t              recv_len;                          /**< Received data length */
-    udp_endpoint_t      recv_remote; /**< Remote endpoint of received data */
-    osMessageQueueId_t  rx_queue;    /**< Queue of udp_rx_pkt_t* */
-    osMemoryPoolId_t    rx_pool;     /**< Pool of udp_rx_pkt_t blocks */
-    uint32_t            rx_dropped;  /**< Dropped RX packets */
+    osMessageQueueId_t  rx_queue;           /**< Queue of udp_rx_pkt_t* */
+    osMemoryPoolId_t    rx_pool;            /**< Pool of udp_rx_pkt_t blocks */
+    uint32_t            rx_queue_len;       /**< Receive queue capacity */
+    uint32_t            rx_max_len;         /**< Longest datagram queued */
+    udp_rx_filter_t     rx_filter;          /**< Filter applied before queueing */
+    void               *rx_filter_context;  /**< Passed to rx_filter */
+    uint32_t            rx_dropped;         /**< Dropped RX packets */
+    uint32_t            rx_rejected;        /**< RX packets refused by length/filter */
 } udp_socket_internal_t;
 
 /** Socket pool */
@@ -64,8 +82,35 @@ static bool module_initialized = false;
 /** Mutex for socket pool access */
 static osMutexId_t socket_mutex = NULL;
 
+/**
+ * Sockets indexed by network stack handle, read by udp_net_callback() without
+ * a lock. RL-NET hands out handles 1 to UDP_NUM_SOCKS.
+ */
+static udp_socket_internal_t *volatile socket_by_net_handle[UDP_NUM_SOCKS + 1];
+
+/**
+ * Receive callback epoch, odd while udp_net_callback() runs. RL-NET calls it
+ * from its core thread only, so there is a single reader to wait for.
+ */
+static volatile uint32_t rx_epoch;
+
+/** Thread running udp_net_callback(), valid while rx_epoch is odd */
+static volatile osThreadId_t rx_thread;
+
 static volatile bool s_eth_link_known = false;
 static volatile bool s_eth_link_up    = false;
+/** Mirrors s_eth_link_up in UDP_LINK_EVENT_UP for udp_socket_wait_for_link() */
+static osEventFlagsId_t link_events = NULL;
+
+/**
+ * Ledger of the stack memory taken by sends. RL-NET panics through
+ * netHandleError() when netUDP_GetBuffer() finds the pool empty, so sends are
+ * refused here before it can.
+ */
+static net_pool_t  tx_pool;
+static osMutexId_t tx_pool_mutex = NULL;
+/** Link rate in bytes per second, set when the link comes up */
+static volatile uint32_t s_link_bytes_per_s = UDP_TX_DRAIN_DEFAULT;
 
 void netETH_Notify(uint32_t if_num, netETH_Event event, uint32_t val)
 {
@@ -79,13 +124,28 @@ void netETH_Notify(uint32_t if_num, netETH_Event event, uint32_t val)
     switch (event)
     {
         case netETH_LinkUp:
-            s_eth_link_known = true;
-            s_eth_link_up    = true;
+        {
+            ARM_ETH_LINK_INFO info = Driver_ETH_PHY0.GetLinkInfo();
+
+            s_link_bytes_per_s = (info.speed == ARM_ETH_SPEED_100M)
+                                     ? 10U * UDP_TX_DRAIN_DEFAULT
+                                     : UDP_TX_DRAIN_DEFAULT;
+            s_eth_link_known   = true;
+            s_eth_link_up      = true;
+            if (link_events != NULL)
+            {
+                (void)osEventFlagsSet(link_events, UDP_LINK_EVENT_UP);
+            }
             break;
+        }
 
         case netETH_LinkDown:
             s_eth_link_known = true;
             s_eth_link_up    = false;
+            if (link_events != NULL)
+            {
+                (void)osEventFlagsClear(link_events, UDP_LINK_EVENT_UP);
+            }
             break;
 
         default:
@@ -94,19 +154,60 @@ void netETH_Notify(uint32_t if_num, netETH_Event event, uint32_t val)
 }
 
 /**
- * @brief Find socket by network handle
+ * @brief Look up a socket by network handle without taking socket_mutex
+ * @note Only valid between rx_enter() and rx_exit().
  */
 static udp_socket_internal_t *find_socket_by_net_handle(int32_t net_socket)
 {
-    for (int i = 0; i < UDP_NUM_SOCKS; i++)
+    if (net_socket <= 0 || net_socket > UDP_NUM_SOCKS)
     {
-        if ((socket_pool[i].flags & SOCKET_FLAG_USED) &&
-            socket_pool[i].net_socket == net_socket)
-        {
-            return &socket_pool[i];
-        }
+        return NULL;
+    }
+
+    return socket_by_net_handle[net_socket];
+}
+
+/**
+ * @brief Mark the start of a receive callback
+ */
+static void rx_enter(void)
+{
+    rx_thread = osThreadGetId();
+    rx_epoch++;
+    /* The epoch must be odd before the socket table is read */
+    __DMB();
+}
+
+/**
+ * @brief Mark the end of a receive callback
+ */
+static void rx_exit(void)
+{
+    /* Socket accesses must be complete before the epoch moves on */
+    __DMB();
+    rx_epoch++;
+}
+
+/**
+ * @brief Wait until no receive callback can still hold an unpublished socket
+ * @details Called after the socket was removed from socket_by_net_handle. A
+ * callback that starts later cannot find it, so only one that is already
+ * running needs to finish. Returns at once when called from that callback.
+ */
+static void rx_wait_for_callbacks(void)
+{
+    __DMB();
+    uint32_t epoch = rx_epoch;
+
+    if ((epoch & 1U) == 0U || rx_thread == osThreadGetId())
+    {
+        return;
+    }
+
+    while (rx_epoch == epoch)
+    {
+        osDelay(1);
     }
-    return NULL;
 }
 
 /**
@@ -184,67 +285,76 @@ static void endpoint_to_net_addr(const udp_endpoint_t *endpoint, NET_ADDR *addr)
 
 /**
  * @brief Network stack callback for received UDP data
+ * @details Runs without socket_mutex: the socket is found in
+ * socket_by_net_handle, and udp_socket_close() waits for the callback to leave
+ * before it frees the socket.
  */
 static uint32_t
 udp_net_callback(int32_t socket, const NET_ADDR *addr, const uint8_t *buf, uint32_t len)
 {
+    uint64_t rx_time_us = system_time_us();
+    uint32_t accepted   = 0;
+
     LOG_DEBUG("Received UDP packet on socket %d, length %u", socket, len);
     udp_endpoint_t remote;
     net_addr_to_endpoint(addr, &remote);
 
-    osMutexAcquire(socket_mutex, osWaitForever);
+    rx_enter();
 
     udp_socket_internal_t *sock = find_socket_by_net_handle(socket);
-    if (sock == NULL || !(sock->flags & SOCKET_FLAG_USED) ||
-        (sock->flags & SOCKET_FLAG_CLOSING))
+    if (sock == NULL || (sock->flags & SOCKET_FLAG_CLOSING))
     {
-        osMutexRelease(socket_mutex);
+        rx_exit();
         return 0;
     }
 
-    /* If user callback registered, call it WITHOUT holding mutex */
     if ((sock->flags & SOCKET_FLAG_CALLBACK) && (sock->callback != NULL))
     {
         udp_recv_callback_t cb = sock->callback;
         void               *ud = sock->callback_user_data;
-        osMutexRelease(socket_mutex);
 
         cb((udp_socket_handle_t)sock, &remote, buf, (size_t)len, ud);
+        rx_exit();
         return 1;
     }
 
-    /* Blocking receive mode: queue packet */
-    if (sock->rx_pool == NULL || sock->rx_queue == NULL)
+    /* Refuse junk before it takes one of the socket's few buffers */
+    if (len > sock->rx_max_len ||
+        (sock->rx_filter != NULL &&
+         !sock->rx_filter(&remote, buf, len, sock->rx_filter_context)))
     {
-        osMutexRelease(socket_mutex);
+        sock->rx_rejected++;
+        rx_exit();
         return 0;
     }
 
+    /* Blocking receive mode: queue packet */
     udp_rx_pkt_t *pkt = (udp_rx_pkt_t *)osMemoryPoolAlloc(sock->rx_pool, 0U);
     if (pkt == NULL)
     {
         sock->rx_dropped++;
-        osMutexRelease(socket_mutex);
+        rx_exit();
         return 0;
     }
 
     pkt->remote       = remote;
-    uint32_t copy_len = (len < UDP_RECV_BUFFER_SIZE) ? len : UDP_RECV_BUFFER_SIZE;
-    pkt->len          = (uint16_t)copy_len;
-    memcpy(pkt->data, buf, copy_len);
+    pkt->rx_time_us = rx_time_us;
+    pkt->len        = (uint16_t)len;
+    memcpy(pkt->data, buf, len);
 
     udp_rx_pkt_t *msg = pkt;
-    osStatus_t    qst = osMessageQueuePut(sock->rx_queue, &msg, 0U, 0U);
-    if (qst != osOK)
+    if (osMessageQueuePut(sock->rx_queue, &msg, 0U, 0U) == osOK)
+    {
+        accepted = 1;
+    }
+    else
     {
         (void)osMemoryPoolFree(sock->rx_pool, pkt);
         sock->rx_dropped++;
-        osMutexRelease(socket_mutex);
-        return 0;
     }
 
-    osMutexRelease(socket_mutex);
-    return 1;
+    rx_exit();
+    return accepted;
 }
 
 udp_status_t udp_socket_init(void)
@@ -270,7 +380,46 @@ udp_status_t udp_socket_init(void)
         return UDP_STATUS_NO_MEMORY;
     }
 
+    const osMutexAttr_t pool_mutex_attr = {
+        .name      = "udp_pool_mutex",
+        .attr_bits = osMutexPrioInherit,
+        .cb_mem    = NULL,
+        .cb_size   = 0
+    };
+
+    tx_pool_mutex = osMutexNew(&pool_mutex_attr);
+    if (tx_pool_mutex == NULL)
+    {
+        LOG_CRITICAL("Failed to create UDP pool mutex");
+        panic("Failed to create UDP pool mutex", NULL);
+        return UDP_STATUS_NO_MEMORY;
+    }
+
+    const osEventFlagsAttr_t link_events_attr = {
+        .name      = "udp_link_events",
+        .attr_bits = 0,
+        .cb_mem    = NULL,
+        .cb_size   = 0
+    };
+
+    link_events = osEventFlagsNew(&link_events_attr);
+    if (link_events == NULL)
+    {
+        LOG_CRITICAL("Failed to create UDP link events");
+        panic("Failed to create UDP link events", NULL);
+        return UDP_STATUS_NO_MEMORY;
+    }
+    if (s_eth_link_up)
+    {
+        (void)osEventFlagsSet(link_events, UDP_LINK_EVENT_UP);
+    }
+
     memset(socket_pool, 0, sizeof(socket_pool));
+    for (int i = 0; i <= UDP_NUM_SOCKS; i++)
+    {
+        socket_by_net_handle[i] = NULL;
+    }
+    net_pool_init(&tx_pool, UDP_TX_POOL_SIZE, s_link_bytes_per_s, system_time_us());
 
     module_initialized = true;
     return UDP_STATUS_OK;
@@ -300,6 +449,18 @@ udp_status_t udp_socket_deinit(void)
         socket_mutex = NULL;
     }
 
+    if (tx_pool_mutex != NULL)
+    {
+        osMutexDelete(tx_pool_mutex);
+        tx_pool_mutex = NULL;
+    }
+
+    if (link_events != NULL)
+    {
+        osEventFlagsDelete(link_events);
+        link_events = NULL;
+    }
+
     module_initialized = false;
     LOG_INFO("UDP socket module deinitialized");
 
@@ -308,6 +469,19 @@ udp_status_t udp_socket_deinit(void)
 
 udp_status_t udp_socket_create(udp_socket_handle_t *handle, uint16_t local_port)
 {
+    return udp_socket_create_rx(handle, local_port, NULL);
+}
+
+udp_status_t udp_socket_create_rx(
+    udp_socket_handle_t *handle, uint16_t local_port, const udp_rx_config_t *rx
+)
+{
+    static const udp_rx_config_t rx_default = {
+        .queue_len      = UDP_RX_QUEUE_LEN,
+        .max_len        = UDP_RECV_BUFFER_SIZE,
+        .filter         = NULL,
+        .filter_context = NULL,
+    };
     udp_status_t           result;
     udp_socket_internal_t *sock;
     netStatus              net_status;
@@ -324,6 +498,18 @@ udp_status_t udp_socket_create(udp_socket_handle_t *handle, uint16_t local_port)
         return UDP_STATUS_INVALID_PARAM;
     }
 
+    if (rx == NULL)
+    {
+        rx = &rx_default;
+    }
+    if (rx->queue_len == 0U || rx->max_len == 0U || rx->max_len > UDP_RECV_BUFFER_SIZE)
+    {
+        LOG_ERROR(
+            "Invalid RX queue settings: %u x %u bytes", rx->queue_len, rx->max_len
+        );
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
     osMutexAcquire(socket_mutex, osWaitForever);
 
     sock = allocate_socket();
@@ -350,7 +536,8 @@ udp_status_t udp_socket_create(udp_socket_handle_t *handle, uint16_t local_port)
         goto cleanup_get_socket;
     }
 
-    sock->rx_pool = osMemoryPoolNew(UDP_RX_QUEUE_LEN, sizeof(udp_rx_pkt_t), NULL);
+    sock->rx_pool =
+        osMemoryPoolNew(rx->queue_len, sizeof(udp_rx_pkt_t) + rx->max_len, NULL);
     if (sock->rx_pool == NULL)
     {
         LOG_ERROR("Failed to create RX memory pool");
@@ -358,7 +545,7 @@ udp_status_t udp_socket_create(udp_socket_handle_t *handle, uint16_t local_port)
         goto cleanup_open;
     }
 
-    sock->rx_queue = osMessageQueueNew(UDP_RX_QUEUE_LEN, sizeof(udp_rx_pkt_t *), NULL);
+    sock->rx_queue = osMessageQueueNew(rx->queue_len, sizeof(udp_rx_pkt_t *), NULL);
     if (sock->rx_queue == NULL)
     {
         LOG_ERROR("Failed to create RX message queue");
@@ -368,16 +555,17 @@ udp_status_t udp_socket_create(udp_socket_handle_t *handle, uint16_t local_port)
 
     sock->local_port = local_port;
     sock->flags |= SOCKET_FLAG_BOUND;
-    sock->recv_len = 0;
+    sock->rx_queue_len      = rx->queue_len;
+    sock->rx_max_len        = rx->max_len;
+    sock->rx_filter         = rx->filter;
+    sock->rx_filter_context = rx->filter_context;
 
-    *handle = sock;
+    /* The socket must be complete before the receive callback can see it */
+    __DMB();
+    socket_by_net_handle[sock->net_socket] = sock;
 
-    uint8_t ip_addr[NET_ADDR_IP4_LEN];
-    netIF_GetOption(
-        NET_IF_CLASS_ETH | 0, netIF_OptionIP4_Address, ip_addr, sizeof(ip_addr)
-    );
+    *handle = sock;
 
-    netARP_CacheIP(NET_IF_CLASS_ETH | 0, ip_addr, netARP_CacheFixedIP);
     osMutexRelease(socket_mutex);
     return UDP_STATUS_OK;
 
@@ -421,6 +609,13 @@ udp_status_t udp_socket_close(udp_socket_handle_t handle)
     }
 
     sock->flags |= SOCKET_FLAG_CLOSING;
+    if (sock->net_socket > 0 && sock->net_socket <= UDP_NUM_SOCKS &&
+        socket_by_net_handle[sock->net_socket] == sock)
+    {
+        socket_by_net_handle[sock->net_socket] = NULL;
+    }
+    rx_wait_for_callbacks();
+
     if (sock->rx_queue != NULL)
     {
         LOG_DEBUG("Resetting RX message queue before closing socket");
@@ -441,41 +636,74 @@ udp_status_t udp_socket_close(udp_socket_handle_t handle)
     return UDP_STATUS_OK;
 }
 
-udp_status_t udp_socket_send(
-    udp_socket_handle_t handle, const udp_endpoint_t *remote, const uint8_t *data,
-    size_t len
-)
+/**
+ * @brief Check that a socket can send right now
+ */
+static udp_status_t check_can_send(const udp_socket_internal_t *sock)
 {
-    if (!module_initialized)
+    if (!(sock->flags & SOCKET_FLAG_BOUND))
     {
-        LOG_WARNING("UDP socket module not initialized");
+        LOG_WARNING("UDP socket not bound");
         return UDP_STATUS_NOT_INIT;
     }
 
-    if (handle == NULL || remote == NULL || data == NULL || len == 0)
+    if (!udp_socket_is_link_up())
     {
-        LOG_CRITICAL("Invalid parameter(s) provided to udp_socket_send");
-        return UDP_STATUS_INVALID_PARAM;
+        LOG_WARNING("UDP link is down");
+        return UDP_STATUS_LINK_DOWN;
     }
 
-    if (len > UDP_MAX_PAYLOAD_SIZE)
+    return UDP_STATUS_OK;
+}
+
+/**
+ * @brief Charge one datagram to the send buffer ledger
+ * @return false if the datagram would leave too little memory in the pool
+ */
+static bool tx_pool_take(size_t len)
+{
+    osMutexAcquire(tx_pool_mutex, osWaitForever);
+
+    uint64_t now = system_time_us();
+    if (tx_pool.drain != s_link_bytes_per_s)
     {
-        LOG_WARNING("UDP payload too large: %u > %u", len, UDP_MAX_PAYLOAD_SIZE);
-        return UDP_STATUS_INVALID_PARAM;
+        net_pool_set_drain(&tx_pool, s_link_bytes_per_s, now);
     }
+    bool taken = net_pool_take(&tx_pool, len, now);
 
-    udp_socket_internal_t *sock = (udp_socket_internal_t *)handle;
+    osMutexRelease(tx_pool_mutex);
+    return taken;
+}
 
-    if (!(sock->flags & SOCKET_FLAG_BOUND))
+/**
+ * @brief Pay back the charge of a datagram the stack did not send
+ */
+static void tx_pool_refund(size_t len)
+{
+    osMutexAcquire(tx_pool_mutex, osWaitForever);
+    net_pool_refund(&tx_pool, len, system_time_us());
+    osMutexRelease(tx_pool_mutex);
+}
+
+/**
+ * @brief Copy one datagram into a network stack buffer and send it
+ * @note The caller has checked the socket with check_can_send().
+ */
+static udp_status_t send_datagram(
+    const udp_socket_internal_t *sock, const udp_endpoint_t *remote,
+    const uint8_t *data, size_t len
+)
+{
+    if (len > UDP_MAX_PAYLOAD_SIZE)
     {
-        LOG_WARNING("UDP socket not bound");
-        return UDP_STATUS_NOT_INIT;
+        LOG_WARNING("UDP payload too large: %u > %u", len, UDP_MAX_PAYLOAD_SIZE);
+        return UDP_STATUS_INVALID_PARAM;
     }
 
-    if (!udp_socket_is_link_up())
+    if (!tx_pool_take(len))
     {
-        LOG_WARNING("UDP link is down");
-        return UDP_STATUS_LINK_DOWN;
+        LOG_DEBUG("UDP send refused, network pool low");
+        return UDP_STATUS_NO_MEMORY;
     }
 
     NET_ADDR addr;
@@ -484,6 +712,7 @@ udp_status_t udp_socket_send(
     uint8_t *sendbuf = netUDP_GetBuffer(len);
     if (sendbuf == NULL)
     {
+        tx_pool_refund(len);
         LOG_ERROR("Failed to allocate UDP send buffer");
         return UDP_STATUS_NO_MEMORY;
     }
@@ -494,7 +723,8 @@ udp_status_t udp_socket_send(
     netStatus status = netUDP_Send(sock->net_socket, &addr, sendbuf, (uint32_t)len);
     if (status != netOK)
     {
-        /* Buffer ownership transferred to stack even on error */
+        /* Buffer ownership transferred to stack even on error, which frees it */
+        tx_pool_refund(len);
         LOG_ERROR("UDP send failed: %d", status);
         return UDP_STATUS_NET_ERROR;
     }
@@ -502,6 +732,103 @@ udp_status_t udp_socket_send(
     return UDP_STATUS_OK;
 }
 
+udp_status_t udp_socket_send(
+    udp_socket_handle_t handle, const udp_endpoint_t *remote, const uint8_t *data,
+    size_t len
+)
+{
+    if (!module_initialized)
+    {
+        LOG_WARNING("UDP socket module not initialized");
+        return UDP_STATUS_NOT_INIT;
+    }
+
+    if (handle == NULL || remote == NULL || data == NULL || len == 0)
+    {
+        LOG_CRITICAL("Invalid parameter(s) provided to udp_socket_send");
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    udp_socket_internal_t *sock   = (udp_socket_internal_t *)handle;
+    udp_status_t           status = check_can_send(sock);
+
+    if (status != UDP_STATUS_OK)
+    {
+        return status;
+    }
+
+    return send_datagram(sock, remote, data, len);
+}
+
+/**
+ * @details netUDP_Send() takes ownership of its buffer, so each datagram is
+ * still copied into its own stack buffer; the batch saves the per-datagram
+ * checks and the link query.
+ */
+udp_status_t udp_socket_send_batch(
+    udp_socket_handle_t handle, const udp_datagram_t *datagrams, size_t count,
+    udp_status_t *results
+)
+{
+    udp_status_t status = UDP_STATUS_OK;
+
+    if (!module_initialized)
+    {
+        LOG_WARNING("UDP socket module not initialized");
+        status = UDP_STATUS_NOT_INIT;
+    }
+    else if (handle == NULL || datagrams == NULL || results == NULL || count == 0)
+    {
+        LOG_CRITICAL("Invalid parameter(s) provided to udp_socket_send_batch");
+        status = UDP_STATUS_INVALID_PARAM;
+    }
+    else
+    {
+        status = check_can_send((udp_socket_internal_t *)handle);
+    }
+
+    if (status != UDP_STATUS_OK)
+    {
+        for (size_t i = 0; results != NULL && i < count; i++)
+        {
+            results[i] = status;
+        }
+        return status;
+    }
+
+    udp_socket_internal_t *sock = (udp_socket_internal_t *)handle;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const udp_datagram_t *datagram = &datagrams[i];
+
+        if (datagram->remote == NULL || datagram->data == NULL || datagram->len == 0)
+        {
+            results[i] = UDP_STATUS_INVALID_PARAM;
+            continue;
+        }
+
+        results[i] =
+            send_datagram(sock, datagram->remote, datagram->data, datagram->len);
+    }
+
+    return UDP_STATUS_OK;
+}
+
+uint32_t udp_socket_tx_wait_us(size_t len, size_t count)
+{
+    if (!module_initialized)
+    {
+        return 0;
+    }
+
+    osMutexAcquire(tx_pool_mutex, osWaitForever);
+    uint32_t wait_us = net_pool_wait_us(&tx_pool, len, count, system_time_us());
+    osMutexRelease(tx_pool_mutex);
+
+    return wait_us;
+}
+
 udp_status_t udp_socket_sendto(
     udp_socket_handle_t handle, const char *ip_addr, uint16_t port, const uint8_t *data,
     size_t len
@@ -524,6 +851,16 @@ udp_status_t udp_socket_recv(
     udp_socket_handle_t handle, udp_endpoint_t *remote, uint8_t *buffer,
     size_t buffer_len, size_t *received, uint32_t timeout_ms
 )
+{
+    return udp_socket_recv_timestamped(
+        handle, remote, buffer, buffer_len, received, NULL, timeout_ms
+    );
+}
+
+udp_status_t udp_socket_recv_timestamped(
+    udp_socket_handle_t handle, udp_endpoint_t *remote, uint8_t *buffer,
+    size_t buffer_len, size_t *received, uint64_t *rx_time_us, uint32_t timeout_ms
+)
 {
     if (!module_initialized)
     {
@@ -556,7 +893,8 @@ udp_status_t udp_socket_recv(
     udp_rx_pkt_t *pkt       = NULL;
     osStatus_t    os_status = osMessageQueueGet(sock->rx_queue, &pkt, NULL, timeout_ms);
 
-    if (os_status == osErrorTimeout)
+    /* RTX reports an empty queue polled without a timeout as osErrorResource */
+    if (os_status == osErrorTimeout || os_status == osErrorResource)
     {
         LOG_DEBUG("UDP receive timeout after %u ms", timeout_ms);
         return UDP_STATUS_TIMEOUT;
@@ -582,6 +920,11 @@ udp_status_t udp_socket_recv(
         *remote = pkt->remote;
     }
 
+    if (rx_time_us != NULL)
+    {
+        *rx_time_us = pkt->rx_time_us;
+    }
+
     if (sock->rx_pool != NULL)
     {
         (void)osMemoryPoolFree(sock->rx_pool, pkt);
@@ -590,6 +933,179 @@ udp_status_t udp_socket_recv(
     return UDP_STATUS_OK;
 }
 
+udp_status_t udp_socket_get_rx_stats(udp_socket_handle_t handle, udp_rx_stats_t *stats)
+{
+    if (handle == NULL || stats == NULL)
+    {
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    udp_socket_internal_t *sock = (udp_socket_internal_t *)handle;
+
+    stats->rx_dropped    = sock->rx_dropped;
+    stats->rx_rejected   = sock->rx_rejected;
+    stats->rx_queued     = 0;
+    stats->rx_queue_size = sock->rx_queue_len;
+    if (sock->rx_queue != NULL)
+    {
+        stats->rx_queued = osMessageQueueGetCount(sock->rx_queue);
+    }
+
+    return UDP_STATUS_OK;
+}
+
+/**
+ * @details Until netETH_Notify() has reported the link once, the state comes from
+ * the interface address, which raises no event, so that case is polled.
+ */
+bool udp_socket_wait_for_link(uint32_t timeout_ms)
+{
+    uint32_t start = osKernelGetTickCount();
+
+    while (!udp_socket_is_link_up())
+    {
+        uint32_t elapsed = osKernelGetTickCount() - start;
+
+        if (link_events == NULL ||
+            (timeout_ms != osWaitForever && elapsed >= timeout_ms))
+        {
+            return false;
+        }
+
+        uint32_t wait = (timeout_ms == osWaitForever) ? osWaitForever
+                                                       : timeout_ms - elapsed;
+        if (!s_eth_link_known && wait > UDP_LINK_POLL_MS)
+        {
+            wait = UDP_LINK_POLL_MS;
+        }
+
+        (void)osEventFlagsWait(
+            link_events, UDP_LINK_EVENT_UP, osFlagsWaitAny | osFlagsNoClear, wait
+        );
+    }
+
+    return true;
+}
+
+udp_status_t udp_socket_arp_pin(const udp_ipv4_addr_t *ip)
+{
+    if (ip == NULL)
+    {
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    if (!module_initialized)
+    {
+        return UDP_STATUS_NOT_INIT;
+    }
+
+    if (!udp_socket_is_link_up())
+    {
+        return UDP_STATUS_LINK_DOWN;
+    }
+
+    netStatus status =
+        netARP_CacheIP(NET_IF_CLASS_ETH | 0, ip->addr, netARP_CacheFixedIP);
+
+    /* netBusy: not cached yet, a request went out */
+    if (status != netOK && status != netBusy)
+    {
+        return (status == netInvalidParameter) ? UDP_STATUS_INVALID_PARAM
+                                               : UDP_STATUS_NET_ERROR;
+    }
+
+    return udp_socket_arp_cached(ip) ? UDP_STATUS_OK : UDP_STATUS_TIMEOUT;
+}
+
+/**
+ * @details The stack raises no event for an ARP reply, so callers poll this.
+ */
+bool udp_socket_arp_cached(const udp_ipv4_addr_t *ip)
+{
+    uint8_t mac[NET_ADDR_ETH_LEN];
+
+    if (ip == NULL || !module_initialized)
+    {
+        return false;
+    }
+
+    return netARP_GetMAC(NET_IF_CLASS_ETH | 0, ip->addr, mac) == netOK;
+}
+
+/**
+ * @details Caching the address again as temporary turns the fixed entry into
+ * an ordinary one.
+ */
+udp_status_t udp_socket_arp_unpin(const udp_ipv4_addr_t *ip)
+{
+    if (ip == NULL)
+    {
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    if (!module_initialized)
+    {
+        return UDP_STATUS_NOT_INIT;
+    }
+
+    netStatus status =
+        netARP_CacheIP(NET_IF_CLASS_ETH | 0, ip->addr, netARP_CacheTempIP);
+
+    return (status == netOK || status == netBusy) ? UDP_STATUS_OK
+                                                  : UDP_STATUS_NET_ERROR;
+}
+
+udp_status_t udp_socket_get_pool_stats(udp_pool_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return UDP_STATUS_INVALID_PARAM;
+    }
+
+    if (!module_initialized)
+    {
+        return UDP_STATUS_NOT_INIT;
+    }
+
+    osMutexAcquire(tx_pool_mutex, osWaitForever);
+    stats->tx_pool_size = tx_pool.size;
+    stats->tx_pool_used = net_pool_used(&tx_pool, system_time_us());
+    stats->tx_pool_peak = tx_pool.peak;
+    stats->tx_refused   = tx_pool.refused;
+    osMutexRelease(tx_pool_mutex);
+
+    return UDP_STATUS_OK;
+}
+
+void udp_socket_log_link_info(void)
+{
+    ARM_ETH_LINK_INFO info = Driver_ETH_PHY0.GetLinkInfo();
+
+    LOG_DEBUG("PHY speed=%u duplex=%u", (unsigned)info.speed, (unsigned)info.duplex);
+}
+
+void udp_socket_log_driver_state(void)
+{
+    if (logger_get_level() > LOG_LEVEL_DEBUG)
+    {
+        return;
+    }
+
+    uint32_t tx_index = LPC_EMAC->TxConsumeIndex;
+    uint32_t tx_slot  = tx_index % (LPC_EMAC->TxDescriptorNumber + 1U);
+    const volatile uint32_t *tx_status =
+        (const volatile uint32_t *)(uintptr_t)LPC_EMAC->TxStatus;
+
+    LOG_DEBUG(
+        "IntStatus=%08lX IntEnable=%08lX", LPC_EMAC->IntStatus, LPC_EMAC->IntEnable
+    );
+    LOG_DEBUG(
+        "RxPI=%lu RxCI=%lu TxPI=%lu TxCI=%lu", LPC_EMAC->RxProduceIndex,
+        LPC_EMAC->RxConsumeIndex, LPC_EMAC->TxProduceIndex, tx_index
+    );
+    LOG_DEBUG("TX: CI=%lu Stat[%lu]=%08lX", tx_index, tx_slot, tx_status[tx_slot]);
+}
+
 bool udp_socket_is_link_up(void)
 {
     if (s_eth_link_known)
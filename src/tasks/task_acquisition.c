@@ -7,15 +7,28 @@
 
 #include "task_acquisition.h"
 
+#include "LPC17xx.h"
+#include "decimator.h"
+#include "fft.h"
 #include "logger.h"
 #include "panic.h"
 #include "protocol.h"
+#include "pulse.h"
+#include "stats.h"
+#include "summary.h"
+#include "system.h"
 #include "task_network.h"
 
 #include <string.h>
 
-/** Acquisition loop delay in ms (controls sample rate) */
+/** Interval in ms between draining the ADC sample buffer */
 #define ACQUISITION_LOOP_DELAY_MS 1
+/** Longest time a detected pulse waits for more pulses before it is sent */
+#define ACQUISITION_EVENT_MAX_AGE_US 1000000U
+/** Longest time in ms a burst capture may take before it is aborted */
+#define ACQUISITION_CAPTURE_TIMEOUT_MS 100
+/** Delay in ms before a configuration the ADC refused is tried again */
+#define ACQUISITION_ADOPT_RETRY_MS 500
 
 static osThreadId_t         acquisition_thread      = NULL;
 static const osThreadAttr_t acquisition_thread_attr = {
@@ -23,15 +36,160 @@ static const osThreadAttr_t acquisition_thread_attr = {
     .stack_size = TASK_ACQUISITION_STACK_SIZE,
     .priority   = TASK_ACQUISITION_PRIORITY,
 };
-static volatile acquisition_state_t current_state   = ACQ_STATE_IDLE;
-static acquisition_stats_t          stats           = {0};
-static adc_channel_t                current_channel = TASK_ACQUISITION_DEFAULT_CHANNEL;
-static uint16_t threshold_mv = TASK_ACQUISITION_DEFAULT_THRESHOLD_MV;
-static uint16_t batch_size   = ACQUISITION_DEFAULT_BATCH_SIZE;
-static uint16_t sample_buffer[ACQUISITION_MAX_BATCH_SIZE];
-static uint16_t sample_index = 0;
-static bool     initialized  = false;
-static uint8_t  tx_buffer[512];
+
+/**
+ * @brief Acquisition parameters adopted together at a batch boundary
+ */
+typedef struct
+{
+    adc_channel_t      channel;        /**< ADC channel */
+    uint16_t           threshold_mv;   /**< Trigger level in millivolts */
+    uint16_t           batch_size;     /**< Samples per packet */
+    acquisition_mode_t mode;           /**< What is sent for the signal */
+    uint16_t           summary_window; /**< Samples per summary */
+    uint16_t           fft_average;    /**< FFT frames averaged per spectrum */
+    uint16_t           decimation;     /**< Decimation ratio, 1 = unfiltered */
+    uint16_t           dead_time;      /**< Samples ignored after a pulse */
+    uint32_t           sample_rate_hz; /**< ADC sample rate */
+} acquisition_config_t;
+
+/**
+ * @brief FFT frame being filled and the magnitudes of completed frames
+ * @details 16-bit magnitudes of up to 256 frames fit the 32-bit sums. Once the
+ * spectrum is sent, the frame buffer holds the averaged bins.
+ */
+typedef struct
+{
+    int16_t  frame[FFT_SIZE]; /**< Windowed samples, transformed in place */
+    uint32_t bins[FFT_BINS];  /**< Sum of magnitudes per bin */
+    uint16_t index;           /**< Samples in the current frame */
+    uint16_t frames;          /**< Completed frames in bins */
+    uint64_t start_us;        /**< Device time of the first sample */
+} spectrum_acc_t;
+
+/**
+ * @brief Pulses waiting to be sent in one event packet
+ */
+typedef struct
+{
+    protocol_event_t events[ACQUISITION_MAX_EVENTS]; /**< Pulses, oldest first */
+    uint16_t         count;                          /**< Pulses in events */
+    uint64_t         start_us;                       /**< Start of the first pulse */
+} event_batch_t;
+
+/** Default acquisition parameters */
+static const acquisition_config_t default_config = {
+    .channel        = TASK_ACQUISITION_DEFAULT_CHANNEL,
+    .threshold_mv   = TASK_ACQUISITION_DEFAULT_THRESHOLD_MV,
+    .batch_size     = ACQUISITION_DEFAULT_BATCH_SIZE,
+    .mode           = ACQ_MODE_RAW,
+    .summary_window = ACQUISITION_DEFAULT_SUMMARY_WINDOW,
+    .fft_average    = 1,
+    .decimation     = 1,
+    .dead_time      = 0,
+    .sample_rate_hz = ACQUISITION_DEFAULT_SAMPLE_RATE_HZ,
+};
+
+static volatile acquisition_state_t current_state = ACQ_STATE_IDLE;
+static acquisition_stats_t          stats         = {0};
+static stats_seq_t                  stats_seq     = {0};
+
+/**
+ * Configuration mailbox. The network task writes the slot that is not
+ * published, then flips config_published and bumps config_version. The
+ * acquisition task copies the published slot and retries if the version
+ * changed meanwhile, so neither side ever waits for the other.
+ */
+static acquisition_config_t config_slots[2];
+static volatile uint32_t    config_published = 0;
+static volatile uint32_t    config_version   = 0;
+
+/** Changes collected between acquisition_config_begin() and _commit() */
+static acquisition_config_t config_staged;
+static bool                 config_staging = false;
+static bool                 config_dirty   = false;
+
+/** Configuration used by the acquisition task, owned by that task */
+static acquisition_config_t active;
+static uint32_t             active_version = 0;
+/** Set while the ADC refuses the published configuration, since refused_tick */
+static bool     adopt_refused = false;
+static uint32_t refused_tick  = 0;
+
+static uint16_t         sample_buffer[ACQUISITION_MAX_BATCH_SIZE];
+static uint16_t         sample_index   = 0;
+static uint64_t         batch_start_us = 0;
+static bool             initialized    = false;
+static uint8_t          tx_buffer[512];
+static summary_acc_t    summary;
+static spectrum_acc_t   spectrum;
+static decimator_t      decimator;
+static event_batch_t    event_batch;
+static pulse_detector_t pulse_detector;
+static bool             sampling         = false;
+static uint32_t         sample_period_ns = 0;
+static uint64_t         sample_time_us   = 0;
+
+/**
+ * Burst capture buffer. The scatter file places .bss.capture in AHB SRAM
+ * bank 1, away from the stacks and heaps in local SRAM.
+ */
+static uint16_t capture_buffer[ACQUISITION_CAPTURE_MAX_SAMPLES]
+    __attribute__((section(".bss.capture")));
+
+/**
+ * The network task requests a capture by setting capture_state to
+ * CAPTURE_STATE_RUNNING and then capture_requested. The acquisition task
+ * fills capture_info before it sets CAPTURE_STATE_DONE.
+ */
+static acquisition_capture_t                capture_info;
+static volatile acquisition_capture_state_t capture_state     = CAPTURE_STATE_IDLE;
+static volatile bool                        capture_requested = false;
+
+/**
+ * @brief Count an acquisition error
+ * @note Only the acquisition task writes the statistics.
+ */
+static void count_error(void)
+{
+    stats_write_begin(&stats_seq);
+    stats.errors++;
+    stats_write_end(&stats_seq);
+}
+
+static void spectrum_reset(spectrum_acc_t *acc)
+{
+    acc->index  = 0;
+    acc->frames = 0;
+    memset(acc->bins, 0, sizeof(acc->bins));
+}
+
+/**
+ * @brief Window a sample into the current frame, transforming it when full
+ */
+static void spectrum_add(spectrum_acc_t *acc, uint16_t sample)
+{
+    if (acc->index == 0 && acc->frames == 0)
+    {
+        acc->start_us = sample_time_us;
+    }
+
+    acc->frame[acc->index] = fft_window_sample(sample, acc->index);
+    acc->index++;
+
+    if (acc->index < FFT_SIZE)
+    {
+        return;
+    }
+
+    fft_real_q15(acc->frame);
+    for (size_t k = 0; k < FFT_BINS; k++)
+    {
+        acc->bins[k] += fft_magnitude(acc->frame, k);
+    }
+    acc->index = 0;
+    acc->frames++;
+}
 
 /**
  * @brief Convert millivolts to ADC value
@@ -41,6 +199,574 @@ static uint16_t mv_to_adc(uint16_t mv)
     return (uint16_t)((uint32_t)mv * 4095 / ADC_VREF_MV);
 }
 
+/**
+ * @brief Append a detected pulse to the event batch
+ */
+static void event_add(event_batch_t *batch, const pulse_t *pulse)
+{
+    if (batch->count == 0)
+    {
+        batch->start_us = pulse->start_us;
+    }
+
+    protocol_event_t *event = &batch->events[batch->count++];
+
+    /* Batches are sent within ACQUISITION_EVENT_MAX_AGE_US, so offsets fit */
+    event->offset_us = (uint32_t)(pulse->start_us - batch->start_us);
+    event->peak      = pulse->peak;
+    event->width     = pulse->width;
+    event->area      = pulse->area;
+}
+
+/**
+ * @brief Publish a new configuration to the acquisition task
+ * @details The change is applied at the next batch boundary.
+ * @note Only the network task may call this.
+ */
+static void publish_config(const acquisition_config_t *config)
+{
+    if (config_staging)
+    {
+        config_staged = *config;
+        config_dirty  = true;
+        return;
+    }
+
+    uint32_t next = config_published ^ 1U;
+
+    config_slots[next] = *config;
+    /* Slot contents must be visible before it is published */
+    __DMB();
+    config_published = next;
+    config_version++;
+}
+
+/**
+ * @brief Get the most recently published configuration, or the staged one
+ * @note Only the network task may call this; it is the only writer.
+ */
+static const acquisition_config_t *published_config(void)
+{
+    return config_staging ? &config_staged : &config_slots[config_published];
+}
+
+/**
+ * @brief Send the samples collected so far as one data packet
+ */
+static void send_batch(void)
+{
+    size_t            packet_len;
+    protocol_status_t proto_status = protocol_build_data_packet(
+        tx_buffer, sizeof(tx_buffer), active.channel, sample_buffer, sample_index,
+        (active.decimation > 1) ? PROTOCOL_DATA_FLAG_FRAC4 : 0, batch_start_us,
+        &packet_len
+    );
+
+    if (proto_status == PROTO_STATUS_OK)
+    {
+        if (network_send_raw(active.channel, tx_buffer, packet_len) == 0)
+        {
+            LOG_INFO("Sent %u samples (%u bytes)", sample_index, packet_len);
+            stats_write_begin(&stats_seq);
+            stats.packets_sent++;
+            stats.samples_sent += sample_index;
+            stats_write_end(&stats_seq);
+        }
+        else
+        {
+            LOG_ERROR("Failed to send data packet");
+            count_error();
+        }
+    }
+    else
+    {
+        LOG_CRITICAL("Failed to build data packet: %d", proto_status);
+        count_error();
+    }
+
+    sample_index = 0;
+}
+
+/**
+ * @brief Send the statistics of the current window as one summary packet
+ */
+static void send_summary(void)
+{
+    summary_t                  result;
+    protocol_summary_payload_t payload;
+    size_t                     packet_len;
+
+    summary_finish(&summary, PROTOCOL_SUMMARY_FRAC_BITS, &result);
+    payload.channel      = (uint8_t)active.channel;
+    payload.flags        = 0;
+    payload.sample_count = result.count;
+    payload.min          = result.min;
+    payload.max          = result.max;
+    payload.mean         = result.mean;
+    payload.rms          = result.rms;
+    payload.timestamp_us = result.start_us;
+
+    protocol_status_t proto_status = protocol_build_summary_packet(
+        tx_buffer, sizeof(tx_buffer), &payload, &packet_len
+    );
+
+    if (proto_status == PROTO_STATUS_OK)
+    {
+        if (network_send_raw(active.channel, tx_buffer, packet_len) == 0)
+        {
+            LOG_DEBUG(
+                "Sent summary of %u samples: min %u, max %u", payload.sample_count,
+                payload.min, payload.max
+            );
+            stats_write_begin(&stats_seq);
+            stats.packets_sent++;
+            stats.samples_sent += summary.count;
+            stats_write_end(&stats_seq);
+        }
+        else
+        {
+            LOG_ERROR("Failed to send summary packet");
+            count_error();
+        }
+    }
+    else
+    {
+        LOG_CRITICAL("Failed to build summary packet: %d", proto_status);
+        count_error();
+    }
+
+    summary_reset(&summary);
+}
+
+/**
+ * @brief Send the averaged magnitudes of the completed frames
+ * @note A partially filled frame is dropped.
+ */
+static void send_spectrum(void)
+{
+    uint16_t *bins   = (uint16_t *)spectrum.frame;
+    uint32_t  frames = spectrum.frames;
+    size_t    packet_len;
+
+    for (size_t k = 0; k < FFT_BINS; k++)
+    {
+        bins[k] = (uint16_t)((spectrum.bins[k] + frames / 2U) / frames);
+    }
+
+    protocol_status_t proto_status = protocol_build_spectrum_packet(
+        tx_buffer, sizeof(tx_buffer), active.channel, bins, FFT_BINS, FFT_SIZE,
+        spectrum.frames, spectrum.start_us, &packet_len
+    );
+
+    if (proto_status == PROTO_STATUS_OK)
+    {
+        if (network_send_raw(active.channel, tx_buffer, packet_len) == 0)
+        {
+            LOG_DEBUG("Sent spectrum of %u frames", spectrum.frames);
+            stats_write_begin(&stats_seq);
+            stats.packets_sent++;
+            stats.samples_sent += (uint32_t)spectrum.frames * FFT_SIZE;
+            stats_write_end(&stats_seq);
+        }
+        else
+        {
+            LOG_ERROR("Failed to send spectrum packet");
+            count_error();
+        }
+    }
+    else
+    {
+        LOG_CRITICAL("Failed to build spectrum packet: %d", proto_status);
+        count_error();
+    }
+
+    spectrum_reset(&spectrum);
+}
+
+/**
+ * @brief Send the pulses detected so far as one event packet
+ */
+static void send_events(void)
+{
+    size_t            packet_len;
+    protocol_status_t proto_status = protocol_build_event_packet(
+        tx_buffer, sizeof(tx_buffer), active.channel, event_batch.events,
+        event_batch.count, event_batch.start_us, &packet_len
+    );
+
+    if (proto_status == PROTO_STATUS_OK)
+    {
+        if (network_send_raw(active.channel, tx_buffer, packet_len) == 0)
+        {
+            LOG_DEBUG("Sent %u events (%u bytes)", event_batch.count, packet_len);
+            stats_write_begin(&stats_seq);
+            stats.packets_sent++;
+            stats_write_end(&stats_seq);
+        }
+        else
+        {
+            LOG_ERROR("Failed to send event packet");
+            count_error();
+        }
+    }
+    else
+    {
+        LOG_CRITICAL("Failed to build event packet: %d", proto_status);
+        count_error();
+    }
+
+    event_batch.count = 0;
+}
+
+/**
+ * @brief Restart the filter and pulse detector with the active configuration
+ * @details Old samples must not leak into the next stream. A pulse still in
+ * progress is dropped.
+ */
+static void reset_stream(void)
+{
+    (void)decimator_init(&decimator, active.decimation);
+    pulse_detector_init(
+        &pulse_detector, mv_to_adc(active.threshold_mv), active.dead_time
+    );
+}
+
+/**
+ * @brief Send whatever was collected under the active configuration
+ * @details Nothing is sent while acquisition is stopped; pending samples are
+ * dropped instead.
+ */
+static void flush_pending(void)
+{
+    bool running = (current_state == ACQ_STATE_RUNNING);
+
+    if (sample_index > 0 && running)
+    {
+        send_batch();
+    }
+    sample_index = 0;
+
+    if (summary.count > 0 && running)
+    {
+        send_summary();
+    }
+    summary_reset(&summary);
+
+    if (spectrum.frames > 0 && running)
+    {
+        send_spectrum();
+    }
+    spectrum_reset(&spectrum);
+
+    if (event_batch.count > 0 && running)
+    {
+        send_events();
+    }
+    event_batch.count = 0;
+
+    reset_stream();
+}
+
+/**
+ * @brief Start timer-triggered sampling at the active rate
+ * @return 0 on success, -1 if the ADC refused the rate
+ */
+static int start_sampling(void)
+{
+    if (adc_start_sampling(active.sample_rate_hz) != ADC_OK)
+    {
+        LOG_ERROR("Failed to start sampling at %u Hz", active.sample_rate_hz);
+        return -1;
+    }
+
+    sample_period_ns =
+        (uint32_t)(1000000000000ULL / adc_sample_rate_millihz(active.sample_rate_hz));
+    sampling = true;
+    LOG_INFO("Sampling at %u Hz", active.sample_rate_hz);
+    return 0;
+}
+
+/**
+ * @brief Stop sampling, dropping samples not processed yet
+ */
+static void stop_sampling(void)
+{
+    if (sampling)
+    {
+        (void)adc_stop_sampling();
+        sampling = false;
+    }
+}
+
+/**
+ * @brief Take a burst capture on the active channel
+ * @details Streaming stops while the ADC fills capture_buffer and restarts
+ * on the next loop iteration, so the capture rate is not limited by the
+ * network.
+ */
+static void run_capture(void)
+{
+    uint32_t waited = 0;
+
+    stop_sampling();
+    flush_pending();
+
+    capture_info.start_us = system_time_us();
+    if (adc_start_capture(
+            capture_buffer, capture_info.count, ACQUISITION_CAPTURE_RATE_HZ
+        ) != ADC_OK)
+    {
+        LOG_ERROR("Failed to start capture of %u samples", capture_info.count);
+        count_error();
+        capture_state = CAPTURE_STATE_IDLE;
+        return;
+    }
+
+    while (!adc_capture_done() && waited < ACQUISITION_CAPTURE_TIMEOUT_MS)
+    {
+        osDelay(1);
+        waited++;
+    }
+
+    if (!adc_capture_done())
+    {
+        (void)adc_stop_sampling();
+        LOG_WARNING(
+            "Capture timed out after %u of %u samples", adc_capture_progress(),
+            capture_info.count
+        );
+        count_error();
+    }
+
+    uint32_t overruns = adc_capture_overrun_count();
+
+    capture_info.samples     = capture_buffer;
+    capture_info.count       = (uint16_t)adc_capture_progress();
+    capture_info.channel     = (uint8_t)active.channel;
+    capture_info.overruns    = (uint8_t)(overruns > UINT8_MAX ? UINT8_MAX : overruns);
+    capture_info.sample_rate = adc_sample_rate_millihz(ACQUISITION_CAPTURE_RATE_HZ);
+
+    /* The network task reads capture_info once it sees CAPTURE_STATE_DONE */
+    __DMB();
+    capture_state = CAPTURE_STATE_DONE;
+
+    LOG_INFO("Captured %u samples", capture_info.count);
+    reset_stream();
+}
+
+/**
+ * @brief Adopt a configuration published by the network task
+ * @details A partial batch or window is sent with the configuration it was
+ * collected under, so each packet is consistent with a single configuration.
+ * If the ADC refuses the new channel, sampling goes back to the old one and
+ * the version stays unadopted, so it is retried after ACQUISITION_ADOPT_RETRY_MS.
+ */
+static void adopt_config(void)
+{
+    acquisition_config_t next;
+    uint32_t             version;
+
+    do
+    {
+        version = config_version;
+        __DMB();
+        next = config_slots[config_published];
+        __DMB();
+    } while (version != config_version);
+
+    flush_pending();
+
+    if (next.channel != active.channel || next.sample_rate_hz != active.sample_rate_hz)
+    {
+        stop_sampling();
+    }
+
+    if (next.channel != active.channel)
+    {
+        adc_deinit();
+        if (adc_init(next.channel) != ADC_OK)
+        {
+            LOG_ERROR("Failed to switch to channel %u", next.channel);
+            count_error();
+            adopt_refused = true;
+            refused_tick  = osKernelGetTickCount();
+            if (adc_init(active.channel) != ADC_OK)
+            {
+                current_state = ACQ_STATE_ERROR;
+            }
+            reset_stream();
+            return;
+        }
+        LOG_INFO("ADC channel set to %u", next.channel);
+    }
+
+    active         = next;
+    active_version = version;
+    adopt_refused  = false;
+    reset_stream();
+}
+
+/**
+ * @brief Count one sample taken into a batch, window or frame
+ */
+static void count_sample(void)
+{
+    stats_write_begin(&stats_seq);
+    stats.samples_collected++;
+    stats_write_end(&stats_seq);
+}
+
+/**
+ * @brief Round a decimator output to whole ADC counts
+ */
+static uint16_t filtered_to_adc(uint16_t filtered)
+{
+    return (uint16_t)((filtered + (1U << (DECIMATOR_FRAC_BITS - 1))) >>
+                      DECIMATOR_FRAC_BITS);
+}
+
+/**
+ * @brief Buffer a sample above threshold and send full batches
+ * @details Decimated samples keep their fractional bits, matching
+ * PROTOCOL_DATA_FLAG_FRAC4.
+ */
+static void collect_raw(uint16_t filtered)
+{
+    uint16_t threshold_adc = mv_to_adc(active.threshold_mv);
+    uint16_t adc_value     = filtered >> DECIMATOR_FRAC_BITS;
+
+    if (active.decimation > 1)
+    {
+        threshold_adc <<= DECIMATOR_FRAC_BITS;
+        adc_value = filtered;
+    }
+
+    LOG_DEBUG("ADC value: %u, Threshold: %u", adc_value, threshold_adc);
+    if (adc_value < threshold_adc)
+    {
+        return;
+    }
+
+    if (sample_index == 0)
+    {
+        batch_start_us = sample_time_us;
+    }
+    sample_buffer[sample_index++] = adc_value;
+    count_sample();
+
+    if (sample_index >= active.batch_size)
+    {
+        send_batch();
+    }
+}
+
+/**
+ * @brief Add a sample to the summary window and send full windows
+ */
+static void collect_summary(uint16_t adc_value)
+{
+    summary_add(&summary, adc_value, sample_time_us);
+    count_sample();
+
+    if (summary.count >= active.summary_window)
+    {
+        send_summary();
+    }
+}
+
+/**
+ * @brief Add a sample to the FFT frame and send once enough frames are averaged
+ */
+static void collect_spectrum(uint16_t adc_value)
+{
+    spectrum_add(&spectrum, adc_value);
+    count_sample();
+
+    if (spectrum.frames >= active.fft_average)
+    {
+        send_spectrum();
+    }
+}
+
+/**
+ * @brief Run the pulse detector and send events when the batch is full or old
+ */
+static void collect_event(uint16_t adc_value)
+{
+    uint64_t now_us = sample_time_us;
+    pulse_t  pulse;
+
+    count_sample();
+    if (pulse_detector_process(&pulse_detector, adc_value, now_us, &pulse))
+    {
+        event_add(&event_batch, &pulse);
+    }
+
+    if (event_batch.count >= ACQUISITION_MAX_EVENTS ||
+        (event_batch.count > 0 &&
+         now_us - event_batch.start_us >= ACQUISITION_EVENT_MAX_AGE_US))
+    {
+        send_events();
+    }
+}
+
+/**
+ * @brief Filter one sample and pass it to the active mode
+ */
+static void process_sample(uint16_t adc_value)
+{
+    uint16_t filtered;
+
+    if (!decimator_process(&decimator, adc_value, &filtered))
+    {
+        return;
+    }
+
+    switch (active.mode)
+    {
+        case ACQ_MODE_SUMMARY:
+            collect_summary(filtered_to_adc(filtered));
+            break;
+
+        case ACQ_MODE_SPECTRUM:
+            collect_spectrum(filtered_to_adc(filtered));
+            break;
+
+        case ACQ_MODE_EVENT:
+            collect_event(filtered_to_adc(filtered));
+            break;
+
+        default:
+            collect_raw(filtered);
+            break;
+    }
+}
+
+/**
+ * @brief Process every sample the ADC has buffered since the last call
+ * @details The newest buffered sample was converted just now and the older
+ * ones one sample period apart, which dates each sample without reading the
+ * clock per sample.
+ */
+static void drain_samples(void)
+{
+    uint32_t pending = adc_buffered_count();
+    uint64_t now_us  = system_time_us();
+    uint16_t adc_value;
+
+    if (pending > 0)
+    {
+        (void)system_boot_mark(SYSTEM_BOOT_FIRST_SAMPLE);
+    }
+
+    while (pending > 0 && adc_read_buffered(&adc_value) == ADC_OK)
+    {
+        pending--;
+        sample_time_us = now_us - ((uint64_t)pending * sample_period_ns) / 1000U;
+        process_sample(adc_value);
+    }
+}
+
 /**
  * @brief Main acquisition task
  */
@@ -48,74 +774,46 @@ static void acquisition_task(void *argument)
 {
     (void)argument;
 
-    uint16_t adc_value;
-    uint16_t threshold_adc;
-
     LOG_INFO("Acquisition task started");
 
     while (1)
     {
-        if (current_state != ACQ_STATE_RUNNING)
+        if (active_version != config_version &&
+            (!adopt_refused ||
+             osKernelGetTickCount() - refused_tick >= ACQUISITION_ADOPT_RETRY_MS))
         {
-            osDelay(100);
-            continue;
+            adopt_config();
         }
 
-        if (!network_is_ready())
+        if (capture_requested)
         {
+            capture_requested = false;
+            run_capture();
+        }
+
+        if (current_state != ACQ_STATE_RUNNING)
+        {
+            stop_sampling();
+            flush_pending();
             osDelay(100);
             continue;
         }
 
-        adc_status_t status = adc_read_sync(&adc_value);
-        if (status != ADC_OK)
+        if (!network_is_streaming())
         {
-            stats.errors++;
-            osDelay(ACQUISITION_LOOP_DELAY_MS);
+            stop_sampling();
+            osDelay(100);
             continue;
         }
 
-        threshold_adc = mv_to_adc(threshold_mv);
-
-        LOG_DEBUG("ADC value: %u, Threshold: %u", adc_value, threshold_adc);
-        if (adc_value >= threshold_adc)
+        if (!sampling && start_sampling() != 0)
         {
-            sample_buffer[sample_index++] = adc_value;
-            stats.samples_collected++;
-
-            if (sample_index >= batch_size)
-            {
-                size_t            packet_len;
-                protocol_status_t proto_status = protocol_build_data_packet(
-                    tx_buffer, sizeof(tx_buffer), current_channel, sample_buffer,
-                    sample_index, &packet_len
-                );
-
-                if (proto_status == PROTO_STATUS_OK)
-                {
-                    if (network_send_raw(tx_buffer, packet_len) == 0)
-                    {
-                        LOG_INFO(
-                            "Sent %u samples (%u bytes)", sample_index, packet_len
-                        );
-                        stats.packets_sent++;
-                    }
-                    else
-                    {
-                        LOG_ERROR("Failed to send data packet");
-                        stats.errors++;
-                    }
-                }
-                else
-                {
-                    LOG_CRITICAL("Failed to build data packet: %d", proto_status);
-                    stats.errors++;
-                }
-
-                sample_index = 0;
-            }
+            count_error();
+            current_state = ACQ_STATE_ERROR;
+            continue;
         }
 
+        drain_samples();
         osDelay(ACQUISITION_LOOP_DELAY_MS);
     }
 }
@@ -128,14 +826,26 @@ int acquisition_init(void)
         return 0;
     }
 
-    if (adc_init(current_channel) != ADC_OK)
+    config_slots[0]  = default_config;
+    config_slots[1]  = default_config;
+    config_published = 0;
+    config_version   = 0;
+    active           = default_config;
+    active_version   = 0;
+    adopt_refused    = false;
+
+    if (adc_init(active.channel) != ADC_OK)
     {
         panic("ADC initialization failed", NULL);
         return -1;
     }
 
     memset(&stats, 0, sizeof(stats));
-    sample_index  = 0;
+    summary_reset(&summary);
+    spectrum_reset(&spectrum);
+    reset_stream();
+    event_batch.count = 0;
+    sample_index      = 0;
     current_state = ACQ_STATE_IDLE;
 
     initialized = true;
@@ -183,8 +893,8 @@ int acquisition_start(void)
     sample_index  = 0;
     current_state = ACQ_STATE_RUNNING;
     LOG_INFO(
-        "Acquisition started on channel %u, threshold %u mV", current_channel,
-        threshold_mv
+        "Acquisition started on channel %u, threshold %u mV",
+        published_config()->channel, published_config()->threshold_mv
     );
 
     return 0;
@@ -214,41 +924,64 @@ acquisition_state_t acquisition_get_state(void)
     return current_state;
 }
 
+void acquisition_config_begin(void)
+{
+    config_staged  = config_slots[config_published];
+    config_staging = true;
+    config_dirty   = false;
+}
+
+void acquisition_config_commit(void)
+{
+    config_staging = false;
+    if (config_dirty)
+    {
+        config_dirty = false;
+        publish_config(&config_staged);
+    }
+}
+
 int acquisition_set_threshold_mv(uint16_t mv)
 {
+    acquisition_config_t config = *published_config();
+
     if (mv > ADC_VREF_MV)
     {
         LOG_ERROR(
             "Invalid threshold value: %u mV. Keep threshold unchanged at %u mV", mv,
-            threshold_mv
+            config.threshold_mv
         );
         return -1;
     }
 
-    threshold_mv = mv;
-    LOG_DEBUG("Threshold set to %u mV", threshold_mv);
+    config.threshold_mv = mv;
+    publish_config(&config);
+    LOG_DEBUG("Threshold set to %u mV", mv);
     return 0;
 }
 
 int acquisition_set_threshold_percent(uint8_t percent)
 {
+    acquisition_config_t config = *published_config();
+
     if (percent > 100)
     {
         LOG_ERROR(
             "Invalid threshold percentage: %u%%. Keep threshold unchanged at %u mV",
-            percent, threshold_mv
+            percent, config.threshold_mv
         );
         return -1;
     }
 
-    threshold_mv = (uint16_t)((uint32_t)percent * ADC_VREF_MV / 100);
-    LOG_DEBUG("Threshold set to %u%% (%u mV)", percent, threshold_mv);
+    config.threshold_mv = (uint16_t)((uint32_t)percent * ADC_VREF_MV / 100);
+    publish_config(&config);
+    LOG_DEBUG("Threshold set to %u%% (%u mV)", percent, config.threshold_mv);
     return 0;
 }
 
 uint16_t acquisition_get_threshold_mv(void)
 {
-    return threshold_mv;
+    return published_config()->threshold_mv;
 }
 
 int acquisition_set_channel(adc_channel_t channel)
@@ -258,20 +991,14 @@ int acquisition_set_channel(adc_channel_t channel)
         LOG_ERROR("Invalid ADC channel: %u", channel);
         return -1;
     }
-    LOG_INFO("Switching to ADC channel %u", channel);
-    /* Need to reinitialize ADC for new channel */
-    if (current_channel != channel)
+
+    acquisition_config_t config = *published_config();
+    if (config.channel != channel)
     {
-        adc_deinit();
-        adc_status_t status = adc_init(channel);
-        if (status != ADC_OK)
-        {
-            LOG_ERROR("Failed to switch to channel %u", channel);
-            current_state = ACQ_STATE_ERROR;
-            return -1;
-        }
-        current_channel = channel;
-        LOG_INFO("ADC channel set to %u", channel);
+        /* The acquisition task reinitializes the ADC at the next batch boundary */
+        LOG_INFO("Switching to ADC channel %u", channel);
+        config.channel = channel;
+        publish_config(&config);
     }
 
     return 0;
@@ -279,15 +1006,25 @@ int acquisition_set_channel(adc_channel_t channel)
 
 adc_channel_t acquisition_get_channel(void)
 {
-    return current_channel;
+    return published_config()->channel;
 }
 
 void acquisition_get_stats(acquisition_stats_t *out_stats)
 {
     if (out_stats != NULL)
     {
-        *out_stats = stats;
+        stats_read(&stats_seq, out_stats, &stats, sizeof(*out_stats));
+    }
+}
+
+uint32_t acquisition_get_stack_free(void)
+{
+    if (acquisition_thread == NULL)
+    {
+        return 0;
     }
+
+    return osThreadGetStackSpace(acquisition_thread);
 }
 
 int acquisition_set_batch_size(uint16_t size)
@@ -297,13 +1034,181 @@ int acquisition_set_batch_size(uint16_t size)
         return -1;
     }
 
-    batch_size   = size;
-    sample_index = 0; /* Reset buffer on batch size change */
-    LOG_DEBUG("Batch size set to %u samples", batch_size);
+    acquisition_config_t config = *published_config();
+
+    config.batch_size = size;
+    publish_config(&config);
+    LOG_DEBUG("Batch size set to %u samples", size);
     return 0;
 }
 
 uint16_t acquisition_get_batch_size(void)
 {
-    return batch_size;
+    return published_config()->batch_size;
+}
+
+int acquisition_set_mode(acquisition_mode_t mode)
+{
+    if (mode != ACQ_MODE_RAW && mode != ACQ_MODE_SUMMARY && mode != ACQ_MODE_SPECTRUM &&
+        mode != ACQ_MODE_EVENT)
+    {
+        LOG_ERROR("Invalid acquisition mode: %u", mode);
+        return -1;
+    }
+
+    acquisition_config_t config = *published_config();
+
+    config.mode = mode;
+    publish_config(&config);
+    LOG_DEBUG("Acquisition mode set to %u", mode);
+    return 0;
+}
+
+acquisition_mode_t acquisition_get_mode(void)
+{
+    return published_config()->mode;
+}
+
+int acquisition_set_summary_window(uint16_t window)
+{
+    if (window == 0)
+    {
+        return -1;
+    }
+
+    acquisition_config_t config = *published_config();
+
+    config.summary_window = window;
+    publish_config(&config);
+    LOG_DEBUG("Summary window set to %u samples", window);
+    return 0;
+}
+
+uint16_t acquisition_get_summary_window(void)
+{
+    return published_config()->summary_window;
+}
+
+int acquisition_set_spectrum_average(uint16_t frames)
+{
+    if (frames == 0 || frames > ACQUISITION_MAX_SPECTRUM_AVERAGE)
+    {
+        return -1;
+    }
+
+    acquisition_config_t config = *published_config();
+
+    config.fft_average = frames;
+    publish_config(&config);
+    LOG_DEBUG("Spectrum averaging set to %u frames", frames);
+    return 0;
+}
+
+uint16_t acquisition_get_spectrum_average(void)
+{
+    return published_config()->fft_average;
+}
+
+int acquisition_set_decimation(uint16_t ratio)
+{
+    if (ratio == 0 || ratio > DECIMATOR_MAX_RATIO)
+    {
+        return -1;
+    }
+
+    acquisition_config_t config = *published_config();
+
+    config.decimation = ratio;
+    publish_config(&config);
+    LOG_DEBUG("Decimation set to %u", ratio);
+    return 0;
+}
+
+uint16_t acquisition_get_decimation(void)
+{
+    return published_config()->decimation;
+}
+
+int acquisition_set_event_dead_time(uint16_t samples)
+{
+    acquisition_config_t config = *published_config();
+
+    config.dead_time = samples;
+    publish_config(&config);
+    LOG_DEBUG("Event dead time set to %u samples", samples);
+    return 0;
+}
+
+uint16_t acquisition_get_event_dead_time(void)
+{
+    return published_config()->dead_time;
+}
+
+int acquisition_set_sample_rate(uint32_t rate_hz)
+{
+    if (rate_hz < ADC_MIN_SAMPLE_RATE_HZ || rate_hz > ADC_MAX_SAMPLE_RATE_HZ)
+    {
+        LOG_ERROR("Invalid sample rate: %u Hz", rate_hz);
+        return -1;
+    }
+
+    acquisition_config_t config = *published_config();
+
+    config.sample_rate_hz = rate_hz;
+    publish_config(&config);
+    LOG_DEBUG("Sample rate set to %u Hz", rate_hz);
+    return 0;
+}
+
+uint32_t acquisition_get_sample_rate(void)
+{
+    return published_config()->sample_rate_hz;
+}
+
+uint32_t acquisition_get_actual_sample_rate_millihz(void)
+{
+    return adc_sample_rate_millihz(published_config()->sample_rate_hz);
+}
+
+int acquisition_capture_start(uint16_t samples)
+{
+    if (!initialized)
+    {
+        panic("Acquisition not initialized", NULL);
+        return -1;
+    }
+
+    if (samples == 0 || samples > ACQUISITION_CAPTURE_MAX_SAMPLES)
+    {
+        return -1;
+    }
+
+    if (capture_state == CAPTURE_STATE_RUNNING)
+    {
+        return -1;
+    }
+
+    capture_info.count = samples;
+    capture_state      = CAPTURE_STATE_RUNNING;
+    __DMB();
+    capture_requested = true;
+
+    return 0;
+}
+
+acquisition_capture_state_t acquisition_capture_state(void)
+{
+    return capture_state;
+}
+
+int acquisition_capture_get(acquisition_capture_t *capture)
+{
+    if (capture == NULL || capture_state != CAPTURE_STATE_DONE)
+    {
+        return -1;
+    }
+
+    __DMB();
+    *capture = capture_info;
+    return 0;
 }
@@ -28,8 +28,9 @@ static void init_task(void *argument)
     LPC_GPIO1->FIODIR |= (1u << 14);
     LPC_GPIO1->FIOCLR = (1u << 14);
 
-    // Accept unicast and broadcast but not multicast
-    LPC_EMAC->RxFilterCtrl = 0x22;
+    // Accept own unicast, broadcast and multicast hash matches (IGMP queries and
+    // groups joined by the stack), but not every multicast frame on the wire
+    LPC_EMAC->RxFilterCtrl = 0x32;
 
     if (network_task_start() != 0)
     {
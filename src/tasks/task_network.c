@@ -7,26 +7,36 @@
 
 #include "task_network.h"
 
-#include "Driver_ETH_MAC.h"
-#include "Driver_ETH_PHY.h"
-#include "LPC17xx.h"
-#include "PIN_LPC17xx.h"
 #include "logger.h"
+#include "pacer.h"
 #include "panic.h"
-#include "rl_net.h"
+#include "session.h"
+#include "stats.h"
+#include "system.h"
 #include "task_acquisition.h"
 
-extern ARM_DRIVER_ETH_MAC Driver_ETH_MAC0;
-extern ARM_DRIVER_ETH_PHY Driver_ETH_PHY0;
-
 #include <string.h>
 
 /** Maximum packet buffer size in bytes */
 #define PACKET_BUFFER_SIZE 1500
-/** Link check interval in ms */
-#define LINK_CHECK_INTERVAL 500
+/** Link wait timeout at startup in ms */
+#define LINK_WAIT_TIMEOUT 30000
+/** Interval of the reminders logged while the link stays down, in ms */
+#define LINK_OUTAGE_LOG_INTERVAL 10000
+/** IP address check interval in ms */
+#define IP_CHECK_INTERVAL 100
 /** IP address wait timeout in ms */
 #define IP_WAIT_TIMEOUT 30000
+/** Time a new subscriber's ARP reply is waited for in ms, see service_arp_waits() */
+#define ARP_RESOLVE_TIMEOUT 200
+/** Requests the control socket queues, enough for a burst of retries */
+#define CONTROL_RX_QUEUE_LEN 8U
+/** Requests the data socket queues, hosts rarely send to it */
+#define DATA_RX_QUEUE_LEN 2U
+/** Time a repeated request is treated as a duplicate, in ms */
+#define REQUEST_REPEAT_WINDOW 1000U
+/** Hosts whose last request each socket remembers, the oldest is forgotten first */
+#define REQUEST_REPEAT_HOSTS 8U
 
 static osThreadId_t         network_thread      = NULL;
 static const osThreadAttr_t network_thread_attr = {
@@ -35,31 +45,152 @@ static const osThreadAttr_t network_thread_attr = {
     .priority   = TASK_NETWORK_PRIORITY,
 };
 static volatile network_state_t current_state       = NET_STATE_INIT;
-static network_stats_t          stats               = {0};
-static udp_socket_handle_t      udp_socket          = NULL;
-static udp_endpoint_t           remote_target       = {0};
-static bool                     target_set_by_start = false;
+static udp_socket_handle_t      control_socket      = NULL;
+static udp_socket_handle_t      data_socket         = NULL;
 static uint8_t                  tx_buffer[PACKET_BUFFER_SIZE];
-static uint8_t                  rx_buffer[PACKET_BUFFER_SIZE];
+static uint8_t                  rx_buffer[PROTOCOL_MAX_REQUEST_SIZE];
 static bool                     initialized = false;
+/** Multicast publish endpoint, the group address is zero while disabled */
+static udp_endpoint_t mcast_target = {.port = TASK_NETWORK_MCAST_PORT};
+/** Receive timestamp of the packet currently being dispatched */
+static uint64_t current_rx_time_us = 0;
+/** Data stream rate limits set by CMD_CONFIGURE, 0 = unlimited */
+static volatile uint32_t pace_bytes_per_s   = 0;
+static volatile uint32_t pace_packets_per_s = 0;
+/** Set while the data path holds its packets for a link that is not up */
+static volatile bool hold_stream = false;
+
+/** Subscriber addresses pinned in the ARP cache, used by the network task only */
+static udp_ipv4_addr_t pinned_hosts[SESSION_MAX_SUBSCRIBERS];
+static size_t          pinned_count = 0;
 
 /**
- * @brief Wait for Ethernet link to come up
+ * @brief Stream start waiting for the host's ARP reply
  */
-static bool wait_for_link(uint32_t timeout_ms)
+typedef struct
 {
-    uint32_t start = osKernelGetTickCount();
+    udp_endpoint_t remote;       /**< Host to subscribe */
+    uint64_t       start_us;     /**< Time the ARP request went out */
+    uint8_t        channel_mask; /**< Requested channels, 0 for the auto-start host */
+} arp_wait_t;
 
-    while ((osKernelGetTickCount() - start) < timeout_ms)
+/** Stream starts deferred until the ARP reply, used by the network task only */
+static arp_wait_t arp_waits[SESSION_MAX_SUBSCRIBERS];
+static size_t     arp_wait_count = 0;
+
+/** Auto-start target, pinned once the socket is ready */
+static udp_endpoint_t autostart_target;
+static bool           autostart_enabled = false;
+
+/**
+ * @brief Header of one packet in the backlog
+ */
+typedef struct __attribute__((packed))
+{
+    uint16_t len;     /**< Packet length */
+    uint8_t  channel; /**< ADC channel the packet belongs to */
+} backlog_entry_t;
+
+/**
+ * @brief Data packets held while the link is down, used by the data path only
+ */
+typedef struct
+{
+    uint8_t  data[TASK_NETWORK_BACKLOG_SIZE]; /**< Entries, each before its packet */
+    size_t   used;     /**< Bytes used in data */
+    uint32_t held;     /**< Packets in data */
+    uint32_t dropped;  /**< Packets that did not fit since the first was held */
+    uint64_t since_us; /**< Device time when the first packet was held */
+    uint32_t discards; /**< Last backlog_discards acted on */
+} stream_backlog_t;
+
+static stream_backlog_t backlog = {0};
+/** Bumped by the network task when the last subscriber leaves, see stream() */
+static volatile uint32_t backlog_discards = 0;
+
+/** Data path pacer and the limits it was set up with, used by publish() only */
+static pacer_t  data_pacer;
+static uint32_t data_pacer_bytes_per_s   = 0;
+static uint32_t data_pacer_packets_per_s = 0;
+
+/**
+ * @brief Network counters updated by a single thread
+ */
+typedef struct
+{
+    stats_seq_t     seq;      /**< Snapshot sequence counter */
+    network_stats_t counters; /**< Counters */
+} network_stats_block_t;
+
+/** Counters written by the network task (receive path and responses) */
+static network_stats_block_t task_stats = {0};
+/** Counters written by the data path (caller of network_send_data/raw) */
+static network_stats_block_t data_stats = {0};
+
+static void count_sent(network_stats_block_t *block, size_t len)
+{
+    stats_write_begin(&block->seq);
+    block->counters.packets_sent++;
+    block->counters.bytes_sent += len;
+    stats_write_end(&block->seq);
+}
+
+static void count_received(network_stats_block_t *block, size_t len)
+{
+    stats_write_begin(&block->seq);
+    block->counters.packets_received++;
+    block->counters.bytes_received += len;
+    stats_write_end(&block->seq);
+}
+
+static void count_error(network_stats_block_t *block)
+{
+    stats_write_begin(&block->seq);
+    block->counters.errors++;
+    stats_write_end(&block->seq);
+}
+
+static void count_paced(network_stats_block_t *block, uint32_t wait_ms)
+{
+    stats_write_begin(&block->seq);
+    block->counters.paced++;
+    block->counters.paced_ms += wait_ms;
+    stats_write_end(&block->seq);
+}
+
+static void count_outage(network_stats_block_t *block)
+{
+    stats_write_begin(&block->seq);
+    block->counters.outages++;
+    stats_write_end(&block->seq);
+}
+
+static void count_arp(network_stats_block_t *block, bool resolved, uint32_t resolve_us)
+{
+    stats_write_begin(&block->seq);
+    if (resolved)
     {
-        if (udp_socket_is_link_up())
-        {
-            return true;
-        }
-        osDelay(LINK_CHECK_INTERVAL);
+        block->counters.arp_resolve_us = resolve_us;
     }
+    else
+    {
+        block->counters.arp_failed++;
+    }
+    stats_write_end(&block->seq);
+}
 
-    return false;
+static void count_held(network_stats_block_t *block, bool dropped)
+{
+    stats_write_begin(&block->seq);
+    if (dropped)
+    {
+        block->counters.held_dropped++;
+    }
+    else
+    {
+        block->counters.held++;
+    }
+    stats_write_end(&block->seq);
 }
 
 /**
@@ -80,136 +211,1017 @@ static bool wait_for_ip(uint32_t timeout_ms)
                 return true;
             }
         }
-        osDelay(500);
+        osDelay(IP_CHECK_INTERVAL);
     }
 
     return false;
 }
 
 /**
- * @brief Handle received command
+ * @brief Handler applying a single configuration parameter
+ * @return 0 on success, negative on error
+ */
+typedef int (*config_handler_t)(uint32_t value);
+
+/**
+ * @brief Handler of a single command code
+ */
+typedef void (*cmd_handler_t)(
+    const protocol_cmd_payload_t *cmd, const udp_endpoint_t *remote
+);
+
+/**
+ * @brief Handler of a single message type
+ */
+typedef void (*msg_handler_t)(
+    const uint8_t *payload, size_t payload_len, const udp_endpoint_t *remote
+);
+
+/**
+ * @brief Message dispatch table entry
+ */
+typedef struct
+{
+    msg_handler_t handler;         /**< Handler, NULL for unsupported types */
+    uint16_t      min_payload_len; /**< Minimum payload length in bytes */
+} msg_dispatch_entry_t;
+
+/** Number of entries in a dispatch table */
+#define DISPATCH_TABLE_SIZE(table) (sizeof(table) / sizeof((table)[0]))
+
+/**
+ * @brief Send a response packet built in tx_buffer
+ */
+static void send_response(const udp_endpoint_t *remote, size_t len)
+{
+    if (udp_socket_send(control_socket, remote, tx_buffer, len) == UDP_STATUS_OK)
+    {
+        count_sent(&task_stats, len);
+    }
+    else
+    {
+        count_error(&task_stats);
+    }
+}
+
+static int config_threshold_percent(uint32_t value)
+{
+    if (value > 100 || acquisition_set_threshold_percent((uint8_t)value) != 0)
+    {
+        return -1;
+    }
+    LOG_INFO("Threshold set to %u%%", value);
+    return 0;
+}
+
+static int config_threshold_mv(uint32_t value)
+{
+    if (acquisition_set_threshold_mv((uint16_t)value) != 0)
+    {
+        return -1;
+    }
+    LOG_INFO("Threshold set to %u mV", value);
+    return 0;
+}
+
+static int config_batch_size(uint32_t value)
+{
+    if (acquisition_set_batch_size((uint16_t)value) != 0)
+    {
+        LOG_WARNING(
+            "Invalid batch size: %u (max %u)", value, ACQUISITION_MAX_BATCH_SIZE
+        );
+        return -1;
+    }
+    LOG_INFO("Batch size set to %u", value);
+    return 0;
+}
+
+static int config_channel(uint32_t value)
+{
+    if (acquisition_set_channel((adc_channel_t)value) != 0)
+    {
+        return -1;
+    }
+    LOG_INFO("Channel set to %u", value);
+    return 0;
+}
+
+static int config_reset_sequence(uint32_t value)
+{
+    (void)value;
+    protocol_reset_sequence();
+    LOG_INFO("Sequence counter reset");
+    return 0;
+}
+
+static int config_log_level(uint32_t value)
+{
+    if (value > LOG_LEVEL_NONE)
+    {
+        return -1;
+    }
+    logger_set_level((log_level_t)value);
+    LOG_INFO("Log level set to %u", value);
+    return 0;
+}
+
+static int config_data_crc(uint32_t value)
+{
+    protocol_set_data_crc(value != 0);
+    LOG_INFO("Data packet CRC32C %s", value != 0 ? "enabled" : "disabled");
+    return 0;
+}
+
+/**
+ * @brief Hand the multicast endpoint to the session table
+ */
+static void update_multicast(void)
+{
+    bool enabled = mcast_target.ip.addr[0] != 0;
+
+    (void)session_set_multicast(enabled ? &mcast_target : NULL);
+    if (enabled)
+    {
+        LOG_INFO(
+            "Publishing to multicast group %u.%u.%u.%u:%u", mcast_target.ip.addr[0],
+            mcast_target.ip.addr[1], mcast_target.ip.addr[2], mcast_target.ip.addr[3],
+            mcast_target.port
+        );
+    }
+    else
+    {
+        LOG_INFO("Publishing to subscribers by unicast");
+    }
+}
+
+static int config_mcast_group(uint32_t value)
+{
+    /* Zero disables multicast, anything else must be in 224.0.0.0/4 */
+    if (value != 0 && (value >> 28) != 0xEU)
+    {
+        LOG_WARNING("Not a multicast address: 0x%08X", value);
+        return -1;
+    }
+
+    mcast_target.ip.addr[0] = (uint8_t)(value >> 24);
+    mcast_target.ip.addr[1] = (uint8_t)(value >> 16);
+    mcast_target.ip.addr[2] = (uint8_t)(value >> 8);
+    mcast_target.ip.addr[3] = (uint8_t)value;
+    update_multicast();
+    return 0;
+}
+
+static int config_mcast_port(uint32_t value)
+{
+    mcast_target.port = (uint16_t)value;
+    update_multicast();
+    return 0;
+}
+
+static int config_acq_mode(uint32_t value)
+{
+    if (acquisition_set_mode((acquisition_mode_t)value) != 0)
+    {
+        return -1;
+    }
+    LOG_INFO("Acquisition mode set to %u", value);
+    return 0;
+}
+
+static int config_summary_window(uint32_t value)
+{
+    if (acquisition_set_summary_window((uint16_t)value) != 0)
+    {
+        return -1;
+    }
+    LOG_INFO("Summary window set to %u samples", value);
+    return 0;
+}
+
+static int config_spectrum_average(uint32_t value)
+{
+    if (acquisition_set_spectrum_average((uint16_t)value) != 0)
+    {
+        return -1;
+    }
+    LOG_INFO("Spectrum averaging set to %u frames", value);
+    return 0;
+}
+
+static int config_decimation(uint32_t value)
+{
+    if (acquisition_set_decimation((uint16_t)value) != 0)
+    {
+        return -1;
+    }
+    LOG_INFO("Decimation set to %u", value);
+    return 0;
+}
+
+static int config_event_dead_time(uint32_t value)
+{
+    if (acquisition_set_event_dead_time((uint16_t)value) != 0)
+    {
+        return -1;
+    }
+    LOG_INFO("Event dead time set to %u samples", value);
+    return 0;
+}
+
+static int config_sample_rate(uint32_t value)
+{
+    if (acquisition_set_sample_rate(value) != 0)
+    {
+        return -1;
+    }
+    LOG_INFO(
+        "Sample rate set to %u Hz (%u mHz achieved)", value,
+        acquisition_get_actual_sample_rate_millihz()
+    );
+    return 0;
+}
+
+static int config_pace_bytes(uint32_t value)
+{
+    pace_bytes_per_s = value;
+    LOG_INFO("Data stream byte rate limit set to %u B/s (0 = off)", value);
+    return 0;
+}
+
+static int config_pace_packets(uint32_t value)
+{
+    pace_packets_per_s = value;
+    LOG_INFO("Data stream packet rate limit set to %u packets/s (0 = off)", value);
+    return 0;
+}
+
+/** Configuration handlers indexed by protocol_config_param_t */
+static const config_handler_t config_dispatch[] = {
+    [CONFIG_THRESHOLD_PERCENT]  = config_threshold_percent,
+    [CONFIG_THRESHOLD_MV]       = config_threshold_mv,
+    [CONFIG_BATCH_SIZE]         = config_batch_size,
+    [CONFIG_CHANNEL]            = config_channel,
+    [CONFIG_RESET_SEQUENCE]     = config_reset_sequence,
+    [CONFIG_LOG_LEVEL]          = config_log_level,
+    [CONFIG_DATA_CRC]           = config_data_crc,
+    [CONFIG_MCAST_GROUP]        = config_mcast_group,
+    [CONFIG_MCAST_PORT]         = config_mcast_port,
+    [CONFIG_ACQ_MODE]           = config_acq_mode,
+    [CONFIG_SUMMARY_WINDOW]     = config_summary_window,
+    [CONFIG_SPECTRUM_AVERAGE]   = config_spectrum_average,
+    [CONFIG_DECIMATION]         = config_decimation,
+    [CONFIG_EVENT_DEAD_TIME]    = config_event_dead_time,
+    [CONFIG_SAMPLE_RATE_HZ]     = config_sample_rate,
+    [CONFIG_PACE_BYTES_PER_S]   = config_pace_bytes,
+    [CONFIG_PACE_PACKETS_PER_S] = config_pace_packets,
+};
+
+/**
+ * @brief Apply a single configuration parameter
+ * @return 0 on success, negative on error
+ */
+static int apply_config_param(uint8_t param_type, uint32_t value)
+{
+    if (param_type >= DISPATCH_TABLE_SIZE(config_dispatch) ||
+        config_dispatch[param_type] == NULL)
+    {
+        LOG_WARNING("Unknown config param_type: %u", param_type);
+        return -1;
+    }
+
+    return config_dispatch[param_type](value);
+}
+
+/**
+ * @brief Check if a stream start is waiting for the ARP reply of a host
+ */
+static bool arp_wait_pending(const udp_ipv4_addr_t *ip)
+{
+    for (size_t i = 0; i < arp_wait_count; i++)
+    {
+        if (memcmp(arp_waits[i].remote.ip.addr, ip->addr, sizeof(ip->addr)) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Find the deferred stream start of an endpoint
+ * @return Index into arp_waits, arp_wait_count if there is none
+ */
+static size_t find_arp_wait(const udp_endpoint_t *remote)
+{
+    size_t i = 0;
+
+    while (i < arp_wait_count &&
+           (arp_waits[i].remote.port != remote->port ||
+            memcmp(arp_waits[i].remote.ip.addr, remote->ip.addr,
+                   sizeof(remote->ip.addr)) != 0))
+    {
+        i++;
+    }
+
+    return i;
+}
+
+/**
+ * @brief Start resolving a subscriber's MAC address before data is sent to it
+ * @details The entry stays fixed while the host has a subscription, see
+ * unpin_departed_hosts(). The reply is not waited for here, the control socket
+ * keeps being served meanwhile; service_arp_waits() picks it up.
+ * @return true if the address is resolved or there is nothing to wait for
+ */
+static bool pin_host(const udp_ipv4_addr_t *ip)
+{
+    for (size_t i = 0; i < pinned_count; i++)
+    {
+        if (memcmp(pinned_hosts[i].addr, ip->addr, sizeof(ip->addr)) == 0)
+        {
+            return udp_socket_arp_cached(ip) || !arp_wait_pending(ip);
+        }
+    }
+
+    if (pinned_count == SESSION_MAX_SUBSCRIBERS)
+    {
+        return true;
+    }
+
+    udp_status_t status = udp_socket_arp_pin(ip);
+
+    if (status == UDP_STATUS_OK || status == UDP_STATUS_TIMEOUT)
+    {
+        pinned_hosts[pinned_count++] = *ip;
+    }
+
+    if (status == UDP_STATUS_OK)
+    {
+        LOG_INFO(
+            "ARP: %u.%u.%u.%u already resolved", ip->addr[0], ip->addr[1],
+            ip->addr[2], ip->addr[3]
+        );
+        count_arp(&task_stats, true, 0);
+    }
+    else if (status != UDP_STATUS_TIMEOUT)
+    {
+        LOG_WARNING(
+            "ARP: %u.%u.%u.%u not resolved (%d)", ip->addr[0], ip->addr[1],
+            ip->addr[2], ip->addr[3], status
+        );
+        count_arp(&task_stats, false, 0);
+    }
+
+    return status != UDP_STATUS_TIMEOUT;
+}
+
+/**
+ * @brief Hold a stream start back until the host's ARP reply
+ * @details A repeated START while waiting only updates the channel mask.
+ * @return false if the table is full and the start has to go ahead now
+ */
+static bool defer_start(const udp_endpoint_t *remote, uint8_t channel_mask)
+{
+    size_t i = find_arp_wait(remote);
+
+    if (i == arp_wait_count)
+    {
+        if (arp_wait_count == SESSION_MAX_SUBSCRIBERS)
+        {
+            return false;
+        }
+
+        arp_waits[i].remote   = *remote;
+        arp_waits[i].start_us = system_time_us();
+        arp_wait_count++;
+    }
+
+    arp_waits[i].channel_mask = channel_mask;
+    return true;
+}
+
+/**
+ * @brief Release the ARP entries of hosts left without a subscription
+ */
+static void unpin_departed_hosts(void)
+{
+    for (size_t i = 0; i < pinned_count;)
+    {
+        if (session_has_host(&pinned_hosts[i]) || arp_wait_pending(&pinned_hosts[i]))
+        {
+            i++;
+            continue;
+        }
+
+        (void)udp_socket_arp_unpin(&pinned_hosts[i]);
+        pinned_hosts[i] = pinned_hosts[--pinned_count];
+    }
+}
+
+/**
+ * @brief Subscribe a host to the data stream and start acquisition
+ */
+static void start_stream(const udp_endpoint_t *remote, uint8_t channel_mask)
+{
+    session_status_t status =
+        session_subscribe(remote, channel_mask, TASK_NETWORK_SESSION_LEASE_MS);
+    if (status != SESSION_STATUS_OK)
+    {
+        LOG_WARNING(
+            "Cannot subscribe %u.%u.%u.%u:%u (error %d)", remote->ip.addr[0],
+            remote->ip.addr[1], remote->ip.addr[2], remote->ip.addr[3], remote->port,
+            status
+        );
+        count_error(&task_stats);
+        unpin_departed_hosts();
+        return;
+    }
+
+    LOG_INFO(
+        "Subscriber %u.%u.%u.%u:%u added (mask 0x%02X, %u total)", remote->ip.addr[0],
+        remote->ip.addr[1], remote->ip.addr[2], remote->ip.addr[3], remote->port,
+        channel_mask, session_count()
+    );
+
+    if (!acquisition_is_running() && acquisition_start() != 0)
+    {
+        LOG_ERROR("Failed to start acquisition");
+    }
+}
+
+/**
+ * @brief Complete the stream starts whose ARP reply arrived or timed out
+ * @details A host that does not answer in time is subscribed anyway and stays
+ * pinned; the stack keeps asking and the first packets may still be lost. The
+ * auto-start host's packets are held until then.
+ */
+static void service_arp_waits(void)
+{
+    uint64_t now = system_time_us();
+
+    for (size_t i = 0; i < arp_wait_count;)
+    {
+        arp_wait_t wait       = arp_waits[i];
+        uint32_t   elapsed_us = (uint32_t)(now - wait.start_us);
+        bool       resolved   = udp_socket_arp_cached(&wait.remote.ip);
+
+        if (!resolved && elapsed_us < ARP_RESOLVE_TIMEOUT * 1000U)
+        {
+            i++;
+            continue;
+        }
+
+        const uint8_t *addr = wait.remote.ip.addr;
+        if (resolved)
+        {
+            LOG_INFO(
+                "ARP: %u.%u.%u.%u resolved in %u us", addr[0], addr[1], addr[2],
+                addr[3], elapsed_us
+            );
+        }
+        else
+        {
+            LOG_WARNING(
+                "ARP: %u.%u.%u.%u not resolved in %u ms", addr[0], addr[1], addr[2],
+                addr[3], ARP_RESOLVE_TIMEOUT
+            );
+        }
+        count_arp(&task_stats, resolved, resolved ? elapsed_us : 0U);
+
+        arp_waits[i] = arp_waits[--arp_wait_count];
+        if (wait.channel_mask == 0U)
+        {
+            hold_stream = false;
+        }
+        else
+        {
+            start_stream(&wait.remote, wait.channel_mask);
+        }
+    }
+}
+
+/**
+ * @brief Stop acquisition and drop the held packets once nobody is subscribed
+ * @details The backlog belongs to the subscribers that left; replayed on the
+ * next start it would deliver stale packets and a gap for an outage nobody saw.
+ * The data path owns the backlog, so it is only told to discard it.
+ */
+static void end_stream(void)
+{
+    backlog_discards++;
+    if (acquisition_is_running())
+    {
+        acquisition_stop();
+    }
+}
+
+/**
+ * @brief Subscribe the sender to the data stream and start acquisition
+ * @note The low byte of the command parameter is the channel mask, zero selects
+ * every channel. A run that is already going is shared, not restarted. A new
+ * host is only subscribed once its ARP reply is in, see service_arp_waits().
+ */
+static void
+cmd_start_acq(const protocol_cmd_payload_t *cmd, const udp_endpoint_t *remote)
+{
+    uint8_t channel_mask = (uint8_t)(cmd->param & 0xFFU);
+    if (channel_mask == 0)
+    {
+        channel_mask = SESSION_CHANNEL_ALL;
+    }
+
+    if (pin_host(&remote->ip) || !defer_start(remote, channel_mask))
+    {
+        start_stream(remote, channel_mask);
+    }
+    /* No response - fire and forget */
+}
+
+/**
+ * @brief Unsubscribe the sender, stopping acquisition when nobody is left
+ */
+static void
+cmd_stop_acq(const protocol_cmd_payload_t *cmd, const udp_endpoint_t *remote)
+{
+    (void)cmd;
+
+    /* A start still waiting for the ARP reply is dropped */
+    size_t wait      = find_arp_wait(remote);
+    bool   cancelled = wait < arp_wait_count && arp_waits[wait].channel_mask != 0U;
+    if (cancelled)
+    {
+        arp_waits[wait] = arp_waits[--arp_wait_count];
+    }
+
+    bool removed = session_unsubscribe(remote) == SESSION_STATUS_OK;
+    if (removed)
+    {
+        LOG_INFO("Subscriber removed (%u left)", session_count());
+    }
+    if (removed || cancelled)
+    {
+        unpin_departed_hosts();
+    }
+
+    if (session_count() == 0)
+    {
+        end_stream();
+    }
+}
+
+static void
+cmd_get_status(const protocol_cmd_payload_t *cmd, const udp_endpoint_t *remote)
+{
+    (void)cmd;
+
+    acquisition_stats_t acq_stats;
+    acquisition_get_stats(&acq_stats);
+
+    protocol_status_payload_t status_payload = {
+        .acquiring    = acquisition_is_running() ? 1 : 0,
+        .channel      = acquisition_get_channel(),
+        .threshold_mv = acquisition_get_threshold_mv(),
+        .uptime       = osKernelGetTickCount() / 1000,
+        .samples_sent = acq_stats.samples_sent,
+        .sample_rate  = acquisition_get_actual_sample_rate_millihz()
+    };
+
+    size_t            response_len;
+    protocol_status_t status = protocol_build_status(
+        tx_buffer, sizeof(tx_buffer), &status_payload, &response_len
+    );
+    if (status == PROTO_STATUS_OK)
+    {
+        send_response(remote, response_len);
+    }
+}
+
+/**
+ * @brief Report every pipeline counter, stack watermark and the CPU load
+ */
+static void
+cmd_get_telemetry(const protocol_cmd_payload_t *cmd, const udp_endpoint_t *remote)
+{
+    (void)cmd;
+
+    acquisition_stats_t acq_stats;
+    network_stats_t     net_stats;
+    logger_stats_t      log_stats;
+    udp_rx_stats_t      rx_stats   = {0};
+    udp_rx_stats_t      data_stats = {0};
+    udp_pool_stats_t    pool_stats = {0};
+    uint32_t            idle_stack_free;
+    uint32_t            timer_stack_free;
+
+    acquisition_get_stats(&acq_stats);
+    network_get_stats(&net_stats);
+    logger_get_stats(&log_stats);
+    (void)udp_socket_get_rx_stats(control_socket, &rx_stats);
+    (void)udp_socket_get_rx_stats(data_socket, &data_stats);
+    (void)udp_socket_get_pool_stats(&pool_stats);
+    system_get_kernel_stack_free(&idle_stack_free, &timer_stack_free);
+
+    const protocol_telemetry_entry_t entries[] = {
+        {TELEM_UPTIME_MS, (uint32_t)(system_time_us() / 1000U)},
+        {TELEM_CPU_LOAD, system_cpu_load_permille()},
+        {TELEM_ACQ_SAMPLES, acq_stats.samples_collected},
+        {TELEM_ACQ_SAMPLES_SENT, acq_stats.samples_sent},
+        {TELEM_ACQ_PACKETS_SENT, acq_stats.packets_sent},
+        {TELEM_ACQ_ERRORS, acq_stats.errors},
+        {TELEM_ACQ_ADC_OVERRUNS, adc_get_overruns()},
+        {TELEM_NET_PACKETS_SENT, net_stats.packets_sent},
+        {TELEM_NET_PACKETS_RECV, net_stats.packets_received},
+        {TELEM_NET_BYTES_SENT, net_stats.bytes_sent},
+        {TELEM_NET_BYTES_RECV, net_stats.bytes_received},
+        {TELEM_NET_ERRORS, net_stats.errors},
+        {TELEM_NET_SUBSCRIBERS, (uint32_t)session_count()},
+        {TELEM_NET_PACED, net_stats.paced},
+        {TELEM_NET_PACED_MS, net_stats.paced_ms},
+        {TELEM_NET_OUTAGES, net_stats.outages},
+        {TELEM_NET_HELD, net_stats.held},
+        {TELEM_NET_HELD_DROPPED, net_stats.held_dropped},
+        {TELEM_NET_ARP_RESOLVE_US, net_stats.arp_resolve_us},
+        {TELEM_NET_ARP_FAILED, net_stats.arp_failed},
+        {TELEM_SOCK_RX_DROPPED, rx_stats.rx_dropped + data_stats.rx_dropped},
+        {TELEM_SOCK_RX_QUEUED, rx_stats.rx_queued + data_stats.rx_queued},
+        {TELEM_SOCK_RX_QUEUE_SIZE, rx_stats.rx_queue_size + data_stats.rx_queue_size},
+        {TELEM_SOCK_TX_POOL_SIZE, pool_stats.tx_pool_size},
+        {TELEM_SOCK_TX_POOL_USED, pool_stats.tx_pool_used},
+        {TELEM_SOCK_TX_POOL_PEAK, pool_stats.tx_pool_peak},
+        {TELEM_SOCK_TX_REFUSED, pool_stats.tx_refused},
+        {TELEM_SOCK_RX_REJECTED, rx_stats.rx_rejected + data_stats.rx_rejected},
+        {TELEM_LOG_MESSAGES, log_stats.messages},
+        {TELEM_LOG_DROPPED, log_stats.dropped},
+        {TELEM_LOG_TRUNCATED, log_stats.truncated},
+        {TELEM_LOG_BYTES, log_stats.bytes},
+        {TELEM_STACK_NETWORK, osThreadGetStackSpace(osThreadGetId())},
+        {TELEM_STACK_ACQUISITION, acquisition_get_stack_free()},
+        {TELEM_STACK_IDLE, idle_stack_free},
+        {TELEM_STACK_TIMER, timer_stack_free},
+        {TELEM_BOOT_LOGGER, system_boot_phase_us(SYSTEM_BOOT_LOGGER)},
+        {TELEM_BOOT_NET_STACK, system_boot_phase_us(SYSTEM_BOOT_NET_STACK)},
+        {TELEM_BOOT_KERNEL, system_boot_phase_us(SYSTEM_BOOT_KERNEL)},
+        {TELEM_BOOT_LINK_UP, system_boot_phase_us(SYSTEM_BOOT_LINK_UP)},
+        {TELEM_BOOT_NET_READY, system_boot_phase_us(SYSTEM_BOOT_NET_READY)},
+        {TELEM_BOOT_FIRST_SAMPLE, system_boot_phase_us(SYSTEM_BOOT_FIRST_SAMPLE)},
+        {TELEM_BOOT_FIRST_SEND, system_boot_phase_us(SYSTEM_BOOT_FIRST_SEND)},
+    };
+
+    size_t            response_len;
+    protocol_status_t status = protocol_build_telemetry(
+        tx_buffer, sizeof(tx_buffer), entries, sizeof(entries) / sizeof(entries[0]),
+        &response_len
+    );
+    if (status == PROTO_STATUS_OK)
+    {
+        send_response(remote, response_len);
+    }
+}
+
+static void
+cmd_configure(const protocol_cmd_payload_t *cmd, const udp_endpoint_t *remote)
+{
+    (void)remote;
+
+    /* Same limits as a MSG_TYPE_CONFIG entry, some handlers trust them */
+    if (!protocol_config_value_valid(cmd->param_type, cmd->param))
+    {
+        LOG_WARNING("Invalid config param %u value %u", cmd->param_type, cmd->param);
+        count_error(&task_stats);
+        return;
+    }
+
+    if (apply_config_param(cmd->param_type, cmd->param) != 0)
+    {
+        count_error(&task_stats);
+    }
+}
+
+/**
+ * @brief Send the capture state and up to max_samples samples from offset
+ */
+static void
+send_capture(const udp_endpoint_t *remote, uint16_t offset, uint16_t max_samples)
+{
+    acquisition_capture_t      capture;
+    const uint16_t            *samples = NULL;
+    protocol_capture_payload_t info    = {0};
+
+    info.state  = (uint8_t)acquisition_capture_state();
+    info.offset = offset;
+
+    if (acquisition_capture_get(&capture) == 0)
+    {
+        info.channel      = capture.channel;
+        info.overruns     = capture.overruns;
+        info.total        = capture.count;
+        info.sample_rate  = capture.sample_rate;
+        info.timestamp_us = capture.start_us;
+
+        if (offset < capture.count)
+        {
+            uint16_t left     = capture.count - offset;
+            info.sample_count = (left < max_samples) ? left : max_samples;
+            samples           = &capture.samples[offset];
+        }
+    }
+
+    size_t            response_len;
+    protocol_status_t status = protocol_build_capture_packet(
+        tx_buffer, sizeof(tx_buffer), &info, samples, &response_len
+    );
+    if (status == PROTO_STATUS_OK)
+    {
+        send_response(remote, response_len);
+    }
+}
+
+/**
+ * @brief Start a burst capture of PARAM samples
+ * @note Always answered with a capture packet. A refused request leaves the
+ * state of the previous capture unchanged.
+ */
+static void
+cmd_capture(const protocol_cmd_payload_t *cmd, const udp_endpoint_t *remote)
+{
+    if (acquisition_capture_start(cmd->param) != 0)
+    {
+        LOG_WARNING("Capture of %u samples refused", cmd->param);
+    }
+
+    send_capture(remote, 0, 0);
+}
+
+/**
+ * @brief Send one chunk of the captured samples starting at offset PARAM
+ * @note Until the capture is done the reply carries only the state, so the
+ * host can poll with this command.
+ */
+static void
+cmd_capture_read(const protocol_cmd_payload_t *cmd, const udp_endpoint_t *remote)
+{
+    send_capture(remote, cmd->param, PROTOCOL_CAPTURE_CHUNK_SAMPLES);
+}
+
+/** Command handlers indexed by protocol_cmd_t */
+static const cmd_handler_t cmd_dispatch[] = {
+    [CMD_START_ACQ]     = cmd_start_acq,
+    [CMD_STOP_ACQ]      = cmd_stop_acq,
+    [CMD_GET_STATUS]    = cmd_get_status,
+    [CMD_CONFIGURE]     = cmd_configure,
+    [CMD_GET_TELEMETRY] = cmd_get_telemetry,
+    [CMD_CAPTURE]       = cmd_capture,
+    [CMD_CAPTURE_READ]  = cmd_capture_read,
+};
+
+static void
+msg_ping(const uint8_t *payload, size_t payload_len, const udp_endpoint_t *remote)
+{
+    (void)payload;
+    (void)payload_len;
+
+    size_t pong_len;
+    if (protocol_build_pong(tx_buffer, sizeof(tx_buffer), &pong_len) == PROTO_STATUS_OK)
+    {
+        send_response(remote, pong_len);
+    }
+}
+
+static void
+msg_pong(const uint8_t *payload, size_t payload_len, const udp_endpoint_t *remote)
+{
+    (void)payload;
+    (void)payload_len;
+    (void)remote;
+}
+
+static void
+msg_command(const uint8_t *payload, size_t payload_len, const udp_endpoint_t *remote)
+{
+    protocol_cmd_payload_t cmd;
+    if (protocol_parse_command(payload, payload_len, &cmd) != PROTO_STATUS_OK)
+    {
+        return;
+    }
+
+    LOG_DEBUG(
+        "Command received: 0x%02X, param_type: %u, param: %u", cmd.cmd, cmd.param_type,
+        cmd.param
+    );
+
+    if (cmd.cmd >= DISPATCH_TABLE_SIZE(cmd_dispatch) || cmd_dispatch[cmd.cmd] == NULL)
+    {
+        LOG_WARNING("Unknown command: 0x%02X", cmd.cmd);
+        return;
+    }
+
+    cmd_dispatch[cmd.cmd](&cmd, remote);
+}
+
+/**
+ * @brief Answer a clock synchronization request
+ * @note The receive time is taken in the network stack callback and the transmit
+ * time right before handing the response to the socket, so that the host sees
+ * neither queueing nor packet building as path delay.
+ */
+static void msg_sync_request(
+    const uint8_t *payload, size_t payload_len, const udp_endpoint_t *remote
+)
+{
+    (void)payload_len;
+
+    protocol_sync_req_payload_t  request;
+    protocol_sync_resp_payload_t response;
+    size_t                       response_len;
+
+    memcpy(&request, payload, sizeof(request));
+    response.host_t1      = request.host_t1;
+    response.device_rx_us = current_rx_time_us;
+    response.device_tx_us = system_time_us();
+
+    protocol_status_t status = protocol_build_sync_response(
+        tx_buffer, sizeof(tx_buffer), &response, &response_len
+    );
+    if (status == PROTO_STATUS_OK)
+    {
+        send_response(remote, response_len);
+    }
+}
+
+/**
+ * @brief Handle received TLV configuration packet
+ * @note All entries are validated by protocol_parse_config() before the first one
+ * is applied, with the same limits the handlers enforce, so an invalid packet
+ * leaves the configuration untouched and a valid one applies as a whole.
+ */
+static void
+msg_config(const uint8_t *payload, size_t payload_len, const udp_endpoint_t *remote)
+{
+    (void)remote;
+
+    protocol_config_entry_t entries[PROTOCOL_MAX_CONFIG_ENTRIES];
+    size_t                  entry_count = 0;
+
+    protocol_status_t status = protocol_parse_config(
+        payload, payload_len, entries, PROTOCOL_MAX_CONFIG_ENTRIES, &entry_count
+    );
+    if (status != PROTO_STATUS_OK)
+    {
+        LOG_WARNING("Rejected config packet (error %d)", status);
+        count_error(&task_stats);
+        return;
+    }
+
+    /* One packet is one configuration version for the acquisition task */
+    size_t applied = 0;
+    acquisition_config_begin();
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        if (apply_config_param(entries[i].param_type, entries[i].value) == 0)
+        {
+            applied++;
+        }
+        else
+        {
+            /* The parser checks what the handlers check, so this is a bug */
+            LOG_ERROR("Failed to apply config param %u", entries[i].param_type);
+            count_error(&task_stats);
+        }
+    }
+    acquisition_config_commit();
+
+    LOG_INFO("Applied %u of %u config parameters", applied, entry_count);
+}
+
+/** Message handlers indexed by protocol_msg_type_t */
+static const msg_dispatch_entry_t msg_dispatch[] = {
+    [MSG_TYPE_PING]     = {msg_ping, 0},
+    [MSG_TYPE_PONG]     = {msg_pong, 0},
+    [MSG_TYPE_SYNC_REQ] = {msg_sync_request, sizeof(protocol_sync_req_payload_t)},
+    [MSG_TYPE_CMD]      = {msg_command, sizeof(protocol_cmd_payload_t)},
+    [MSG_TYPE_CONFIG]   = {msg_config, PROTOCOL_CONFIG_TLV_HEADER_SIZE},
+};
+
+/**
+ * @brief Last request a socket queued from one host, used to drop repeats of it
+ */
+typedef struct
+{
+    udp_endpoint_t remote;   /**< Host that sent it */
+    uint32_t       tick;     /**< Kernel tick it was queued at */
+    uint16_t       sequence; /**< Host sequence number */
+    uint8_t        msg_type; /**< Message type */
+    bool           used;     /**< Entry holds a request */
+} last_request_t;
+
+/**
+ * @brief Last requests of the hosts a socket heard from most recently
  */
-static void
-handle_command(const protocol_cmd_payload_t *cmd, const udp_endpoint_t *remote)
+typedef struct
 {
-    size_t            response_len = 0;
-    protocol_status_t status       = PROTO_STATUS_ERROR;
-    char              ip_str[16];
+    last_request_t hosts[REQUEST_REPEAT_HOSTS]; /**< One entry per host */
+} request_history_t;
 
-    LOG_INFO(
-        "Command received: 0x%02X, param_type: %u, param: %u", cmd->cmd,
-        cmd->param_type, cmd->param
-    );
+static request_history_t control_history;
+static request_history_t data_history;
+
+/**
+ * @brief Find the entry of a host, or the one to reuse for it
+ * @details A free entry is reused first, then the one queued longest ago.
+ */
+static last_request_t *
+history_entry(request_history_t *history, const udp_endpoint_t *remote, uint32_t now)
+{
+    last_request_t *oldest = &history->hosts[0];
 
-    switch (cmd->cmd)
+    for (size_t i = 0; i < REQUEST_REPEAT_HOSTS; i++)
     {
-        case CMD_GET_STATUS:
+        last_request_t *entry = &history->hosts[i];
+
+        if (entry->used && entry->remote.port == remote->port &&
+            memcmp(entry->remote.ip.addr, remote->ip.addr, sizeof(remote->ip.addr)) ==
+                0)
         {
-            protocol_status_payload_t status_payload = {
-                .acquiring    = acquisition_is_running() ? 1 : 0,
-                .channel      = acquisition_get_channel(),
-                .threshold_mv = acquisition_get_threshold_mv(),
-                .uptime       = osKernelGetTickCount() / 1000,
-                .samples_sent = stats.packets_sent
-            };
-
-            status = protocol_build_status(
-                tx_buffer, sizeof(tx_buffer), &status_payload, &response_len
-            );
+            return entry;
         }
-        break;
-
-        case CMD_START_ACQ:
-            /* Set remote target to sender of START command */
-            remote_target       = *remote;
-            target_set_by_start = true;
-            udp_ipv4_to_string(&remote->ip, ip_str, sizeof(ip_str));
-            LOG_INFO("Acquisition target set to %s:%u", ip_str, remote->port);
+        if (oldest->used && (!entry->used || now - entry->tick > now - oldest->tick))
+        {
+            oldest = entry;
+        }
+    }
 
-            if (acquisition_start() != 0)
-            {
-                LOG_ERROR("Failed to start acquisition");
-            }
-            /* No response - fire and forget */
-            return;
+    return oldest;
+}
 
-        case CMD_STOP_ACQ:
-            acquisition_stop();
-            return;
+/**
+ * @brief Receive filter of both sockets: queue only requests the task handles
+ * @details Runs in the network stack's receive path, so junk never takes one of
+ * the few receive buffers that a CMD_STOP_ACQ may need. A request repeating the
+ * type and sequence number of the one its host had queued last is a duplicate
+ * and is refused as well for REQUEST_REPEAT_WINDOW ms. The last request is kept
+ * for each host, so repeats from several hosts in turn are refused too.
+ */
+static bool accept_request(
+    const udp_endpoint_t *remote, const uint8_t *data, size_t len, void *context
+)
+{
+    request_history_t *history = context;
+    protocol_header_t  header;
 
-        case CMD_CONFIGURE:
-            /* Handle configuration based on param_type */
-            switch (cmd->param_type)
-            {
-                case CONFIG_THRESHOLD_PERCENT:
-                    if (acquisition_set_threshold_percent((uint8_t)cmd->param) == 0)
-                    {
-                        LOG_INFO("Threshold set to %u%%", cmd->param);
-                    }
-                    break;
-
-                case CONFIG_THRESHOLD_MV:
-                    if (acquisition_set_threshold_mv(cmd->param) == 0)
-                    {
-                        LOG_INFO("Threshold set to %u mV", cmd->param);
-                    }
-                    break;
-
-                case CONFIG_BATCH_SIZE:
-                    if (acquisition_set_batch_size(cmd->param) == 0)
-                    {
-                        LOG_INFO("Batch size set to %u", cmd->param);
-                    }
-                    else
-                    {
-                        LOG_WARNING(
-                            "Invalid batch size: %u (max %u)", cmd->param,
-                            ACQUISITION_MAX_BATCH_SIZE
-                        );
-                    }
-                    break;
-
-                case CONFIG_CHANNEL:
-                    if (acquisition_set_channel((adc_channel_t)cmd->param) == 0)
-                    {
-                        LOG_INFO("Channel set to %u", cmd->param);
-                    }
-                    break;
-
-                case CONFIG_RESET_SEQUENCE:
-                    protocol_reset_sequence();
-                    LOG_INFO("Sequence counter reset");
-                    break;
-
-                case CONFIG_LOG_LEVEL:
-                    if (cmd->param <= LOG_LEVEL_NONE)
-                    {
-                        logger_set_level((log_level_t)cmd->param);
-                        LOG_INFO("Log level set to %u", cmd->param);
-                    }
-                    break;
-
-                default:
-                    LOG_WARNING("Unknown config param_type: %u", cmd->param_type);
-                    break;
-            }
-            return;
+    if (len < sizeof(header))
+    {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
 
-        default:
-            LOG_WARNING("Unknown command: 0x%02X", cmd->cmd);
-            return;
+    if (header.magic != PROTOCOL_MAGIC ||
+        header.msg_type >= DISPATCH_TABLE_SIZE(msg_dispatch) ||
+        msg_dispatch[header.msg_type].handler == NULL ||
+        len < sizeof(header) + header.payload_len)
+    {
+        return false;
     }
 
-    if (status == PROTO_STATUS_OK && response_len > 0)
+    uint32_t        now  = osKernelGetTickCount();
+    last_request_t *last = history_entry(history, remote, now);
+    if (last->used && now - last->tick < REQUEST_REPEAT_WINDOW &&
+        header.sequence == last->sequence && header.msg_type == last->msg_type &&
+        remote->port == last->remote.port &&
+        memcmp(remote->ip.addr, last->remote.ip.addr, sizeof(remote->ip.addr)) == 0)
     {
-        udp_socket_send(udp_socket, remote, tx_buffer, response_len);
-        stats.packets_sent++;
-        stats.bytes_sent += response_len;
+        return false;
     }
+
+    last->remote   = *remote;
+    last->tick     = now;
+    last->sequence = header.sequence;
+    last->msg_type = header.msg_type;
+    last->used     = true;
+    return true;
 }
 
+/** Control port: commands, pings and clock sync from the hosts */
+static const udp_rx_config_t control_rx = {
+    .queue_len      = CONTROL_RX_QUEUE_LEN,
+    .max_len        = PROTOCOL_MAX_REQUEST_SIZE,
+    .filter         = accept_request,
+    .filter_context = &control_history,
+};
+
+/** Data port: sends the stream, queues the odd request a host sends back to it */
+static const udp_rx_config_t data_rx = {
+    .queue_len      = DATA_RX_QUEUE_LEN,
+    .max_len        = PROTOCOL_MAX_REQUEST_SIZE,
+    .filter         = accept_request,
+    .filter_context = &data_history,
+};
+
 /**
  * @brief Process received UDP packet
+ * @note Runs for every received datagram, so it does no string formatting
+ * unless a message is actually logged.
  */
 static void
 process_received_packet(const uint8_t *data, size_t len, const udp_endpoint_t *remote)
@@ -218,58 +1230,164 @@ process_received_packet(const uint8_t *data, size_t len, const udp_endpoint_t *r
     const uint8_t    *payload;
     size_t            payload_len;
 
-    char remote_ip[16];
-    udp_ipv4_to_string(&remote->ip, remote_ip, sizeof(remote_ip));
-
-    LOG_DEBUG("Received %u bytes from %s:%u", len, remote_ip, remote->port);
-
     protocol_status_t status =
         protocol_parse_packet(data, len, &header, &payload, &payload_len);
 
     if (status != PROTO_STATUS_OK)
     {
         LOG_WARNING(
-            "Invalid packet from %s:%u (error %d)", remote_ip, remote->port, status
+            "Invalid packet from %u.%u.%u.%u:%u (error %d)", remote->ip.addr[0],
+            remote->ip.addr[1], remote->ip.addr[2], remote->ip.addr[3], remote->port,
+            status
         );
+        count_error(&task_stats);
         return;
     }
 
-    switch (header.msg_type)
+    if (header.msg_type >= DISPATCH_TABLE_SIZE(msg_dispatch) ||
+        msg_dispatch[header.msg_type].handler == NULL)
     {
-        case MSG_TYPE_PING:
-            LOG_DEBUG("Ping received, sending pong");
-            {
-                size_t pong_len;
-                if (protocol_build_pong(tx_buffer, sizeof(tx_buffer), &pong_len) ==
-                    PROTO_STATUS_OK)
-                {
-                    udp_socket_send(udp_socket, remote, tx_buffer, pong_len);
-                    stats.packets_sent++;
-                    stats.bytes_sent += pong_len;
-                }
-            }
-            break;
+        LOG_WARNING("Unknown message type: 0x%02X", header.msg_type);
+        return;
+    }
 
-        case MSG_TYPE_CMD:
-            LOG_DEBUG("Command received");
-            {
-                protocol_cmd_payload_t cmd;
-                if (protocol_parse_command(payload, payload_len, &cmd) ==
-                    PROTO_STATUS_OK)
-                {
-                    handle_command(&cmd, remote);
-                }
-            }
-            break;
+    /* Any valid packet from a subscriber renews its lease */
+    (void)session_touch(remote);
+
+    const msg_dispatch_entry_t *entry = &msg_dispatch[header.msg_type];
+    if (payload_len < entry->min_payload_len)
+    {
+        LOG_WARNING(
+            "Payload too short for message 0x%02X: %u < %u", header.msg_type,
+            payload_len, entry->min_payload_len
+        );
+        count_error(&task_stats);
+        return;
+    }
+
+    entry->handler(payload, payload_len, remote);
+}
+
+/**
+ * @brief Stream to the preconfigured host from boot, see system_autostart_target()
+ * @details The host is subscribed for good and acquisition starts before the
+ * link is up. The data path holds the packets until the socket is ready, as
+ * during a link outage, so sampling overlaps link negotiation.
+ */
+static void autostart(void)
+{
+    uint16_t    port;
+    const char *host = system_autostart_target(&port);
+
+    if (host == NULL)
+    {
+        return;
+    }
+
+    if (udp_endpoint_create(host, port, &autostart_target) != UDP_STATUS_OK ||
+        session_subscribe(
+            &autostart_target, SESSION_CHANNEL_ALL, SESSION_LEASE_FOREVER
+        ) != SESSION_STATUS_OK)
+    {
+        LOG_ERROR("Cannot auto-start to %s:%u", host, port);
+        return;
+    }
+
+    autostart_enabled = true;
+    hold_stream       = true;
+    if (acquisition_start() != 0)
+    {
+        LOG_ERROR("Failed to start acquisition");
+        return;
+    }
+
+    LOG_INFO("Auto-start: streaming to %s:%u", host, port);
+}
 
-        case MSG_TYPE_PONG:
-            LOG_DEBUG("Pong received from %s:%u", remote_ip, remote->port);
-            break;
+/**
+ * @brief Log how long each boot milestone took to reach
+ */
+static void log_boot_phases(void)
+{
+    LOG_INFO(
+        "Boot (ms): logger %u, net stack %u, kernel %u, link %u, ready %u, "
+        "first sample %u, first send %u",
+        system_boot_phase_us(SYSTEM_BOOT_LOGGER) / 1000U,
+        system_boot_phase_us(SYSTEM_BOOT_NET_STACK) / 1000U,
+        system_boot_phase_us(SYSTEM_BOOT_KERNEL) / 1000U,
+        system_boot_phase_us(SYSTEM_BOOT_LINK_UP) / 1000U,
+        system_boot_phase_us(SYSTEM_BOOT_NET_READY) / 1000U,
+        system_boot_phase_us(SYSTEM_BOOT_FIRST_SAMPLE) / 1000U,
+        system_boot_phase_us(SYSTEM_BOOT_FIRST_SEND) / 1000U
+    );
+}
+
+/**
+ * @brief Wait out a link outage, keeping the socket and the subscriptions
+ * @details The data path holds its packets meanwhile (see stream()). RL-NET keeps
+ * the socket bound and the address across the outage, so nothing is recreated.
+ * Hosts could not renew their leases while the link was down, so the leases are
+ * restarted once it is back.
+ */
+static void ride_out_outage(void)
+{
+    uint32_t start = osKernelGetTickCount();
+
+    LOG_WARNING("Ethernet link lost, holding the data stream");
+    hold_stream   = true;
+    current_state = NET_STATE_WAIT_LINK;
+    count_outage(&task_stats);
+
+    while (!udp_socket_wait_for_link(LINK_OUTAGE_LOG_INTERVAL))
+    {
+        LOG_WARNING(
+            "Ethernet link still down after %u ms", osKernelGetTickCount() - start
+        );
+    }
+
+    current_state = NET_STATE_WAIT_IP;
+    while (!wait_for_ip(IP_WAIT_TIMEOUT))
+    {
+        LOG_ERROR("IP address restore timeout");
+    }
+
+    session_renew_all();
+    current_state = NET_STATE_READY;
+    hold_stream   = false;
+    LOG_INFO("Ethernet link restored after %u ms", osKernelGetTickCount() - start);
+}
+
+/**
+ * @brief Receive and dispatch one request from a socket
+ * @param socket Control or data socket
+ * @param timeout_ms Time to wait for a request
+ * @return true if a request was handled
+ */
+static bool receive_request(udp_socket_handle_t socket, uint32_t timeout_ms)
+{
+    udp_endpoint_t remote;
+    size_t         received;
+
+    udp_status_t status = udp_socket_recv_timestamped(
+        socket, &remote, rx_buffer, sizeof(rx_buffer), &received, &current_rx_time_us,
+        timeout_ms
+    );
+
+    if (status == UDP_STATUS_OK && received > 0)
+    {
+        LOG_DEBUG("Packet received: %u bytes", received);
+        count_received(&task_stats, received);
+
+        process_received_packet(rx_buffer, received, &remote);
+        return true;
+    }
 
-        default:
-            LOG_WARNING("Unknown message type: 0x%02X", header.msg_type);
-            break;
+    if (status != UDP_STATUS_OK && status != UDP_STATUS_TIMEOUT)
+    {
+        LOG_WARNING("UDP receive error: %d", status);
+        count_error(&task_stats);
     }
+    return false;
 }
 
 /**
@@ -278,24 +1396,28 @@ process_received_packet(const uint8_t *data, size_t len, const udp_endpoint_t *r
 static void network_task(void *argument)
 {
     (void)argument;
-    ARM_ETH_LINK_INFO info;
 
     LOG_INFO("Network task started");
 
     current_state = NET_STATE_WAIT_LINK;
+    autostart();
+
     LOG_INFO("Network task: waiting for Ethernet link...");
-    if (!wait_for_link(30000))
+    if (!udp_socket_wait_for_link(LINK_WAIT_TIMEOUT))
     {
         LOG_ERROR("Ethernet link timeout");
+        hold_stream   = false;
         current_state = NET_STATE_ERROR;
         return;
     }
+    (void)system_boot_mark(SYSTEM_BOOT_LINK_UP);
 
     current_state = NET_STATE_WAIT_IP;
     LOG_INFO("Ethernet link up, waiting for IP address...");
     if (!wait_for_ip(IP_WAIT_TIMEOUT))
     {
         LOG_ERROR("IP address timeout");
+        hold_stream   = false;
         current_state = NET_STATE_ERROR;
         return;
     }
@@ -306,96 +1428,66 @@ static void network_task(void *argument)
         LOG_INFO("IP address obtained: %s", ip_str);
     }
 
-    udp_status_t status = udp_socket_create(&udp_socket, TASK_NETWORK_LOCAL_PORT);
+    udp_status_t status =
+        udp_socket_create_rx(&control_socket, TASK_NETWORK_LOCAL_PORT, &control_rx);
+    if (status == UDP_STATUS_OK)
+    {
+        status = udp_socket_create_rx(&data_socket, TASK_NETWORK_DATA_PORT, &data_rx);
+    }
     if (status != UDP_STATUS_OK)
     {
         LOG_ERROR("Failed to create UDP socket: %d", status);
+        hold_stream   = false;
         current_state = NET_STATE_ERROR;
         return;
     }
 
+    /* The auto-start host's packets stay held until its ARP reply */
+    bool resolving = autostart_enabled && !pin_host(&autostart_target.ip) &&
+                     defer_start(&autostart_target, 0U);
+
     current_state = NET_STATE_READY;
-    LOG_INFO("UDP socket created on port %u", TASK_NETWORK_LOCAL_PORT);
+    hold_stream   = resolving;
+    (void)system_boot_mark(SYSTEM_BOOT_NET_READY);
+    LOG_INFO(
+        "UDP sockets created on ports %u (control) and %u (data)",
+        TASK_NETWORK_LOCAL_PORT, TASK_NETWORK_DATA_PORT
+    );
 
-    info = Driver_ETH_PHY0.GetLinkInfo();
-    LOG_DEBUG("PHY speed=%u duplex=%u\n", (unsigned)info.speed, (unsigned)info.duplex);
+    udp_socket_log_link_info();
 
     while (1)
     {
         if (!udp_socket_is_link_up())
         {
-            LOG_WARNING("Ethernet link lost");
-            current_state = NET_STATE_WAIT_LINK;
-
-            if (udp_socket != NULL)
-            {
-                LOG_WARNING("Closing UDP socket due to link loss");
-                udp_socket_close(udp_socket);
-                udp_socket = NULL;
-            }
-
-            if (!wait_for_link(10000))
-            {
-                LOG_ERROR("Ethernet link restore timeout");
-                current_state = NET_STATE_ERROR;
-                continue;
-            }
+            ride_out_outage();
+        }
 
-            current_state = NET_STATE_WAIT_IP;
-            if (!wait_for_ip(IP_WAIT_TIMEOUT))
-            {
-                LOG_ERROR("IP address restore timeout");
-                current_state = NET_STATE_ERROR;
-                continue;
-            }
+        if (session_expire() > 0)
+        {
+            unpin_departed_hosts();
 
-            udp_status_t st = udp_socket_create(&udp_socket, TASK_NETWORK_LOCAL_PORT);
-            if (st != UDP_STATUS_OK)
+            if (session_count() == 0)
             {
-                LOG_ERROR("Failed to recreate UDP socket: %d", st);
-                current_state = NET_STATE_ERROR;
-                continue;
+                LOG_INFO("All subscriber leases expired, stopping the stream");
+                end_stream();
             }
-
-            current_state = NET_STATE_READY;
-            LOG_INFO("Ethernet link restored (socket reopened)");
         }
 
-        udp_endpoint_t remote;
-        size_t         received;
-
-        udp_status_t recv_status = udp_socket_recv(
-            udp_socket, &remote, rx_buffer, sizeof(rx_buffer), &received, 100
-        );
-
-        if (recv_status == UDP_STATUS_OK && received > 0)
+        /* Drain the control queue first, the data port only gets a turn when it
+         * is empty */
+        uint32_t handled = 0;
+        while (handled < CONTROL_RX_QUEUE_LEN && receive_request(control_socket, 0U))
         {
-            LOG_DEBUG("Packet received: %u bytes", received);
-            stats.packets_received++;
-            stats.bytes_received += received;
-
-            process_received_packet(rx_buffer, received, &remote);
+            handled++;
         }
-        else if (recv_status != UDP_STATUS_TIMEOUT)
+        if (handled == 0 && !receive_request(data_socket, 0U))
         {
-            LOG_WARNING("UDP receive error: %d", recv_status);
-            LOG_WARNING("UDP error on receive %d", stats.errors);
-            stats.errors++;
+            /* Poll the ARP cache every tick while a stream start waits on it */
+            (void)receive_request(control_socket, (arp_wait_count != 0U) ? 0U : 100U);
         }
-        LOG_DEBUG(
-            "IntStatus=%08lX IntEnable=%08lX", LPC_EMAC->IntStatus, LPC_EMAC->IntEnable
-        );
-        LOG_DEBUG(
-            "RxPI=%lu RxCI=%lu TxPI=%lu TxCI=%lu", LPC_EMAC->RxProduceIndex,
-            LPC_EMAC->RxConsumeIndex, LPC_EMAC->TxProduceIndex, LPC_EMAC->TxConsumeIndex
-        );
-        LOG_DEBUG(
-            "TX: CI=%lu Stat[%lu]=%08lX", LPC_EMAC->TxConsumeIndex,
-            LPC_EMAC->TxConsumeIndex % LPC_EMAC->TxDescriptorNumber,
-            (
-                (volatile uint32_t *)LPC_EMAC->TxStatus
-            )[LPC_EMAC->TxConsumeIndex % LPC_EMAC->TxDescriptorNumber]
-        );
+        service_arp_waits();
+        udp_socket_log_driver_state();
         osDelay(1);
     }
 }
@@ -419,6 +1511,12 @@ int network_init(void)
         return -1;
     }
 
+    if (session_init() != SESSION_STATUS_OK)
+    {
+        panic("Session table initialization failed", NULL);
+        return -1;
+    }
+
     initialized = true;
     return 0;
 }
@@ -457,6 +1555,11 @@ bool network_is_ready(void)
     return (current_state == NET_STATE_READY);
 }
 
+bool network_is_streaming(void)
+{
+    return network_is_ready() || hold_stream;
+}
+
 int network_set_target(const char *ip_addr, uint16_t port)
 {
     if (ip_addr == NULL)
@@ -465,20 +1568,255 @@ int network_set_target(const char *ip_addr, uint16_t port)
         return -1;
     }
 
-    udp_status_t status = udp_endpoint_create(ip_addr, port, &remote_target);
+    udp_endpoint_t target;
+    udp_status_t   status = udp_endpoint_create(ip_addr, port, &target);
     if (status != UDP_STATUS_OK)
     {
         LOG_ERROR("Invalid target address: %s:%u", ip_addr, port);
         return -1;
     }
 
+    if (session_subscribe(&target, SESSION_CHANNEL_ALL, SESSION_LEASE_FOREVER) !=
+        SESSION_STATUS_OK)
+    {
+        LOG_ERROR("No free subscriber slot for %s:%u", ip_addr, port);
+        return -1;
+    }
+
     LOG_INFO("Target set to %s:%u", ip_addr, port);
     return 0;
 }
 
+/**
+ * @brief Microseconds until a fan-out may be sent, taking pacer tokens if it may
+ * @details The send buffer budget is checked first, so pacer tokens are only
+ * taken for a fan-out that goes out right away.
+ */
+static uint32_t pace_wait_us(size_t len, size_t count, uint64_t now_us)
+{
+    uint32_t wait_us = udp_socket_tx_wait_us(len, count);
+
+    if (wait_us != 0U)
+    {
+        return wait_us;
+    }
+
+    if (data_pacer_bytes_per_s == 0U && data_pacer_packets_per_s == 0U)
+    {
+        return 0;
+    }
+
+    return pacer_reserve(&data_pacer, (uint32_t)(len * count), (uint32_t)count, now_us);
+}
+
+/**
+ * @brief Block the data path until the pacer and the send buffers admit a send
+ * @details Waiting here is the backpressure: while the caller sleeps, samples
+ * pile up in the ADC buffer instead of the network stack running out of send
+ * buffers and dropping the packet.
+ */
+static void pace(size_t len, size_t count)
+{
+    uint32_t bytes_per_s   = pace_bytes_per_s;
+    uint32_t packets_per_s = pace_packets_per_s;
+
+    if (bytes_per_s != data_pacer_bytes_per_s ||
+        packets_per_s != data_pacer_packets_per_s)
+    {
+        pacer_init(&data_pacer, bytes_per_s, packets_per_s, system_time_us());
+        data_pacer_bytes_per_s   = bytes_per_s;
+        data_pacer_packets_per_s = packets_per_s;
+    }
+
+    uint64_t start_us = system_time_us();
+    uint32_t wait_us  = pace_wait_us(len, count, start_us);
+
+    if (wait_us == 0U)
+    {
+        return;
+    }
+
+    do
+    {
+        osDelay((wait_us + 999U) / 1000U);
+        wait_us = pace_wait_us(len, count, system_time_us());
+    } while (wait_us != 0U);
+
+    count_paced(&data_stats, (uint32_t)((system_time_us() - start_us) / 1000U));
+}
+
+/**
+ * @brief Send one packet to every subscriber of a channel
+ * @note The packet is built once by the caller and handed to the socket as one
+ * batch, so the socket and link are checked once per packet rather than once per
+ * subscriber. Endpoints are snapshotted so that the table lock is not held while
+ * sending. In multicast mode the snapshot holds just the group. The whole fan-out
+ * is paced as one send and waits until the stack has buffers for all of it.
+ * @return 0 if at least one send succeeded or nobody is subscribed
+ */
+static int publish(uint8_t channel, const uint8_t *data, size_t len)
+{
+    udp_endpoint_t targets[SESSION_MAX_SUBSCRIBERS];
+    udp_datagram_t datagrams[SESSION_MAX_SUBSCRIBERS];
+    udp_status_t   results[SESSION_MAX_SUBSCRIBERS];
+    size_t         sent = 0;
+
+    size_t target_count =
+        session_get_targets(channel, targets, SESSION_MAX_SUBSCRIBERS);
+    if (target_count == 0)
+    {
+        return 0;
+    }
+
+    pace(len, target_count);
+
+    for (size_t i = 0; i < target_count; i++)
+    {
+        datagrams[i].remote = &targets[i];
+        datagrams[i].data   = data;
+        datagrams[i].len    = len;
+    }
+
+    (void)udp_socket_send_batch(data_socket, datagrams, target_count, results);
+
+    for (size_t i = 0; i < target_count; i++)
+    {
+        if (results[i] != UDP_STATUS_OK)
+        {
+            LOG_ERROR(
+                "Failed to send to %u.%u.%u.%u:%u: %d", targets[i].ip.addr[0],
+                targets[i].ip.addr[1], targets[i].ip.addr[2], targets[i].ip.addr[3],
+                targets[i].port, results[i]
+            );
+            count_error(&data_stats);
+            continue;
+        }
+
+        count_sent(&data_stats, len);
+        sent++;
+    }
+
+    return (sent > 0) ? 0 : -1;
+}
+
+/**
+ * @brief Keep a packet in the backlog until the link is back
+ * @return 0 if held, -1 if the backlog is full and the packet was dropped
+ */
+static int hold(uint8_t channel, const uint8_t *data, size_t len)
+{
+    backlog_entry_t entry = {.len = (uint16_t)len, .channel = channel};
+
+    if (backlog.held == 0U && backlog.dropped == 0U)
+    {
+        backlog.since_us = system_time_us();
+    }
+
+    if (backlog.used + sizeof(entry) + len > sizeof(backlog.data))
+    {
+        backlog.dropped++;
+        count_held(&data_stats, true);
+        return -1;
+    }
+
+    memcpy(&backlog.data[backlog.used], &entry, sizeof(entry));
+    memcpy(&backlog.data[backlog.used + sizeof(entry)], data, len);
+    backlog.used += sizeof(entry) + len;
+    backlog.held++;
+    count_held(&data_stats, false);
+
+    return 0;
+}
+
+/**
+ * @brief Send the held packets, then a gap packet describing the outage
+ * @details The held packets keep the sequence numbers they were built with, so
+ * the host sees them in order; the dropped ones show up as missing numbers that
+ * the gap packet accounts for.
+ */
+static void resume_stream(uint8_t channel)
+{
+    protocol_gap_payload_t gap = {
+        .outage_ms    = (uint32_t)((system_time_us() - backlog.since_us) / 1000U),
+        .held         = backlog.held,
+        .dropped      = backlog.dropped,
+        .timestamp_us = backlog.since_us,
+    };
+
+    for (size_t offset = 0; offset < backlog.used;)
+    {
+        backlog_entry_t entry;
+
+        memcpy(&entry, &backlog.data[offset], sizeof(entry));
+        offset += sizeof(entry);
+        (void)publish(entry.channel, &backlog.data[offset], entry.len);
+        offset += entry.len;
+    }
+
+    backlog.used    = 0;
+    backlog.held    = 0;
+    backlog.dropped = 0;
+
+    uint8_t packet[sizeof(protocol_header_t) + sizeof(protocol_gap_payload_t)];
+    size_t  packet_len;
+    if (protocol_build_gap_packet(packet, sizeof(packet), &gap, &packet_len) ==
+        PROTO_STATUS_OK)
+    {
+        (void)publish(channel, packet, packet_len);
+    }
+
+    LOG_INFO(
+        "Stream resumed after %u ms, %u packets held, %u dropped", gap.outage_ms,
+        gap.held, gap.dropped
+    );
+}
+
+/**
+ * @brief Publish a data packet, or hold it while the link is down or the
+ * auto-start host is being resolved
+ * @details A backlog left from before end_stream() is discarded first.
+ */
+static int stream(uint8_t channel, const uint8_t *data, size_t len)
+{
+    uint32_t discards = backlog_discards;
+
+    if (backlog.discards != discards)
+    {
+        if (backlog.held != 0U || backlog.dropped != 0U)
+        {
+            LOG_INFO(
+                "Backlog of a stopped stream discarded, %u packets held, %u dropped",
+                backlog.held, backlog.dropped
+            );
+        }
+        backlog.used     = 0;
+        backlog.held     = 0;
+        backlog.dropped  = 0;
+        backlog.discards = discards;
+    }
+
+    if (hold_stream || current_state != NET_STATE_READY || !udp_socket_is_link_up())
+    {
+        return hold(channel, data, len);
+    }
+
+    if (backlog.held != 0U || backlog.dropped != 0U)
+    {
+        resume_stream(channel);
+    }
+
+    int result = publish(channel, data, len);
+    if (result == 0 && system_boot_mark(SYSTEM_BOOT_FIRST_SEND))
+    {
+        log_boot_phases();
+    }
+
+    return result;
+}
+
 int network_send_data(uint8_t channel, const uint16_t *samples, uint16_t sample_count)
 {
-    if (!network_is_ready())
+    if (!network_is_streaming())
     {
         LOG_CRITICAL("Network not ready. Cannot send data.");
         return -1;
@@ -492,35 +1830,23 @@ int network_send_data(uint8_t channel, const uint16_t *samples, uint16_t sample_
 
     size_t            packet_len;
     protocol_status_t proto_status = protocol_build_data_packet(
-        tx_buffer, sizeof(tx_buffer), channel, samples, sample_count, &packet_len
+        tx_buffer, sizeof(tx_buffer), channel, samples, sample_count, 0,
+        system_time_us(), &packet_len
     );
 
     if (proto_status != PROTO_STATUS_OK)
     {
         LOG_ERROR("Failed to build data packet: %d", proto_status);
-        stats.errors++;
-        return -1;
-    }
-
-    udp_status_t udp_status =
-        udp_socket_send(udp_socket, &remote_target, tx_buffer, packet_len);
-
-    if (udp_status != UDP_STATUS_OK)
-    {
-        LOG_ERROR("Failed to send data packet: %d", udp_status);
-        stats.errors++;
+        count_error(&data_stats);
         return -1;
     }
 
-    stats.packets_sent++;
-    stats.bytes_sent += packet_len;
-
-    return 0;
+    return stream(channel, tx_buffer, packet_len);
 }
 
-int network_send_raw(const uint8_t *data, size_t len)
+int network_send_raw(uint8_t channel, const uint8_t *data, size_t len)
 {
-    if (!network_is_ready())
+    if (!network_is_streaming())
     {
         LOG_CRITICAL("Network not ready. Cannot send data.");
         return -1;
@@ -532,27 +1858,30 @@ int network_send_raw(const uint8_t *data, size_t len)
         return -1;
     }
 
-    udp_status_t status = udp_socket_send(udp_socket, &remote_target, data, len);
-
-    if (status != UDP_STATUS_OK)
-    {
-        LOG_ERROR("Failed to send raw data: %d", status);
-        stats.errors++;
-        return -1;
-    }
-
-    stats.packets_sent++;
-    stats.bytes_sent += len;
-
-    return 0;
+    return stream(channel, data, len);
 }
 
 void network_get_stats(network_stats_t *out_stats)
 {
-    if (out_stats != NULL)
+    if (out_stats == NULL)
     {
-        *out_stats = stats;
+        return;
     }
+
+    network_stats_t data;
+
+    stats_read(&task_stats.seq, out_stats, &task_stats.counters, sizeof(*out_stats));
+    stats_read(&data_stats.seq, &data, &data_stats.counters, sizeof(data));
+
+    out_stats->packets_sent += data.packets_sent;
+    out_stats->packets_received += data.packets_received;
+    out_stats->bytes_sent += data.bytes_sent;
+    out_stats->bytes_received += data.bytes_received;
+    out_stats->errors += data.errors;
+    out_stats->paced += data.paced;
+    out_stats->paced_ms += data.paced_ms;
+    out_stats->held += data.held;
+    out_stats->held_dropped += data.held_dropped;
 }
 
 char *network_get_local_ip_str(char *buffer, size_t buffer_len)
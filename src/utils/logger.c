@@ -39,9 +39,10 @@ extern ARM_DRIVER_USART Driver_USART3;
 #define LOGGER_TX_TIMEOUT_MS    1000 /**< Default TX timeout */
 #define LOGGER_MUTEX_TIMEOUT_MS 5000 /**< Mutex acquire timeout */
 
-static log_level_t current_log_level = DEFAULT_LOG_LEVEL;
-static bool        initialized       = false;
-static char        log_buffer[LOGGER_BUFFER_SIZE];
+static log_level_t    current_log_level = DEFAULT_LOG_LEVEL;
+static bool           initialized       = false;
+static char           log_buffer[LOGGER_BUFFER_SIZE];
+static logger_stats_t stats             = {0};
 
 static osMutexId_t     logger_mutex = NULL;
 static osSemaphoreId_t tx_semaphore = NULL;
@@ -229,6 +230,18 @@ log_level_t logger_get_level(void)
     return current_log_level;
 }
 
+/**
+ * @brief Get logger counters
+ * @param out_stats Pointer to store counters
+ */
+void logger_get_stats(logger_stats_t *out_stats)
+{
+    if (out_stats != NULL)
+    {
+        *out_stats = stats;
+    }
+}
+
 /**
  * @brief Log a message with specified level
  * @param level Log level
@@ -256,6 +269,8 @@ int logger_log(log_level_t level, const char *format, ...)
     mutex_status = osMutexAcquire(logger_mutex, LOGGER_MUTEX_TIMEOUT_MS);
     if (mutex_status != osOK)
     {
+        /* Not under the mutex, a lost increment only undercounts */
+        stats.dropped++;
         return LOGGER_ERROR_BUSY;
     }
 
@@ -265,6 +280,7 @@ int logger_log(log_level_t level, const char *format, ...)
 
     if (length < 0)
     {
+        stats.dropped++;
         osMutexRelease(logger_mutex);
         return LOGGER_ERROR_PARAM;
     }
@@ -277,14 +293,18 @@ int logger_log(log_level_t level, const char *format, ...)
     status = logger_write_raw(log_buffer, chunk_size);
     if (status != LOGGER_OK)
     {
+        stats.dropped++;
         osMutexRelease(logger_mutex);
         return status;
     }
     total_sent += chunk_size;
+    stats.messages++;
+    stats.bytes += (uint32_t)chunk_size;
 
     /* Send truncation notice if message was too long */
     if (length >= LOGGER_BUFFER_SIZE)
     {
+        stats.truncated++;
         const char *continuation = "...[TRUNCATED]...\r\n";
         status                   = logger_write_raw(continuation, strlen(continuation));
         if (status != LOGGER_OK)
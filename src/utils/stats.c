@@ -0,0 +1,51 @@
+/**
+ * @file stats.c
+ * @brief Lock-free statistics snapshots using a sequence counter
+ * @author Wiktor Szewczyk
+ * @author Patryk Madej
+ */
+
+#include "stats.h"
+
+#include "LPC17xx.h"
+#include "cmsis_os2.h"
+
+#include <string.h>
+
+void stats_write_begin(stats_seq_t *seq)
+{
+    seq->sequence++;
+    /* Readers must see the odd sequence before any counter changes */
+    __DMB();
+}
+
+void stats_write_end(stats_seq_t *seq)
+{
+    /* Counter changes must be visible before the sequence turns even */
+    __DMB();
+    seq->sequence++;
+}
+
+void stats_read(const stats_seq_t *seq, void *dst, const void *src, size_t size)
+{
+    for (;;)
+    {
+        uint32_t start = seq->sequence;
+
+        if ((start & 1U) != 0U)
+        {
+            /* Writer preempted mid-update; spinning would starve it */
+            (void)osDelay(1);
+            continue;
+        }
+
+        __DMB();
+        memcpy(dst, src, size);
+        __DMB();
+
+        if (seq->sequence == start)
+        {
+            return;
+        }
+    }
+}